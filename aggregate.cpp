@@ -0,0 +1,217 @@
+#include "aggregate.h"
+#include "columns.h"
+#include "snapshot.h"
+#include "memory.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+// Номер дня от 1970-01-01 по дате григорианского календаря
+static int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+}
+
+// Год по номеру дня от 1970-01-01
+static int64_t yearFromDays(int64_t days) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+    unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+    return static_cast<int64_t>(yearOfEra) + era * 400 + (monthIndex >= 10 ? 1 : 0);
+}
+
+// Числовой ключ интервала для даты ГГГГММДД (0 - дата некорректна)
+static uint32_t dateBucket(uint32_t dateKey, GroupBy by) {
+    uint32_t year = dateKey / 10000;
+    uint32_t month = dateKey / 100 % 100;
+    uint32_t day = dateKey % 100;
+    if (dateKey == 0 || month < 1 || month > 12 || day < 1 || day > 31) {
+        return 0;
+    }
+
+    switch (by) {
+        case GroupBy::Day:
+            return dateKey;
+        case GroupBy::Month:
+            return dateKey / 100;
+        case GroupBy::Year:
+            return year;
+        case GroupBy::Week: {
+            // ISO 8601: неделя относится к году, в который попадает ее четверг
+            int64_t days = daysFromCivil(year, month, day);
+            int64_t weekday = ((days + 3) % 7 + 7) % 7;     // 0 - понедельник
+            int64_t thursday = days + 3 - weekday;
+            int64_t isoYear = yearFromDays(thursday);
+            int64_t week = (thursday - daysFromCivil(isoYear, 1, 1)) / 7 + 1;
+            return static_cast<uint32_t>(isoYear * 100 + week);
+        }
+        case GroupBy::Category:
+            break;
+    }
+    return 0;
+}
+
+static std::string bucketName(uint32_t bucket, GroupBy by) {
+    if (bucket == 0) {
+        return "";
+    }
+    char buffer[32];
+    switch (by) {
+        case GroupBy::Day:
+            std::snprintf(buffer, sizeof(buffer), "%04u-%02u-%02u", bucket / 10000, bucket / 100 % 100, bucket % 100);
+            break;
+        case GroupBy::Week:
+            std::snprintf(buffer, sizeof(buffer), "%04u-W%02u", bucket / 100, bucket % 100);
+            break;
+        case GroupBy::Month:
+            std::snprintf(buffer, sizeof(buffer), "%04u-%02u", bucket / 100, bucket % 100);
+            break;
+        default:
+            std::snprintf(buffer, sizeof(buffer), "%04u", bucket);
+            break;
+    }
+    return buffer;
+}
+
+bool parseGroupBy(const std::string& name, GroupBy& by) {
+    static const std::pair<const char*, GroupBy> names[] = {
+        {"category", GroupBy::Category}, {"day", GroupBy::Day}, {"week", GroupBy::Week},
+        {"month", GroupBy::Month}, {"year", GroupBy::Year}
+    };
+    for (const auto& entry : names) {
+        if (name == entry.first) {
+            by = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string dateGroupKey(const std::string& date, GroupBy by) {
+    return bucketName(dateBucket(NoteColumns::dateKey(date), by), by);
+}
+
+void sortGroups(std::vector<GroupCount>& groups, GroupBy by) {
+    if (by == GroupBy::Category) {
+        std::sort(groups.begin(), groups.end(), [](const GroupCount& a, const GroupCount& b) {
+            return a.count > b.count || (a.count == b.count && a.key < b.key);
+        });
+    } else {
+        // Ключи дат одной длины, поэтому строковый порядок - хронологический
+        std::sort(groups.begin(), groups.end(), [](const GroupCount& a, const GroupCount& b) {
+            return a.key < b.key;
+        });
+    }
+}
+
+// ===== СЧЕТЧИКИ =====
+
+static const GroupBy DATE_GROUPS[4] = {GroupBy::Day, GroupBy::Week, GroupBy::Month, GroupBy::Year};
+
+void NoteAggregates::add(const std::string& category, const std::string& date) {
+    categories[category]++;
+    uint32_t key = NoteColumns::dateKey(date);
+    for (size_t i = 0; i < 4; i++) {
+        dates[i][dateBucket(key, DATE_GROUPS[i])]++;
+    }
+}
+
+// Уменьшение счетчика с удалением опустевшей группы
+template <typename Map, typename Key>
+static void decrement(Map& counts, const Key& key) {
+    auto it = counts.find(key);
+    if (it != counts.end() && --it->second == 0) {
+        counts.erase(it);
+    }
+}
+
+void NoteAggregates::remove(const std::string& category, const std::string& date) {
+    decrement(categories, category);
+    uint32_t key = NoteColumns::dateKey(date);
+    for (size_t i = 0; i < 4; i++) {
+        decrement(dates[i], dateBucket(key, DATE_GROUPS[i]));
+    }
+}
+
+std::vector<GroupCount> NoteAggregates::counts(GroupBy by) const {
+    std::vector<GroupCount> result;
+    if (by == GroupBy::Category) {
+        result.reserve(categories.size());
+        for (const auto& entry : categories) {
+            result.push_back({entry.first, entry.second});
+        }
+    } else {
+        const auto& buckets = dates[static_cast<size_t>(by) - 1];
+        result.reserve(buckets.size());
+        for (const auto& entry : buckets) {
+            result.push_back({bucketName(entry.first, by), entry.second});
+        }
+    }
+    sortGroups(result, by);
+    return result;
+}
+
+void NoteAggregates::save(SnapshotWriter& out) const {
+    out.putU64(categories.size());
+    for (const auto& entry : categories) {
+        out.putString(entry.first);
+        out.putU64(entry.second);
+    }
+    for (const auto& buckets : dates) {
+        std::vector<uint32_t> keys;
+        std::vector<uint64_t> counts;
+        keys.reserve(buckets.size());
+        counts.reserve(buckets.size());
+        for (const auto& entry : buckets) {
+            keys.push_back(entry.first);
+            counts.push_back(entry.second);
+        }
+        out.putVector(keys);
+        out.putVector(counts);
+    }
+}
+
+void NoteAggregates::load(SnapshotReader& in) {
+    clear();
+    size_t count = in.getCount(2 * sizeof(uint64_t));
+    categories.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        std::string category = in.getString();
+        categories[category] = in.getU64();
+    }
+    for (auto& buckets : dates) {
+        std::vector<uint32_t> keys;
+        std::vector<uint64_t> counts;
+        in.getVector(keys);
+        in.getVector(counts);
+        if (keys.size() != counts.size()) {
+            throw std::runtime_error("поврежденные счетчики дат");
+        }
+        buckets.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            buckets[keys[i]] = counts[i];
+        }
+    }
+}
+
+void NoteAggregates::clear() {
+    categories.clear();
+    for (auto& buckets : dates) {
+        buckets.clear();
+    }
+}
+
+size_t NoteAggregates::memoryUsage() const {
+    size_t bytes = stringKeyedTableBytes(categories);
+    for (const auto& buckets : dates) {
+        bytes += hashTableBytes(buckets);
+    }
+    return bytes;
+}
@@ -0,0 +1,60 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+// Группировка при подсчете заметок
+enum class GroupBy {
+    Category,   // Тема
+    Day,        // "2025-03-14"
+    Week,       // ISO-неделя "2025-W11" (неделя с понедельника)
+    Month,      // "2025-03"
+    Year        // "2025"
+};
+
+// Число заметок в группе
+struct GroupCount {
+    std::string key;
+    uint64_t count;
+};
+
+// Разбор имени группировки ("category", "day", "week", "month", "year")
+bool parseGroupBy(const std::string& name, GroupBy& by);
+
+// Ключ группы для даты ГГГГ-ММ-ДД (некорректная дата - пустой ключ)
+std::string dateGroupKey(const std::string& date, GroupBy by);
+
+// Порядок вывода: темы - по убыванию числа заметок, даты - по возрастанию
+void sortGroups(std::vector<GroupCount>& groups, GroupBy by);
+
+// Счетчики заметок по темам и интервалам дат. Обновляются при каждом
+// добавлении и удалении заметки, поэтому чтение стоит O(число групп).
+// Даты хранятся числами (ГГГГММДД, ГГГГНН, ГГГГММ, ГГГГ), строка ключа
+// собирается только при чтении.
+class NoteAggregates {
+public:
+    void add(const std::string& category, const std::string& date);
+    void remove(const std::string& category, const std::string& date);
+
+    std::vector<GroupCount> counts(GroupBy by) const;
+
+    // Сохранение в снимок и восстановление (snapshot.h)
+    void save(SnapshotWriter& out) const;
+    void load(SnapshotReader& in);
+
+    void clear();
+    // Байты кучи счетчиков (memory.h)
+    size_t memoryUsage() const;
+
+private:
+    std::unordered_map<std::string, uint64_t> categories;
+    std::unordered_map<uint32_t, uint64_t> dates[4];    // Day, Week, Month, Year
+};
+
+#endif // AGGREGATE_H
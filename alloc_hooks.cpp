@@ -0,0 +1,73 @@
+#include "memory.h"
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+// Замена глобальных operator new/delete со счетчиком кучи (memory.h).
+// Собирается только в программы, которым нужен точный учет (memtest_runner):
+// каждый вызов стоит двух атомарных операций и malloc_usable_size.
+// Блок учитывается вместе с заголовком malloc, как в heapBlockBytes.
+// Варианты с выравниванием не заменяются: стандартная библиотека выделяет
+// и освобождает их в паре, мимо счетчика.
+
+// Отметка о том, что счетчик собран (при инициализации программы)
+static const bool trackingInstalled = (enableAllocationTracking(), true);
+
+static void* countedAllocate(size_t size) {
+    void* block = std::malloc(size == 0 ? 1 : size);
+    if (block != nullptr) {
+        recordAllocation(malloc_usable_size(block) + sizeof(size_t));
+    }
+    return block;
+}
+
+static void countedFree(void* block) noexcept {
+    if (block != nullptr) {
+        recordDeallocation(malloc_usable_size(block) + sizeof(size_t));
+        std::free(block);
+    }
+}
+
+void* operator new(size_t size) {
+    void* block = countedAllocate(size);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void operator delete(void* block) noexcept {
+    countedFree(block);
+}
+
+void operator delete[](void* block) noexcept {
+    countedFree(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    countedFree(block);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+    countedFree(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept {
+    countedFree(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept {
+    countedFree(block);
+}
@@ -0,0 +1,377 @@
+#include "archive.h"
+#include "checksum.h"
+#include "tags.h"
+#include "timestamp.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef HAVE_ZLIB
+    #include <zlib.h>
+#endif
+
+// Сигнатура архива (последние два символа - версия формата)
+static const char ARCHIVE_MAGIC[8] = {'T', 'M', 'A', 'R', 'C', 'H', '0', '3'};
+static const size_t ARCHIVE_MAGIC_PREFIX = 6;
+
+// Размер буфера потоковой записи и чтения
+const size_t ARCHIVE_BUFFER_SIZE = 1 << 20;
+
+// Ограничение длины поля: все, что больше, считается повреждением
+const uint64_t ARCHIVE_MAX_FIELD = 1ull << 30;
+
+// ===== КОДИРОВАНИЕ ЧИСЕЛ =====
+
+static void putU32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+static void putU64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+static uint32_t getU32(const unsigned char* bytes) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+static uint64_t getU64(const unsigned char* bytes) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+bool archiveCompressionAvailable() {
+#ifdef HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+// ===== ЗАПИСЬ =====
+
+#ifdef HAVE_ZLIB
+struct ArchiveWriter::Deflater {
+    z_stream stream;
+    std::string output;
+};
+#else
+struct ArchiveWriter::Deflater {};
+#endif
+
+ArchiveWriter::ArchiveWriter(const std::string& path, bool compress)
+    : streamCrc(0), noteCount(0), finished(false) {
+    if (compress && !archiveCompressionAvailable()) {
+        throw std::runtime_error("Программа собрана без поддержки сжатия (zlib)");
+    }
+    
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Не удалось создать файл архива: " + path);
+    }
+    
+    std::string header(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+    putU32(header, compress ? ARCHIVE_FLAG_COMPRESSED : 0);
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    
+#ifdef HAVE_ZLIB
+    if (compress) {
+        deflater = std::make_unique<Deflater>();
+        std::memset(&deflater->stream, 0, sizeof(deflater->stream));
+        // Уровень 1: сжатие не должно становиться узким местом по сравнению с диском
+        if (deflateInit(&deflater->stream, 1) != Z_OK) {
+            throw std::runtime_error("Ошибка инициализации zlib");
+        }
+        deflater->output.resize(ARCHIVE_BUFFER_SIZE);
+    }
+#endif
+    buffer.reserve(ARCHIVE_BUFFER_SIZE + 64 * 1024);
+}
+
+ArchiveWriter::~ArchiveWriter() {
+#ifdef HAVE_ZLIB
+    if (deflater) {
+        deflateEnd(&deflater->stream);
+    }
+#endif
+}
+
+void ArchiveWriter::append(const void* data, size_t size) {
+    streamCrc = crc32(data, size, streamCrc);
+    buffer.append(static_cast<const char*>(data), size);
+    if (buffer.size() >= ARCHIVE_BUFFER_SIZE) {
+        flush(false);
+    }
+}
+
+void ArchiveWriter::flush(bool last) {
+#ifdef HAVE_ZLIB
+    if (deflater) {
+        z_stream& stream = deflater->stream;
+        stream.next_in = reinterpret_cast<Bytef*>(&buffer[0]);
+        stream.avail_in = static_cast<uInt>(buffer.size());
+        int mode = last ? Z_FINISH : Z_NO_FLUSH;
+        int result;
+        do {
+            stream.next_out = reinterpret_cast<Bytef*>(&deflater->output[0]);
+            stream.avail_out = static_cast<uInt>(deflater->output.size());
+            result = deflate(&stream, mode);
+            if (result == Z_STREAM_ERROR) {
+                throw std::runtime_error("Ошибка сжатия архива");
+            }
+            size_t produced = deflater->output.size() - stream.avail_out;
+            file.write(deflater->output.data(), static_cast<std::streamsize>(produced));
+        } while (stream.avail_out == 0 || (last && result != Z_STREAM_END));
+        buffer.clear();
+        if (!file) {
+            throw std::runtime_error("Ошибка записи архива");
+        }
+        return;
+    }
+#endif
+    (void)last;
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+    if (!file) {
+        throw std::runtime_error("Ошибка записи архива");
+    }
+}
+
+void ArchiveWriter::add(const Note& note) {
+    std::string record;
+    std::string tags = joinTags(note.tags);
+    record.reserve(44 + note.title.size() + note.category.size() +
+                   note.creationDate.size() + tags.size() + note.content.size());
+    record.push_back('N');
+    putU32(record, static_cast<uint32_t>(note.id));
+    putU32(record, static_cast<uint32_t>(note.title.size()));
+    record += note.title;
+    putU32(record, static_cast<uint32_t>(note.category.size()));
+    record += note.category;
+    putU32(record, static_cast<uint32_t>(note.creationDate.size()));
+    record += note.creationDate;
+    putU64(record, static_cast<uint64_t>(note.createdAt));
+    putU32(record, static_cast<uint32_t>(tags.size()));
+    record += tags;
+    putU64(record, note.content.size());
+    record += note.content;
+    putU32(record, crc32String(record));
+    
+    append(record.data(), record.size());
+    noteCount++;
+}
+
+void ArchiveWriter::finish() {
+    if (finished) {
+        return;
+    }
+    
+    std::string trailer;
+    trailer.push_back('E');
+    putU64(trailer, noteCount);
+    putU32(trailer, streamCrc);
+    append(trailer.data(), trailer.size());
+    
+    flush(true);
+    file.close();
+    finished = true;
+}
+
+// ===== ЧТЕНИЕ =====
+
+#ifdef HAVE_ZLIB
+struct ArchiveReader::Inflater {
+    z_stream stream;
+    std::string input;
+    bool ended;
+};
+#else
+struct ArchiveReader::Inflater {};
+#endif
+
+ArchiveReader::ArchiveReader(const std::string& path)
+    : position(0), streamCrc(0), noteCount(0), version(0), compressed(false), finished(false) {
+    file.open(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Не удалось открыть файл архива: " + path);
+    }
+    
+    unsigned char header[12];
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (file.gcount() != sizeof(header) || std::memcmp(header, ARCHIVE_MAGIC, ARCHIVE_MAGIC_PREFIX) != 0) {
+        throw std::runtime_error("Файл не является архивом заметок");
+    }
+    version = (header[6] - '0') * 10 + (header[7] - '0');
+    if (version < 1 || version > 3) {
+        throw std::runtime_error("Неподдерживаемая версия архива");
+    }
+    
+    uint32_t flags = getU32(header + 8);
+    compressed = (flags & ARCHIVE_FLAG_COMPRESSED) != 0;
+    if (compressed) {
+#ifdef HAVE_ZLIB
+        inflater = std::make_unique<Inflater>();
+        std::memset(&inflater->stream, 0, sizeof(inflater->stream));
+        if (inflateInit(&inflater->stream) != Z_OK) {
+            throw std::runtime_error("Ошибка инициализации zlib");
+        }
+        inflater->input.resize(ARCHIVE_BUFFER_SIZE);
+        inflater->ended = false;
+#else
+        throw std::runtime_error("Архив сжат, а программа собрана без поддержки zlib");
+#endif
+    }
+}
+
+ArchiveReader::~ArchiveReader() {
+#ifdef HAVE_ZLIB
+    if (inflater) {
+        inflateEnd(&inflater->stream);
+    }
+#endif
+}
+
+bool ArchiveReader::fill() {
+    // Непрочитанный остаток переносится в начало буфера
+    buffer.erase(0, position);
+    position = 0;
+    size_t oldSize = buffer.size();
+    
+#ifdef HAVE_ZLIB
+    if (inflater) {
+        if (inflater->ended) {
+            return false;
+        }
+        z_stream& stream = inflater->stream;
+        buffer.resize(oldSize + ARCHIVE_BUFFER_SIZE);
+        stream.next_out = reinterpret_cast<Bytef*>(&buffer[oldSize]);
+        stream.avail_out = static_cast<uInt>(ARCHIVE_BUFFER_SIZE);
+        
+        while (stream.avail_out > 0) {
+            if (stream.avail_in == 0) {
+                file.read(&inflater->input[0], static_cast<std::streamsize>(inflater->input.size()));
+                stream.next_in = reinterpret_cast<Bytef*>(&inflater->input[0]);
+                stream.avail_in = static_cast<uInt>(file.gcount());
+                if (stream.avail_in == 0) {
+                    break;
+                }
+            }
+            int result = inflate(&stream, Z_NO_FLUSH);
+            if (result == Z_STREAM_END) {
+                inflater->ended = true;
+                break;
+            }
+            if (result != Z_OK) {
+                throw std::runtime_error("Сжатые данные архива повреждены");
+            }
+        }
+        buffer.resize(oldSize + ARCHIVE_BUFFER_SIZE - stream.avail_out);
+        return buffer.size() > oldSize;
+    }
+#endif
+    
+    buffer.resize(oldSize + ARCHIVE_BUFFER_SIZE);
+    file.read(&buffer[oldSize], static_cast<std::streamsize>(ARCHIVE_BUFFER_SIZE));
+    buffer.resize(oldSize + static_cast<size_t>(file.gcount()));
+    return buffer.size() > oldSize;
+}
+
+void ArchiveReader::read(void* data, size_t size) {
+    char* out = static_cast<char*>(data);
+    while (size > 0) {
+        if (position == buffer.size() && !fill()) {
+            throw std::runtime_error("Архив обрывается до завершающей записи");
+        }
+        size_t chunk = std::min(size, buffer.size() - position);
+        std::memcpy(out, buffer.data() + position, chunk);
+        streamCrc = crc32(out, chunk, streamCrc);
+        position += chunk;
+        out += chunk;
+        size -= chunk;
+    }
+}
+
+bool ArchiveReader::next(Note& note) {
+    if (finished) {
+        return false;
+    }
+    
+    uint32_t crcBefore = streamCrc;
+    char tag;
+    read(&tag, 1);
+    
+    if (tag == 'E') {
+        unsigned char trailer[12];
+        read(trailer, sizeof(trailer));
+        if (getU64(trailer) != noteCount || getU32(trailer + 8) != crcBefore) {
+            throw std::runtime_error("Контрольная сумма архива не совпадает");
+        }
+        finished = true;
+        return false;
+    }
+    if (tag != 'N') {
+        throw std::runtime_error("Неизвестный тип записи в архиве");
+    }
+    
+    uint32_t recordCrc = crc32(&tag, 1);
+    auto readU32 = [&]() {
+        unsigned char bytes[4];
+        read(bytes, 4);
+        recordCrc = crc32(bytes, 4, recordCrc);
+        return getU32(bytes);
+    };
+    auto readString = [&](std::string& out, uint64_t length) {
+        if (length > ARCHIVE_MAX_FIELD) {
+            throw std::runtime_error("Недопустимая длина поля в архиве");
+        }
+        out.resize(static_cast<size_t>(length));
+        if (length > 0) {
+            read(&out[0], out.size());
+            recordCrc = crc32String(out, recordCrc);
+        }
+    };
+    
+    note.id = static_cast<int>(readU32());
+    readString(note.title, readU32());
+    readString(note.category, readU32());
+    readString(note.creationDate, readU32());
+    if (version >= 3) {
+        unsigned char timeBytes[8];
+        read(timeBytes, 8);
+        recordCrc = crc32(timeBytes, 8, recordCrc);
+        note.createdAt = static_cast<int64_t>(getU64(timeBytes));
+    } else {
+        note.createdAt = dateTimestamp(note.creationDate);
+    }
+    note.tags.clear();
+    if (version >= 2) {
+        std::string tags;
+        readString(tags, readU32());
+        note.tags = parseTags(tags);
+    }
+    
+    unsigned char lengthBytes[8];
+    read(lengthBytes, 8);
+    recordCrc = crc32(lengthBytes, 8, recordCrc);
+    readString(note.content, getU64(lengthBytes));
+    
+    unsigned char crcBytes[4];
+    read(crcBytes, 4);
+    if (getU32(crcBytes) != recordCrc) {
+        throw std::runtime_error("Контрольная сумма заметки " + std::to_string(note.id) + " не совпадает");
+    }
+    
+    note.filePath.clear();
+    noteCount++;
+    return true;
+}
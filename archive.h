@@ -0,0 +1,82 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "note.h"
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+// Архив хранилища: метаданные и тексты всех заметок в одном потоковом файле.
+//
+// Формат (все числа little-endian):
+//   заголовок  "TMARCH03" + u32 флаги (бит 0 - поток сжат zlib)
+//   заметка    'N' u32 id, u32+байты название, тема, дата, u64 время создания
+//              (мкс), u32+байты метки через запятую, u64+байты текст,
+//              u32 CRC-32 записи (от 'N' до конца текста)
+//   конец      'E' u64 число заметок, u32 CRC-32 всего потока записей
+// При сжатии через zlib проходит все, что идет после заголовка.
+// Архивы "TMARCH01" (без меток) и "TMARCH02" (без времени создания) тоже
+// читаются; время создания в них - начало суток даты создания.
+
+const uint32_t ARCHIVE_FLAG_COMPRESSED = 1;
+
+// Запись архива; ошибки сообщаются исключением std::runtime_error
+class ArchiveWriter {
+public:
+    ArchiveWriter(const std::string& path, bool compress);
+    ~ArchiveWriter();
+    
+    void add(const Note& note);
+    
+    // Запись завершающей записи и сброс буферов
+    void finish();
+    
+    uint64_t getNoteCount() const { return noteCount; }
+    
+private:
+    struct Deflater;
+    
+    std::ofstream file;
+    std::string buffer;                 // Несжатые данные до сброса
+    std::unique_ptr<Deflater> deflater; // Состояние zlib (если сжатие включено)
+    uint32_t streamCrc;                 // CRC-32 всего потока записей
+    uint64_t noteCount;
+    bool finished;
+    
+    void append(const void* data, size_t size);
+    void flush(bool last);
+};
+
+// Чтение архива; поврежденные данные дают исключение std::runtime_error
+class ArchiveReader {
+public:
+    explicit ArchiveReader(const std::string& path);
+    ~ArchiveReader();
+    
+    // Следующая заметка; false после завершающей записи
+    bool next(Note& note);
+    
+    bool isCompressed() const { return compressed; }
+    
+private:
+    struct Inflater;
+    
+    std::ifstream file;
+    std::string buffer;                 // Прочитанные (распакованные) данные
+    size_t position;                    // Позиция чтения в buffer
+    std::unique_ptr<Inflater> inflater;
+    uint32_t streamCrc;
+    uint64_t noteCount;
+    int version;                        // Версия формата из заголовка
+    bool compressed;
+    bool finished;
+    
+    void read(void* data, size_t size);
+    bool fill();
+};
+
+// Проверка, собрана ли программа с поддержкой сжатия
+bool archiveCompressionAvailable();
+
+#endif // ARCHIVE_H
@@ -0,0 +1,141 @@
+#include "async_note.h"
+#include "tags.h"
+#include "validation.h"
+#include <cstdio>
+
+AsyncNoteManager::AsyncNoteManager(NoteManager& manager, size_t ioThreads)
+    : manager(manager), owner(1), io(ioThreads), commitRunning(false), writes(0) {}
+
+AsyncNoteManager::~AsyncNoteManager() {
+    // Запись метаданных переходит между пулами - ждем, пока оба не опустеют
+    do {
+        io.wait();
+        owner.wait();
+    } while (commitRunning);
+}
+
+AsyncNoteManager::CommitAwaiter AsyncNoteManager::commitMetadata() {
+    return CommitAwaiter{*this, true, nullptr};
+}
+
+void AsyncNoteManager::startCommit() {
+    // Метаданные собираются во владельце, записываются в пуле ввода-вывода
+    commitRunning = true;
+    std::vector<CommitAwaiter*> batch = std::move(commitWaiters);
+    commitWaiters.clear();
+    std::string data = manager.formatMetadata();
+    uint64_t generation = manager.generation;
+    
+    io.submit([this, batch = std::move(batch), data = std::move(data), generation]() {
+        bool success = true;
+        try {
+            manager.writeMetadata(data, generation);
+        } catch (const std::exception&) {
+            success = false;
+        }
+        writes++;
+        
+        owner.submit([this, batch, success]() {
+            // Следующая запись начинается до продолжения операций этой
+            commitRunning = false;
+            if (!commitWaiters.empty()) {
+                startCommit();
+            }
+            for (CommitAwaiter* waiter : batch) {
+                std::coroutine_handle<> handle = waiter->handle;
+                waiter->success = success;
+                handle.resume();
+            }
+        });
+    });
+}
+
+Task<AsyncResult> AsyncNoteManager::addNote(std::string title, std::string category, std::string content,
+                                            std::vector<std::string> tags) {
+    AsyncResult result;
+    std::vector<std::string> normalized = normalizeTags(tags);
+    if (checkNoteTitle(title) != ValidationError::None || checkNoteCategory(category) != ValidationError::None ||
+        checkNoteContent(content) != ValidationError::None || checkNoteTags(normalized) != ValidationError::None) {
+        result.status = OpStatus::InvalidInput;
+        co_return result;
+    }
+    
+    co_await resumeOn(owner);
+    Note note;
+    result.status = manager.reserveNote(manager.nextId, title, category, content, normalized, note);
+    if (!result.ok()) {
+        co_return result;
+    }
+    result.id = note.id;
+    
+    // Файлы текста и заметки пишутся, пока владелец занят другими операциями
+    co_await resumeOn(io);
+    bool written = true;
+    try {
+        manager.saveNoteToFile(note);
+    } catch (const std::exception&) {
+        written = false;
+    }
+    
+    co_await resumeOn(owner);
+    if (!written) {
+        manager.cancelNote(note);
+        result.status = OpStatus::IoError;
+        co_return result;
+    }
+    manager.commitNote(std::move(note));
+    if (!co_await commitMetadata()) {
+        result.status = OpStatus::IoError;
+    }
+    co_return result;
+}
+
+Task<std::optional<Note>> AsyncNoteManager::getNote(int id) {
+    co_await resumeOn(owner);
+    const Note* note = manager.getNote(id);
+    if (note == nullptr) {
+        co_return std::nullopt;
+    }
+    co_return *note;
+}
+
+Task<AsyncResult> AsyncNoteManager::deleteNote(int id) {
+    AsyncResult result;
+    result.id = id;
+    
+    co_await resumeOn(owner);
+    NoteNode* node = manager.findNode(id);
+    if (node == nullptr) {
+        result.status = OpStatus::NotFound;
+        co_return result;
+    }
+    if (manager.getDeleteMode() == DeleteMode::Trash) {
+        // Корзина: одна строка в журнале, файлы и метаданные не меняются
+        if (!manager.trashNodes({node})) {
+            result.status = OpStatus::IoError;
+        }
+        co_return result;
+    }
+    
+    Note removed = manager.detachNote(node);
+    co_await resumeOn(io);
+    std::remove(removed.filePath.c_str());
+    
+    // Текст удаляется владельцем: только он знает число ссылок
+    co_await resumeOn(owner);
+    manager.bodies.removeIfUnused(removed.bodyHash);
+    if (!co_await commitMetadata()) {
+        result.status = OpStatus::IoError;
+    }
+    co_return result;
+}
+
+Task<std::vector<int>> AsyncNoteManager::findByContent(std::string text) {
+    co_await resumeOn(owner);
+    co_return manager.findByContent(text);
+}
+
+Task<std::vector<int>> AsyncNoteManager::findByCategory(std::string category) {
+    co_await resumeOn(owner);
+    co_return manager.findByCategory(category);
+}
@@ -0,0 +1,86 @@
+#ifndef ASYNC_NOTE_H
+#define ASYNC_NOTE_H
+
+#include "note.h"
+#include "task.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <coroutine>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Итог асинхронной операции (сообщения в консоль не выводятся)
+struct AsyncResult {
+    OpStatus status = OpStatus::Ok;
+    int id = 0;                 // ID добавленной или удаленной заметки
+
+    bool ok() const { return status == OpStatus::Ok; }
+};
+
+// Асинхронный API поверх NoteManager на сопрограммах C++20 (task.h).
+//
+// Заметки, списки и индексы NoteManager меняются только в потоке-владельце,
+// поэтому операции не мешают друг другу; файлы заметок и текстов пишутся и
+// удаляются в пуле ввода-вывода, пока владелец обслуживает другие операции.
+// Файл метаданных записывается групповой фиксацией: операции, завершившиеся
+// за время записи, фиксируются следующей одной записью. Операция добавления
+// или удаления завершается, когда метаданные с ней записаны на диск.
+//
+// Пока существует AsyncNoteManager, NoteManager используется только через него.
+class AsyncNoteManager {
+public:
+    // ioThreads = 0 - по числу аппаратных потоков
+    explicit AsyncNoteManager(NoteManager& manager, size_t ioThreads = 0);
+    // Дожидается фоновой записи метаданных
+    ~AsyncNoteManager();
+
+    AsyncNoteManager(const AsyncNoteManager&) = delete;
+    AsyncNoteManager& operator=(const AsyncNoteManager&) = delete;
+
+    // Аргументы передаются по значению: задача ленивая и может начаться
+    // позже, чем закончится выражение вызова
+    Task<AsyncResult> addNote(std::string title, std::string category, std::string content,
+                              std::vector<std::string> tags = {});
+    Task<std::optional<Note>> getNote(int id);
+    Task<AsyncResult> deleteNote(int id);
+    Task<std::vector<int>> findByContent(std::string text);
+    Task<std::vector<int>> findByCategory(std::string category);
+
+    // Число записей файла метаданных (для оценки групповой фиксации)
+    uint64_t metadataWrites() const { return writes; }
+
+private:
+    NoteManager& manager;
+    ThreadPool owner;           // Поток-владелец NoteManager
+    ThreadPool io;              // Запись и удаление файлов
+
+    // Групповая фиксация метаданных (поля меняются только в потоке-владельце)
+    struct CommitAwaiter;
+    std::vector<CommitAwaiter*> commitWaiters;      // Ждут следующей записи
+    std::atomic<bool> commitRunning;                // Запись в пуле ввода-вывода (читает и деструктор)
+    std::atomic<uint64_t> writes;
+
+    // Ожидание записи метаданных с изменениями текущей операции
+    CommitAwaiter commitMetadata();
+    void startCommit();
+};
+
+// Ожидающий фиксации: продолжается после записи метаданных
+struct AsyncNoteManager::CommitAwaiter {
+    AsyncNoteManager& owner;
+    bool success = true;
+    std::coroutine_handle<> handle;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> awaiting) {
+        handle = awaiting;
+        owner.commitWaiters.push_back(this);
+        if (!owner.commitRunning) {
+            owner.startCommit();
+        }
+    }
+    bool await_resume() const noexcept { return success; }
+};
+
+#endif // ASYNC_NOTE_H
@@ -0,0 +1,1433 @@
+#include "note.h"
+#include "fileio.h"
+#include "title_index.h"
+#include "fuzzy.h"
+#include "utf8.h"
+#include "scan.h"
+#include "columns.h"
+#include "archive.h"
+#include "timestamp.h"
+#include "validation.h"
+#include "tags.h"
+#include "async_note.h"
+#include "similar.h"
+#include <thread>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <cstdlib>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+// Директория для временных данных бенчмарков
+const std::string BENCH_DIR = "bench_data";
+
+// Замер времени выполнения функции в миллисекундах
+template <typename Func>
+double measureMs(Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Вывод строки результата
+void printResult(const std::string& name, double ms, size_t operations) {
+    std::cout.width(44);
+    std::cout << std::left << name << " | ";
+    std::cout.width(10);
+    std::cout << std::left << ms << " мс | ";
+    if (operations > 0) {
+        std::cout << (ms * 1000.0 / operations) << " мкс/оп";
+    }
+    std::cout << std::endl;
+}
+
+// Защита от удаления результата оптимизатором (составное присваивание
+// volatile-переменной в C++20 устарело, поэтому benchSink = benchSink + x)
+volatile size_t benchSink = 0;
+
+// ===== ЧТЕНИЕ ТЕКСТА ЗАМЕТКИ =====
+
+// Прежняя реализация: построчное чтение с конкатенацией
+std::string legacyLoadNoteContent(const std::string& filePath) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+        return "";
+    }
+    
+    std::string content;
+    std::string line;
+    bool contentStarted = false;
+    
+    for (int i = 0; i < 4; i++) {
+        std::getline(file, line);
+    }
+    
+    while (std::getline(file, line)) {
+        if (contentStarted) {
+            content += "\n";
+        }
+        content += line;
+        contentStarted = true;
+    }
+    
+    return content;
+}
+
+void benchNoteBodyReader() {
+    std::cout << "\n--- Чтение текста заметки ---" << std::endl;
+    
+    const size_t sizes[] = {1024, 4096, 16384, 65536};
+    const int iterations = 2000;
+    
+    for (size_t size : sizes) {
+        std::string path = "body_" + std::to_string(size) + ".txt";
+        {
+            std::ofstream file(path);
+            file << "Название: Тест\nТема: Бенчмарк\nДата: 2026-01-01\n\n";
+            std::string line = "Строка текста заметки для проверки скорости чтения.\n";
+            std::string body;
+            while (body.size() < size) {
+                body += line;
+            }
+            file << body;
+        }
+        
+        std::string label = std::to_string(size / 1024) + " КБ";
+        
+        double legacyMs = measureMs([&]() {
+            for (int i = 0; i < iterations; i++) {
+                benchSink = benchSink + legacyLoadNoteContent(path).size();
+            }
+        });
+        printResult("построчно, " + label, legacyMs, iterations);
+        
+        double bulkMs = measureMs([&]() {
+            for (int i = 0; i < iterations; i++) {
+                benchSink = benchSink + readNoteBody(path).size();
+            }
+        });
+        printResult("одним чтением, " + label, bulkMs, iterations);
+    }
+}
+
+// ===== ПРЕФИКСНЫЙ ИНДЕКС НАЗВАНИЙ =====
+
+// Синтетические названия из кириллических и латинских слов
+std::vector<std::string> makeTitles(size_t count, unsigned seed) {
+    const char* words[] = {
+        "Проект", "отчет", "Встреча", "план", "Задача", "идея", "Покупки",
+        "звонок", "Report", "draft", "Meeting", "notes", "Бюджет", "итоги"
+    };
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+    
+    std::mt19937 rng(seed);
+    std::vector<std::string> titles;
+    titles.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        std::string title = words[rng() % wordCount];
+        title += " ";
+        title += words[rng() % wordCount];
+        title += " " + std::to_string(i);
+        titles.push_back(title);
+    }
+    return titles;
+}
+
+void benchTitlePrefixIndex(size_t count) {
+    std::cout << "\n--- Префиксный индекс названий (" << count << ") ---" << std::endl;
+    
+    std::vector<std::string> titles = makeTitles(count, 42);
+    TitleIndex index;
+    
+    double buildMs = measureMs([&]() {
+        for (size_t i = 0; i < titles.size(); i++) {
+            index.append(titles[i], static_cast<int>(i));
+        }
+        index.finalize();
+    });
+    printResult("построение", buildMs, count);
+    
+    const char* prefixes[] = {"про", "Отчет з", "m", "Встреча Бюджет 1", "Бю", "notes draft 99"};
+    const int queries = 100000;
+    double queryMs = measureMs([&]() {
+        for (int i = 0; i < queries; i++) {
+            benchSink = benchSink + index.complete(prefixes[i % 6], 10).size();
+        }
+    });
+    printResult("top-10 по префиксу", queryMs, queries);
+    
+    // Прежний способ: линейный обход всех названий
+    const int scans = 20;
+    double scanMs = measureMs([&]() {
+        for (int i = 0; i < scans; i++) {
+            std::string prefix = prefixes[i % 6];
+            size_t found = 0;
+            for (const std::string& title : titles) {
+                if (title.compare(0, prefix.size(), prefix) == 0 && ++found >= 10) {
+                    break;
+                }
+            }
+            benchSink = benchSink + found;
+        }
+    });
+    printResult("линейный обход (с учетом регистра)", scanMs, scans);
+    
+    // Вставки по одной, как при addNote: с учетом слияний добавок
+    const int updates = 100000;
+    std::vector<std::string> added = makeTitles(updates, 43);
+    double insertMs = measureMs([&]() {
+        for (int i = 0; i < updates; i++) {
+            index.insert(added[i], static_cast<int>(count) + i);
+        }
+    });
+    printResult("вставка", insertMs, updates);
+    
+    double mixedMs = measureMs([&]() {
+        for (int i = 0; i < queries; i++) {
+            benchSink = benchSink + index.complete(prefixes[i % 6], 10).size();
+        }
+    });
+    printResult("top-10 после вставок", mixedMs, queries);
+    
+    // Удаления по одной, как при deleteNote и переименовании: вразброс по индексу
+    std::mt19937 rng(44);
+    double eraseMs = measureMs([&]() {
+        for (int i = 0; i < updates; i++) {
+            size_t victim = rng() % count;
+            benchSink = benchSink + index.erase(titles[victim], static_cast<int>(victim));
+        }
+    });
+    printResult("удаление", eraseMs, updates);
+    
+    double erasedQueryMs = measureMs([&]() {
+        for (int i = 0; i < queries; i++) {
+            benchSink = benchSink + index.complete(prefixes[i % 6], 10).size();
+        }
+    });
+    printResult("top-10 после удалений", erasedQueryMs, queries);
+}
+
+// ===== НЕЧЕТКИЙ ПОИСК =====
+
+void benchFuzzySearch(size_t count) {
+    std::cout << "\n--- Нечеткий поиск по названиям (" << count << ") ---" << std::endl;
+    
+    std::vector<std::string> titles = makeTitles(count, 7);
+    BKTree tree;
+    
+    double buildMs = measureMs([&]() {
+        for (size_t i = 0; i < titles.size(); i++) {
+            tree.insert(titles[i], static_cast<int>(i));
+        }
+    });
+    printResult("построение BK-дерева", buildMs, count);
+    
+    // Запросы с одной-двумя опечатками относительно существующих названий
+    std::vector<std::string> queries;
+    std::mt19937 rng(11);
+    for (int i = 0; i < 50; i++) {
+        std::u32string title = decodeUtf8(foldCaseUtf8(titles[rng() % titles.size()]));
+        title[rng() % title.size()] = U'ж';
+        if (i % 2 == 0) {
+            title.erase(rng() % title.size(), 1);
+        }
+        std::string query;
+        for (char32_t cp : title) {
+            appendUtf8(query, cp);
+        }
+        queries.push_back(query);
+    }
+    
+    for (int k = 1; k <= 2; k++) {
+        size_t found = 0;
+        double treeMs = measureMs([&]() {
+            for (const std::string& query : queries) {
+                found += tree.search(query, k).size();
+            }
+        });
+        printResult("BK-дерево, k=" + std::to_string(k), treeMs, queries.size());
+        benchSink = benchSink + found;
+    }
+    
+    // Полный перебор с тем же ограниченным расстоянием
+    std::vector<std::u32string> folded;
+    folded.reserve(titles.size());
+    for (const std::string& title : titles) {
+        folded.push_back(decodeUtf8(foldCaseUtf8(title)));
+    }
+    const size_t bruteQueries = 5;
+    double bruteMs = measureMs([&]() {
+        for (size_t q = 0; q < bruteQueries; q++) {
+            std::u32string query = decodeUtf8(queries[q]);
+            for (const std::u32string& title : folded) {
+                benchSink = benchSink + (boundedEditDistance(query, title, 2) <= 2);
+            }
+        }
+    });
+    printResult("полный перебор, k=2", bruteMs, bruteQueries);
+}
+
+// ===== ВЕКТОРНЫЕ ЯДРА ПРОСМОТРА =====
+
+void benchScanKernels(size_t count) {
+    std::cout << "\n--- Полный просмотр (" << count << " заметок) ---" << std::endl;
+    std::cout << "Процессор поддерживает: " << scanLevelName(detectScanLevel()) << std::endl;
+    
+    // Метаданные в виде прежнего связного списка и в виде столбцов
+    const char* categoryNames[] = {"Работа", "Быт", "Личное", "Учеба", "Здоровье", "Финансы", "Проекты", "Идеи"};
+    std::vector<std::string> dates;
+    for (int month = 1; month <= 12; month++) {
+        for (int day = 1; day <= 28; day++) {
+            char date[16];
+            std::snprintf(date, sizeof(date), "2025-%02d-%02d", month, day);
+            dates.push_back(date);
+        }
+    }
+    
+    std::mt19937 rng(3);
+    std::vector<NoteNode*> nodes;
+    NoteColumns columns;
+    NoteNode* head = nullptr;
+    NoteNode* tail = nullptr;
+    for (size_t i = 0; i < count; i++) {
+        Note note;
+        note.id = static_cast<int>(i + 1);
+        note.category = categoryNames[rng() % 8];
+        note.creationDate = dates[rng() % dates.size()];
+        columns.add(note.id, note.category, note.creationDate);
+        
+        NoteNode* node = new NoteNode(note);
+        if (tail == nullptr) {
+            head = tail = node;
+        } else {
+            tail->next = node;
+            node->prev = tail;
+            tail = node;
+        }
+        nodes.push_back(node);
+    }
+    
+    const int repeats = 5;
+    double listMs = measureMs([&]() {
+        for (int r = 0; r < repeats; r++) {
+            size_t found = 0;
+            for (NoteNode* current = head; current != nullptr; current = current->next) {
+                if (current->data.category == "Учеба") {
+                    found++;
+                }
+            }
+            benchSink = benchSink + found;
+        }
+    });
+    printResult("тема: обход списка (прежний)", listMs, repeats);
+    
+    const ScanLevel levels[] = {ScanLevel::Scalar, ScanLevel::SSE42, ScanLevel::AVX2};
+    for (ScanLevel level : levels) {
+        setScanLevel(level);
+        std::string name = scanLevelName(getScanLevel());
+        double columnMs = measureMs([&]() {
+            for (int r = 0; r < repeats; r++) {
+                benchSink = benchSink + columns.selectCategory("Учеба").size();
+            }
+        });
+        printResult("тема: столбец, " + name, columnMs, repeats);
+        
+        double rangeMs = measureMs([&]() {
+            for (int r = 0; r < repeats; r++) {
+                benchSink = benchSink + columns.selectDateRange("2025-03-01", "2025-04-15").size();
+            }
+        });
+        printResult("диапазон дат: столбец, " + name, rangeMs, repeats);
+    }
+    
+    // Чистая пропускная способность ядра на столбце из 64 млн значений
+    std::vector<uint32_t> column(64 * 1024 * 1024 / 4 * 4);
+    for (size_t i = 0; i < column.size(); i++) {
+        column[i] = static_cast<uint32_t>(i % 1000);
+    }
+    std::vector<uint32_t> rows;
+    rows.reserve(column.size() / 1000 + 16);
+    for (ScanLevel level : levels) {
+        setScanLevel(level);
+        double ms = measureMs([&]() {
+            rows.clear();
+            filterEqual(column.data(), column.size(), 500, rows);
+        });
+        double gbPerSec = column.size() * 4.0 / (ms / 1000.0) / 1e9;
+        std::cout << "filterEqual 256 МБ, " << scanLevelName(getScanLevel()) << ": "
+                  << ms << " мс, " << gbPerSec << " ГБ/с" << std::endl;
+    }
+    
+    // Поиск подстроки в текстах заметок по 4 КБ
+    std::vector<std::string> bodies;
+    size_t bodyCount = std::max<size_t>(count / 20, 1);
+    std::string line = "Обсудили план работ на квартал, сроки и бюджет проекта. ";
+    for (size_t i = 0; i < bodyCount; i++) {
+        std::string body;
+        while (body.size() < 4096) {
+            body += line;
+        }
+        if (i % 100 == 0) {
+            body += "редкое совпадение";
+        }
+        bodies.push_back(body);
+    }
+    for (ScanLevel level : levels) {
+        setScanLevel(level);
+        size_t found = 0;
+        double ms = measureMs([&]() {
+            for (const std::string& body : bodies) {
+                found += findSubstring(body, "редкое совпадение") != std::string_view::npos;
+            }
+        });
+        double gbPerSec = bodies.size() * 4096.0 / (ms / 1000.0) / 1e9;
+        std::cout << "подстрока в " << bodies.size() << " текстах, " << scanLevelName(getScanLevel())
+                  << ": " << ms << " мс, " << gbPerSec << " ГБ/с" << std::endl;
+        benchSink = benchSink + found;
+    }
+    setScanLevel(detectScanLevel());
+    
+    for (NoteNode* node : nodes) {
+        delete node;
+    }
+}
+
+// ===== ПАРАЛЛЕЛЬНЫЙ ПОИСК =====
+
+// Создание хранилища напрямую в формате NoteManager (без addNote,
+// который перезаписывает метаданные после каждой заметки)
+void generateStore(size_t count, size_t bodySize) {
+    std::filesystem::create_directory("notes");
+    std::ofstream metadata("notes_metadata.dat");
+    
+    std::string line = "Обсудили план работ на квартал, сроки и бюджет проекта. ";
+    std::string body;
+    while (body.size() < bodySize) {
+        body += line;
+    }
+    
+    for (size_t i = 1; i <= count; i++) {
+        std::string path = "notes/" + std::to_string(i) + "_note.txt";
+        std::ofstream file(path);
+        file << "Название: Заметка " << i << "\nТема: Работа\nДата: 2026-01-01\n\n" << body;
+        if (i % 1000 == 0) {
+            file << " редкое совпадение";
+        }
+        metadata << i << "|Заметка " << i << "|Работа|2026-01-01|" << path << "\n";
+    }
+}
+
+void benchParallelSearch(size_t count) {
+    std::cout << "\n--- Параллельный поиск по тексту (" << count << " заметок по 4 КБ) ---" << std::endl;
+    
+    generateStore(count, 4096);
+    NoteManager manager;
+    double loadMs = measureMs([&]() { manager.loadFromFile(); });
+    printResult("загрузка хранилища", loadMs, count);
+    
+    size_t maxThreads = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    std::cout << "Аппаратных потоков: " << maxThreads << std::endl;
+    
+    double singleMs = 0;
+    for (size_t threads = 1; threads <= std::max<size_t>(maxThreads, 4); threads *= 2) {
+        double firstMs = -1;
+        auto start = std::chrono::steady_clock::now();
+        size_t found = 0;
+        double ms = measureMs([&]() {
+            found = manager.parallelSearchContent("редкое совпадение", [&](const Note&) {
+                if (firstMs < 0) {
+                    firstMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start).count();
+                }
+            }, threads);
+        });
+        if (threads == 1) {
+            singleMs = ms;
+        }
+        double gbPerSec = count * 4096.0 / (ms / 1000.0) / 1e9;
+        std::cout << "потоков: " << threads << ", " << ms << " мс, " << gbPerSec
+                  << " ГБ/с, ускорение x" << (singleMs / ms)
+                  << ", первый результат через " << firstMs << " мс (найдено " << found << ")" << std::endl;
+    }
+    
+    std::error_code ec;
+    std::filesystem::remove_all("notes", ec);
+    std::filesystem::remove("notes_metadata.dat", ec);
+}
+
+// ===== АРХИВЫ =====
+
+void benchArchive(size_t count) {
+    std::cout << "\n--- Экспорт и импорт архива (" << count << " заметок по 4 КБ) ---" << std::endl;
+    
+    generateStore(count, 4096);
+    double megabytes = count * 4096.0 / (1024.0 * 1024.0);
+    
+    {
+        NoteManager manager;
+        manager.loadFromFile();
+        
+        double snapshotMs = measureMs([&]() { benchSink = benchSink + manager.snapshot().size(); });
+        printResult("снимок в памяти (блокировка записи)", snapshotMs, count);
+        
+        for (int compress = 0; compress <= 1; compress++) {
+            if (compress && !archiveCompressionAvailable()) {
+                continue;
+            }
+            std::string path = compress ? "store.tma.z" : "store.tma";
+            double ms = measureMs([&]() { manager.exportArchive(path, compress != 0); });
+            std::cout << "экспорт" << (compress ? " со сжатием" : "") << ": " << ms << " мс, "
+                      << (megabytes / (ms / 1000.0)) << " МБ/с, размер "
+                      << std::filesystem::file_size(path) / 1024 << " КБ" << std::endl;
+        }
+    }
+    
+    for (int compress = 0; compress <= 1; compress++) {
+        if (compress && !archiveCompressionAvailable()) {
+            continue;
+        }
+        std::string path = compress ? "store.tma.z" : "store.tma";
+        
+        // Только чтение и проверка контрольных сумм
+        double readMs = measureMs([&]() {
+            ArchiveReader reader(path);
+            Note note;
+            while (reader.next(note)) {
+                benchSink = benchSink + note.content.size();
+            }
+        });
+        std::cout << "чтение архива" << (compress ? " со сжатием" : "") << ": " << readMs << " мс, "
+                  << (megabytes / (readMs / 1000.0)) << " МБ/с" << std::endl;
+        
+        // Полный импорт в пустое хранилище (с записью файлов заметок)
+        std::error_code ec;
+        std::filesystem::remove_all("notes", ec);
+        std::filesystem::remove_all("bodies", ec);
+        std::filesystem::remove("notes_metadata.dat", ec);
+        NoteManager manager;
+        std::streambuf* original = std::cout.rdbuf(nullptr);
+        double importMs = measureMs([&]() { manager.importArchive(path); });
+        std::cout.rdbuf(original);
+        std::cout << "импорт" << (compress ? " со сжатием" : "") << ": " << importMs << " мс, "
+                  << (megabytes / (importMs / 1000.0)) << " МБ/с" << std::endl;
+    }
+    
+    std::error_code ec;
+    std::filesystem::remove_all("notes", ec);
+    std::filesystem::remove_all("bodies", ec);
+    std::filesystem::remove("notes_metadata.dat", ec);
+    std::filesystem::remove("store.tma", ec);
+    std::filesystem::remove("store.tma.z", ec);
+}
+
+// ===== СНИМОК ИНДЕКСОВ =====
+
+void benchSnapshot(size_t count) {
+    std::cout << "\n--- Запуск из снимка индексов (" << count << " заметок по 1 КБ) ---" << std::endl;
+    
+    generateStore(count, 1024);
+    
+    {
+        NoteManager manager;
+        double fullMs = measureMs([&]() { manager.loadFromFile(); });
+        printResult("полная загрузка (файлы и индексы)", fullMs, count);
+        
+        double saveMs = measureMs([&]() { manager.saveSnapshot(); });
+        printResult("запись снимка", saveMs, count);
+        std::cout << "размер снимка: "
+                  << std::filesystem::file_size("notes_metadata.dat.snap") / 1024 << " КБ" << std::endl;
+    }
+    
+    {
+        NoteManager manager;
+        double ms = measureMs([&]() { manager.loadFromFile(); });
+        printResult("загрузка из снимка без изменений", ms, count);
+        
+        // Одна новая заметка: поколение метаданных меняется
+        manager.addNote("Новая заметка", "Работа", "Текст");
+    }
+    
+    {
+        NoteManager manager;
+        LoadReport report;
+        double ms = measureMs([&]() { report = manager.loadFromFile(); });
+        printResult("загрузка из снимка + разница", ms, count);
+        std::cout << "перечитано заметок: " << report.refreshed << std::endl;
+    }
+    
+    std::error_code ec;
+    std::filesystem::remove_all("notes", ec);
+    std::filesystem::remove("notes_metadata.dat", ec);
+    std::filesystem::remove("notes_metadata.dat.snap", ec);
+}
+
+// ===== ТЕКУЩАЯ ДАТА =====
+
+// Прежняя реализация: localtime и stringstream на каждый вызов
+std::string legacyGetCurrentDate() {
+    std::time_t now = std::time(nullptr);
+    std::tm* localTime = std::localtime(&now);
+    
+    std::stringstream ss;
+    ss << std::setfill('0')
+       << std::setw(4) << (localTime->tm_year + 1900) << "-"
+       << std::setw(2) << (localTime->tm_mon + 1) << "-"
+       << std::setw(2) << localTime->tm_mday;
+    
+    return ss.str();
+}
+
+void benchCurrentDate(size_t count) {
+    std::cout << "\n--- Текущая дата (" << count << " вызовов) ---" << std::endl;
+    
+    double legacyMs = measureMs([&]() {
+        for (size_t i = 0; i < count; i++) {
+            benchSink = benchSink + legacyGetCurrentDate().size();
+        }
+    });
+    printResult("localtime + stringstream", legacyMs, count);
+    
+    double cachedMs = measureMs([&]() {
+        for (size_t i = 0; i < count; i++) {
+            benchSink = benchSink + currentDate().size();
+        }
+    });
+    printResult("кэш дня + localtime_r", cachedMs, count);
+    
+    double stampMs = measureMs([&]() {
+        for (size_t i = 0; i < count; i++) {
+            benchSink = benchSink + static_cast<size_t>(currentTimestampUs());
+        }
+    });
+    printResult("время в мкс (целое)", stampMs, count);
+    
+    // Одновременные вызовы из нескольких потоков (прежняя версия здесь гонка)
+    const size_t threadCount = 4;
+    double parallelMs = measureMs([&]() {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; t++) {
+            threads.emplace_back([count, threadCount]() {
+                size_t local = 0;
+                for (size_t i = 0; i < count / threadCount; i++) {
+                    local += currentDate().size();
+                }
+                benchSink = benchSink + local;
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    });
+    printResult("кэш дня, 4 потока", parallelMs, count);
+}
+
+// ===== ПРОВЕРКА ТЕКСТА =====
+
+// Прежняя проверка: длина в байтах и поиск видимого символа
+bool legacyValidateContent(const std::string& content) {
+    if (content.empty() || content.length() > 10000) {
+        return false;
+    }
+    for (char c : content) {
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Подсчет символов посимвольным декодированием
+bool decodeValidateContent(const std::string& content) {
+    size_t pos = 0;
+    size_t length = 0;
+    while (pos < content.size()) {
+        size_t start = pos;
+        if (decodeUtf8Char(content, pos) == UTF8_REPLACEMENT &&
+            content.compare(start, 3, "\xEF\xBF\xBD") != 0) {
+            return false;
+        }
+        length++;
+    }
+    return length > 0 && length <= 10000;
+}
+
+void benchValidation(size_t count) {
+    std::cout << "\n--- Проверка текста заметки (" << count << " проверок) ---" << std::endl;
+    
+    // Тексты около 9000 символов: латиница и кириллица (2 байта на букву)
+    std::string ascii;
+    while (ascii.size() < 9000) {
+        ascii += "Meeting notes: budget, deadlines and next steps. ";
+    }
+    std::string cyrillic;
+    while (cyrillic.size() < 18000) {
+        cyrillic += "Обсудили план работ, сроки и бюджет проекта. ";
+    }
+    
+    const std::pair<std::string, const std::string*> inputs[] = {{"латиница", &ascii}, {"кириллица", &cyrillic}};
+    const ScanLevel levels[] = {ScanLevel::Scalar, ScanLevel::SSE42, ScanLevel::AVX2};
+    for (const auto& [label, text] : inputs) {
+        double legacyMs = measureMs([&]() {
+            for (size_t i = 0; i < count; i++) {
+                benchSink = benchSink + legacyValidateContent(*text);
+            }
+        });
+        printResult(label + ": байты (прежняя)", legacyMs, count);
+        
+        double decodeMs = measureMs([&]() {
+            for (size_t i = 0; i < count; i++) {
+                benchSink = benchSink + decodeValidateContent(*text);
+            }
+        });
+        printResult(label + ": посимвольное декодирование", decodeMs, count);
+        
+        for (ScanLevel level : levels) {
+            setScanLevel(level);
+            double ms = measureMs([&]() {
+                for (size_t i = 0; i < count; i++) {
+                    benchSink = benchSink + (checkNoteContent(*text) == ValidationError::None);
+                }
+            });
+            printResult(label + ": checkNoteContent, " + scanLevelName(getScanLevel()), ms, count);
+        }
+    }
+    setScanLevel(detectScanLevel());
+}
+
+// ===== МЕТКИ =====
+
+void benchTags(size_t count) {
+    std::cout << "\n--- Метки: битовые карты (" << count << " заметок) ---" << std::endl;
+    
+    // 64 метки с убывающей частотой: "t0" есть у половины заметок, "t63" - у редких
+    const size_t tagTotal = 64;
+    std::mt19937 rng(42);
+    std::vector<std::vector<std::string>> noteTags(count);
+    for (size_t i = 0; i < count; i++) {
+        for (size_t t = 0; t < tagTotal; t++) {
+            if (rng() % (2 * (t + 1)) == 0) {
+                noteTags[i].push_back("t" + std::to_string(t));
+            }
+        }
+        std::sort(noteTags[i].begin(), noteTags[i].end());
+    }
+    
+    TagIndex index;
+    double buildMs = measureMs([&]() {
+        for (size_t i = 0; i < count; i++) {
+            index.add(static_cast<int>(i + 1), noteTags[i]);
+        }
+    });
+    printResult("построение индекса", buildMs, count);
+    
+    TagQuery query = parseTagQuery("t0 AND t1 AND NOT t2");
+    
+    // Прежний способ - проверка меток каждой заметки
+    size_t scanFound = 0;
+    double scanMs = measureMs([&]() {
+        for (const std::vector<std::string>& tags : noteTags) {
+            auto has = [&tags](const std::string& tag) {
+                return std::binary_search(tags.begin(), tags.end(), tag);
+            };
+            scanFound += has("t0") && has("t1") && !has("t2");
+        }
+    });
+    printResult("A AND B AND NOT C: перебор заметок", scanMs, 1);
+    
+    const int repeats = 100;
+    size_t found = 0;
+    double queryMs = measureMs([&]() {
+        for (int r = 0; r < repeats; r++) {
+            found = index.select(query).cardinality();
+        }
+    });
+    printResult("A AND B AND NOT C: битовые карты", queryMs, repeats);
+    
+    double idsMs = measureMs([&]() {
+        for (int r = 0; r < repeats; r++) {
+            benchSink = benchSink + index.query(query).size();
+        }
+    });
+    printResult("то же со списком ID", idsMs, repeats);
+    
+    TagQuery rare = parseTagQuery("t40 AND t0");
+    double rareMs = measureMs([&]() {
+        for (int r = 0; r < repeats; r++) {
+            benchSink = benchSink + index.select(rare).cardinality();
+        }
+    });
+    printResult("редкая AND частая метка", rareMs, repeats);
+    
+    double countsMs = measureMs([&]() {
+        for (int r = 0; r < repeats; r++) {
+            benchSink = benchSink + index.counts().size();
+        }
+    });
+    printResult("число заметок по меткам", countsMs, repeats);
+    
+    RoaringBitmap within = index.select(query);
+    double facetsMs = measureMs([&]() {
+        for (int r = 0; r < repeats; r++) {
+            benchSink = benchSink + index.counts(within).size();
+        }
+    });
+    printResult("фасеты среди результатов запроса", facetsMs, repeats);
+    
+    std::cout << "найдено: " << found << " (перебором: " << scanFound << ")" << std::endl;
+}
+
+// ===== АГРЕГАЦИЯ =====
+
+void benchAggregation(size_t count) {
+    std::cout << "\n--- Число заметок по темам и неделям (" << count << " заметок) ---" << std::endl;
+    
+    // 40 тем и даты за три года
+    const size_t categoryTotal = 40;
+    std::filesystem::create_directory("notes");
+    {
+        std::ofstream metadata("notes_metadata.dat");
+        for (size_t i = 1; i <= count; i++) {
+            std::string path = "notes/" + std::to_string(i) + "_note.txt";
+            std::string category = "Тема " + std::to_string(i * 7 % categoryTotal);
+            char date[16];
+            std::snprintf(date, sizeof(date), "%04zu-%02zu-%02zu", 2023 + i % 3, 1 + i % 12, 1 + i % 28);
+            std::ofstream file(path);
+            file << "Название: Заметка " << i << "\nТема: " << category << "\nДата: " << date << "\n\nТекст";
+            metadata << i << "|Заметка " << i << "|" << category << "|" << date << "|" << path << "\n";
+        }
+    }
+    
+    NoteManager manager;
+    manager.loadFromFile();
+    
+    // Прежний способ: отдельный запрос на каждую тему
+    const int repeats = 100;
+    double perCategoryMs = measureMs([&]() {
+        for (int r = 0; r < repeats; r++) {
+            for (size_t c = 0; c < categoryTotal; c++) {
+                benchSink = benchSink + manager.findByCategory("Тема " + std::to_string(c)).size();
+            }
+        }
+    });
+    printResult("по темам: запрос на каждую тему", perCategoryMs, repeats);
+    
+    double categoryMs = measureMs([&]() {
+        for (int r = 0; r < repeats; r++) {
+            benchSink = benchSink + manager.countBy(GroupBy::Category).size();
+        }
+    });
+    printResult("по темам: счетчики", categoryMs, repeats);
+    
+    double weekMs = measureMs([&]() {
+        for (int r = 0; r < repeats; r++) {
+            benchSink = benchSink + manager.countBy(GroupBy::Week).size();
+        }
+    });
+    printResult("по неделям: счетчики", weekMs, repeats);
+    
+    // Произвольное условие: параллельный полный просмотр
+    auto filter = [](const Note& note) { return note.title.size() % 2 == 0; };
+    size_t maxThreads = std::max<size_t>(std::thread::hardware_concurrency(), 4);
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        double ms = measureMs([&]() {
+            benchSink = benchSink + manager.countBy(GroupBy::Week, filter, threads).size();
+        });
+        printResult("по неделям с условием, потоков: " + std::to_string(threads), ms, 1);
+    }
+    
+    std::error_code ec;
+    std::filesystem::remove_all("notes", ec);
+    std::filesystem::remove("notes_metadata.dat", ec);
+}
+
+// ===== ХРАНЕНИЕ ТЕКСТОВ ПО СОДЕРЖИМОМУ =====
+
+// Суммарный размер файлов в директории
+static uint64_t directoryBytes(const std::string& path) {
+    uint64_t total = 0;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(path, ec)) {
+        if (entry.is_regular_file(ec)) {
+            total += entry.file_size(ec);
+        }
+    }
+    return total;
+}
+
+void benchDeduplication(size_t count) {
+    std::cout << "\n--- Импорт с повторяющимися текстами (" << count << " заметок по 4 КБ) ---" << std::endl;
+    
+    // Шаблоны: повестка, протокол встречи и т.п.
+    const size_t templateTotal = 20;
+    std::vector<std::string> templates;
+    for (size_t t = 0; t < templateTotal; t++) {
+        std::string body = "Шаблон " + std::to_string(t) + ". ";
+        while (body.size() < 4096) {
+            body += "Повестка, участники, решения и сроки по пункту " + std::to_string(t) + ". ";
+        }
+        templates.push_back(body);
+    }
+    double megabytes = count * 4096.0 / (1024.0 * 1024.0);
+    
+    // Два корпуса: тексты из шаблонов и все тексты разные
+    for (int unique = 0; unique <= 1; unique++) {
+        {
+            ArchiveWriter writer("dedup.tma", false);
+            Note note;
+            for (size_t i = 1; i <= count; i++) {
+                note.id = static_cast<int>(i);
+                note.title = "Встреча " + std::to_string(i);
+                note.category = "Работа";
+                note.creationDate = "2026-01-01";
+                note.content = templates[i % templateTotal];
+                if (unique) {
+                    note.content += std::to_string(i);
+                }
+                writer.add(note);
+            }
+            writer.finish();
+        }
+        
+        std::error_code ec;
+        std::filesystem::remove_all("notes", ec);
+        std::filesystem::remove_all("bodies", ec);
+        std::filesystem::remove("notes_metadata.dat", ec);
+        
+        NoteManager manager;
+        std::streambuf* original = std::cout.rdbuf(nullptr);
+        double ms = measureMs([&]() { manager.importArchive("dedup.tma"); });
+        std::cout.rdbuf(original);
+        
+        BodyStats stats = manager.bodyStats();
+        uint64_t diskBytes = directoryBytes("notes") + directoryBytes("bodies");
+        std::cout << (unique ? "все тексты разные" : "тексты из " + std::to_string(templateTotal) + " шаблонов")
+                  << ": " << ms << " мс, " << (megabytes / (ms / 1000.0)) << " МБ/с текста, файлов текстов "
+                  << stats.uniqueBodies << ", сэкономлено " << stats.savedBytes() / 1024 << " КБ из "
+                  << stats.logicalBytes / 1024 << " КБ, на диске " << diskBytes / 1024 << " КБ" << std::endl;
+    }
+    
+    std::error_code ec;
+    std::filesystem::remove_all("notes", ec);
+    std::filesystem::remove_all("bodies", ec);
+    std::filesystem::remove("notes_metadata.dat", ec);
+    std::filesystem::remove("dedup.tma", ec);
+}
+
+// ===== КОРЗИНА =====
+
+void benchTrash(size_t count) {
+    std::cout << "\n--- Удаление: сразу против корзины (" << count << " заметок) ---" << std::endl;
+    
+    const int single = 100;
+    generateStore(count, 1024);
+    std::streambuf* original = std::cout.rdbuf();
+    {
+        NoteManager manager;
+        manager.loadFromFile();
+        
+        // По одной заметке: каждое удаление перезаписывает метаданные
+        double immediateMs = measureMs([&]() {
+            for (int id = 1; id <= single; id++) {
+                manager.deleteNote(id);
+            }
+        });
+        printResult("удаление сразу, по одной", immediateMs, single);
+        
+        // В корзину: одна строка журнала на заметку
+        manager.setDeleteMode(DeleteMode::Trash);
+        double trashMs = measureMs([&]() {
+            for (int id = single + 1; id <= 2 * single; id++) {
+                manager.deleteNote(id);
+            }
+        });
+        printResult("в корзину, по одной", trashMs, single);
+        
+        // Вся тема одной операцией и ее отмена
+        int mass = 0;
+        double massMs = measureMs([&]() { mass = manager.deleteByCategory("Работа"); });
+        printResult("в корзину вся тема (" + std::to_string(mass) + " заметок)", massMs, 1);
+        double undoMs = measureMs([&]() { benchSink = benchSink + manager.undoDelete(); });
+        printResult("отмена удаления темы", undoMs, 1);
+        
+        // Очистка: в основном потоке - только сборка метаданных
+        mass = manager.deleteByCategory("Работа");
+        int purged = 0;
+        double purgeMs = measureMs([&]() { purged = manager.purgeTrash(currentTimestampUs()); });
+        double backgroundMs = measureMs([&]() { manager.waitForPurge(); });
+        printResult("очистка корзины (" + std::to_string(purged) + " заметок), основной поток", purgeMs, 1);
+        printResult("очистка корзины, фоновая часть", backgroundMs, 1);
+    }
+    
+    // Для сравнения: та же тема, удаленная сразу
+    std::error_code ec;
+    std::filesystem::remove_all("notes", ec);
+    std::filesystem::remove_all("bodies", ec);
+    std::filesystem::remove("notes_metadata.dat", ec);
+    std::filesystem::remove("notes_metadata.dat.trash", ec);
+    generateStore(count, 1024);
+    {
+        NoteManager manager;
+        manager.loadFromFile();
+        int mass = 0;
+        std::cout.rdbuf(nullptr);
+        double massMs = measureMs([&]() { mass = manager.deleteByCategory("Работа"); });
+        std::cout.rdbuf(original);
+        printResult("удаление сразу вся тема (" + std::to_string(mass) + " заметок)", massMs, 1);
+    }
+    
+    std::filesystem::remove_all("notes", ec);
+    std::filesystem::remove_all("bodies", ec);
+    std::filesystem::remove("notes_metadata.dat", ec);
+    std::filesystem::remove("notes_metadata.dat.trash", ec);
+}
+
+// ===== ИСТОРИЯ ВЕРСИЙ =====
+
+void benchHistory(size_t count) {
+    const int edits = 100;
+    std::cout << "\n--- История версий (" << count << " заметок по 8 КБ, по " << edits
+              << " правок) ---" << std::endl;
+    
+    std::mt19937 rng(42);
+    std::vector<std::string> texts(count);
+    NoteManager manager;
+    for (size_t i = 0; i < count; i++) {
+        while (texts[i].size() < 8192) {
+            texts[i] += "Абзац " + std::to_string(rng() % 100000) + ": обсуждение, решения и сроки.\n";
+        }
+        manager.addNote("Документ " + std::to_string(i + 1), "Работа", texts[i]);
+    }
+    
+    // Каждая правка вставляет предложение в случайное место текста
+    double editMs = measureMs([&]() {
+        for (int round = 0; round < edits; round++) {
+            for (size_t i = 0; i < count; i++) {
+                std::string& text = texts[i];
+                size_t pos = text.find('\n', rng() % text.size());
+                text.insert(pos == std::string::npos ? text.size() : pos + 1,
+                            "Дополнение " + std::to_string(round) + ".\n");
+                manager.updateNote(static_cast<int>(i + 1), "Документ " + std::to_string(i + 1), "Работа", text);
+            }
+        }
+    });
+    manager.getHistory().waitForCompaction();
+    printResult("правка с записью версии", editMs, count * edits);
+    
+    HistoryStats stats = manager.getHistory().stats();
+    std::cout << "версий " << stats.revisions << " (опорных " << stats.keyframes << "), полные копии "
+              << stats.logicalBytes / 1024 << " КБ, на диске " << stats.storedBytes / 1024 << " КБ ("
+              << (stats.storedBytes * 100.0 / stats.logicalBytes) << "%)" << std::endl;
+    
+    // Восстановление: последняя версия и самая дальняя от опорной
+    std::vector<RevisionInfo> revisions = manager.listRevisions(1);
+    uint32_t farthest = revisions.front().number;
+    size_t depth = 0;
+    for (size_t i = 0, run = 0; i < revisions.size(); i++) {
+        run = revisions[i].keyframe ? 0 : run + 1;
+        if (run > depth) {
+            depth = run;
+            farthest = revisions[i].number;
+        }
+    }
+    NoteVersion version;
+    double latestMs = measureMs([&]() {
+        for (size_t i = 0; i < count; i++) {
+            int id = static_cast<int>(i + 1);
+            manager.getRevision(id, manager.listRevisions(id).back().number, version);
+            benchSink = benchSink + version.content.size();
+        }
+    });
+    printResult("последняя версия (со списком версий)", latestMs, count);
+    double farthestMs = measureMs([&]() {
+        for (size_t i = 0; i < count; i++) {
+            manager.getRevision(static_cast<int>(i + 1), farthest, version);
+            benchSink = benchSink + version.content.size();
+        }
+    });
+    printResult("версия " + std::to_string(farthest) + " (" + std::to_string(depth) + " разниц от опорной)",
+                farthestMs, count);
+    
+    std::vector<DiffLine> diff;
+    double diffMs = measureMs([&]() {
+        for (size_t i = 0; i < count; i++) {
+            manager.diffRevisions(static_cast<int>(i + 1), revisions.front().number, revisions.back().number, diff);
+            benchSink = benchSink + diff.size();
+        }
+    });
+    printResult("сравнение первой и последней версий", diffMs, count);
+    
+    // Сжатие до 16 последних версий
+    manager.getHistory().setKeepRevisions(16);
+    double compactMs = measureMs([&]() {
+        for (size_t i = 0; i < count; i++) {
+            manager.getHistory().compact(static_cast<int>(i + 1));
+        }
+    });
+    printResult("сжатие до 16 версий", compactMs, count);
+    stats = manager.getHistory().stats();
+    std::cout << "после сжатия: версий " << stats.revisions << ", на диске " << stats.storedBytes / 1024
+              << " КБ" << std::endl;
+    
+    std::error_code ec;
+    std::filesystem::remove_all("notes", ec);
+    std::filesystem::remove_all("bodies", ec);
+    std::filesystem::remove_all("history", ec);
+    std::filesystem::remove("notes_metadata.dat", ec);
+}
+
+void benchAsync(size_t count) {
+    const size_t operations = 1000;
+    std::cout << "\n--- Асинхронный API (" << count << " заметок, по " << operations
+              << " операций) ---" << std::endl;
+    
+    generateStore(count, 1024);
+    NoteManager manager;
+    manager.loadFromFile();
+    std::string text = "Протокол встречи: решения, сроки, ответственные. ";
+    
+    // Синхронно: каждая операция перезаписывает метаданные сама
+    size_t next = 0;
+    double syncAddMs = measureMs([&]() {
+        for (size_t i = 0; i < operations; i++, next++) {
+            manager.addNote("Новая " + std::to_string(next), "Работа", text + std::to_string(next));
+        }
+    });
+    printResult("синхронное добавление", syncAddMs, operations);
+    double syncDeleteMs = measureMs([&]() {
+        for (size_t i = 0; i < operations; i++) {
+            manager.deleteNote(static_cast<int>(count + 1 + i));
+        }
+    });
+    printResult("синхронное удаление", syncDeleteMs, operations);
+    
+    AsyncNoteManager async(manager);
+    
+    // По одной операции: та же работа плюс переходы между потоками
+    uint64_t writesBefore = async.metadataWrites();
+    double oneMs = measureMs([&]() {
+        for (size_t i = 0; i < operations; i++, next++) {
+            syncWait(async.addNote("Новая " + std::to_string(next), "Работа", text + std::to_string(next)));
+        }
+    });
+    printResult("асинхронное добавление по одному", oneMs, operations);
+    std::cout << "записей метаданных: " << async.metadataWrites() - writesBefore << std::endl;
+    
+    // Все операции сразу: записи метаданных объединяются
+    writesBefore = async.metadataWrites();
+    std::vector<Task<AsyncResult>> adds;
+    for (size_t i = 0; i < operations; i++, next++) {
+        adds.push_back(async.addNote("Новая " + std::to_string(next), "Работа", text + std::to_string(next)));
+    }
+    std::vector<AsyncResult> added;
+    double batchAddMs = measureMs([&]() { added = syncWait(whenAll(std::move(adds))); });
+    printResult("асинхронное добавление, " + std::to_string(operations) + " одновременно", batchAddMs, operations);
+    std::cout << "записей метаданных: " << async.metadataWrites() - writesBefore << std::endl;
+    
+    writesBefore = async.metadataWrites();
+    std::vector<Task<AsyncResult>> deletes;
+    for (const AsyncResult& result : added) {
+        deletes.push_back(async.deleteNote(result.id));
+    }
+    double batchDeleteMs = measureMs([&]() { benchSink = benchSink + syncWait(whenAll(std::move(deletes))).size(); });
+    printResult("асинхронное удаление, " + std::to_string(operations) + " одновременно", batchDeleteMs, operations);
+    std::cout << "записей метаданных: " << async.metadataWrites() - writesBefore << std::endl;
+    
+    std::error_code ec;
+    std::filesystem::remove_all("notes", ec);
+    std::filesystem::remove_all("bodies", ec);
+    std::filesystem::remove_all("history", ec);
+    std::filesystem::remove("notes_metadata.dat", ec);
+}
+
+// Добавление, правка и запросы на менеджере одной конфигурации
+template <typename Manager>
+void benchPolicyConfig(const std::string& name, size_t count, bool queries) {
+    std::error_code ec;
+    std::filesystem::remove_all("notes", ec);
+    std::filesystem::remove_all("bodies", ec);
+    std::filesystem::remove_all("history", ec);
+    std::filesystem::remove("notes_metadata.dat", ec);
+    
+    std::mt19937 rng(7);
+    Manager manager;
+    double addMs = measureMs([&]() {
+        for (size_t i = 0; i < count; i++) {
+            manager.addNote("Заметка " + std::to_string(rng() % 1000000) + " " + std::to_string(i),
+                            "Тема " + std::to_string(i % 50), "Текст заметки " + std::to_string(i),
+                            {"метка" + std::to_string(i % 20)});
+        }
+        manager.flush();
+    });
+    printResult(name + ": добавление", addMs, count);
+    double updateMs = measureMs([&]() {
+        for (size_t i = 0; i < count; i += 2) {
+            int id = static_cast<int>(i + 1);
+            manager.updateNote(id, manager.getNote(id)->title, "Тема " + std::to_string(i % 40),
+                               "Новый текст " + std::to_string(i));
+        }
+        manager.flush();
+    });
+    printResult(name + ": правка", updateMs, (count + 1) / 2);
+    if (!queries) {
+        return;
+    }
+    
+    const size_t rounds = 100;
+    double categoryMs = measureMs([&]() {
+        for (size_t i = 0; i < rounds; i++) {
+            benchSink = benchSink + manager.findByCategory("Тема " + std::to_string(i % 50)).size();
+        }
+    });
+    printResult(name + ": отбор по теме", categoryMs, rounds);
+    double prefixMs = measureMs([&]() {
+        for (size_t i = 0; i < rounds; i++) {
+            benchSink = benchSink + manager.suggestTitles("заметка " + std::to_string(i % 10), 10).size();
+        }
+    });
+    printResult(name + ": подсказка названий", prefixMs, rounds);
+    double fuzzyMs = measureMs([&]() {
+        for (size_t i = 0; i < rounds; i++) {
+            benchSink = benchSink + manager.fuzzySearchCategories("тема " + std::to_string(i % 50) + "x", 1).size();
+        }
+    });
+    printResult(name + ": тема с опечаткой", fuzzyMs, rounds);
+    double tagsMs = measureMs([&]() {
+        for (size_t i = 0; i < rounds; i++) {
+            TagQuery query = parseTagQuery("метка" + std::to_string(i % 20));
+            benchSink = benchSink + manager.findByTags(query).size();
+        }
+    });
+    printResult(name + ": запрос по метке", tagsMs, rounds);
+    double countMs = measureMs([&]() {
+        for (size_t i = 0; i < rounds; i++) {
+            benchSink = benchSink + manager.countBy(GroupBy::Category).size();
+        }
+    });
+    printResult(name + ": число заметок по темам", countMs, rounds);
+}
+
+void benchPolicies(size_t count) {
+    // Синхронная запись метаданных - O(N) на операцию, поэтому в файлах меньше заметок
+    size_t fileCount = std::min<size_t>(count, 2000);
+    std::cout << "\n--- Политики хранилища (" << fileCount << " заметок в файлах, " << count
+              << " в памяти) ---" << std::endl;
+    
+    benchPolicyConfig<NoteManager>("файлы, индексы", fileCount, false);
+    benchPolicyConfig<BufferedNoteManager>("файлы, индексы, flush", fileCount, false);
+    benchPolicyConfig<LookupNoteManager>("файлы, без индексов", fileCount, false);
+    benchPolicyConfig<MemoryNoteManager>("память, индексы", count, true);
+    benchPolicyConfig<MemoryLookupNoteManager>("память, без индексов", count, true);
+    
+    std::error_code ec;
+    std::filesystem::remove_all("notes", ec);
+    std::filesystem::remove_all("bodies", ec);
+    std::filesystem::remove_all("history", ec);
+    std::filesystem::remove("notes_metadata.dat", ec);
+}
+
+// ===== ПОХОЖИЕ ЗАМЕТКИ =====
+
+// Текст из count случайных слов (слова из слогов, как в живом тексте повторяются)
+static std::string randomText(std::mt19937& rng, size_t count) {
+    const char* syllables[] = {"ка", "ро", "ми", "ла", "ba", "to", "ne", "ру", "sa", "де",
+                               "ki", "мо", "по", "ve", "ст", "на", "li", "го", "zu", "ть"};
+    std::string text;
+    for (size_t i = 0; i < count; i++) {
+        size_t length = 2 + rng() % 3;
+        for (size_t j = 0; j < length; j++) {
+            text += syllables[rng() % 20];
+        }
+        text += ' ';
+    }
+    return text;
+}
+
+// Копия текста с заменой edits слов
+static std::string editText(const std::string& text, std::mt19937& rng, size_t edits) {
+    std::vector<std::string> words;
+    std::istringstream in(text);
+    std::string word;
+    while (in >> word) {
+        words.push_back(word);
+    }
+    for (size_t i = 0; i < edits; i++) {
+        words[rng() % words.size()] = "правка" + std::to_string(rng() % 100000);
+    }
+    std::string result;
+    for (const std::string& w : words) {
+        result += w;
+        result += ' ';
+    }
+    return result;
+}
+
+void benchSimilar(size_t count) {
+    const size_t queries = 100;
+    std::cout << "\n--- Похожие заметки (" << count << " заметок, " << queries << " запросов) ---" << std::endl;
+    
+    // Каждая 10-я заметка - копия одной из прежних с 1-12 замененными словами
+    // из 30 (сходство от ~0,9 до ~0,3)
+    std::mt19937 rng(47);
+    std::vector<int> copies;
+    MemoryNoteManager manager;
+    double addMs = measureMs([&]() {
+        for (size_t i = 0; i < count; i++) {
+            std::string text;
+            if (i % 10 == 9) {
+                const Note* original = manager.getNote(static_cast<int>(1 + rng() % i));
+                text = editText(original->content, rng, 1 + rng() % 12);
+                copies.push_back(static_cast<int>(i + 1));
+            } else {
+                text = randomText(rng, 30);
+            }
+            manager.addNote("Заметка " + std::to_string(i), "Тема " + std::to_string(i % 50), text);
+        }
+    });
+    printResult("добавление с подписью MinHash", addMs, count);
+    std::cout << "индекс похожих текстов: " << manager.memoryUsage().similar / count << " Б/заметку" << std::endl;
+    
+    std::vector<int> probes;
+    for (size_t i = 0; i < queries && !copies.empty(); i++) {
+        probes.push_back(copies[rng() % copies.size()]);
+    }
+    
+    // Без индекса: сходство по Жаккару с каждой заметкой
+    double bruteMs = measureMs([&]() {
+        std::vector<uint64_t> shingles = textShingles(manager.getNote(probes[0])->content);
+        for (int id = 1; id <= static_cast<int>(count); id++) {
+            if (jaccardSimilarity(shingles, textShingles(manager.getNote(id)->content)) >= SIMILAR_NOTES_THRESHOLD) {
+                benchSink = benchSink + 1;
+            }
+        }
+    });
+    printResult("полный перебор по Жаккару", bruteMs, 1);
+    
+    // Точный ответ для всех запросов одним проходом (шинглы заметки - один раз)
+    std::vector<std::vector<uint64_t>> probeShingles;
+    for (int probe : probes) {
+        probeShingles.push_back(textShingles(manager.getNote(probe)->content));
+    }
+    std::vector<std::vector<SimilarNote>> truth(probes.size());
+    for (int id = 1; id <= static_cast<int>(count); id++) {
+        std::vector<uint64_t> shingles = textShingles(manager.getNote(id)->content);
+        for (size_t q = 0; q < probes.size(); q++) {
+            double similarity = jaccardSimilarity(probeShingles[q], shingles);
+            if (id != probes[q] && similarity >= SIMILAR_NOTES_THRESHOLD) {
+                truth[q].push_back({id, similarity});
+            }
+        }
+    }
+    
+    std::vector<std::vector<SimilarNote>> found(probes.size());
+    const size_t rounds = 20;
+    double lshMs = measureMs([&]() {
+        for (size_t r = 0; r < rounds; r++) {
+            for (size_t q = 0; q < probes.size(); q++) {
+                found[q] = manager.findSimilar(probes[q], SIMILAR_NOTES_THRESHOLD, count);
+            }
+        }
+    });
+    printResult("LSH-индекс с точной проверкой", lshMs, rounds * probes.size());
+    
+    // Полнота по порогам: доля пар из точного ответа, найденных индексом
+    const double thresholds[] = {0.5, 0.6, 0.7, 0.8};
+    for (double threshold : thresholds) {
+        size_t expected = 0;
+        size_t matched = 0;
+        for (size_t q = 0; q < probes.size(); q++) {
+            for (const SimilarNote& pair : truth[q]) {
+                if (pair.similarity < threshold) {
+                    continue;
+                }
+                expected++;
+                for (const SimilarNote& note : found[q]) {
+                    matched += note.id == pair.id ? 1 : 0;
+                }
+            }
+        }
+        std::cout << "полнота при сходстве >= " << threshold << ": " << matched << " из " << expected << std::endl;
+    }
+}
+
+// ===== ГЛАВНАЯ ФУНКЦИЯ =====
+
+int main(int argc, char* argv[]) {
+    // Необязательные аргументы - имя группы бенчмарков и размер данных
+    std::string only = argc > 1 ? argv[1] : "";
+    size_t count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+    
+    // Бенчмарки работают во временной директории, чтобы не задеть
+    // рабочие notes/ и notes_metadata.dat
+    std::error_code ec;
+    std::filesystem::path startDir = std::filesystem::current_path();
+    std::filesystem::remove_all(BENCH_DIR, ec);
+    std::filesystem::create_directory(BENCH_DIR, ec);
+    std::filesystem::current_path(BENCH_DIR);
+    
+    std::cout << "\n=== БЕНЧМАРКИ СИСТЕМЫ УПРАВЛЕНИЯ ЗАМЕТКАМИ ===" << std::endl;
+    
+    if (only.empty() || only == "read") {
+        benchNoteBodyReader();
+    }
+    if (only.empty() || only == "prefix") {
+        benchTitlePrefixIndex(count);
+    }
+    if (only.empty() || only == "fuzzy") {
+        benchFuzzySearch(count);
+    }
+    if (only.empty() || only == "scan") {
+        benchScanKernels(count);
+    }
+    if (only.empty() || only == "parallel") {
+        benchParallelSearch(std::min<size_t>(count, 100000));
+    }
+    if (only.empty() || only == "archive") {
+        benchArchive(std::min<size_t>(count, 50000));
+    }
+    if (only.empty() || only == "snapshot") {
+        benchSnapshot(std::min<size_t>(count, 100000));
+    }
+    if (only.empty() || only == "date") {
+        benchCurrentDate(count);
+    }
+    if (only.empty() || only == "validate") {
+        benchValidation(std::min<size_t>(count, 100000));
+    }
+    if (only.empty() || only == "tags") {
+        benchTags(count);
+    }
+    if (only.empty() || only == "aggregate") {
+        benchAggregation(std::min<size_t>(count, 100000));
+    }
+    if (only.empty() || only == "dedup") {
+        benchDeduplication(std::min<size_t>(count, 50000));
+    }
+    if (only.empty() || only == "trash") {
+        benchTrash(std::min<size_t>(count, 100000));
+    }
+    if (only.empty() || only == "history") {
+        benchHistory(std::min<size_t>(count, 200));
+    }
+    if (only.empty() || only == "async") {
+        benchAsync(std::min<size_t>(count, 10000));
+    }
+    if (only.empty() || only == "policy") {
+        benchPolicies(std::min<size_t>(count, 100000));
+    }
+    if (only.empty() || only == "similar") {
+        benchSimilar(count);
+    }
+    
+    std::filesystem::current_path(startDir);
+    std::filesystem::remove_all(BENCH_DIR, ec);
+    return 0;
+}
@@ -0,0 +1,494 @@
+#include "bitmap.h"
+#include "snapshot.h"
+#include "memory.h"
+#include <algorithm>
+#include <stdexcept>
+
+// Контейнер-массив не больше 4096 значений (8 КБ, как и битовая карта)
+const uint32_t ARRAY_MAX_SIZE = 4096;
+const size_t BITMAP_WORDS = 65536 / 64;
+
+// Массивы, различающиеся по размеру сильнее, пересекаются двоичным поиском
+const size_t GALLOP_RATIO = 32;
+
+static inline int popcount64(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    while (word != 0) {
+        word &= word - 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+// Номер младшего установленного бита (word != 0)
+static inline int lowestBit(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+static inline bool testBit(const std::vector<uint64_t>& bits, uint16_t low) {
+    return (bits[low >> 6] >> (low & 63)) & 1;
+}
+
+// ===== КОНТЕЙНЕРЫ =====
+
+size_t RoaringBitmap::findContainer(uint16_t key) const {
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                               [](const Container& container, uint16_t k) { return container.key < k; });
+    return static_cast<size_t>(it - containers.begin());
+}
+
+void RoaringBitmap::toBitmap(Container& container) {
+    container.bits.assign(BITMAP_WORDS, 0);
+    for (uint16_t low : container.values) {
+        container.bits[low >> 6] |= uint64_t(1) << (low & 63);
+    }
+    container.values.clear();
+    container.values.shrink_to_fit();
+}
+
+void RoaringBitmap::toArray(Container& container) {
+    container.values.clear();
+    container.values.reserve(container.cardinality);
+    for (size_t w = 0; w < BITMAP_WORDS; w++) {
+        uint64_t word = container.bits[w];
+        while (word != 0) {
+            container.values.push_back(static_cast<uint16_t>(w * 64 + lowestBit(word)));
+            word &= word - 1;
+        }
+    }
+    container.bits.clear();
+    container.bits.shrink_to_fit();
+}
+
+void RoaringBitmap::normalize(Container& container) {
+    // Вид контейнера однозначно определяется числом значений
+    if (container.dense() && container.cardinality <= ARRAY_MAX_SIZE) {
+        toArray(container);
+    } else if (!container.dense() && container.cardinality > ARRAY_MAX_SIZE) {
+        toBitmap(container);
+    }
+}
+
+RoaringBitmap::Container RoaringBitmap::intersect(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+
+    if (a.dense() && b.dense()) {
+        result.bits.resize(BITMAP_WORDS);
+        for (size_t w = 0; w < BITMAP_WORDS; w++) {
+            result.bits[w] = a.bits[w] & b.bits[w];
+            result.cardinality += popcount64(result.bits[w]);
+        }
+        normalize(result);
+        return result;
+    }
+
+    if (a.dense() || b.dense()) {
+        const Container& array = a.dense() ? b : a;
+        const Container& bitmap = a.dense() ? a : b;
+        result.values.reserve(array.values.size());
+        for (uint16_t low : array.values) {
+            if (testBit(bitmap.bits, low)) {
+                result.values.push_back(low);
+            }
+        }
+        result.cardinality = static_cast<uint32_t>(result.values.size());
+        return result;
+    }
+
+    const std::vector<uint16_t>& small = a.values.size() <= b.values.size() ? a.values : b.values;
+    const std::vector<uint16_t>& large = a.values.size() <= b.values.size() ? b.values : a.values;
+    result.values.reserve(small.size());
+    if (small.size() * GALLOP_RATIO < large.size()) {
+        auto from = large.begin();
+        for (uint16_t low : small) {
+            from = std::lower_bound(from, large.end(), low);
+            if (from == large.end()) {
+                break;
+            }
+            if (*from == low) {
+                result.values.push_back(low);
+            }
+        }
+    } else {
+        std::set_intersection(small.begin(), small.end(), large.begin(), large.end(),
+                              std::back_inserter(result.values));
+    }
+    result.cardinality = static_cast<uint32_t>(result.values.size());
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::unite(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+
+    if (a.dense() || b.dense()) {
+        const Container& bitmap = a.dense() ? a : b;
+        const Container& other = a.dense() ? b : a;
+        result.bits = bitmap.bits;
+        if (other.dense()) {
+            for (size_t w = 0; w < BITMAP_WORDS; w++) {
+                result.bits[w] |= other.bits[w];
+            }
+        } else {
+            for (uint16_t low : other.values) {
+                result.bits[low >> 6] |= uint64_t(1) << (low & 63);
+            }
+        }
+        for (uint64_t word : result.bits) {
+            result.cardinality += popcount64(word);
+        }
+        return result;
+    }
+
+    result.values.reserve(a.values.size() + b.values.size());
+    std::set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                   std::back_inserter(result.values));
+    result.cardinality = static_cast<uint32_t>(result.values.size());
+    normalize(result);
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::subtract(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+
+    if (a.dense()) {
+        result.bits = a.bits;
+        if (b.dense()) {
+            for (size_t w = 0; w < BITMAP_WORDS; w++) {
+                result.bits[w] &= ~b.bits[w];
+            }
+        } else {
+            for (uint16_t low : b.values) {
+                result.bits[low >> 6] &= ~(uint64_t(1) << (low & 63));
+            }
+        }
+        for (uint64_t word : result.bits) {
+            result.cardinality += popcount64(word);
+        }
+        normalize(result);
+        return result;
+    }
+
+    result.values.reserve(a.values.size());
+    if (b.dense()) {
+        for (uint16_t low : a.values) {
+            if (!testBit(b.bits, low)) {
+                result.values.push_back(low);
+            }
+        }
+    } else {
+        std::set_difference(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                            std::back_inserter(result.values));
+    }
+    result.cardinality = static_cast<uint32_t>(result.values.size());
+    return result;
+}
+
+uint64_t RoaringBitmap::intersectCount(const Container& a, const Container& b) {
+    uint64_t count = 0;
+    if (a.dense() && b.dense()) {
+        for (size_t w = 0; w < BITMAP_WORDS; w++) {
+            count += popcount64(a.bits[w] & b.bits[w]);
+        }
+    } else if (a.dense() || b.dense()) {
+        const Container& array = a.dense() ? b : a;
+        const Container& bitmap = a.dense() ? a : b;
+        for (uint16_t low : array.values) {
+            count += testBit(bitmap.bits, low);
+        }
+    } else {
+        size_t i = 0;
+        size_t j = 0;
+        while (i < a.values.size() && j < b.values.size()) {
+            if (a.values[i] < b.values[j]) {
+                i++;
+            } else if (b.values[j] < a.values[i]) {
+                j++;
+            } else {
+                count++;
+                i++;
+                j++;
+            }
+        }
+    }
+    return count;
+}
+
+// ===== ОПЕРАЦИИ НАД МНОЖЕСТВОМ =====
+
+void RoaringBitmap::add(uint32_t value) {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+    size_t index = findContainer(key);
+    if (index == containers.size() || containers[index].key != key) {
+        Container container;
+        container.key = key;
+        containers.insert(containers.begin() + static_cast<std::ptrdiff_t>(index), std::move(container));
+    }
+
+    Container& container = containers[index];
+    if (container.dense()) {
+        uint64_t& word = container.bits[low >> 6];
+        uint64_t mask = uint64_t(1) << (low & 63);
+        if ((word & mask) == 0) {
+            word |= mask;
+            container.cardinality++;
+        }
+        return;
+    }
+
+    auto it = std::lower_bound(container.values.begin(), container.values.end(), low);
+    if (it != container.values.end() && *it == low) {
+        return;
+    }
+    container.values.insert(it, low);
+    container.cardinality++;
+    normalize(container);
+}
+
+bool RoaringBitmap::remove(uint32_t value) {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+    size_t index = findContainer(key);
+    if (index == containers.size() || containers[index].key != key) {
+        return false;
+    }
+
+    Container& container = containers[index];
+    if (container.dense()) {
+        uint64_t& word = container.bits[low >> 6];
+        uint64_t mask = uint64_t(1) << (low & 63);
+        if ((word & mask) == 0) {
+            return false;
+        }
+        word &= ~mask;
+        container.cardinality--;
+        normalize(container);
+    } else {
+        auto it = std::lower_bound(container.values.begin(), container.values.end(), low);
+        if (it == container.values.end() || *it != low) {
+            return false;
+        }
+        container.values.erase(it);
+        container.cardinality--;
+    }
+
+    if (container.cardinality == 0) {
+        containers.erase(containers.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+    return true;
+}
+
+bool RoaringBitmap::contains(uint32_t value) const {
+    uint16_t key = static_cast<uint16_t>(value >> 16);
+    uint16_t low = static_cast<uint16_t>(value & 0xFFFF);
+    size_t index = findContainer(key);
+    if (index == containers.size() || containers[index].key != key) {
+        return false;
+    }
+    const Container& container = containers[index];
+    if (container.dense()) {
+        return testBit(container.bits, low);
+    }
+    return std::binary_search(container.values.begin(), container.values.end(), low);
+}
+
+uint64_t RoaringBitmap::cardinality() const {
+    uint64_t total = 0;
+    for (const Container& container : containers) {
+        total += container.cardinality;
+    }
+    return total;
+}
+
+RoaringBitmap RoaringBitmap::operator&(const RoaringBitmap& other) const {
+    RoaringBitmap result;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < containers.size() && j < other.containers.size()) {
+        if (containers[i].key < other.containers[j].key) {
+            i++;
+        } else if (other.containers[j].key < containers[i].key) {
+            j++;
+        } else {
+            Container container = intersect(containers[i], other.containers[j]);
+            if (container.cardinality > 0) {
+                result.containers.push_back(std::move(container));
+            }
+            i++;
+            j++;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::operator|(const RoaringBitmap& other) const {
+    RoaringBitmap result;
+    result.containers.reserve(containers.size() + other.containers.size());
+    size_t i = 0;
+    size_t j = 0;
+    while (i < containers.size() || j < other.containers.size()) {
+        if (j == other.containers.size() ||
+            (i < containers.size() && containers[i].key < other.containers[j].key)) {
+            result.containers.push_back(containers[i++]);
+        } else if (i == containers.size() || other.containers[j].key < containers[i].key) {
+            result.containers.push_back(other.containers[j++]);
+        } else {
+            result.containers.push_back(unite(containers[i], other.containers[j]));
+            i++;
+            j++;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::andNot(const RoaringBitmap& other) const {
+    RoaringBitmap result;
+    result.containers.reserve(containers.size());
+    size_t j = 0;
+    for (const Container& container : containers) {
+        while (j < other.containers.size() && other.containers[j].key < container.key) {
+            j++;
+        }
+        if (j == other.containers.size() || other.containers[j].key != container.key) {
+            result.containers.push_back(container);
+            continue;
+        }
+        Container difference = subtract(container, other.containers[j]);
+        if (difference.cardinality > 0) {
+            result.containers.push_back(std::move(difference));
+        }
+    }
+    return result;
+}
+
+uint64_t RoaringBitmap::andCardinality(const RoaringBitmap& other) const {
+    uint64_t count = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < containers.size() && j < other.containers.size()) {
+        if (containers[i].key < other.containers[j].key) {
+            i++;
+        } else if (other.containers[j].key < containers[i].key) {
+            j++;
+        } else {
+            count += intersectCount(containers[i], other.containers[j]);
+            i++;
+            j++;
+        }
+    }
+    return count;
+}
+
+std::vector<uint32_t> RoaringBitmap::toVector() const {
+    std::vector<uint32_t> result;
+    result.reserve(cardinality());
+    for (const Container& container : containers) {
+        uint32_t high = static_cast<uint32_t>(container.key) << 16;
+        if (container.dense()) {
+            for (size_t w = 0; w < BITMAP_WORDS; w++) {
+                uint64_t word = container.bits[w];
+                while (word != 0) {
+                    result.push_back(high | static_cast<uint32_t>(w * 64 + lowestBit(word)));
+                    word &= word - 1;
+                }
+            }
+        } else {
+            for (uint16_t low : container.values) {
+                result.push_back(high | low);
+            }
+        }
+    }
+    return result;
+}
+
+size_t RoaringBitmap::memoryUsage() const {
+    size_t bytes = vectorHeapBytes(containers);
+    for (const Container& container : containers) {
+        bytes += vectorHeapBytes(container.values) + vectorHeapBytes(container.bits);
+    }
+    return bytes;
+}
+
+bool RoaringBitmap::operator==(const RoaringBitmap& other) const {
+    if (containers.size() != other.containers.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < containers.size(); i++) {
+        const Container& a = containers[i];
+        const Container& b = other.containers[i];
+        if (a.key != b.key || a.cardinality != b.cardinality || a.values != b.values || a.bits != b.bits) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ===== СНИМОК =====
+
+void RoaringBitmap::save(SnapshotWriter& out) const {
+    out.putU64(containers.size());
+    for (const Container& container : containers) {
+        out.putU32(container.key);
+        out.putU32(container.cardinality);
+        if (container.dense()) {
+            out.putVector(container.bits);
+        } else {
+            out.putVector(container.values);
+        }
+    }
+}
+
+void RoaringBitmap::load(SnapshotReader& in) {
+    containers.clear();
+    size_t count = in.getCount(2 * sizeof(uint32_t) + sizeof(uint64_t));
+    containers.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        Container& container = containers[i];
+        uint32_t key = in.getU32();
+        container.cardinality = in.getU32();
+        if (key > 0xFFFF || (i > 0 && key <= containers[i - 1].key) ||
+            container.cardinality == 0 || container.cardinality > 65536) {
+            throw std::runtime_error("поврежденная битовая карта");
+        }
+        container.key = static_cast<uint16_t>(key);
+
+        // Вид контейнера определяется числом значений, его содержимое сверяется с ним
+        uint64_t stored = 0;
+        if (container.cardinality > ARRAY_MAX_SIZE) {
+            in.getVector(container.bits);
+            if (container.bits.size() != BITMAP_WORDS) {
+                throw std::runtime_error("поврежденная битовая карта");
+            }
+            for (uint64_t word : container.bits) {
+                stored += popcount64(word);
+            }
+        } else {
+            in.getVector(container.values);
+            stored = container.values.size();
+            for (size_t v = 1; v < container.values.size(); v++) {
+                if (container.values[v] <= container.values[v - 1]) {
+                    throw std::runtime_error("поврежденная битовая карта");
+                }
+            }
+        }
+        if (stored != container.cardinality) {
+            throw std::runtime_error("поврежденная битовая карта");
+        }
+    }
+}
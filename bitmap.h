@@ -0,0 +1,70 @@
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+// Сжатое множество 32-битных чисел по схеме Roaring: старшие 16 бит значения
+// выбирают контейнер, младшие 16 бит хранятся в нем. Контейнер, где не больше
+// 4096 значений, - отсортированный массив uint16_t, в остальных случаях -
+// битовая карта на 65536 бит (8 КБ). Операции над множествами выполняются
+// по контейнерам: пересечение массивов - слиянием, битовых карт - по словам.
+class RoaringBitmap {
+public:
+    void add(uint32_t value);
+    bool remove(uint32_t value);
+    bool contains(uint32_t value) const;
+
+    uint64_t cardinality() const;
+    bool empty() const { return containers.empty(); }
+    void clear() { containers.clear(); }
+
+    // Операции над множествами
+    RoaringBitmap operator&(const RoaringBitmap& other) const;
+    RoaringBitmap operator|(const RoaringBitmap& other) const;
+    RoaringBitmap andNot(const RoaringBitmap& other) const;
+
+    // Размер пересечения без построения результата (для подсчета по меткам)
+    uint64_t andCardinality(const RoaringBitmap& other) const;
+
+    // Значения по возрастанию
+    std::vector<uint32_t> toVector() const;
+
+    // Байты кучи контейнеров (memory.h)
+    size_t memoryUsage() const;
+
+    bool operator==(const RoaringBitmap& other) const;
+    bool operator!=(const RoaringBitmap& other) const { return !(*this == other); }
+
+    // Сохранение в снимок и восстановление (snapshot.h)
+    void save(SnapshotWriter& out) const;
+    void load(SnapshotReader& in);
+
+private:
+    struct Container {
+        uint16_t key = 0;                   // Старшие 16 бит значений
+        uint32_t cardinality = 0;           // Число значений в контейнере
+        std::vector<uint16_t> values;       // Массив (если bits пуст)
+        std::vector<uint64_t> bits;         // Битовая карта из 1024 слов
+
+        bool dense() const { return !bits.empty(); }
+    };
+
+    std::vector<Container> containers;      // По возрастанию key
+
+    size_t findContainer(uint16_t key) const;
+
+    static void toBitmap(Container& container);
+    static void toArray(Container& container);
+    static void normalize(Container& container);
+    static Container intersect(const Container& a, const Container& b);
+    static Container unite(const Container& a, const Container& b);
+    static Container subtract(const Container& a, const Container& b);
+    static uint64_t intersectCount(const Container& a, const Container& b);
+};
+
+#endif // BITMAP_H
@@ -0,0 +1,136 @@
+#include "bodystore.h"
+#include "checksum.h"
+#include "fileio.h"
+#include "memory.h"
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+    #include <direct.h>
+    #define mkdir(path, mode) _mkdir(path)
+#else
+    #include <sys/stat.h>
+#endif
+
+// Номер временного файла: одинаковый текст могут записывать несколько
+// потоков сразу (AsyncNoteManager), у каждого свой временный файл
+static std::atomic<uint64_t> tmpCounter{0};
+
+BodyStore::BodyStore(const std::string& directory) : directory(directory) {
+    // Пустая директория - хранилище заметок в памяти, файлов нет
+    if (!directory.empty()) {
+        mkdir(directory.c_str(), 0755);
+    }
+}
+
+std::string BodyStore::pathOf(const std::string& hash) const {
+    return directory + "/" + hash + ".txt";
+}
+
+std::string BodyStore::put(std::string_view content) const {
+    std::string hash = contentHash(content);
+    std::string path = pathOf(hash);
+    
+    // Файл с этим хешем уже есть: тот же текст не перезаписывается,
+    // поврежденный файл (не совпадает со своим хешем) записывается заново,
+    // а целый файл с другим текстом - коллизия хеша, его не трогаем
+    std::string existing;
+    if (readWholeFile(path, existing)) {
+        if (existing == content) {
+            return hash;
+        }
+        if (contentHash(existing) == hash) {
+            return std::string();
+        }
+    }
+    
+    // Запись через временный файл: читатель видит либо весь текст, либо ничего
+    std::string tmpPath = path + "." + std::to_string(tmpCounter.fetch_add(1)) + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Невозможно создать файл текста");
+        }
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        file.close();
+        if (!file) {
+            std::remove(tmpPath.c_str());
+            throw std::runtime_error("Ошибка записи файла текста");
+        }
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        throw std::runtime_error("Не удалось сохранить файл текста");
+    }
+    return hash;
+}
+
+bool BodyStore::read(const std::string& hash, std::string& content) const {
+    return readWholeFile(pathOf(hash), content);
+}
+
+bool BodyStore::exists(const std::string& hash) const {
+    FileStamp stamp;
+    return readFileStamp(pathOf(hash), stamp);
+}
+
+void BodyStore::addRef(const std::string& hash, uint64_t size) {
+    if (hash.empty()) {
+        return;
+    }
+    Entry& entry = refs[hash];
+    entry.refs++;
+    entry.size = size;
+}
+
+void BodyStore::release(const std::string& hash) {
+    auto it = refs.find(hash);
+    if (it != refs.end() && --it->second.refs == 0) {
+        refs.erase(it);
+    }
+}
+
+uint32_t BodyStore::refCount(const std::string& hash) const {
+    auto it = refs.find(hash);
+    return it != refs.end() ? it->second.refs : 0;
+}
+
+bool BodyStore::removeIfUnused(const std::string& hash) {
+    if (hash.empty() || refs.count(hash) != 0) {
+        return false;
+    }
+    return std::remove(pathOf(hash).c_str()) == 0;
+}
+
+std::vector<std::string> BodyStore::listHashes() const {
+    std::vector<std::string> hashes;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        std::filesystem::path path = entry.path();
+        if (entry.is_regular_file(ec) && path.extension() == ".txt") {
+            hashes.push_back(path.stem().string());
+        }
+    }
+    return hashes;
+}
+
+BodyStats BodyStore::stats() const {
+    BodyStats result;
+    result.uniqueBodies = refs.size();
+    for (const auto& entry : refs) {
+        result.references += entry.second.refs;
+        result.logicalBytes += entry.second.refs * entry.second.size;
+        result.storedBytes += entry.second.size;
+    }
+    return result;
+}
+
+size_t BodyStore::memoryUsage() const {
+    return stringKeyedTableBytes(refs);
+}
@@ -0,0 +1,67 @@
+#ifndef BODYSTORE_H
+#define BODYSTORE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Итог учета текстов в хранилище
+struct BodyStats {
+    uint64_t uniqueBodies = 0;      // Различных текстов (файлов в bodies/)
+    uint64_t references = 0;        // Заметок, ссылающихся на тексты
+    uint64_t logicalBytes = 0;      // Сумма размеров текстов всех заметок
+    uint64_t storedBytes = 0;       // Сумма размеров различных текстов
+    
+    uint64_t savedBytes() const { return logicalBytes - storedBytes; }
+};
+
+// Хранилище текстов заметок по содержимому: каждый различный текст лежит
+// один раз в файле <каталог>/<хеш>.txt (хеш - contentHash из checksum.h),
+// файл заметки хранит только ссылку на него. Счетчики ссылок живут в памяти
+// и восстанавливаются при загрузке хранилища; файл текста удаляется явно
+// через removeIfUnused, когда на него не осталось ссылок.
+class BodyStore {
+public:
+    explicit BodyStore(const std::string& directory);
+    
+    // Сохранение текста; возвращает его хеш. Если такой текст уже есть
+    // на диске и совпадает побайтно, файл не перезаписывается. Если под тем
+    // же хешем лежит другой целый текст (коллизия), возвращает пустую
+    // строку - текст остается в файле заметки, чужой файл не меняется.
+    std::string put(std::string_view content) const;
+    
+    // Чтение текста по хешу; false - файла нет
+    bool read(const std::string& hash, std::string& content) const;
+    bool exists(const std::string& hash) const;
+    std::string pathOf(const std::string& hash) const;
+    
+    // Учет ссылок (пустой хеш - текст хранится в файле заметки, не учитывается)
+    void addRef(const std::string& hash, uint64_t size);
+    void release(const std::string& hash);
+    uint32_t refCount(const std::string& hash) const;
+    void clearRefs() { refs.clear(); }
+    
+    // Удаление файла текста, на который не осталось ссылок
+    bool removeIfUnused(const std::string& hash);
+    
+    // Хеши всех текстов в каталоге (для проверки хранилища)
+    std::vector<std::string> listHashes() const;
+    
+    BodyStats stats() const;
+    const std::string& getDirectory() const { return directory; }
+    // Байты кучи счетчиков ссылок (memory.h)
+    size_t memoryUsage() const;
+    
+private:
+    struct Entry {
+        uint32_t refs = 0;
+        uint64_t size = 0;
+    };
+    
+    std::string directory;
+    std::unordered_map<std::string, Entry> refs;
+};
+
+#endif // BODYSTORE_H
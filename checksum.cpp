@@ -0,0 +1,105 @@
+#include "checksum.h"
+#include <cstring>
+
+// Таблицы для обработки по 8 байт за шаг (slicing-by-8)
+struct Crc32Tables {
+    uint32_t table[8][256];
+    
+    Crc32Tables() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int slice = 1; slice < 8; slice++) {
+                uint32_t previous = table[slice - 1][i];
+                table[slice][i] = (previous >> 8) ^ table[0][previous & 0xFF];
+            }
+        }
+    }
+};
+
+static const Crc32Tables& crcTables() {
+    static const Crc32Tables tables;
+    return tables;
+}
+
+uint32_t crc32(const void* data, size_t size, uint32_t crc) {
+    const uint32_t (*t)[256] = crcTables().table;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    
+    // Основной цикл по 8 байт (порядок байтов little-endian)
+    while (size >= 8) {
+        uint32_t low;
+        uint32_t high;
+        std::memcpy(&low, bytes, 4);
+        std::memcpy(&high, bytes + 4, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        low = __builtin_bswap32(low);
+        high = __builtin_bswap32(high);
+#endif
+        low ^= crc;
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^
+              t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^
+              t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        bytes += 8;
+        size -= 8;
+    }
+    
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *bytes++) & 0xFF];
+    }
+    
+    return ~crc;
+}
+
+// ===== ХЕШ СОДЕРЖИМОГО =====
+
+static inline uint64_t rotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Финальное перемешивание (splitmix64)
+static inline uint64_t finalMix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ull;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBull;
+    value ^= value >> 31;
+    return value;
+}
+
+std::string contentHash(std::string_view data) {
+    uint64_t first = 0x9E3779B97F4A7C15ull;
+    uint64_t second = 0xC2B2AE3D27D4EB4Full ^ data.size();
+    
+    size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data.data() + i, sizeof(word));
+        first = rotateLeft(first ^ (word * 0x87C37B91114253D5ull), 31) * 0x4CF5AD432745937Full;
+        second = rotateLeft(second + (word ^ 0x52DCE729DA3ED2B5ull), 27) * 0xFF51AFD7ED558CCDull + first;
+    }
+    
+    // Остаток короче 8 байт дополняется нулями, длина входит в хеш отдельно
+    uint64_t tail = 0;
+    std::memcpy(&tail, data.data() + i, data.size() - i);
+    first = rotateLeft(first ^ (tail * 0x87C37B91114253D5ull), 31) * 0x4CF5AD432745937Full;
+    second = rotateLeft(second + (tail ^ 0x52DCE729DA3ED2B5ull), 27) * 0xFF51AFD7ED558CCDull + first;
+    
+    first = finalMix(first ^ data.size());
+    second = finalMix(second ^ first);
+    
+    static const char digits[] = "0123456789abcdef";
+    std::string hash(32, '0');
+    for (int k = 0; k < 16; k++) {
+        hash[15 - k] = digits[(first >> (4 * k)) & 0xF];
+        hash[31 - k] = digits[(second >> (4 * k)) & 0xF];
+    }
+    return hash;
+}
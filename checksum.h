@@ -0,0 +1,24 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// CRC-32 (полином IEEE 802.3, как в zlib и PNG).
+// Значение можно накапливать по частям: crc32(b, n2, crc32(a, n1)).
+uint32_t crc32(const void* data, size_t size, uint32_t crc = 0);
+
+// CRC-32 строки (отдельное имя, чтобы вызов с const char* не спутать с crc32(data, size))
+inline uint32_t crc32String(std::string_view text, uint32_t crc = 0) {
+    return crc32(text.data(), text.size(), crc);
+}
+
+// 128-битный хеш содержимого в виде 32 шестнадцатеричных цифр (имя файла
+// в хранилище текстов). Две независимые 64-битные полосы обрабатывают по
+// 8 байт за шаг. Хеш не криптографический: он защищает от случайных
+// совпадений, но не от подобранных.
+std::string contentHash(std::string_view data);
+
+#endif // CHECKSUM_H
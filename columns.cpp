@@ -0,0 +1,149 @@
+#include "columns.h"
+#include "snapshot.h"
+#include "scan.h"
+#include "memory.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+
+uint32_t NoteColumns::categoryCode(const std::string& category) {
+    auto it = categoryCodes.find(category);
+    if (it != categoryCodes.end()) {
+        return it->second;
+    }
+    uint32_t code = static_cast<uint32_t>(categoryCodes.size());
+    categoryCodes.emplace(category, code);
+    return code;
+}
+
+void NoteColumns::add(int id, const std::string& category, const std::string& date) {
+    rowById[id] = ids.size();
+    ids.push_back(id);
+    categories.push_back(categoryCode(category));
+    dates.push_back(dateKey(date));
+}
+
+void NoteColumns::remove(int id) {
+    auto it = rowById.find(id);
+    if (it == rowById.end()) {
+        return;
+    }
+    
+    // Переносим последнюю строку на место удаляемой
+    size_t row = it->second;
+    size_t last = ids.size() - 1;
+    if (row != last) {
+        ids[row] = ids[last];
+        categories[row] = categories[last];
+        dates[row] = dates[last];
+        rowById[ids[row]] = row;
+    }
+    ids.pop_back();
+    categories.pop_back();
+    dates.pop_back();
+    rowById.erase(it);
+}
+
+void NoteColumns::setCategory(int id, const std::string& category) {
+    auto it = rowById.find(id);
+    if (it != rowById.end()) {
+        categories[it->second] = categoryCode(category);
+    }
+}
+
+std::vector<int> NoteColumns::rowsToIds(const std::vector<uint32_t>& rows) const {
+    std::vector<int> result;
+    result.reserve(rows.size());
+    for (uint32_t row : rows) {
+        result.push_back(ids[row]);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<int> NoteColumns::selectCategory(const std::string& category) const {
+    auto it = categoryCodes.find(category);
+    if (it == categoryCodes.end()) {
+        return std::vector<int>();
+    }
+    
+    std::vector<uint32_t> rows;
+    filterEqual(categories.data(), categories.size(), it->second, rows);
+    return rowsToIds(rows);
+}
+
+std::vector<int> NoteColumns::selectDateRange(const std::string& from, const std::string& to) const {
+    uint32_t low = dateKey(from);
+    uint32_t high = dateKey(to);
+    if (low == 0 || high == 0 || low > high) {
+        return std::vector<int>();
+    }
+    
+    std::vector<uint32_t> rows;
+    filterRange(dates.data(), dates.size(), low, high, rows);
+    return rowsToIds(rows);
+}
+
+void NoteColumns::save(SnapshotWriter& out) const {
+    out.putVector(ids);
+    out.putVector(categories);
+    out.putVector(dates);
+    out.putU64(categoryCodes.size());
+    for (const auto& entry : categoryCodes) {
+        out.putString(entry.first);
+        out.putU32(entry.second);
+    }
+}
+
+void NoteColumns::load(SnapshotReader& in) {
+    clear();
+    in.getVector(ids);
+    in.getVector(categories);
+    in.getVector(dates);
+    size_t codes = in.getCount(sizeof(uint64_t) + sizeof(uint32_t));
+    for (size_t i = 0; i < codes; i++) {
+        std::string category = in.getString();
+        categoryCodes[category] = in.getU32();
+    }
+    if (categories.size() != ids.size() || dates.size() != ids.size()) {
+        clear();
+        throw std::runtime_error("Снимок столбцов поврежден");
+    }
+    
+    // Номера строк восстанавливаются по столбцу ID
+    rowById.reserve(ids.size());
+    for (size_t row = 0; row < ids.size(); row++) {
+        rowById[ids[row]] = row;
+    }
+}
+
+void NoteColumns::clear() {
+    ids.clear();
+    categories.clear();
+    dates.clear();
+    rowById.clear();
+    categoryCodes.clear();
+}
+
+size_t NoteColumns::memoryUsage() const {
+    return vectorHeapBytes(ids) + vectorHeapBytes(categories) + vectorHeapBytes(dates) +
+           hashTableBytes(rowById) + stringKeyedTableBytes(categoryCodes);
+}
+
+uint32_t NoteColumns::dateKey(const std::string& date) {
+    // Формат ГГГГ-ММ-ДД
+    if (date.size() != 10 || date[4] != '-' || date[7] != '-') {
+        return 0;
+    }
+    uint32_t key = 0;
+    for (size_t i = 0; i < date.size(); i++) {
+        if (i == 4 || i == 7) {
+            continue;
+        }
+        if (!std::isdigit(static_cast<unsigned char>(date[i]))) {
+            return 0;
+        }
+        key = key * 10 + static_cast<uint32_t>(date[i] - '0');
+    }
+    return key;
+}
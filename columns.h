@@ -0,0 +1,50 @@
+#ifndef COLUMNS_H
+#define COLUMNS_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+// Столбцовое представление метаданных для полного просмотра векторными
+// ядрами (scan.h): тема хранится кодом из словаря, дата - числом ГГГГММДД.
+// Строки не упорядочены: удаление переносит последнюю строку на место удаленной.
+class NoteColumns {
+public:
+    void add(int id, const std::string& category, const std::string& date);
+    void remove(int id);
+    void setCategory(int id, const std::string& category);
+    
+    // ID заметок (по возрастанию) с указанной темой
+    std::vector<int> selectCategory(const std::string& category) const;
+    
+    // ID заметок (по возрастанию) с датой создания в диапазоне [from, to]
+    std::vector<int> selectDateRange(const std::string& from, const std::string& to) const;
+    
+    // Сохранение в снимок и восстановление без перестроения (snapshot.h)
+    void save(SnapshotWriter& out) const;
+    void load(SnapshotReader& in);
+    
+    void clear();
+    size_t size() const { return ids.size(); }
+    // Байты кучи столбцов и словаря тем (memory.h)
+    size_t memoryUsage() const;
+    
+    // Дата ГГГГ-ММ-ДД в виде числа ГГГГММДД (0 для некорректной даты)
+    static uint32_t dateKey(const std::string& date);
+    
+private:
+    std::vector<int> ids;                                   // ID заметки
+    std::vector<uint32_t> categories;                       // Код темы
+    std::vector<uint32_t> dates;                            // Дата ГГГГММДД
+    std::unordered_map<int, size_t> rowById;                // ID -> номер строки
+    std::unordered_map<std::string, uint32_t> categoryCodes; // Словарь тем
+    
+    uint32_t categoryCode(const std::string& category);
+    std::vector<int> rowsToIds(const std::vector<uint32_t>& rows) const;
+};
+
+#endif // COLUMNS_H
@@ -0,0 +1,114 @@
+#include "fileio.h"
+#include <fstream>
+#include <sys/stat.h>
+
+bool readWholeFile(const std::string& path, std::string& buffer) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    // Один вызов read в буфер нужного размера вместо построчной сборки
+    buffer.resize(static_cast<size_t>(st.st_size));
+    file.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+    
+    // Файл мог укоротиться между stat() и read()
+    buffer.resize(static_cast<size_t>(file.gcount()));
+    return true;
+}
+
+bool readFileStamp(const std::string& path, FileStamp& stamp) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        stamp = FileStamp();
+        return false;
+    }
+    stamp.size = static_cast<int64_t>(st.st_size);
+#ifdef __linux__
+    stamp.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#else
+    stamp.mtimeNs = static_cast<int64_t>(st.st_mtime) * 1000000000;
+#endif
+    return true;
+}
+
+std::string_view noteBodyView(std::string_view fileData, int headerLines) {
+    size_t pos = 0;
+    for (int i = 0; i < headerLines; i++) {
+        size_t newline = fileData.find('\n', pos);
+        if (newline == std::string_view::npos) {
+            // Файл короче заголовка - текста нет
+            return std::string_view();
+        }
+        pos = newline + 1;
+    }
+    return fileData.substr(pos);
+}
+
+std::string readNoteBody(const std::string& path) {
+    std::string buffer;
+    if (!readWholeFile(path, buffer)) {
+        return "";
+    }
+    
+    std::string_view body = noteBodyView(buffer);
+    if (body.size() == buffer.size()) {
+        return buffer;
+    }
+    
+    // Сдвигаем текст в начало буфера, чтобы не выделять память повторно
+    size_t offset = buffer.size() - body.size();
+    buffer.erase(0, offset);
+    return buffer;
+}
+
+// Значение строки заголовка с заданной меткой; pos сдвигается на следующую строку
+static bool headerField(std::string_view data, size_t& pos, std::string_view label, std::string& value) {
+    size_t newline = data.find('\n', pos);
+    if (newline == std::string_view::npos) {
+        return false;
+    }
+    std::string_view line = data.substr(pos, newline - pos);
+    pos = newline + 1;
+    if (line.substr(0, label.size()) != label) {
+        return false;
+    }
+    value.assign(line.substr(label.size()));
+    return true;
+}
+
+bool parseNoteHeader(std::string_view fileData, std::string& title,
+                     std::string& category, std::string& date) {
+    size_t pos = 0;
+    return headerField(fileData, pos, "Название: ", title) &&
+           headerField(fileData, pos, "Тема: ", category) &&
+           headerField(fileData, pos, "Дата: ", date);
+}
+
+bool parseNoteBodyRef(std::string_view fileData, std::string& hash) {
+    static const std::string_view label = "Текст: ";
+    const size_t hashLength = 32;
+    
+    std::string_view line = noteBodyView(fileData, NOTE_HEADER_LINES - 1);
+    if (line.substr(0, label.size()) != label) {
+        return false;
+    }
+    line.remove_prefix(label.size());
+    if (line.size() < hashLength ||
+        (line.size() > hashLength && line.substr(hashLength) != "\n")) {
+        return false;
+    }
+    for (size_t i = 0; i < hashLength; i++) {
+        char c = line[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    hash.assign(line.substr(0, hashLength));
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef FILEIO_H
+#define FILEIO_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Количество строк заголовка в файле заметки (название, тема, дата, пустая строка)
+const int NOTE_HEADER_LINES = 4;
+
+// Чтение файла целиком за одну операцию в заранее выделенный буфер.
+// Размер файла определяется через stat(), поэтому буфер не перевыделяется.
+// Возвращает false, если файл не удалось открыть или прочитать.
+bool readWholeFile(const std::string& path, std::string& buffer);
+
+// Представление текста заметки внутри прочитанного файла: все, что идет
+// после строк заголовка. Завершающий перевод строки сохраняется.
+std::string_view noteBodyView(std::string_view fileData, int headerLines = NOTE_HEADER_LINES);
+
+// Чтение текста заметки из файла (readWholeFile + noteBodyView)
+std::string readNoteBody(const std::string& path);
+
+// Размер и время изменения файла (для проверки, менялся ли файл)
+struct FileStamp {
+    int64_t size = -1;          // -1 - файла нет
+    int64_t mtimeNs = 0;        // Время изменения в наносекундах
+    
+    bool operator==(const FileStamp& other) const {
+        return size == other.size && mtimeNs == other.mtimeNs;
+    }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+// Чтение размера и времени изменения через stat(); false - файла нет
+bool readFileStamp(const std::string& path, FileStamp& stamp);
+
+// Разбор заголовка файла заметки ("Название: ", "Тема: ", "Дата: ").
+// Возвращает false, если заголовок не в ожидаемом формате.
+bool parseNoteHeader(std::string_view fileData, std::string& title,
+                     std::string& category, std::string& date);
+
+// Ссылка на текст в хранилище текстов (bodystore.h): после заголовка идет
+// единственная строка "Текст: <32 шестнадцатеричные цифры>". Возвращает
+// false для файлов старого формата, где текст записан после пустой строки.
+bool parseNoteBodyRef(std::string_view fileData, std::string& hash);
+
+#endif // FILEIO_H
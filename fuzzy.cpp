@@ -0,0 +1,295 @@
+#include "fuzzy.h"
+#include "utf8.h"
+#include "snapshot.h"
+#include "memory.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+
+int boundedEditDistance(const std::u32string& a, const std::u32string& b, int limit) {
+    int n = static_cast<int>(a.size());
+    int m = static_cast<int>(b.size());
+    if (std::abs(n - m) > limit) {
+        return limit + 1;
+    }
+    
+    // Две строки таблицы динамического программирования
+    // (буферы переиспользуются между вызовами в пределах потока)
+    thread_local std::vector<int> previous;
+    thread_local std::vector<int> current;
+    previous.resize(m + 1);
+    current.resize(m + 1);
+    for (int j = 0; j <= m; j++) {
+        previous[j] = j;
+    }
+    
+    for (int i = 1; i <= n; i++) {
+        current[0] = i;
+        int rowMin = current[0];
+        for (int j = 1; j <= m; j++) {
+            int cost = (a[i - 1] == b[j - 1]) ? 0 : 1;
+            current[j] = std::min({previous[j] + 1, current[j - 1] + 1, previous[j - 1] + cost});
+            rowMin = std::min(rowMin, current[j]);
+        }
+        // Все значения строки превысили предел - дальше они только растут
+        if (rowMin > limit) {
+            return limit + 1;
+        }
+        previous.swap(current);
+    }
+    
+    return std::min(previous[m], limit + 1);
+}
+
+// Число ID в узле, начиная с которого удаление идет через карту позиций
+const size_t BKTREE_INDEXED_IDS = 64;
+
+BKTree::BKTree() : idCount(0), emptyNodes(0) {}
+
+std::u32string BKTree::makeKey(const std::string& text) {
+    return decodeUtf8(foldCaseUtf8(text));
+}
+
+void BKTree::insert(const std::string& key, int id) {
+    std::u32string folded = makeKey(key);
+    idCount++;
+    
+    // Ключ уже есть в дереве - только добавляем ID
+    auto existing = nodeByKey.find(folded);
+    if (existing != nodeByKey.end()) {
+        Node& node = nodes[existing->second];
+        if (node.ids.empty()) {
+            emptyNodes--;
+        }
+        node.ids.push_back(id);
+        if (!node.positions.empty()) {
+            node.positions[id] = static_cast<uint32_t>(node.ids.size() - 1);
+        }
+        return;
+    }
+    
+    int newIndex = static_cast<int>(nodes.size());
+    if (!nodes.empty()) {
+        // Спускаемся по ребрам с расстоянием до текущего узла
+        int current = 0;
+        while (true) {
+            int distance = boundedEditDistance(folded, nodes[current].key,
+                static_cast<int>(std::max(folded.size(), nodes[current].key.size())));
+            
+            int next = -1;
+            for (const auto& child : nodes[current].children) {
+                if (child.first == distance) {
+                    next = child.second;
+                    break;
+                }
+            }
+            if (next < 0) {
+                nodes[current].children.emplace_back(distance, newIndex);
+                nodes[current].maxEdge = std::max(nodes[current].maxEdge, distance);
+                break;
+            }
+            current = next;
+        }
+    }
+    
+    Node node;
+    node.key = folded;
+    node.ids.push_back(id);
+    node.maxEdge = 0;
+    nodes.push_back(std::move(node));
+    nodeByKey.emplace(std::move(folded), newIndex);
+}
+
+bool BKTree::erase(const std::string& key, int id) {
+    auto existing = nodeByKey.find(makeKey(key));
+    if (existing == nodeByKey.end()) {
+        return false;
+    }
+    
+    Node& node = nodes[existing->second];
+    std::vector<int>& ids = node.ids;
+    size_t pos;
+    if (!node.positions.empty() || ids.size() > BKTREE_INDEXED_IDS) {
+        if (node.positions.empty()) {
+            node.positions.reserve(ids.size());
+            for (size_t i = 0; i < ids.size(); i++) {
+                node.positions[ids[i]] = static_cast<uint32_t>(i);
+            }
+        }
+        auto it = node.positions.find(id);
+        if (it == node.positions.end()) {
+            return false;
+        }
+        pos = it->second;
+        node.positions.erase(it);
+        if (pos + 1 != ids.size()) {
+            node.positions[ids.back()] = static_cast<uint32_t>(pos);
+        }
+    } else {
+        auto found = std::find(ids.begin(), ids.end(), id);
+        if (found == ids.end()) {
+            return false;
+        }
+        pos = static_cast<size_t>(found - ids.begin());
+    }
+    ids[pos] = ids.back();
+    ids.pop_back();
+    idCount--;
+    
+    // Пустой узел остается в дереве для навигации, пока их не станет слишком много
+    if (ids.empty()) {
+        emptyNodes++;
+        if (emptyNodes > 64 && emptyNodes * 2 > nodes.size()) {
+            rebuild();
+        }
+    }
+    return true;
+}
+
+size_t BKTree::eraseIds(const std::unordered_set<int>& ids) {
+    size_t erased = 0;
+    for (Node& node : nodes) {
+        if (node.ids.empty()) {
+            continue;
+        }
+        size_t before = node.ids.size();
+        node.ids.erase(std::remove_if(node.ids.begin(), node.ids.end(),
+                                      [&](int id) { return ids.count(id) != 0; }),
+                       node.ids.end());
+        erased += before - node.ids.size();
+        if (before != node.ids.size()) {
+            // Позиции сдвинулись - карта строится заново при следующем удалении
+            node.positions.clear();
+        }
+        if (node.ids.empty()) {
+            emptyNodes++;
+        }
+    }
+    idCount -= erased;
+    
+    if (emptyNodes > 64 && emptyNodes * 2 > nodes.size()) {
+        rebuild();
+    }
+    return erased;
+}
+
+std::vector<FuzzyMatch> BKTree::search(const std::string& query, int maxDistance) const {
+    std::vector<FuzzyMatch> result;
+    if (nodes.empty()) {
+        return result;
+    }
+    
+    std::u32string folded = makeKey(query);
+    std::vector<int> stack;
+    stack.push_back(0);
+    
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+        
+        // Точное расстояние нужно только до maxEdge + k: дальше ни один потомок не подходит
+        int limit = node.maxEdge + maxDistance;
+        int distance = boundedEditDistance(folded, node.key, limit);
+        
+        if (distance <= maxDistance) {
+            for (int id : node.ids) {
+                result.push_back({id, distance});
+            }
+        }
+        
+        for (const auto& child : node.children) {
+            if (child.first >= distance - maxDistance && child.first <= distance + maxDistance) {
+                stack.push_back(child.second);
+            }
+        }
+    }
+    
+    std::sort(result.begin(), result.end(), [](const FuzzyMatch& a, const FuzzyMatch& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+    });
+    return result;
+}
+
+void BKTree::clear() {
+    nodes.clear();
+    nodeByKey.clear();
+    idCount = 0;
+    emptyNodes = 0;
+}
+
+size_t BKTree::memoryUsage() const {
+    size_t bytes = vectorHeapBytes(nodes) + stringKeyedTableBytes(nodeByKey);
+    for (const Node& node : nodes) {
+        bytes += stringHeapBytes(node.key) + vectorHeapBytes(node.ids) + vectorHeapBytes(node.children) +
+                 hashTableBytes(node.positions);
+    }
+    return bytes;
+}
+
+void BKTree::save(SnapshotWriter& out) const {
+    out.putU64(nodes.size());
+    for (const Node& node : nodes) {
+        out.putU64(node.key.size());
+        out.putBytes(node.key.data(), node.key.size() * sizeof(char32_t));
+        out.putVector(node.ids);
+        out.putU64(node.children.size());
+        for (const auto& child : node.children) {
+            out.putU32(static_cast<uint32_t>(child.first));
+            out.putU32(static_cast<uint32_t>(child.second));
+        }
+        out.putU32(static_cast<uint32_t>(node.maxEdge));
+    }
+    out.putU64(idCount);
+    out.putU64(emptyNodes);
+}
+
+void BKTree::load(SnapshotReader& in) {
+    clear();
+    size_t count = in.getCount(3 * sizeof(uint64_t) + sizeof(uint32_t));
+    nodes.resize(count);
+    nodeByKey.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        Node& node = nodes[i];
+        node.key.resize(in.getCount(sizeof(char32_t)));
+        in.getBytes(&node.key[0], node.key.size() * sizeof(char32_t));
+        in.getVector(node.ids);
+        node.children.resize(in.getCount(2 * sizeof(uint32_t)));
+        for (auto& child : node.children) {
+            child.first = static_cast<int>(in.getU32());
+            child.second = static_cast<int>(in.getU32());
+        }
+        node.maxEdge = static_cast<int>(in.getU32());
+        nodeByKey[node.key] = static_cast<int>(i);
+    }
+    idCount = in.getU64();
+    emptyNodes = in.getU64();
+    
+    // Ссылки на потомков должны указывать внутрь массива узлов
+    for (const Node& node : nodes) {
+        for (const auto& child : node.children) {
+            if (child.second <= 0 || static_cast<size_t>(child.second) >= count) {
+                clear();
+                throw std::runtime_error("Снимок BK-дерева поврежден");
+            }
+        }
+    }
+}
+
+void BKTree::rebuild() {
+    std::vector<Node> oldNodes;
+    oldNodes.swap(nodes);
+    clear();
+    
+    for (const Node& node : oldNodes) {
+        if (node.ids.empty()) {
+            continue;
+        }
+        std::string key;
+        for (char32_t cp : node.key) {
+            appendUtf8(key, cp);
+        }
+        for (int id : node.ids) {
+            insert(key, id);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef FUZZY_H
+#define FUZZY_H
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+// Результат нечеткого поиска
+struct FuzzyMatch {
+    int id;                     // ID заметки
+    int distance;               // Расстояние редактирования до запроса
+};
+
+// Расстояние Левенштейна с ограничением: если расстояние больше limit,
+// возвращается limit + 1 (вычисление прекращается досрочно)
+int boundedEditDistance(const std::u32string& a, const std::u32string& b, int limit);
+
+// BK-дерево для поиска строк с опечатками. Ключи хранятся приведенными
+// к нижнему регистру, поэтому "Работа" и "работа" совпадают точно.
+// Поиск с ограниченным расстоянием k обходит только ветви, у которых
+// расстояние до узла лежит в интервале [d - k, d + k].
+class BKTree {
+public:
+    BKTree();
+    
+    void insert(const std::string& key, int id);
+    bool erase(const std::string& key, int id);
+    // Массовое удаление за один проход по узлам (у темы могут быть тысячи ID)
+    size_t eraseIds(const std::unordered_set<int>& ids);
+    
+    // Все ID с расстоянием не больше maxDistance, по возрастанию (расстояние, ID)
+    std::vector<FuzzyMatch> search(const std::string& query, int maxDistance) const;
+    
+    // Сохранение в снимок и восстановление без перестроения (snapshot.h)
+    void save(SnapshotWriter& out) const;
+    void load(SnapshotReader& in);
+    
+    void clear();
+    size_t size() const { return idCount; }
+    // Байты кучи дерева (memory.h)
+    size_t memoryUsage() const;
+    
+private:
+    struct Node {
+        std::u32string key;                         // Ключ в нижнем регистре
+        std::vector<int> ids;                       // Заметки с этим ключом
+        std::vector<std::pair<int, int>> children;  // (расстояние, индекс узла)
+        int maxEdge;                                // Наибольшее расстояние до потомка
+        // Позиции ID в ids - только у узлов с множеством ID (тема с тысячами
+        // заметок), чтобы удаление одного ID не просматривало весь список.
+        // Строится при первом таком удалении, в снимок не сохраняется
+        std::unordered_map<int, uint32_t> positions;
+    };
+    
+    std::vector<Node> nodes;                        // Узлы, корень - nodes[0]
+    std::unordered_map<std::u32string, int> nodeByKey;
+    size_t idCount;                                 // Всего ID в дереве
+    size_t emptyNodes;                              // Узлы без ID после удалений
+    
+    static std::u32string makeKey(const std::string& text);
+    
+    // Перестроение дерева без пустых узлов
+    void rebuild();
+};
+
+#endif // FUZZY_H
@@ -0,0 +1,700 @@
+#include "history.h"
+#include "checksum.h"
+#include "fileio.h"
+#include "memory.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+    #include <direct.h>
+    #define mkdir(path, mode) _mkdir(path)
+#else
+    #include <sys/stat.h>
+#endif
+
+// Сигнатура файла истории (последние два символа - версия формата)
+static const char HISTORY_MAGIC[8] = {'T', 'M', 'H', 'I', 'S', 'T', '0', '1'};
+
+// Ограничение длины записи: все, что больше, считается повреждением
+const uint32_t HISTORY_MAX_RECORD = 1u << 30;
+
+// Длина куска, по которому ищутся совпадения с предыдущим текстом
+const size_t DELTA_BLOCK = 32;
+
+// Команды разницы
+const unsigned char DELTA_COPY = 1;     // смещение, длина: кусок предыдущего текста
+const unsigned char DELTA_INSERT = 2;   // длина, байты: новый кусок
+
+// Вид записи
+const unsigned char RECORD_KEYFRAME = 0;
+const unsigned char RECORD_DELTA = 1;
+
+// Больше стольких пар строк сравнение не строит таблицу, а выдает замену целиком
+const size_t DIFF_MAX_CELLS = 1u << 24;
+
+// ===== КОДИРОВАНИЕ ЧИСЕЛ =====
+
+static void putU32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+static void putU64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+static uint32_t getU32(const unsigned char* bytes) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+static uint64_t getU64(const unsigned char* bytes) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+// Числа в разнице - переменной длины (по 7 бит в байте, младшие первыми)
+static void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static bool getVarint(std::string_view data, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < data.size(); shift += 7) {
+        unsigned char byte = static_cast<unsigned char>(data[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ===== РАЗНИЦА ТЕКСТОВ =====
+
+static void putCopy(std::string& out, size_t offset, size_t length) {
+    out.push_back(static_cast<char>(DELTA_COPY));
+    putVarint(out, offset);
+    putVarint(out, length);
+}
+
+static void putInsert(std::string& out, std::string_view bytes) {
+    if (bytes.empty()) {
+        return;
+    }
+    out.push_back(static_cast<char>(DELTA_INSERT));
+    putVarint(out, bytes.size());
+    out.append(bytes);
+}
+
+std::string encodeDelta(std::string_view base, std::string_view target) {
+    std::string out;
+    
+    // Обычная правка затрагивает одно место: общие начало и конец
+    // копируются целиком, совпадения ищутся только в середине
+    size_t limit = std::min(base.size(), target.size());
+    size_t prefix = 0;
+    while (prefix < limit && base[prefix] == target[prefix]) {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < limit - prefix &&
+           base[base.size() - 1 - suffix] == target[target.size() - 1 - suffix]) {
+        suffix++;
+    }
+    if (prefix > 0) {
+        putCopy(out, 0, prefix);
+    }
+    
+    // Куски предыдущего текста по границам DELTA_BLOCK: хеш -> смещение
+    std::unordered_map<std::string_view, size_t> blocks;
+    for (size_t pos = 0; pos + DELTA_BLOCK <= base.size(); pos += DELTA_BLOCK) {
+        blocks.emplace(base.substr(pos, DELTA_BLOCK), pos);
+    }
+    
+    size_t end = target.size() - suffix;
+    size_t pending = prefix;    // Начало еще не записанной вставки
+    size_t pos = prefix;
+    while (pos + DELTA_BLOCK <= end) {
+        auto it = blocks.find(target.substr(pos, DELTA_BLOCK));
+        if (it == blocks.end()) {
+            pos++;
+            continue;
+        }
+    
+        // Совпадение расширяется в обе стороны
+        size_t offset = it->second;
+        size_t length = DELTA_BLOCK;
+        while (pos + length < end && offset + length < base.size() &&
+               target[pos + length] == base[offset + length]) {
+            length++;
+        }
+        while (pos > pending && offset > 0 && target[pos - 1] == base[offset - 1]) {
+            pos--;
+            offset--;
+            length++;
+        }
+        putInsert(out, target.substr(pending, pos - pending));
+        putCopy(out, offset, length);
+        pos += length;
+        pending = pos;
+    }
+    putInsert(out, target.substr(pending, end - pending));
+    
+    if (suffix > 0) {
+        putCopy(out, base.size() - suffix, suffix);
+    }
+    return out;
+}
+
+bool applyDelta(std::string_view base, std::string_view delta, std::string& out) {
+    out.clear();
+    size_t pos = 0;
+    while (pos < delta.size()) {
+        unsigned char op = static_cast<unsigned char>(delta[pos++]);
+        uint64_t first = 0;
+        if (!getVarint(delta, pos, first)) {
+            return false;
+        }
+        if (op == DELTA_COPY) {
+            uint64_t length = 0;
+            if (!getVarint(delta, pos, length) || first > base.size() || length > base.size() - first) {
+                return false;
+            }
+            out.append(base.substr(first, length));
+        } else if (op == DELTA_INSERT) {
+            if (first > delta.size() - pos) {
+                return false;
+            }
+            out.append(delta.substr(pos, first));
+            pos += first;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ===== СРАВНЕНИЕ ВЕРСИЙ =====
+
+static std::vector<std::string_view> splitLines(std::string_view text) {
+    std::vector<std::string_view> lines;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        lines.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return lines;
+}
+
+std::vector<DiffLine> diffLines(std::string_view before, std::string_view after) {
+    std::vector<std::string_view> a = splitLines(before);
+    std::vector<std::string_view> b = splitLines(after);
+    std::vector<DiffLine> result;
+    
+    // Общие строки в начале и в конце в таблицу не попадают
+    size_t prefix = 0;
+    while (prefix < a.size() && prefix < b.size() && a[prefix] == b[prefix]) {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < a.size() - prefix && suffix < b.size() - prefix &&
+           a[a.size() - 1 - suffix] == b[b.size() - 1 - suffix]) {
+        suffix++;
+    }
+    for (size_t i = 0; i < prefix; i++) {
+        result.push_back({' ', std::string(a[i])});
+    }
+    
+    size_t n = a.size() - prefix - suffix;
+    size_t m = b.size() - prefix - suffix;
+    if (n * m > DIFF_MAX_CELLS) {
+        for (size_t i = 0; i < n; i++) {
+            result.push_back({'-', std::string(a[prefix + i])});
+        }
+        for (size_t j = 0; j < m; j++) {
+            result.push_back({'+', std::string(b[prefix + j])});
+        }
+    } else {
+        // lcs[i][j] - длина общей подпоследовательности хвостов a[i..] и b[j..]
+        std::vector<uint32_t> lcs((n + 1) * (m + 1), 0);
+        auto cell = [&](size_t i, size_t j) -> uint32_t& { return lcs[i * (m + 1) + j]; };
+        for (size_t i = n; i-- > 0;) {
+            for (size_t j = m; j-- > 0;) {
+                cell(i, j) = a[prefix + i] == b[prefix + j] ? cell(i + 1, j + 1) + 1
+                                                            : std::max(cell(i + 1, j), cell(i, j + 1));
+            }
+        }
+        size_t i = 0;
+        size_t j = 0;
+        while (i < n || j < m) {
+            if (i < n && j < m && a[prefix + i] == b[prefix + j]) {
+                result.push_back({' ', std::string(a[prefix + i])});
+                i++;
+                j++;
+            } else if (j < m && (i == n || cell(i, j + 1) >= cell(i + 1, j))) {
+                result.push_back({'+', std::string(b[prefix + j])});
+                j++;
+            } else {
+                result.push_back({'-', std::string(a[prefix + i])});
+                i++;
+            }
+        }
+    }
+    
+    for (size_t i = a.size() - suffix; i < a.size(); i++) {
+        result.push_back({' ', std::string(a[i])});
+    }
+    return result;
+}
+
+// ===== ИСТОРИЯ ВЕРСИЙ =====
+
+struct RevisionHistory::Record {
+    RevisionInfo info;
+    std::string payload;        // Полный текст или разница
+};
+
+// Запись файла истории: длина, тело, CRC-32 тела
+static std::string formatRecord(const RevisionInfo& info, std::string_view payload) {
+    std::string body;
+    putU32(body, info.number);
+    putU64(body, static_cast<uint64_t>(info.savedAt));
+    body.push_back(static_cast<char>(info.keyframe ? RECORD_KEYFRAME : RECORD_DELTA));
+    putU32(body, static_cast<uint32_t>(info.title.size()));
+    body += info.title;
+    putU32(body, static_cast<uint32_t>(info.category.size()));
+    body += info.category;
+    putU64(body, info.size);
+    body += payload;
+    
+    std::string record;
+    putU32(record, static_cast<uint32_t>(body.size()));
+    record += body;
+    putU32(record, crc32String(body));
+    return record;
+}
+
+// Последовательное чтение полей тела записи с проверкой границ
+struct BodyReader {
+    const unsigned char* data;
+    size_t size;
+    size_t pos = 0;
+    
+    bool u8(unsigned char& value) {
+        if (size - pos < 1) {
+            return false;
+        }
+        value = data[pos++];
+        return true;
+    }
+    bool u32(uint32_t& value) {
+        if (size - pos < 4) {
+            return false;
+        }
+        value = getU32(data + pos);
+        pos += 4;
+        return true;
+    }
+    bool u64(uint64_t& value) {
+        if (size - pos < 8) {
+            return false;
+        }
+        value = getU64(data + pos);
+        pos += 8;
+        return true;
+    }
+    bool text(std::string& value) {
+        uint32_t length = 0;
+        if (!u32(length) || length > size - pos) {
+            return false;
+        }
+        value.assign(reinterpret_cast<const char*>(data + pos), length);
+        pos += length;
+        return true;
+    }
+};
+
+RevisionHistory::RevisionHistory(const std::string& directory)
+    : directory(directory), keepRevisions(HISTORY_KEEP_REVISIONS) {
+    // Каталог создается при первой записи; здесь запоминаются заметки,
+    // у которых история уже есть
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        std::filesystem::path path = entry.path();
+        if (path.extension() != ".hist") {
+            continue;
+        }
+        try {
+            ids.insert(std::stoi(path.stem().string()));
+        } catch (const std::exception&) {
+            // Посторонний файл
+        }
+    }
+}
+
+RevisionHistory::~RevisionHistory() {
+    waitForCompaction();
+    pool.reset();
+}
+
+std::string RevisionHistory::pathOf(int id) const {
+    return directory + "/" + std::to_string(id) + ".hist";
+}
+
+bool RevisionHistory::has(int id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ids.count(id) != 0;
+}
+
+bool RevisionHistory::readRecords(int id, std::vector<Record>& records, uint64_t& validSize) const {
+    records.clear();
+    validSize = 0;
+    std::string data;
+    if (ids.count(id) == 0 || !readWholeFile(pathOf(id), data)) {
+        return false;
+    }
+    if (data.size() < sizeof(HISTORY_MAGIC) || std::memcmp(data.data(), HISTORY_MAGIC, sizeof(HISTORY_MAGIC)) != 0) {
+        return false;
+    }
+    
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+    size_t offset = sizeof(HISTORY_MAGIC);
+    validSize = offset;
+    while (data.size() - offset >= 8) {
+        uint32_t length = getU32(bytes + offset);
+        if (length > HISTORY_MAX_RECORD || length > data.size() - offset - 8) {
+            break;
+        }
+        const unsigned char* body = bytes + offset + 4;
+        if (crc32(body, length) != getU32(body + length)) {
+            break;
+        }
+    
+        Record record;
+        BodyReader reader{body, length};
+        unsigned char kind = 0;
+        uint64_t savedAt = 0;
+        if (!reader.u32(record.info.number) || !reader.u64(savedAt) || !reader.u8(kind) ||
+            !reader.text(record.info.title) || !reader.text(record.info.category) ||
+            !reader.u64(record.info.size) || kind > RECORD_DELTA) {
+            break;
+        }
+        record.info.savedAt = static_cast<int64_t>(savedAt);
+        record.info.keyframe = kind == RECORD_KEYFRAME;
+        record.info.storedBytes = length + 8;
+        record.payload.assign(reinterpret_cast<const char*>(body + reader.pos), length - reader.pos);
+        records.push_back(std::move(record));
+    
+        offset += length + 8;
+        validSize = offset;
+    }
+    return true;
+}
+
+bool RevisionHistory::rebuild(const std::vector<Record>& records, size_t index, std::string& content) const {
+    // От ближайшей опорной версии применяется не больше HISTORY_KEYFRAME_INTERVAL - 1 разниц
+    size_t start = index;
+    while (!records[start].info.keyframe) {
+        if (start == 0) {
+            return false;
+        }
+        start--;
+    }
+    content = records[start].payload;
+    std::string next;
+    for (size_t i = start + 1; i <= index; i++) {
+        if (!applyDelta(content, records[i].payload, next) || next.size() != records[i].info.size) {
+            return false;
+        }
+        content.swap(next);
+    }
+    return content.size() == records[index].info.size;
+}
+
+RevisionHistory::Chain& RevisionHistory::chainOf(int id) const {
+    auto it = chains.find(id);
+    if (it != chains.end()) {
+        return it->second;
+    }
+    
+    Chain chain;
+    std::vector<Record> records;
+    readRecords(id, records, chain.validSize);
+    
+    // Последняя версия, которую удалось восстановить, становится концом цепочки:
+    // записи после нее (поврежденная разница) отбрасываются
+    std::string content;
+    size_t valid = records.size();
+    while (valid > 0 && !rebuild(records, valid - 1, content)) {
+        chain.validSize -= records[valid - 1].info.storedBytes;
+        valid--;
+    }
+    if (valid > 0) {
+        chain.count = static_cast<uint32_t>(valid);
+        chain.lastNumber = records[valid - 1].info.number;
+        chain.lastHash = contentHash(content);
+        while (chain.sinceKeyframe < valid && !records[valid - 1 - chain.sinceKeyframe].info.keyframe) {
+            chain.sinceKeyframe++;
+        }
+    }
+    return chains.emplace(id, std::move(chain)).first->second;
+}
+
+bool RevisionHistory::appendRecord(int id, Chain& chain, const NoteVersion& version, const std::string* base) {
+    // Разница пишется, если предыдущая версия известна, цепочка не слишком
+    // длинная и разница заметно меньше полного текста
+    std::string payload;
+    bool keyframe = base == nullptr || chain.count == 0 || chain.sinceKeyframe + 1 >= HISTORY_KEYFRAME_INTERVAL;
+    if (!keyframe) {
+        payload = encodeDelta(*base, version.content);
+        keyframe = payload.size() * 2 >= version.content.size() && !version.content.empty();
+    }
+    if (keyframe) {
+        payload = version.content;
+    }
+    
+    RevisionInfo info;
+    info.number = chain.lastNumber + 1;
+    info.savedAt = version.savedAt;
+    info.title = version.title;
+    info.category = version.category;
+    info.size = version.content.size();
+    info.keyframe = keyframe;
+    std::string record = formatRecord(info, payload);
+    
+    std::string path = pathOf(id);
+    std::error_code ec;
+    if (chain.validSize == 0) {
+        // Новый файл (или файл с поврежденной сигнатурой)
+        mkdir(directory.c_str(), 0755);
+        record.insert(0, HISTORY_MAGIC, sizeof(HISTORY_MAGIC));
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(record.data(), static_cast<std::streamsize>(record.size()));
+        file.close();
+        if (!file) {
+            return false;
+        }
+    } else {
+        // Оборванная запись в конце файла отрезается перед дописыванием
+        if (std::filesystem::file_size(path, ec) != chain.validSize) {
+            std::filesystem::resize_file(path, chain.validSize, ec);
+            if (ec) {
+                return false;
+            }
+        }
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file.write(record.data(), static_cast<std::streamsize>(record.size()));
+        file.close();
+        if (!file) {
+            return false;
+        }
+    }
+    
+    ids.insert(id);
+    chain.count++;
+    chain.lastNumber++;
+    chain.sinceKeyframe = keyframe ? 0 : chain.sinceKeyframe + 1;
+    chain.lastHash = contentHash(version.content);
+    chain.validSize += record.size();
+    return true;
+}
+
+uint32_t RevisionHistory::record(int id, const NoteVersion& before, const NoteVersion& after) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Chain& chain = chainOf(id);
+    
+    // Состояние до изменения не совпадает с последней версией (или истории
+    // нет) - оно записывается отдельной опорной версией
+    if (chain.count == 0 || chain.lastHash != contentHash(before.content)) {
+        if (!appendRecord(id, chain, before, nullptr)) {
+            chains.erase(id);
+            return 0;
+        }
+    }
+    if (!appendRecord(id, chain, after, &before.content)) {
+        chains.erase(id);
+        return 0;
+    }
+    uint32_t number = chain.lastNumber;
+    
+    if (chain.count >= keepRevisions + HISTORY_KEYFRAME_INTERVAL && compactQueued.insert(id).second) {
+        if (!pool) {
+            pool = std::make_unique<ThreadPool>(1);
+        }
+        pool->submit([this, id]() {
+            std::lock_guard<std::mutex> taskLock(mutex);
+            compactQueued.erase(id);
+            try {
+                compactLocked(id);
+            } catch (const std::exception& e) {
+                std::cout << "Предупреждение: история заметки " << id << " не сжата: " << e.what() << std::endl;
+            }
+        });
+    }
+    return number;
+}
+
+std::vector<RevisionInfo> RevisionHistory::list(int id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Record> records;
+    uint64_t validSize = 0;
+    readRecords(id, records, validSize);
+    
+    std::vector<RevisionInfo> result;
+    result.reserve(records.size());
+    for (Record& record : records) {
+        result.push_back(std::move(record.info));
+    }
+    return result;
+}
+
+bool RevisionHistory::get(int id, uint32_t number, NoteVersion& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Record> records;
+    uint64_t validSize = 0;
+    readRecords(id, records, validSize);
+    
+    auto it = std::lower_bound(records.begin(), records.end(), number,
+                               [](const Record& record, uint32_t value) { return record.info.number < value; });
+    if (it == records.end() || it->info.number != number ||
+        !rebuild(records, static_cast<size_t>(it - records.begin()), out.content)) {
+        return false;
+    }
+    out.title = it->info.title;
+    out.category = it->info.category;
+    out.savedAt = it->info.savedAt;
+    return true;
+}
+
+bool RevisionHistory::diff(int id, uint32_t from, uint32_t to, std::vector<DiffLine>& out) const {
+    NoteVersion before;
+    NoteVersion after;
+    if (!get(id, from, before) || !get(id, to, after)) {
+        return false;
+    }
+    out = diffLines(before.content, after.content);
+    return true;
+}
+
+void RevisionHistory::remove(int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ids.erase(id) != 0) {
+        std::remove(pathOf(id).c_str());
+    }
+    chains.erase(id);
+}
+
+void RevisionHistory::setKeepRevisions(size_t keep) {
+    std::lock_guard<std::mutex> lock(mutex);
+    keepRevisions = std::max<size_t>(keep, 1);
+}
+
+bool RevisionHistory::compact(int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return compactLocked(id);
+}
+
+bool RevisionHistory::compactLocked(int id) {
+    std::vector<Record> records;
+    uint64_t validSize = 0;
+    readRecords(id, records, validSize);
+    if (records.size() <= keepRevisions) {
+        return false;
+    }
+    
+    // Первая оставшаяся версия восстанавливается и записывается полностью,
+    // следующие разницы ссылаются на оставшиеся версии и копируются как есть
+    size_t first = records.size() - keepRevisions;
+    std::string content;
+    if (!rebuild(records, first, content)) {
+        return false;
+    }
+    records[first].payload = std::move(content);
+    records[first].info.keyframe = true;
+    
+    std::string data(HISTORY_MAGIC, sizeof(HISTORY_MAGIC));
+    for (size_t i = first; i < records.size(); i++) {
+        data += formatRecord(records[i].info, records[i].payload);
+    }
+    
+    // Замена через временный файл: при сбое остается полная старая история
+    std::string path = pathOf(id);
+    std::string tmpPath = path + ".tmp";
+    std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    file.close();
+    if (!file) {
+        std::remove(tmpPath.c_str());
+        throw std::runtime_error("Ошибка записи файла истории");
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        throw std::runtime_error("Не удалось заменить файл истории");
+    }
+    
+    // Цепочка перечитывается при следующей записи
+    chains.erase(id);
+    return true;
+}
+
+void RevisionHistory::waitForCompaction() {
+    if (pool) {
+        pool->wait();
+    }
+}
+
+HistoryStats RevisionHistory::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    HistoryStats result;
+    std::vector<Record> records;
+    for (int id : ids) {
+        uint64_t validSize = 0;
+        if (!readRecords(id, records, validSize)) {
+            continue;
+        }
+        result.notes++;
+        result.storedBytes += validSize;
+        for (const Record& record : records) {
+            result.revisions++;
+            result.keyframes += record.info.keyframe ? 1 : 0;
+            result.logicalBytes += record.info.size;
+        }
+    }
+    return result;
+}
+
+size_t RevisionHistory::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t bytes = hashTableBytes(ids) + hashTableBytes(chains) + hashTableBytes(compactQueued);
+    for (const auto& entry : chains) {
+        bytes += stringHeapBytes(entry.second.lastHash);
+    }
+    return bytes;
+}
@@ -0,0 +1,146 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class ThreadPool;
+
+// История версий заметок.
+//
+// Версии одной заметки лежат в файле <каталог>/<id>.hist, который только
+// дописывается. Каждая версия - это либо полный текст (опорная версия), либо
+// разница с предыдущей версией (команды "копировать кусок предыдущего текста"
+// и "вставить байты"). Опорная версия пишется каждые HISTORY_KEYFRAME_INTERVAL
+// версий и тогда, когда разница получилась не меньше половины текста, поэтому
+// для восстановления любой версии применяется не больше
+// HISTORY_KEYFRAME_INTERVAL - 1 разниц.
+//
+// Запись файла: u32 длина | тело | u32 CRC-32 тела (числа - little-endian).
+// Тело: u32 номер | u64 время | u8 вид | u32+название | u32+тема |
+// u64 размер текста | полный текст или разница. Оборванная запись в конце
+// файла (сбой при дописывании) отбрасывается.
+//
+// История появляется при первом изменении заметки: первой версией
+// записывается состояние до изменения.
+
+// Опорная версия - не реже чем каждые столько версий
+const uint32_t HISTORY_KEYFRAME_INTERVAL = 16;
+
+// Сколько последних версий оставляет сжатие истории
+const size_t HISTORY_KEEP_REVISIONS = 64;
+
+// Состояние заметки для записи в историю
+struct NoteVersion {
+    std::string title;
+    std::string category;
+    std::string content;
+    int64_t savedAt = 0;        // Время, мкс от начала эпохи
+};
+
+// Описание версии (без текста)
+struct RevisionInfo {
+    uint32_t number = 0;        // Номер версии (с 1, растет и после сжатия)
+    int64_t savedAt = 0;        // Время сохранения, мкс от начала эпохи
+    std::string title;
+    std::string category;
+    uint64_t size = 0;          // Размер текста
+    uint64_t storedBytes = 0;   // Размер записи в файле истории
+    bool keyframe = false;      // Полный текст, а не разница
+};
+
+// Строка построчного сравнения версий
+struct DiffLine {
+    char op;                    // ' ' - без изменений, '-' - удалена, '+' - добавлена
+    std::string text;
+};
+
+// Итог учета места под историю
+struct HistoryStats {
+    uint64_t notes = 0;         // Заметок с историей
+    uint64_t revisions = 0;     // Всего версий
+    uint64_t keyframes = 0;     // Из них опорных
+    uint64_t logicalBytes = 0;  // Сумма размеров текстов всех версий
+    uint64_t storedBytes = 0;   // Размер файлов истории
+};
+
+// Разница target относительно base и ее применение (false - разница повреждена)
+std::string encodeDelta(std::string_view base, std::string_view target);
+bool applyDelta(std::string_view base, std::string_view delta, std::string& out);
+
+// Построчное сравнение текстов (наибольшая общая подпоследовательность строк)
+std::vector<DiffLine> diffLines(std::string_view before, std::string_view after);
+
+class RevisionHistory {
+public:
+    explicit RevisionHistory(const std::string& directory);
+    ~RevisionHistory();
+    
+    RevisionHistory(const RevisionHistory&) = delete;
+    RevisionHistory& operator=(const RevisionHistory&) = delete;
+    
+    // Запись новой версии заметки. before - состояние до изменения: оно
+    // записывается первой версией, если истории еще нет или последняя
+    // версия с ним не совпадает (файл изменили мимо истории).
+    // Возвращает номер записанной версии (0 - ошибка записи).
+    uint32_t record(int id, const NoteVersion& before, const NoteVersion& after);
+    
+    // Версии заметки по возрастанию номера
+    std::vector<RevisionInfo> list(int id) const;
+    // Восстановление версии; false - такой версии нет или файл поврежден
+    bool get(int id, uint32_t number, NoteVersion& out) const;
+    // Построчное сравнение двух версий; false - одной из версий нет
+    bool diff(int id, uint32_t from, uint32_t to, std::vector<DiffLine>& out) const;
+    
+    bool has(int id) const;
+    // Удаление истории заметки (при окончательном удалении заметки)
+    void remove(int id);
+    
+    // Сжатие: в истории остаются keep последних версий, первая из них
+    // становится опорной. Запускается само в фоновом потоке, когда версий
+    // набирается keep + HISTORY_KEYFRAME_INTERVAL
+    void setKeepRevisions(size_t keep);
+    bool compact(int id);
+    void waitForCompaction();
+    
+    HistoryStats stats() const;
+    // Байты кучи сведений о цепочках в памяти (сами версии лежат в файлах, memory.h)
+    size_t memoryUsage() const;
+    std::string pathOf(int id) const;
+    const std::string& getDirectory() const { return directory; }
+
+private:
+    // Сведения о цепочке версий, нужные для дописывания
+    struct Chain {
+        uint32_t count = 0;             // Версий в файле
+        uint32_t lastNumber = 0;        // Номер последней версии
+        uint32_t sinceKeyframe = 0;     // Разниц после последней опорной версии
+        std::string lastHash;           // contentHash текста последней версии
+        uint64_t validSize = 0;         // Размер файла до оборванной записи
+    };
+    
+    struct Record;
+    
+    std::string directory;
+    size_t keepRevisions;
+    std::unordered_set<int> ids;                    // Заметки, у которых есть файл истории
+    mutable std::unordered_map<int, Chain> chains;  // Прочитанные цепочки
+    mutable std::mutex mutex;                       // Файлы истории и поля выше
+    std::unordered_set<int> compactQueued;          // Заметки в очереди на сжатие
+    std::unique_ptr<ThreadPool> pool;               // Поток фонового сжатия
+    
+    bool readRecords(int id, std::vector<Record>& records, uint64_t& validSize) const;
+    bool rebuild(const std::vector<Record>& records, size_t index, std::string& content) const;
+    Chain& chainOf(int id) const;
+    // base - текст предыдущей версии (nullptr - записать полный текст)
+    bool appendRecord(int id, Chain& chain, const NoteVersion& version, const std::string* base);
+    bool compactLocked(int id);
+};
+
+#endif // HISTORY_H
@@ -1,10 +1,96 @@
 #include "ui.h"
 #include <iostream>
+#include <string>
 
-int main() {
+// Вывод справки по параметрам командной строки
+static void printUsage(const char* program) {
+    std::cerr << "Использование: " << program << " [--store <директория>]" << std::endl;
+    std::cerr << "                [--export <архив> [--compress] | --import <архив> | --fsck]" << std::endl;
+    std::cerr << "                [--stats category|day|week|month|year]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
     try {
+        // Директория хранилища: --store <директория> (по умолчанию текущая)
+        std::string storeRoot = ".";
+        std::string exportPath;
+        std::string importPath;
+        bool compress = false;
+        bool fsck = false;
+        std::string statsGroup;
+        
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--store" && i + 1 < argc) {
+                storeRoot = argv[++i];
+            } else if (arg == "--export" && i + 1 < argc) {
+                exportPath = argv[++i];
+            } else if (arg == "--import" && i + 1 < argc) {
+                importPath = argv[++i];
+            } else if (arg == "--compress") {
+                compress = true;
+            } else if (arg == "--fsck") {
+                fsck = true;
+            } else if (arg == "--stats" && i + 1 < argc) {
+                statsGroup = argv[++i];
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        
         // Создаем менеджер заметок
-        NoteManager noteManager;
+        NoteManager noteManager(storeRoot);
+        
+        // Проверка хранилища без загрузки заметок в память
+        if (fsck) {
+            FsckReport report = noteManager.verifyStore();
+            for (const std::string& problem : report.problems) {
+                std::cout << problem << std::endl;
+            }
+            std::cout << "Записей: " << report.records
+                      << ", поврежденных: " << report.badRecords
+                      << ", без файла: " << report.missingFiles
+                      << ", с другим названием: " << report.titleMismatches
+                      << ", лишних файлов: " << report.orphanFiles.size()
+                      << ", без текста: " << report.missingBodies
+                      << ", лишних текстов: " << report.orphanBodies.size() << std::endl;
+            return report.ok() ? 0 : 2;
+        }
+        
+        // Число заметок по темам или интервалам дат (ключ и число через табуляцию)
+        if (!statsGroup.empty()) {
+            GroupBy by;
+            if (!parseGroupBy(statsGroup, by)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            noteManager.loadFromFile();
+            for (const GroupCount& group : noteManager.countBy(by)) {
+                std::cout << group.key << "\t" << group.count << std::endl;
+            }
+            return 0;
+        }
+        
+        // Пакетные команды выполняются без запуска меню
+        if (!exportPath.empty() || !importPath.empty()) {
+            noteManager.loadFromFile();
+            bool success = true;
+            if (!importPath.empty()) {
+                success = noteManager.importArchive(importPath);
+                if (success) {
+                    // Следующий запуск поднимет импортированное хранилище из снимка
+                    noteManager.saveSnapshot();
+                }
+            }
+            if (success && !exportPath.empty()) {
+                success = noteManager.exportArchive(exportPath, compress);
+                if (success) {
+                    std::cout << "Экспортировано заметок: " << noteManager.getNoteCount() << std::endl;
+                }
+            }
+            return success ? 0 : 1;
+        }
         
         // Создаем интерфейс пользователя
         UI ui(noteManager);
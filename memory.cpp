@@ -0,0 +1,58 @@
+#include "memory.h"
+#include <atomic>
+#include <fstream>
+#include <unistd.h>
+
+// Счетчики кучи. Атомарные переменные без конструктора инициализируются
+// до любого выделения памяти, поэтому учитываются и выделения статических
+// объектов других единиц трансляции.
+static std::atomic<bool> trackingEnabled{false};
+static std::atomic<uint64_t> liveBytes{0};
+static std::atomic<uint64_t> peakBytes{0};
+static std::atomic<uint64_t> liveBlocks{0};
+static std::atomic<uint64_t> totalAllocations{0};
+
+void enableAllocationTracking() {
+    trackingEnabled.store(true, std::memory_order_relaxed);
+}
+
+void recordAllocation(size_t bytes) {
+    uint64_t current = liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    liveBlocks.fetch_add(1, std::memory_order_relaxed);
+    totalAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (current > peak && !peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+}
+
+void recordDeallocation(size_t bytes) {
+    liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    liveBlocks.fetch_sub(1, std::memory_order_relaxed);
+}
+
+AllocationStats allocationStats() {
+    AllocationStats stats;
+    stats.enabled = trackingEnabled.load(std::memory_order_relaxed);
+    stats.bytes = liveBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = peakBytes.load(std::memory_order_relaxed);
+    stats.blocks = liveBlocks.load(std::memory_order_relaxed);
+    stats.allocations = totalAllocations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void resetPeakAllocation() {
+    peakBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+uint64_t residentBytes() {
+    // /proc/self/statm: размер программы и резидентная часть в страницах
+    std::ifstream statm("/proc/self/statm");
+    uint64_t pages = 0;
+    uint64_t resident = 0;
+    if (!(statm >> pages >> resident)) {
+        return 0;
+    }
+    long pageSize = sysconf(_SC_PAGESIZE);
+    return resident * static_cast<uint64_t>(pageSize > 0 ? pageSize : 4096);
+}
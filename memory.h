@@ -0,0 +1,95 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Учет памяти структур хранилища.
+//
+// Каждая структура оценивает байты кучи, которыми владеет, по своим полям:
+// емкости векторов и строк, узлы и массив корзин хеш-таблиц. Размер блока
+// считается так, как его выделяет malloc (glibc: заголовок 8 байт, выравнивание
+// 16, не меньше 32 байт), поэтому сумма оценок сравнима со счетчиком кучи.
+//
+// Счетчик кучи работает, если в программу собран alloc_hooks.cpp (замена
+// operator new/delete) - так собирается memtest_runner. Без него
+// allocationStats() возвращает enabled = false.
+
+// Размер блока malloc под запрос в bytes байт (0 - блока нет)
+inline size_t heapBlockBytes(size_t bytes) {
+    if (bytes == 0) {
+        return 0;
+    }
+    size_t block = (bytes + sizeof(size_t) + 15) & ~static_cast<size_t>(15);
+    return block < 32 ? 32 : block;
+}
+
+// Буфер строки вне объекта (короткие строки хранятся внутри объекта - 0 байт)
+template <typename Char>
+size_t stringHeapBytes(const std::basic_string<Char>& text) {
+    const char* data = reinterpret_cast<const char*>(text.data());
+    const char* self = reinterpret_cast<const char*>(&text);
+    if (data >= self && data < self + sizeof(text)) {
+        return 0;
+    }
+    return heapBlockBytes((text.capacity() + 1) * sizeof(Char));
+}
+
+template <typename T>
+size_t vectorHeapBytes(const std::vector<T>& items) {
+    return heapBlockBytes(items.capacity() * sizeof(T));
+}
+
+// Узлы и массив корзин std::unordered_map/set (без памяти, которой владеют
+// сами ключи и значения). libstdc++ хранит в узле хеш нецелочисленного ключа.
+template <typename Table>
+size_t hashTableBytes(const Table& table) {
+    using Value = typename Table::value_type;
+    constexpr size_t cachedHash = std::is_integral_v<typename Table::key_type> ? 0 : sizeof(size_t);
+    size_t bytes = table.size() * heapBlockBytes(sizeof(void*) + sizeof(Value) + cachedHash);
+    if (table.bucket_count() > 1) {
+        bytes += heapBlockBytes(table.bucket_count() * sizeof(void*));
+    }
+    return bytes;
+}
+
+// Хеш-таблица со строковыми ключами вместе с буферами ключей
+template <typename Table>
+size_t stringKeyedTableBytes(const Table& table) {
+    size_t bytes = hashTableBytes(table);
+    for (const auto& item : table) {
+        if constexpr (std::is_same_v<typename Table::key_type, typename Table::value_type>) {
+            bytes += stringHeapBytes(item);
+        } else {
+            bytes += stringHeapBytes(item.first);
+        }
+    }
+    return bytes;
+}
+
+// Итог счетчика кучи (alloc_hooks.cpp)
+struct AllocationStats {
+    bool enabled = false;           // Счетчик собран в программу
+    uint64_t bytes = 0;             // Занято блоками сейчас
+    uint64_t peakBytes = 0;         // Наибольшее значение bytes
+    uint64_t blocks = 0;            // Живых блоков
+    uint64_t allocations = 0;       // Всего выделений с начала работы
+};
+
+AllocationStats allocationStats();
+
+// Сброс пикового значения к текущему (замер пика на отдельном участке)
+void resetPeakAllocation();
+
+// Резидентная память процесса в байтах (0 - не удалось прочитать /proc)
+uint64_t residentBytes();
+
+// Счетчики, которые ведет alloc_hooks.cpp
+void enableAllocationTracking();
+void recordAllocation(size_t bytes);
+void recordDeallocation(size_t bytes);
+
+#endif // MEMORY_H
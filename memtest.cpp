@@ -0,0 +1,148 @@
+#include "note.h"
+#include "memory.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Замер памяти хранилища (make memtest).
+//
+// Заметки добавляются в MemoryNoteManager (все индексы, без диска) на 10 тыс.,
+// 100 тыс. и 1 млн заметок. Для каждого размера выводятся резидентная память,
+// куча по счетчику operator new (alloc_hooks.cpp) и учет по структурам из
+// memoryUsage(). Программа завершается с кодом 1, если куча на заметку
+// превысила бюджет, учет по структурам разошелся со счетчиком или после
+// удаления менеджера куча не вернулась к исходной - так рост памяти
+// замечается до того, как попадет в релиз.
+
+// Бюджет кучи на заметку (текст около 200 байт, 1-2 метки). Замер - от 1,55 КБ
+// на 1 млн до 1,85 КБ на 10 тыс. заметок (массивы и таблицы индексов сразу
+// после удвоения); запас покрывает разницу версий библиотеки
+const double HEAP_BUDGET_PER_NOTE = 2200.0;
+
+// Доля кучи, которую должен объяснять учет по структурам (и наоборот)
+const double ACCOUNTED_MIN_SHARE = 0.90;
+const double ACCOUNTED_MAX_SHARE = 1.05;
+
+// Куча, которая может остаться после удаления менеджера (пулы стандартной библиотеки)
+const uint64_t LEAK_TOLERANCE_BYTES = 64 * 1024;
+
+// Вывод строки таблицы: имя, байты, байты на заметку. Ширина имени
+// считается в символах, а не в байтах UTF-8
+static void printRow(const std::string& name, uint64_t bytes, size_t count) {
+    size_t width = 0;
+    for (unsigned char c : name) {
+        width += (c & 0xC0) != 0x80 ? 1 : 0;
+    }
+    char numbers[64];
+    std::snprintf(numbers, sizeof(numbers), "%10.1f МБ %9.1f Б/заметку", bytes / (1024.0 * 1024.0),
+                  count > 0 ? static_cast<double>(bytes) / count : 0.0);
+    std::cout << "  " << name << std::string(width < 26 ? 26 - width : 0, ' ') << numbers << std::endl;
+}
+
+// Заполнение хранилища заметками, похожими на настоящие
+static void fillStore(MemoryNoteManager& manager, size_t count) {
+    const char* words[] = {
+        "проект", "отчет", "встреча", "план", "задача", "идея", "покупки",
+        "звонок", "report", "draft", "meeting", "notes", "бюджет", "итоги"
+    };
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+    std::mt19937 rng(46);
+    for (size_t i = 0; i < count; i++) {
+        std::string title = "Заметка " + std::to_string(rng() % 1000000) + " " + std::to_string(i);
+        std::string content;
+        while (content.size() < 200) {
+            content += words[rng() % wordCount];
+            content += ' ';
+        }
+        std::vector<std::string> tags = {"метка" + std::to_string(i % 20)};
+        if (i % 3 == 0) {
+            tags.push_back(words[rng() % wordCount]);
+        }
+        manager.addNote(title, "Тема " + std::to_string(i % 50), content, tags);
+    }
+}
+
+// Замер одного размера; false - нарушен бюджет
+static bool measure(size_t count) {
+    std::cout << "\n--- " << count << " заметок ---" << std::endl;
+
+    AllocationStats before = allocationStats();
+    uint64_t rssBefore = residentBytes();
+    resetPeakAllocation();
+
+    auto manager = std::make_unique<MemoryNoteManager>();
+    fillStore(*manager, count);
+
+    AllocationStats after = allocationStats();
+    uint64_t rssAfter = residentBytes();
+    uint64_t heap = after.bytes - before.bytes;
+    MemoryReport report = manager->memoryUsage();
+
+    printRow("узлы списка", report.nodes, count);
+    printRow("строки метаданных", report.strings, count);
+    printRow("тексты", report.content, count);
+    printRow("индекс ID", report.idIndex, count);
+    printRow("индекс названий", report.titleIndex, count);
+    printRow("префиксы названий", report.titlePrefixes, count);
+    printRow("опечатки в названиях", report.titleFuzzy, count);
+    printRow("опечатки в темах", report.categoryFuzzy, count);
+    printRow("столбцы", report.columns, count);
+    printRow("метки", report.tags, count);
+    printRow("счетчики", report.aggregates, count);
+    printRow("похожие тексты", report.similar, count);
+    printRow("ссылки на тексты", report.bodyRefs, count);
+    printRow("учет по структурам", report.total(), count);
+    printRow("куча (operator new)", heap, count);
+    printRow("пик кучи при заполнении", after.peakBytes - before.bytes, count);
+    printRow("резидентная память", rssAfter > rssBefore ? rssAfter - rssBefore : 0, count);
+
+    bool ok = true;
+    double perNote = static_cast<double>(heap) / count;
+    if (perNote > HEAP_BUDGET_PER_NOTE) {
+        std::cout << "  ОШИБКА: куча на заметку " << perNote << " Б, бюджет " << HEAP_BUDGET_PER_NOTE << " Б"
+                  << std::endl;
+        ok = false;
+    }
+    double share = static_cast<double>(report.total()) / heap;
+    if (share < ACCOUNTED_MIN_SHARE || share > ACCOUNTED_MAX_SHARE) {
+        std::cout << "  ОШИБКА: учет по структурам объясняет " << share * 100 << "% кучи" << std::endl;
+        ok = false;
+    }
+
+    manager.reset();
+    uint64_t remaining = allocationStats().bytes;
+    if (remaining > before.bytes + LEAK_TOLERANCE_BYTES) {
+        std::cout << "  ОШИБКА: после удаления менеджера осталось " << remaining - before.bytes << " Б кучи"
+                  << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    // Необязательный аргумент - наибольшее число заметок
+    size_t limit = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    if (!allocationStats().enabled) {
+        std::cout << "Счетчик кучи не собран (нужен alloc_hooks.cpp)" << std::endl;
+        return 1;
+    }
+
+    std::cout << "\n=== ПАМЯТЬ ХРАНИЛИЩА ===" << std::endl;
+    bool ok = true;
+    for (size_t count : {10000UL, 100000UL, 1000000UL}) {
+        if (count > limit) {
+            break;
+        }
+        ok = measure(count) && ok;
+    }
+
+    std::cout << "\n" << (ok ? "Память в пределах бюджета" : "Бюджет памяти нарушен") << std::endl;
+    return ok ? 0 : 1;
+}
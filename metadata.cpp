@@ -0,0 +1,292 @@
+#include "metadata.h"
+#include "checksum.h"
+#include "tags.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <unordered_set>
+
+std::string formatMetadataHeader(uint64_t generation) {
+    return METADATA_HEADER_V2 + " " + std::to_string(generation);
+}
+
+bool parseMetadataHeader(std::string_view line, uint64_t& generation) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    generation = 0;
+    if (line.substr(0, METADATA_HEADER_V2.size()) != METADATA_HEADER_V2) {
+        return false;
+    }
+    
+    // Файлы версии 2 без поколения считаются поколением 0
+    std::string_view rest = line.substr(METADATA_HEADER_V2.size());
+    if (!rest.empty() && rest.front() == ' ') {
+        rest.remove_prefix(1);
+        for (char c : rest) {
+            if (c < '0' || c > '9') {
+                generation = 0;
+                break;
+            }
+            generation = generation * 10 + static_cast<uint64_t>(c - '0');
+        }
+    }
+    return true;
+}
+
+uint64_t readMetadataGeneration(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    uint64_t generation = 0;
+    if (std::getline(file, line)) {
+        parseMetadataHeader(line, generation);
+    }
+    return generation;
+}
+
+std::string escapeMetadataField(std::string_view value) {
+    std::string result;
+    result.reserve(value.size());
+    for (char c : value) {
+        switch (c) {
+            case '\\':
+                result += "\\\\";
+                break;
+            case '|':
+                result += "\\p";
+                break;
+            case '\n':
+                result += "\\n";
+                break;
+            case '\r':
+                result += "\\r";
+                break;
+            default:
+                result.push_back(c);
+        }
+    }
+    return result;
+}
+
+bool unescapeMetadataField(std::string_view field, std::string& value) {
+    value.clear();
+    value.reserve(field.size());
+    for (size_t i = 0; i < field.size(); i++) {
+        if (field[i] != '\\') {
+            value.push_back(field[i]);
+            continue;
+        }
+        if (++i == field.size()) {
+            return false;
+        }
+        switch (field[i]) {
+            case '\\':
+                value.push_back('\\');
+                break;
+            case 'p':
+                value.push_back('|');
+                break;
+            case 'n':
+                value.push_back('\n');
+                break;
+            case 'r':
+                value.push_back('\r');
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+// Разбиение строки по '|' (в версии 2 '|' внутри полей всегда экранирован)
+static std::vector<std::string_view> splitFields(std::string_view line) {
+    std::vector<std::string_view> fields;
+    size_t start = 0;
+    while (true) {
+        size_t pos = line.find('|', start);
+        if (pos == std::string_view::npos) {
+            fields.push_back(line.substr(start));
+            break;
+        }
+        fields.push_back(line.substr(start, pos - start));
+        start = pos + 1;
+    }
+    return fields;
+}
+
+// Разбор целого числа без исключений
+static bool parseId(std::string_view text, int& id) {
+    if (text.empty() || text.size() > 10) {
+        return false;
+    }
+    long value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + (c - '0');
+    }
+    if (value <= 0 || value > 2147483647L) {
+        return false;
+    }
+    id = static_cast<int>(value);
+    return true;
+}
+
+// Разбор неотрицательного времени в микросекундах
+static bool parseTimestamp(std::string_view text, int64_t& value) {
+    if (text.empty() || text.size() > 18) {
+        return false;
+    }
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + (c - '0');
+    }
+    return true;
+}
+
+std::string formatMetadataRecord(const Note& note) {
+    std::string record = std::to_string(note.id);
+    record += '|';
+    record += escapeMetadataField(note.title);
+    record += '|';
+    record += escapeMetadataField(note.category);
+    record += '|';
+    record += escapeMetadataField(note.creationDate);
+    record += '|';
+    record += escapeMetadataField(note.filePath);
+    record += '|';
+    record += std::to_string(note.createdAt);
+    record += '|';
+    record += escapeMetadataField(joinTags(note.tags));
+    
+    char crc[16];
+    std::snprintf(crc, sizeof(crc), "|%08x", crc32String(record));
+    record += crc;
+    return record;
+}
+
+bool parseMetadataRecord(const std::string& line, int version, Note& note, std::string& error) {
+    std::string_view text(line);
+    if (!text.empty() && text.back() == '\r') {
+        text.remove_suffix(1);
+    }
+    
+    std::vector<std::string_view> fields;
+    if (version >= 2) {
+        // Проверяем контрольную сумму до разбора полей
+        size_t crcPos = text.rfind('|');
+        if (crcPos == std::string_view::npos || text.size() - crcPos - 1 != 8) {
+            error = "нет контрольной суммы";
+            return false;
+        }
+        std::string crcText(text.substr(crcPos + 1));
+        char* end = nullptr;
+        unsigned long expected = std::strtoul(crcText.c_str(), &end, 16);
+        if (end != crcText.c_str() + crcText.size() ||
+            static_cast<uint32_t>(expected) != crc32String(text.substr(0, crcPos))) {
+            error = "контрольная сумма не совпадает";
+            return false;
+        }
+        fields = splitFields(text.substr(0, crcPos));
+    } else {
+        // В версии 1 '|' не экранировался, поэтому строки с лишними полями отбрасываются
+        fields = splitFields(text);
+    }
+    
+    if (fields.size() < 5 || fields.size() > (version >= 2 ? 7u : 5u)) {
+        error = "неверное число полей";
+        return false;
+    }
+    note.createdAt = 0;
+    if (fields.size() >= 6 && !parseTimestamp(fields[5], note.createdAt)) {
+        error = "некорректное время создания";
+        return false;
+    }
+    note.tags.clear();
+    if (fields.size() == 7) {
+        std::string tags;
+        if (!unescapeMetadataField(fields[6], tags)) {
+            error = "некорректное экранирование";
+            return false;
+        }
+        note.tags = parseTags(tags);
+    }
+    if (!parseId(fields[0], note.id)) {
+        error = "некорректный ID";
+        return false;
+    }
+    
+    if (version >= 2) {
+        if (!unescapeMetadataField(fields[1], note.title) ||
+            !unescapeMetadataField(fields[2], note.category) ||
+            !unescapeMetadataField(fields[3], note.creationDate) ||
+            !unescapeMetadataField(fields[4], note.filePath)) {
+            error = "некорректное экранирование";
+            return false;
+        }
+    } else {
+        note.title = std::string(fields[1]);
+        note.category = std::string(fields[2]);
+        note.creationDate = std::string(fields[3]);
+        note.filePath = std::string(fields[4]);
+    }
+    
+    if (note.title.empty() || note.filePath.empty()) {
+        error = "пустое название или путь";
+        return false;
+    }
+    return true;
+}
+
+bool readMetadataFile(const std::string& path, std::vector<Note>& notes,
+                      std::vector<MetadataError>& errors) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    std::unordered_set<int> seenIds;
+    std::unordered_set<std::string> seenTitles;
+    std::string line;
+    int version = 1;
+    int lineNumber = 0;
+    
+    while (std::getline(file, line)) {
+        lineNumber++;
+        if (lineNumber == 1) {
+            // Файл без заголовка - старый формат версии 1
+            uint64_t generation;
+            if (parseMetadataHeader(line, generation)) {
+                version = 2;
+                continue;
+            }
+        }
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+        
+        Note note;
+        std::string reason;
+        if (parseMetadataRecord(line, version, note, reason)) {
+            if (seenIds.count(note.id) != 0) {
+                reason = "повторный ID " + std::to_string(note.id);
+            } else if (seenTitles.count(note.title) != 0) {
+                reason = "повторное название";
+            }
+        }
+        if (!reason.empty()) {
+            errors.push_back({lineNumber, line, reason});
+            continue;
+        }
+        
+        seenIds.insert(note.id);
+        seenTitles.insert(note.title);
+        notes.push_back(std::move(note));
+    }
+    return true;
+}
@@ -0,0 +1,56 @@
+#ifndef METADATA_H
+#define METADATA_H
+
+#include "note.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Формат файла метаданных.
+//
+// Версия 2 (текущая): первая строка "#TMv2 <поколение>", далее по записи на строку
+//   id|название|тема|дата|путь|время_создания|метки|crc
+// Символы '\', '|', перевод строки и возврат каретки в полях экранируются
+// как \\, \p, \n, \r. crc - CRC-32 части строки до последнего '|'
+// (8 шестнадцатеричных цифр). Время создания - микросекунды от начала эпохи,
+// метки перечисляются через запятую (tags.h); записи без этих полей (ранние
+// файлы версии 2) тоже читаются. Поколение увеличивается при каждом сохранении
+// и связывает файл со снимком индексов (snapshot.h).
+//
+// Версия 1 (старая, без заголовка): id|название|тема|дата|путь без
+// экранирования и контрольной суммы. Читается для совместимости.
+
+const std::string METADATA_HEADER_V2 = "#TMv2";
+
+// Строка заголовка версии 2 и ее разбор (false - файл версии 1)
+std::string formatMetadataHeader(uint64_t generation);
+bool parseMetadataHeader(std::string_view line, uint64_t& generation);
+
+// Поколение из заголовка файла (0 - файла нет или он версии 1)
+uint64_t readMetadataGeneration(const std::string& path);
+
+// Экранирование и восстановление значения поля
+std::string escapeMetadataField(std::string_view value);
+bool unescapeMetadataField(std::string_view field, std::string& value);
+
+// Строка записи версии 2 (без перевода строки)
+std::string formatMetadataRecord(const Note& note);
+
+// Разбор строки записи. При ошибке возвращает false и описание в error.
+bool parseMetadataRecord(const std::string& line, int version, Note& note, std::string& error);
+
+// Отброшенная запись файла метаданных
+struct MetadataError {
+    int line;               // Номер строки (с 1)
+    std::string text;       // Исходная строка
+    std::string reason;     // Причина
+};
+
+// Чтение всех записей файла с проверкой формата, CRC и уникальности ID и
+// названий. Поврежденные записи попадают в errors, остальные - в notes
+// (поле content не заполняется). false - файл не удалось открыть.
+bool readMetadataFile(const std::string& path, std::vector<Note>& notes,
+                      std::vector<MetadataError>& errors);
+
+#endif // METADATA_H
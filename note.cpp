@@ -1,9 +1,24 @@
 #include "note.h"
 #include "validation.h"
+#include "fileio.h"
+#include "utf8.h"
+#include "scan.h"
+#include "thread_pool.h"
+#include "archive.h"
+#include "metadata.h"
+#include "snapshot.h"
+#include "timestamp.h"
+#include "trash.h"
+#include "checksum.h"
+#include "memory.h"
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <unordered_set>
 
 #ifdef _WIN32
     #include <direct.h>
@@ -12,20 +27,209 @@
     #include <sys/stat.h>
 #endif
 
-// Константы
-const std::string METADATA_FILE = "notes_metadata.dat";
-const std::string NOTES_DIR = "notes";
+// Число заметок, начиная с которого поиск по тексту выполняется параллельно
+const int PARALLEL_SCAN_THRESHOLD = 4096;
 
-NoteManager::NoteManager() : head(nullptr), tail(nullptr), noteCount(0), nextId(1) {
-    // Создаем директорию для заметок если она не существует
-    mkdir(NOTES_DIR.c_str(), 0755);
+// Размер части хранилища для одной задачи параллельного поиска
+const size_t PARALLEL_SCAN_CHUNK = 512;
+
+// Число заметок в одной операции, начиная с которого индексы названий и тем
+// обновляются одним проходом (удаление) или одной сортировкой (восстановление)
+const size_t BULK_UPDATE_THRESHOLD = 64;
+
+// Вывод одной строки таблицы заметок
+static void printNoteRow(const Note& note) {
+    std::cout.width(2);
+    std::cout << std::left << note.id << " | ";
+    
+    std::string title = note.title;
+    if (title.length() > 22) {
+        title = title.substr(0, 19) + "...";
+    }
+    std::cout.width(22);
+    std::cout << std::left << title << " | ";
+    
+    std::string category = note.category;
+    if (category.length() > 14) {
+        category = category.substr(0, 11) + "...";
+    }
+    std::cout.width(14);
+    std::cout << std::left << category << " | ";
+    
+    std::cout << note.creationDate << std::endl;
+}
+
+// ===== ЗАПРОСЫ ПРОСМОТРОМ СПИСКА (LookupIndex) =====
+// Результаты и порядок - те же, что у индексов
+
+// ID подходящих заметок по возрастанию
+template <typename Predicate>
+static std::vector<int> scanIds(const NoteNode* head, Predicate matches) {
+    std::vector<int> ids;
+    for (const NoteNode* current = head; current != nullptr; current = current->next) {
+        if (matches(current->data)) {
+            ids.push_back(current->data.id);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+static std::vector<TagCount> scanTagCounts(const NoteNode* head, const TagQuery& query) {
+    std::unordered_map<std::string, uint64_t> counts;
+    for (const NoteNode* current = head; current != nullptr; current = current->next) {
+        if (matchesTagQuery(current->data.tags, query)) {
+            for (const std::string& tag : current->data.tags) {
+                counts[tag]++;
+            }
+        }
+    }
+    std::vector<TagCount> result;
+    result.reserve(counts.size());
+    for (const auto& entry : counts) {
+        result.push_back({entry.first, entry.second});
+    }
+    sortTagCounts(result);
+    return result;
+}
+
+// Нечеткий поиск по полю заметки (как BKTree: без учета регистра)
+static std::vector<FuzzyMatch> scanFuzzy(const NoteNode* head, std::string Note::*field, const std::string& query,
+                                         int maxDistance) {
+    std::u32string folded = decodeUtf8(foldCaseUtf8(query));
+    std::vector<FuzzyMatch> result;
+    for (const NoteNode* current = head; current != nullptr; current = current->next) {
+        int distance = boundedEditDistance(folded, decodeUtf8(foldCaseUtf8(current->data.*field)), maxDistance);
+        if (distance <= maxDistance) {
+            result.push_back({current->data.id, distance});
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const FuzzyMatch& a, const FuzzyMatch& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+    });
+    return result;
+}
+
+// Названия с префиксом (как TitleIndex::complete): по алфавиту, затем по ID
+static std::vector<int> scanTitlePrefix(const NoteNode* head, const std::string& prefix, size_t limit) {
+    std::string key = foldCaseUtf8(std::string_view(prefix).substr(0, utf8CompletePrefixLength(prefix)));
+    std::vector<std::pair<std::string, int>> matches;
+    for (const NoteNode* current = head; current != nullptr; current = current->next) {
+        std::string title = foldCaseUtf8(current->data.title);
+        if (title.compare(0, key.size(), key) == 0) {
+            matches.emplace_back(std::move(title), current->data.id);
+        }
+    }
+    size_t count = std::min(limit, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + static_cast<std::ptrdiff_t>(count), matches.end());
+    
+    std::vector<int> ids;
+    ids.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        ids.push_back(matches[i].second);
+    }
+    return ids;
+}
+
+// Похожие тексты просмотром всех заметок: точное сходство с каждой
+static std::vector<SimilarNote> scanSimilar(const NoteNode* head, const std::vector<uint64_t>& shingles,
+                                            int excludeId, double minSimilarity) {
+    std::vector<SimilarNote> result;
+    for (const NoteNode* current = head; current != nullptr; current = current->next) {
+        if (current->data.id == excludeId) {
+            continue;
+        }
+        double similarity = jaccardSimilarity(shingles, textShingles(current->data.content));
+        if (similarity >= minSimilarity) {
+            result.push_back({current->data.id, similarity});
+        }
+    }
+    return result;
+}
+
+// Подпись текста заметки в индексе похожих текстов (пустой текст не индексируется)
+static void indexSimilarity(SimilarityIndex& index, const Note& note) {
+    std::vector<uint64_t> shingles = textShingles(note.content);
+    if (shingles.empty()) {
+        index.remove(note.id);
+    } else {
+        index.add(note.id, minHashSignature(shingles));
+    }
+}
+
+// Поддиректория хранилища (корень хранилища создается здесь, так как
+// хранилища текстов и версий инициализируются раньше тела конструктора)
+static std::string storeDirectory(const std::string& storeRoot, const std::string& name) {
+    if (storeRoot.empty() || storeRoot == ".") {
+        return name;
+    }
+    mkdir(storeRoot.c_str(), 0755);
+    return storeRoot + "/" + name;
+}
+
+// Директории текстов и версий по политике хранения; хранилище в памяти
+// директорий не создает
+template <typename Storage>
+static std::string bodiesDirectory(const std::string& storeRoot) {
+    if constexpr (Storage::persistent) {
+        return storeDirectory(storeRoot, Storage::bodiesDir);
+    } else {
+        return std::string();
+    }
 }
 
-NoteManager::~NoteManager() {
+template <typename Storage>
+static std::string historyDirectory(const std::string& storeRoot) {
+    if constexpr (Storage::persistent) {
+        return storeDirectory(storeRoot, Storage::historyDir);
+    } else {
+        return std::string();
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+BasicNoteManager<Storage, Index, Durability>::BasicNoteManager() : BasicNoteManager(".") {}
+
+template <typename Storage, typename Index, typename Durability>
+BasicNoteManager<Storage, Index, Durability>::BasicNoteManager(const std::string& storeRoot)
+    : head(nullptr), tail(nullptr), noteCount(0), nextId(1), generation(0), metadataDirty(false),
+      bodies(bodiesDirectory<Storage>(storeRoot)), history(historyDirectory<Storage>(storeRoot)),
+      bulkLoading(false), bulkRemoving(false), nearDuplicateThreshold(0.0), deleteMode(DeleteMode::Immediate),
+      lastBatch(0), metadataHasTrash(false), writtenGeneration(0) {
+    if constexpr (Storage::persistent) {
+        // Для текущей директории пути остаются прежними: notes_metadata.dat, notes/, bodies/ и history/
+        if (storeRoot.empty() || storeRoot == ".") {
+            metadataFile = Storage::metadataFile;
+            notesDir = Storage::notesDir;
+        } else {
+            metadataFile = storeRoot + "/" + Storage::metadataFile;
+            notesDir = storeRoot + "/" + Storage::notesDir;
+        }
+        snapshotFile = metadataFile + ".snap";
+        trashFile = metadataFile + ".trash";
+        
+        // Создаем директорию для заметок если она не существует
+        mkdir(notesDir.c_str(), 0755);
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+BasicNoteManager<Storage, Index, Durability>::~BasicNoteManager() {
+    // Фоновая очистка обращается к полям менеджера - дожидаемся ее
+    waitForPurge();
+    purgePool.reset();
+    if constexpr (Storage::persistent && Durability::deferred) {
+        try {
+            flush();
+        } catch (const std::exception& e) {
+            std::cout << "Ошибка при сохранении метаданных: " << e.what() << std::endl;
+        }
+    }
     clearList();
 }
 
-void NoteManager::clearList() {
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::clearList() {
     NoteNode* current = head;
     while (current != nullptr) {
         NoteNode* next = current->next;
@@ -35,272 +239,1867 @@ void NoteManager::clearList() {
     head = nullptr;
     tail = nullptr;
     noteCount = 0;
+    idIndex.clear();
+    titleIndex.clear();
+    titlePrefixes.clear();
+    titleFuzzy.clear();
+    categoryFuzzy.clear();
+    columns.clear();
+    tagIndex.clear();
+    aggregates.clear();
+    similarNotes.clear();
+    bodies.clearRefs();
+}
+
+template <typename Storage, typename Index, typename Durability>
+NoteNode* BasicNoteManager<Storage, Index, Durability>::findNode(int id) const {
+    auto it = idIndex.find(id);
+    return it != idIndex.end() ? it->second : nullptr;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::linkNode(NoteNode* node) {
+    // Добавляем в конец списка
+    if (tail == nullptr) {
+        // Список пуст
+        head = tail = node;
+    } else {
+        tail->next = node;
+        node->prev = tail;
+        tail = node;
+    }
+    noteCount++;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::appendNode(NoteNode* node) {
+    linkNode(node);
+    indexNode(node);
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::unlinkNode(NoteNode* node) {
+    unindexNode(node);
+    
+    if (node->prev != nullptr) {
+        node->prev->next = node->next;
+    } else {
+        // Удаляем голову списка
+        head = node->next;
+    }
+    
+    if (node->next != nullptr) {
+        node->next->prev = node->prev;
+    } else {
+        // Удаляем хвост списка
+        tail = node->prev;
+    }
+    
+    node->next = nullptr;
+    node->prev = nullptr;
+    noteCount--;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::indexNode(NoteNode* node) {
+    idIndex[node->data.id] = node;
+    titleIndex[node->data.title] = node;
+    
+    if constexpr (Index::secondary) {
+        // При массовой загрузке префиксный индекс сортируется один раз в конце
+        if (bulkLoading) {
+            titlePrefixes.append(node->data.title, node->data.id);
+        } else {
+            titlePrefixes.insert(node->data.title, node->data.id);
+        }
+        titleFuzzy.insert(node->data.title, node->data.id);
+        categoryFuzzy.insert(node->data.category, node->data.id);
+        columns.add(node->data.id, node->data.category, node->data.creationDate);
+        tagIndex.add(node->data.id, node->data.tags);
+        aggregates.add(node->data.category, node->data.creationDate);
+        indexSimilarity(similarNotes, node->data);
+    }
+    if constexpr (Storage::persistent) {
+        bodies.addRef(node->data.bodyHash, node->data.content.size());
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::unindexNode(NoteNode* node) {
+    idIndex.erase(node->data.id);
+    auto it = titleIndex.find(node->data.title);
+    if (it != titleIndex.end() && it->second == node) {
+        titleIndex.erase(it);
+    }
+    
+    if constexpr (Index::secondary) {
+        // При массовом удалении эти индексы чистятся одним проходом в конце
+        if (bulkRemoving) {
+            bulkRemoved.insert(node->data.id);
+        } else {
+            titlePrefixes.erase(node->data.title, node->data.id);
+            titleFuzzy.erase(node->data.title, node->data.id);
+            categoryFuzzy.erase(node->data.category, node->data.id);
+        }
+        columns.remove(node->data.id);
+        tagIndex.remove(node->data.id, node->data.tags);
+        aggregates.remove(node->data.category, node->data.creationDate);
+        similarNotes.remove(node->data.id);
+    }
+    if constexpr (Storage::persistent) {
+        // Файл текста не удаляется: узел может вернуться в индексы (applyMetadataDelta)
+        bodies.release(node->data.bodyHash);
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::addNote(
+    const std::string& title, const std::string& category, const std::string& content,
+    const std::vector<std::string>& tags) {
+    return insertNote(nextId, title, category, content, tags);
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::insertNote(
+    int id, const std::string& title, const std::string& category, const std::string& content,
+    const std::vector<std::string>& tags) {
+    // Проверка уникальности названия и ID
+    Note newNote;
+    OpStatus status = reserveNote(id, title, category, content, tags, newNote);
+    if (status == OpStatus::DuplicateTitle) {
+        std::cout << "Ошибка: заметка с таким названием уже существует" << std::endl;
+        return false;
+    }
+    if (status == OpStatus::DuplicateId) {
+        std::cout << "Ошибка: заметка с ID " << id << " уже существует" << std::endl;
+        return false;
+    }
+    
+    // Сохраняем заметку в файл
+    try {
+        saveNoteToFile(newNote);
+    } catch (const std::exception& e) {
+        cancelNote(newNote);
+        std::cout << "Ошибка при сохранении файла: " << e.what() << std::endl;
+        return false;
+    }
+    
+    // Создаем новый узел и добавляем в конец списка
+    commitNote(std::move(newNote));
+    
+    // Обновляем метаданные
+    persistChange();
+    
+    if (nearDuplicateThreshold > 0.0) {
+        for (const SimilarNote& similar : similarTo(content, id, nearDuplicateThreshold, 3)) {
+            std::cout << "Внимание: текст почти совпадает с заметкой #" << similar.id << " \""
+                      << findNode(similar.id)->data.title << "\" (сходство "
+                      << static_cast<int>(similar.similarity * 100) << "%)" << std::endl;
+        }
+    }
+    
+    return true;
+}
+
+template <typename Storage, typename Index, typename Durability>
+OpStatus BasicNoteManager<Storage, Index, Durability>::reserveNote(
+    int id, const std::string& title, const std::string& category, const std::string& content,
+    const std::vector<std::string>& tags, Note& note) {
+    if (titleIndex.count(title) != 0 || reservedTitles.count(title) != 0) {
+        return OpStatus::DuplicateTitle;
+    }
+    if (idIndex.count(id) != 0 || reservedIds.count(id) != 0) {
+        return OpStatus::DuplicateId;
+    }
+    // ID из корзины занят до очистки: восстановление и история заметки
+    // не должны достаться новой. Все ID корзины меньше nextId
+    if (id < nextId && std::any_of(trash.begin(), trash.end(),
+                                   [id](const TrashEntry& entry) { return entry.note.id == id; })) {
+        return OpStatus::DuplicateId;
+    }
+    if (id >= nextId) {
+        nextId = id + 1;
+    }
+    
+    note.id = id;
+    note.title = title;
+    note.category = category;
+    note.content = content;
+    note.tags = normalizeTags(tags);
+    note.createdAt = currentTimestampUs();
+    note.creationDate = localDate(note.createdAt);
+    note.filePath = generateFilePath(note.id, note.title);
+    
+    reservedTitles.insert(title);
+    reservedIds.insert(id);
+    if constexpr (Storage::persistent) {
+        bodies.addRef(contentHash(content), content.size());
+    }
+    return OpStatus::Ok;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::commitNote(Note note) {
+    reservedTitles.erase(note.title);
+    reservedIds.erase(note.id);
+    // Файлы записаны: bodyHash - хеш того же текста, что и в резерве
+    // (пустой, если текст лег в файл заметки из-за коллизии)
+    std::string pendingHash = note.bodyHash.empty() ? contentHash(note.content) : note.bodyHash;
+    appendNode(new NoteNode(std::move(note)));
+    if constexpr (Storage::persistent) {
+        bodies.release(pendingHash);
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::cancelNote(const Note& note) {
+    reservedTitles.erase(note.title);
+    reservedIds.erase(note.id);
+    if constexpr (Storage::persistent) {
+        std::string pendingHash = contentHash(note.content);
+        bodies.release(pendingHash);
+        bodies.removeIfUnused(pendingHash);
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+Note BasicNoteManager<Storage, Index, Durability>::detachNote(NoteNode* node) {
+    if constexpr (Storage::persistent) {
+        history.remove(node->data.id);
+    }
+    unlinkNode(node);
+    Note note = std::move(node->data);
+    delete node;
+    return note;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::replaceNodeData(NoteNode* node, Note updated) {
+    Note& note = node->data;
+    
+    // Инкрементально обновляем индексы: только затронутые ключи
+    if (note.title != updated.title) {
+        titleIndex.erase(note.title);
+        titleIndex[updated.title] = node;
+    }
+    if constexpr (Index::secondary) {
+        if (note.title != updated.title) {
+            titlePrefixes.erase(note.title, note.id);
+            titlePrefixes.insert(updated.title, updated.id);
+            titleFuzzy.erase(note.title, note.id);
+            titleFuzzy.insert(updated.title, updated.id);
+        }
+        if (note.category != updated.category) {
+            categoryFuzzy.erase(note.category, note.id);
+            categoryFuzzy.insert(updated.category, updated.id);
+            columns.setCategory(updated.id, updated.category);
+        }
+        if (note.creationDate != updated.creationDate) {
+            columns.remove(note.id);
+            columns.add(updated.id, updated.category, updated.creationDate);
+        }
+        if (note.tags != updated.tags) {
+            tagIndex.remove(note.id, note.tags);
+            tagIndex.add(updated.id, updated.tags);
+        }
+        if (note.category != updated.category || note.creationDate != updated.creationDate) {
+            aggregates.remove(note.category, note.creationDate);
+            aggregates.add(updated.category, updated.creationDate);
+        }
+        if (note.content != updated.content) {
+            indexSimilarity(similarNotes, updated);
+        }
+    }
+    if constexpr (Storage::persistent) {
+        if (note.bodyHash != updated.bodyHash) {
+            bodies.release(note.bodyHash);
+            bodies.addRef(updated.bodyHash, updated.content.size());
+        }
+    }
+    note = std::move(updated);
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::recordRevision(const Note& before, const Note& after) {
+    // В памяти история версий не ведется
+    if (!Storage::persistent ||
+        (before.title == after.title && before.category == after.category && before.content == after.content)) {
+        return;
+    }
+    
+    // Время первой версии неизвестно - берется время создания заметки
+    NoteVersion previous{before.title, before.category, before.content, before.createdAt};
+    NoteVersion current{after.title, after.category, after.content, currentTimestampUs()};
+    if (history.record(after.id, previous, current) == 0) {
+        std::cout << "Предупреждение: не удалось записать версию заметки в историю" << std::endl;
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::restoreRevision(int id, uint32_t number) {
+    NoteVersion version;
+    if (!history.get(id, number, version)) {
+        std::cout << "Ошибка: версии " << number << " заметки с ID " << id << " нет" << std::endl;
+        return false;
+    }
+    return updateNote(id, version.title, version.category, version.content);
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::deleteNote(int id) {
+    NoteNode* node = findNode(id);
+    if (node == nullptr) {
+        std::cout << "Ошибка: заметка с ID " << id << " не найдена" << std::endl;
+        return false;
+    }
+    
+    deleteNodes({node});
+    return true;
+}
+
+template <typename Storage, typename Index, typename Durability>
+int BasicNoteManager<Storage, Index, Durability>::deleteByCategory(const std::string& category) {
+    std::vector<NoteNode*> nodes;
+    for (int id : findByCategory(category)) {
+        nodes.push_back(findNode(id));
+    }
+    return deleteNodes(nodes);
+}
+
+template <typename Storage, typename Index, typename Durability>
+int BasicNoteManager<Storage, Index, Durability>::deleteNodes(const std::vector<NoteNode*>& nodes) {
+    if (nodes.empty()) {
+        return 0;
+    }
+    if (deleteMode == DeleteMode::Trash) {
+        if (!trashNodes(nodes)) {
+            std::cout << "Предупреждение: не удалось записать журнал корзины" << std::endl;
+        }
+        return static_cast<int>(nodes.size());
+    }
+    bulkRemoving = nodes.size() >= BULK_UPDATE_THRESHOLD;
+    
+    std::vector<std::string> bodyHashes;
+    bodyHashes.reserve(nodes.size());
+    for (NoteNode* node : nodes) {
+        // Удаляем узел из списка, затем файл заметки
+        Note removed = detachNote(node);
+        if constexpr (Storage::persistent) {
+            if (remove(removed.filePath.c_str()) != 0) {
+                std::cout << "Предупреждение: не удалось удалить файл заметки" << std::endl;
+            }
+            bodyHashes.push_back(removed.bodyHash);
+        }
+    }
+    finishBulkRemove();
+    
+    // Текст удаляется, только если на него не осталось ссылок
+    for (const std::string& hash : bodyHashes) {
+        bodies.removeIfUnused(hash);
+    }
+    
+    // Обновляем метаданные (один раз на всю операцию)
+    persistChange();
+    
+    return static_cast<int>(nodes.size());
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::trashNodes(const std::vector<NoteNode*>& nodes) {
+    bulkRemoving = nodes.size() >= BULK_UPDATE_THRESHOLD;
+    
+    // Файлы и метаданные не трогаем: в журнал дописываются строки всей операции
+    TrashEntry entry;
+    entry.deletedAt = currentTimestampUs();
+    entry.batch = ++lastBatch;
+    std::string journal;
+    for (NoteNode* node : nodes) {
+        unlinkNode(node);
+        entry.note = std::move(node->data);
+        delete node;
+        entry.bodySize = entry.note.content.size();
+        
+        // Корзина держит ссылку на текст, пока заметку можно восстановить;
+        // в памяти текст остается в записи корзины
+        if constexpr (Storage::persistent) {
+            entry.note.content = std::string();
+            bodies.addRef(entry.note.bodyHash, entry.bodySize);
+            journal += formatTrashRecord(entry);
+            journal += '\n';
+        }
+        trash.push_back(std::move(entry));
+    }
+    finishBulkRemove();
+    
+    if constexpr (Storage::persistent) {
+        metadataHasTrash = true;
+        std::lock_guard<std::mutex> lock(journalMutex);
+        return appendTrashJournal(trashFile, journal);
+    }
+    return true;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::finishBulkRemove() {
+    if (Index::secondary && bulkRemoving) {
+        titlePrefixes.eraseIds(bulkRemoved);
+        titleFuzzy.eraseIds(bulkRemoved);
+        categoryFuzzy.eraseIds(bulkRemoved);
+        bulkRemoved.clear();
+        bulkRemoving = false;
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::restoreEntry(const TrashEntry& entry) {
+    const Note& record = entry.note;
+    if (idIndex.count(record.id) != 0 || titleIndex.count(record.title) != 0) {
+        std::cout << "Ошибка: заметку \"" << record.title
+                  << "\" нельзя восстановить, ID или название уже заняты" << std::endl;
+        return false;
+    }
+    
+    // Файл заметки не удалялся - текст читается с диска
+    Note note = record;
+    if constexpr (Storage::persistent) {
+        loadNoteBody(note);
+    }
+    appendNode(new NoteNode(std::move(note)));
+    bodies.release(record.bodyHash);
+    return true;
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::restoreNote(int id) {
+    auto it = std::find_if(trash.begin(), trash.end(),
+                           [id](const TrashEntry& entry) { return entry.note.id == id; });
+    if (it == trash.end()) {
+        std::cout << "Ошибка: заметки с ID " << id << " нет в корзине" << std::endl;
+        return false;
+    }
+    if (!restoreEntry(*it)) {
+        return false;
+    }
+    trash.erase(it);
+    if constexpr (Storage::persistent) {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        appendTrashJournal(trashFile, formatRestoreRecord(id) + "\n");
+    }
+    
+    // Запись заметки могла уйти из метаданных при сохранении
+    persistChange();
+    return true;
+}
+
+template <typename Storage, typename Index, typename Durability>
+int BasicNoteManager<Storage, Index, Durability>::undoDelete() {
+    if (trash.empty()) {
+        return 0;
+    }
+    
+    // Заметки последней операции лежат в конце корзины
+    uint64_t batch = trash.back().batch;
+    size_t batchSize = 0;
+    for (size_t i = trash.size(); i-- > 0 && trash[i].batch == batch;) {
+        batchSize++;
+    }
+    bulkLoading = batchSize >= BULK_UPDATE_THRESHOLD;
+    int restored = 0;
+    std::string journal;
+    for (size_t i = trash.size(); i-- > 0;) {
+        if (trash[i].batch != batch) {
+            continue;
+        }
+        if (restoreEntry(trash[i])) {
+            journal += formatRestoreRecord(trash[i].note.id);
+            journal += '\n';
+            trash.erase(trash.begin() + static_cast<std::ptrdiff_t>(i));
+            restored++;
+        }
+    }
+    finishBulkLoad();
+    if (restored > 0) {
+        if constexpr (Storage::persistent) {
+            std::lock_guard<std::mutex> lock(journalMutex);
+            appendTrashJournal(trashFile, journal);
+        }
+        persistChange();
+    }
+    return restored;
+}
+
+template <typename Storage, typename Index, typename Durability>
+int BasicNoteManager<Storage, Index, Durability>::purgeTrash(int64_t deletedBefore) {
+    if constexpr (!Storage::persistent) {
+        // В памяти удалять нечего, кроме самих записей корзины
+        size_t before = trash.size();
+        trash.erase(std::remove_if(trash.begin(), trash.end(), [&](const TrashEntry& entry) {
+            return entry.deletedAt <= deletedBefore;
+        }), trash.end());
+        return static_cast<int>(before - trash.size());
+    }
+    
+    std::vector<std::string> files;
+    std::vector<std::string> bodyHashes;
+    std::unordered_set<int> purgedIds;
+    for (const TrashEntry& entry : trash) {
+        if (entry.deletedAt > deletedBefore) {
+            continue;
+        }
+        // Файл могла занять заметка, импортированная позже с тем же ID и названием
+        NoteNode* live = findNode(entry.note.id);
+        if (live == nullptr || live->data.filePath != entry.note.filePath) {
+            files.push_back(entry.note.filePath);
+        }
+        if (live == nullptr) {
+            history.remove(entry.note.id);
+        }
+        bodies.release(entry.note.bodyHash);
+        bodyHashes.push_back(entry.note.bodyHash);
+        purgedIds.insert(entry.note.id);
+    }
+    if (purgedIds.empty()) {
+        return 0;
+    }
+    trash.erase(std::remove_if(trash.begin(), trash.end(), [&](const TrashEntry& entry) {
+        return purgedIds.count(entry.note.id) != 0;
+    }), trash.end());
+    
+    // Тексты удаляются здесь же: BodyStore::put в основном потоке не должен
+    // застать текст, который фоновый поток вот-вот удалит
+    for (const std::string& hash : bodyHashes) {
+        bodies.removeIfUnused(hash);
+    }
+    
+    // Метаданные собираются сейчас, а записываются в фоне. Порядок записи -
+    // метаданные, журнал, файлы: при сбое удаленная заметка может остаться
+    // в корзине, но не вернется в список
+    std::string metadata;
+    uint64_t metadataGeneration = 0;
+    if (metadataHasTrash) {
+        metadata = formatMetadata();
+        metadataGeneration = generation;
+    }
+    if (!purgePool) {
+        purgePool = std::make_unique<ThreadPool>(1);
+    }
+    purgePool->submit([this, files = std::move(files), metadata = std::move(metadata),
+                       metadataGeneration, purgedIds = std::move(purgedIds)]() {
+        try {
+            if (metadataGeneration != 0) {
+                writeMetadata(metadata, metadataGeneration);
+            }
+            
+            // Журнал перечитывается под блокировкой: основной поток мог дописать
+            // новые удаления после того, как очистка была запущена
+            std::lock_guard<std::mutex> lock(journalMutex);
+            std::vector<TrashEntry> entries;
+            readTrashJournal(trashFile, entries);
+            entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const TrashEntry& entry) {
+                return purgedIds.count(entry.note.id) != 0;
+            }), entries.end());
+            if (!writeTrashJournal(trashFile, entries)) {
+                throw std::runtime_error("Не удалось перезаписать журнал корзины");
+            }
+        } catch (const std::exception& e) {
+            // Файлы не удаляются: заметки останутся в корзине после перезапуска
+            std::cout << "Предупреждение: очистка корзины не завершена: " << e.what() << std::endl;
+            return;
+        }
+        for (const std::string& path : files) {
+            std::remove(path.c_str());
+        }
+    });
+    return static_cast<int>(bodyHashes.size());
+}
+
+template <typename Storage, typename Index, typename Durability>
+ThreadPool& BasicNoteManager<Storage, Index, Durability>::scanPoolFor(size_t threads) const {
+    // Потоки создаются один раз, а не при каждом поиске
+    threads = ThreadPool::resolveThreads(threads);
+    if (!scanPool || scanPool->size() != threads) {
+        scanPool.reset();
+        scanPool = std::make_unique<ThreadPool>(threads);
+    }
+    return *scanPool;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::waitForPurge() const {
+    if (purgePool) {
+        purgePool->wait();
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::loadTrash() {
+    std::vector<TrashEntry> entries;
+    readTrashJournal(trashFile, entries);
+    metadataHasTrash = !entries.empty();
+    
+    // Записи удаленных заметок остаются в метаданных до ближайшего сохранения
+    // (и в снимке, сделанном до удаления) - убираем их из списка
+    bulkRemoving = entries.size() >= BULK_UPDATE_THRESHOLD;
+    for (TrashEntry& entry : entries) {
+        NoteNode* node = findNode(entry.note.id);
+        if (node != nullptr) {
+            unlinkNode(node);
+            delete node;
+        }
+        bodies.addRef(entry.note.bodyHash, entry.bodySize);
+        lastBatch = std::max(lastBatch, entry.batch);
+        // Запись заметки могла уйти из метаданных при сохранении - ID
+        // из корзины не выдается новым заметкам
+        nextId = std::max(nextId, entry.note.id + 1);
+    }
+    finishBulkRemove();
+    trash = std::move(entries);
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::updateNote(int id, const std::string& title,
+                                                              const std::string& category, const std::string& content) {
+    NoteNode* node = findNode(id);
+    if (node == nullptr) {
+        std::cout << "Ошибка: заметка с ID " << id << " не найдена" << std::endl;
+        return false;
+    }
+    
+    Note& note = node->data;
+    bool titleChanged = note.title != title;
+    bool categoryChanged = note.category != category;
+    bool contentChanged = note.content != content;
+    
+    if (!titleChanged && !categoryChanged && !contentChanged) {
+        // Изменений нет - ничего не трогаем
+        return true;
+    }
+    
+    // Проверка уникальности нового названия
+    if (titleChanged && titleIndex.count(title) != 0) {
+        std::cout << "Ошибка: заметка с таким названием уже существует" << std::endl;
+        return false;
+    }
+    
+    Note updated = note;
+    updated.title = title;
+    updated.category = category;
+    updated.content = content;
+    
+    if constexpr (Storage::persistent) {
+        // При смене названия файл переименовывается под новое имя
+        bool renamed = false;
+        if (titleChanged) {
+            updated.filePath = generateFilePath(updated.id, updated.title);
+            renamed = std::rename(note.filePath.c_str(), updated.filePath.c_str()) == 0;
+        }
+        
+        // Заголовок файла содержит название и тему, поэтому файл
+        // перезаписывается только при изменении этих полей или текста
+        try {
+            saveNoteToFile(updated);
+        } catch (const std::exception& e) {
+            if (renamed) {
+                std::rename(updated.filePath.c_str(), note.filePath.c_str());
+            }
+            bodies.removeIfUnused(updated.bodyHash);
+            std::cout << "Ошибка при сохранении файла: " << e.what() << std::endl;
+            return false;
+        }
+        if (titleChanged && !renamed) {
+            // Переименование не удалось - удаляем старый файл, если он остался
+            remove(note.filePath.c_str());
+        }
+    }
+    
+    std::string oldBodyHash = note.bodyHash;
+    recordRevision(note, updated);
+    replaceNodeData(node, std::move(updated));
+    bodies.removeIfUnused(oldBodyHash);
+    
+    // Обновляем метаданные (один раз, ID сохраняется)
+    persistChange();
+    
+    return true;
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::setNoteTags(int id, const std::vector<std::string>& tags) {
+    NoteNode* node = findNode(id);
+    if (node == nullptr) {
+        std::cout << "Ошибка: заметка с ID " << id << " не найдена" << std::endl;
+        return false;
+    }
+    
+    Note updated = node->data;
+    updated.tags = normalizeTags(tags);
+    if (updated.tags == node->data.tags) {
+        return true;
+    }
+    
+    replaceNodeData(node, std::move(updated));
+    persistChange();
+    return true;
 }
 
-NoteNode* NoteManager::findNode(int id) const {
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::displayAllNotes() const {
+    if (noteCount == 0) {
+        std::cout << "\nЗаметки не найдены\n" << std::endl;
+        return;
+    }
+    
+    std::cout << "\n=== СПИСОК ЗАМЕТОК ===" << std::endl;
+    std::cout << "№  | Название                | Тема           | Дата создания" << std::endl;
+    std::cout << "---+------------------------+----------------+--------------" << std::endl;
+    
     NoteNode* current = head;
     while (current != nullptr) {
-        if (current->data.id == id) {
-            return current;
+        printNoteRow(current->data);
+        current = current->next;
+    }
+    std::cout << std::endl;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::displayNote(int id) const {
+    NoteNode* node = findNode(id);
+    if (node == nullptr) {
+        std::cout << "Ошибка: заметка с ID " << id << " не найдена" << std::endl;
+        return;
+    }
+    
+    const Note& note = node->data;
+    
+    std::cout << "\n=== ЗАМЕТКА #" << note.id << " ===" << std::endl;
+    std::cout << "Название: " << note.title << std::endl;
+    std::cout << "Тема: " << note.category << std::endl;
+    std::cout << "Дата: " << note.creationDate << std::endl;
+    if (!note.tags.empty()) {
+        std::cout << "Метки: " << joinTags(note.tags) << std::endl;
+    }
+    std::cout << "\nТекст:" << std::endl;
+    std::cout << note.content << std::endl;
+    
+    std::vector<SimilarNote> related = findSimilar(id, SIMILAR_NOTES_THRESHOLD, 5);
+    if (!related.empty()) {
+        std::cout << "\nПохожие заметки:" << std::endl;
+        for (const SimilarNote& similar : related) {
+            std::cout << "  #" << similar.id << " " << findNode(similar.id)->data.title << " ("
+                      << static_cast<int>(similar.similarity * 100) << "%)" << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::searchByCategory(const std::string& category) const {
+    bool foundAny = false;
+    
+    std::cout << "\n=== РЕЗУЛЬТАТЫ ПОИСКА: " << category << " ===" << std::endl;
+    std::cout << "№  | Название                | Тема           | Дата создания" << std::endl;
+    std::cout << "---+------------------------+----------------+--------------" << std::endl;
+    
+    // Отбираем заметки векторным просмотром столбца тем
+    for (int id : findByCategory(category)) {
+        foundAny = true;
+        printNoteRow(findNode(id)->data);
+    }
+    
+    if (!foundAny) {
+        // Точных совпадений нет - показываем заметки с похожими темами
+        // (без учета регистра и с опечатками)
+        int maxDistance = decodeUtf8(category).size() <= 4 ? 1 : 2;
+        std::vector<FuzzyMatch> matches = fuzzySearchCategories(category, maxDistance);
+        if (matches.empty()) {
+            std::cout << "\nЗаметки с темой \"" << category << "\" не найдены" << std::endl;
+        } else {
+            std::cout << "\nТочных совпадений нет. Заметки с похожими темами:" << std::endl;
+            for (const FuzzyMatch& match : matches) {
+                printNoteRow(findNode(match.id)->data);
+            }
+        }
+    }
+    
+    std::cout << std::endl;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::searchByTags(const std::string& queryText) const {
+    TagQuery query = parseTagQuery(queryText);
+    std::vector<int> matches = findByTags(query);
+    
+    std::cout << "\n=== РЕЗУЛЬТАТЫ ПОИСКА ПО МЕТКАМ: " << queryText << " ===" << std::endl;
+    std::cout << "№  | Название                | Тема           | Дата создания" << std::endl;
+    std::cout << "---+------------------------+----------------+--------------" << std::endl;
+    
+    for (int id : matches) {
+        printNoteRow(findNode(id)->data);
+    }
+    
+    if (matches.empty()) {
+        std::cout << "\nЗаметки по запросу \"" << queryText << "\" не найдены" << std::endl;
+    } else {
+        // Метки среди найденных заметок - для уточнения запроса
+        std::cout << "\nМетки найденных заметок:";
+        for (const TagCount& facet : tagCounts(query)) {
+            std::cout << " " << facet.tag << " (" << facet.count << ")";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::searchByContent(const std::string& text) const {
+    std::cout << "\n=== РЕЗУЛЬТАТЫ ПОИСКА ПО ТЕКСТУ: " << text << " ===" << std::endl;
+    std::cout << "№  | Название                | Тема           | Дата создания" << std::endl;
+    std::cout << "---+------------------------+----------------+--------------" << std::endl;
+    
+    // Строки выводятся по мере нахождения
+    size_t found = parallelSearchContent(text, [](const Note& note) { printNoteRow(note); });
+    
+    if (found == 0) {
+        std::cout << "\nЗаметки с текстом \"" << text << "\" не найдены" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<int> BasicNoteManager<Storage, Index, Durability>::findByContent(const std::string& text) const {
+    std::vector<int> ids;
+    if (noteCount >= PARALLEL_SCAN_THRESHOLD) {
+        parallelSearchContent(text, [&ids](const Note& note) { ids.push_back(note.id); });
+        return ids;
+    }
+    
+    NoteNode* current = head;
+    while (current != nullptr) {
+        if (findSubstring(current->data.content, text) != std::string_view::npos) {
+            ids.push_back(current->data.id);
         }
         current = current->next;
     }
-    return nullptr;
+    return ids;
+}
+
+template <typename Storage, typename Index, typename Durability>
+size_t BasicNoteManager<Storage, Index, Durability>::parallelSearchContent(
+    const std::string& text, const std::function<void(const Note&)>& onMatch, size_t threads) const {
+    // Снимок узлов в порядке ID; список не меняется до конца вызова
+    std::vector<const NoteNode*> nodes;
+    nodes.reserve(noteCount);
+    for (NoteNode* current = head; current != nullptr; current = current->next) {
+        nodes.push_back(current);
+    }
+    auto byId = [](const NoteNode* a, const NoteNode* b) { return a->data.id < b->data.id; };
+    if (!std::is_sorted(nodes.begin(), nodes.end(), byId)) {
+        std::sort(nodes.begin(), nodes.end(), byId);
+    }
+    
+    size_t chunkCount = (nodes.size() + PARALLEL_SCAN_CHUNK - 1) / PARALLEL_SCAN_CHUNK;
+    std::vector<std::vector<const Note*>> chunkMatches(chunkCount);
+    std::vector<char> chunkDone(chunkCount, 0);
+    
+    // Результаты отдаются по порядку частей: часть выводится, как только
+    // готовы все предыдущие, поэтому первые совпадения приходят сразу
+    std::mutex emitMutex;
+    size_t nextToEmit = 0;
+    size_t matchCount = 0;
+    
+    std::lock_guard<std::mutex> scanLock(scanMutex);
+    ThreadPool& pool = scanPoolFor(threads);
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        pool.submit([&, chunk]() {
+            size_t begin = chunk * PARALLEL_SCAN_CHUNK;
+            size_t end = std::min(begin + PARALLEL_SCAN_CHUNK, nodes.size());
+            std::vector<const Note*> matches;
+            for (size_t i = begin; i < end; i++) {
+                if (findSubstring(nodes[i]->data.content, text) != std::string_view::npos) {
+                    matches.push_back(&nodes[i]->data);
+                }
+            }
+            
+            std::lock_guard<std::mutex> lock(emitMutex);
+            chunkMatches[chunk] = std::move(matches);
+            chunkDone[chunk] = 1;
+            while (nextToEmit < chunkCount && chunkDone[nextToEmit]) {
+                for (const Note* note : chunkMatches[nextToEmit]) {
+                    onMatch(*note);
+                    matchCount++;
+                }
+                chunkMatches[nextToEmit].clear();
+                nextToEmit++;
+            }
+        });
+    }
+    pool.wait();
+    
+    return matchCount;
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<int> BasicNoteManager<Storage, Index, Durability>::findByCategory(const std::string& category) const {
+    if constexpr (Index::secondary) {
+        return columns.selectCategory(category);
+    } else {
+        return scanIds(head, [&](const Note& note) { return note.category == category; });
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<int> BasicNoteManager<Storage, Index, Durability>::findByDateRange(const std::string& from,
+                                                                               const std::string& to) const {
+    if constexpr (Index::secondary) {
+        return columns.selectDateRange(from, to);
+    } else {
+        uint32_t low = NoteColumns::dateKey(from);
+        uint32_t high = NoteColumns::dateKey(to);
+        if (low == 0 || high == 0 || low > high) {
+            return std::vector<int>();
+        }
+        return scanIds(head, [&](const Note& note) {
+            uint32_t date = NoteColumns::dateKey(note.creationDate);
+            return date >= low && date <= high;
+        });
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<int> BasicNoteManager<Storage, Index, Durability>::findByTags(const TagQuery& query) const {
+    if constexpr (Index::secondary) {
+        return tagIndex.query(query);
+    } else {
+        return scanIds(head, [&](const Note& note) { return matchesTagQuery(note.tags, query); });
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<TagCount> BasicNoteManager<Storage, Index, Durability>::tagCounts() const {
+    if constexpr (Index::secondary) {
+        return tagIndex.counts();
+    } else {
+        return scanTagCounts(head, TagQuery());
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<TagCount> BasicNoteManager<Storage, Index, Durability>::tagCounts(const TagQuery& query) const {
+    if constexpr (Index::secondary) {
+        return tagIndex.counts(tagIndex.select(query));
+    } else {
+        return scanTagCounts(head, query);
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<SimilarNote> BasicNoteManager<Storage, Index, Durability>::findSimilar(int id, double minSimilarity,
+                                                                                  size_t limit) const {
+    NoteNode* node = findNode(id);
+    if (node == nullptr) {
+        return {};
+    }
+    return similarTo(node->data.content, id, minSimilarity, limit);
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<SimilarNote> BasicNoteManager<Storage, Index, Durability>::findSimilarText(
+    const std::string& content, double minSimilarity, size_t limit) const {
+    return similarTo(content, 0, minSimilarity, limit);
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<SimilarNote> BasicNoteManager<Storage, Index, Durability>::similarTo(
+    const std::string& content, int excludeId, double minSimilarity, size_t limit) const {
+    std::vector<uint64_t> shingles = textShingles(content);
+    if (shingles.empty()) {
+        return {};
+    }
+    
+    std::vector<SimilarNote> result;
+    if constexpr (Index::secondary) {
+        // Оценка по подписи только отбирает кандидатов, сходство считается точно
+        MinHashSignature signature = minHashSignature(shingles);
+        for (const SimilarNote& candidate :
+             similarNotes.candidates(signature, minSimilarity - MINHASH_ESTIMATE_MARGIN)) {
+            if (candidate.id == excludeId) {
+                continue;
+            }
+            double similarity = jaccardSimilarity(shingles, textShingles(findNode(candidate.id)->data.content));
+            if (similarity >= minSimilarity) {
+                result.push_back({candidate.id, similarity});
+            }
+        }
+    } else {
+        result = scanSimilar(head, shingles, excludeId, minSimilarity);
+    }
+    sortSimilar(result);
+    if (result.size() > limit) {
+        result.resize(limit);
+    }
+    return result;
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<GroupCount> BasicNoteManager<Storage, Index, Durability>::countBy(GroupBy by) const {
+    if constexpr (Index::secondary) {
+        return aggregates.counts(by);
+    } else {
+        return countBy(by, [](const Note&) { return true; });
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<GroupCount> BasicNoteManager<Storage, Index, Durability>::countBy(
+    GroupBy by, const std::function<bool(const Note&)>& filter, size_t threads) const {
+    std::vector<const Note*> notes;
+    notes.reserve(noteCount);
+    for (NoteNode* current = head; current != nullptr; current = current->next) {
+        notes.push_back(&current->data);
+    }
+    
+    // Каждая часть считает в свою таблицу, таблицы сливаются под мьютексом
+    std::unordered_map<std::string, uint64_t> total;
+    std::mutex mergeMutex;
+    size_t chunkCount = (notes.size() + PARALLEL_SCAN_CHUNK - 1) / PARALLEL_SCAN_CHUNK;
+    
+    std::lock_guard<std::mutex> scanLock(scanMutex);
+    ThreadPool& pool = scanPoolFor(threads);
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        pool.submit([&, chunk]() {
+            size_t begin = chunk * PARALLEL_SCAN_CHUNK;
+            size_t end = std::min(begin + PARALLEL_SCAN_CHUNK, notes.size());
+            std::unordered_map<std::string, uint64_t> local;
+            for (size_t i = begin; i < end; i++) {
+                const Note& note = *notes[i];
+                if (filter(note)) {
+                    local[by == GroupBy::Category ? note.category : dateGroupKey(note.creationDate, by)]++;
+                }
+            }
+            
+            std::lock_guard<std::mutex> lock(mergeMutex);
+            for (const auto& entry : local) {
+                total[entry.first] += entry.second;
+            }
+        });
+    }
+    pool.wait();
+    
+    std::vector<GroupCount> result;
+    result.reserve(total.size());
+    for (const auto& entry : total) {
+        result.push_back({entry.first, entry.second});
+    }
+    sortGroups(result, by);
+    return result;
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<FuzzyMatch> BasicNoteManager<Storage, Index, Durability>::fuzzySearchTitles(const std::string& query,
+                                                                                        int maxDistance) const {
+    if constexpr (Index::secondary) {
+        return titleFuzzy.search(query, maxDistance);
+    } else {
+        return scanFuzzy(head, &Note::title, query, maxDistance);
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<FuzzyMatch> BasicNoteManager<Storage, Index, Durability>::fuzzySearchCategories(const std::string& query,
+                                                                                            int maxDistance) const {
+    if constexpr (Index::secondary) {
+        return categoryFuzzy.search(query, maxDistance);
+    } else {
+        return scanFuzzy(head, &Note::category, query, maxDistance);
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<std::string> BasicNoteManager<Storage, Index, Durability>::suggestTitles(const std::string& prefix,
+                                                                                     size_t limit) const {
+    std::vector<int> ids;
+    if constexpr (Index::secondary) {
+        ids = titlePrefixes.complete(prefix, limit);
+    } else {
+        ids = scanTitlePrefix(head, prefix, limit);
+    }
+    
+    std::vector<std::string> titles;
+    for (int id : ids) {
+        NoteNode* node = findNode(id);
+        if (node != nullptr) {
+            titles.push_back(node->data.title);
+        }
+    }
+    return titles;
+}
+
+// Состояние, сохраненное в снимке вместе с заметками и индексами
+template <typename Storage, typename Index, typename Durability>
+struct BasicNoteManager<Storage, Index, Durability>::SnapshotState {
+    SnapshotHeader header;                      // Метаданные, для которых сделан снимок
+    std::unordered_map<int, FileStamp> stamps;  // ID -> состояние файла заметки
+};
+
+// Ошибки в записях метаданных: в строгом режиме - исключение до изменения хранилища
+static void checkRejected(const std::vector<MetadataError>& rejected, LoadMode mode, LoadReport& report) {
+    for (const MetadataError& error : rejected) {
+        std::string message = "строка " + std::to_string(error.line) + ": " + error.reason;
+        if (mode == LoadMode::Strict) {
+            throw std::runtime_error("Поврежденный файл метаданных, " + message);
+        }
+        report.errors.push_back(message);
+    }
+}
+
+// Отброшенные строки сохраняются как есть для ручного восстановления
+static void writeRejected(const std::vector<MetadataError>& rejected, const std::string& metadataFile,
+                          LoadReport& report) {
+    report.skipped = static_cast<int>(rejected.size());
+    if (rejected.empty()) {
+        return;
+    }
+    std::ofstream rejectedFile(metadataFile + ".rejected", std::ios::app);
+    for (const MetadataError& error : rejected) {
+        rejectedFile << error.text << '\n';
+    }
+    std::cout << "Пропущено поврежденных записей: " << report.skipped
+              << " (сохранены в " << metadataFile << ".rejected)" << std::endl;
 }
 
-bool NoteManager::addNote(const std::string& title, const std::string& category, const std::string& content) {
-    // Проверка уникальности названия
-    NoteNode* current = head;
-    while (current != nullptr) {
-        if (current->data.title == title) {
-            std::cout << "Ошибка: заметка с таким названием уже существует" << std::endl;
-            return false;
-        }
-        current = current->next;
+template <typename Storage, typename Index, typename Durability>
+LoadReport BasicNoteManager<Storage, Index, Durability>::loadFromFile(LoadMode mode) {
+    LoadReport report;
+    if constexpr (!Storage::persistent) {
+        // Хранилище в памяти загружать неоткуда
+        return report;
     }
+    waitForPurge();
+    flush();
     
-    // Создаем новую заметку
-    Note newNote;
-    newNote.id = nextId++;
-    newNote.title = title;
-    newNote.category = category;
-    newNote.content = content;
-    newNote.creationDate = getCurrentDate();
-    newNote.filePath = generateFilePath(newNote.id, newNote.title);
+    FileStamp metadataStamp;
+    if (!readFileStamp(metadataFile, metadataStamp)) {
+        // Файл не существует - это нормально при первом запуске
+        return report;
+    }
+    uint64_t fileGeneration = readMetadataGeneration(metadataFile);
     
-    // Сохраняем заметку в файл
-    try {
-        saveNoteToFile(newNote);
-    } catch (const std::exception& e) {
-        std::cout << "Ошибка при сохранении файла: " << e.what() << std::endl;
-        return false;
+    // Снимок сделан для этого же файла метаданных - записи можно не разбирать.
+    // Без вторичных индексов снимок не используется: строить почти нечего
+    SnapshotHeader header;
+    bool haveSnapshot = Index::secondary && readSnapshotHeader(snapshotFile, header);
+    bool exact = haveSnapshot && header.generation == fileGeneration &&
+                 header.metadataSize == static_cast<uint64_t>(metadataStamp.size);
+    
+    // Иначе сначала разбираем все записи: в строгом режиме ошибка не должна
+    // оставлять хранилище наполовину загруженным
+    std::vector<Note> notes;
+    std::vector<MetadataError> rejected;
+    if (!exact) {
+        readMetadataFile(metadataFile, notes, rejected);
+        checkRejected(rejected, mode, report);
+    }
+    
+    SnapshotState state;
+    if (haveSnapshot && loadSnapshot(state) && state.header.generation == header.generation) {
+        report.fromSnapshot = true;
+        if (exact) {
+            // Файлы проверяются всегда: правка "на месте" не меняет время
+            // изменения директории, а проверка - один stat на заметку
+            report.refreshed = refreshChangedFiles(state);
+        } else {
+            report.refreshed = applyMetadataDelta(notes, state);
+            report.refreshed += refreshChangedFiles(state);
+        }
+        loadTrash();
+        generation = fileGeneration;
+        report.loaded = noteCount;
+        writeRejected(rejected, metadataFile, report);
+        return report;
     }
     
-    // Создаем новый узел
-    NoteNode* newNode = new NoteNode(newNote);
+    // Полная загрузка: снимка нет или он поврежден
+    if (exact) {
+        readMetadataFile(metadataFile, notes, rejected);
+        checkRejected(rejected, mode, report);
+    }
     
-    // Добавляем в конец списка
-    if (tail == nullptr) {
-        // Список пуст
-        head = tail = newNode;
-    } else {
-        // Добавляем в конец
-        tail->next = newNode;
-        newNode->prev = tail;
-        tail = newNode;
+    // Очищаем текущий список
+    clearList();
+    bulkLoading = true;
+    
+    for (Note& note : notes) {
+        if (note.id >= nextId) {
+            nextId = note.id + 1;
+        }
+        
+        // Загружаем содержимое из файла
+        loadNoteBody(note);
+        
+        // Создаем новый узел и добавляем в конец списка
+        appendNode(new NoteNode(std::move(note)));
     }
-    noteCount++;
     
-    // Обновляем метаданные
-    saveToFile();
+    finishBulkLoad();
+    loadTrash();
     
-    return true;
+    generation = fileGeneration;
+    report.loaded = noteCount;
+    writeRejected(rejected, metadataFile, report);
+    return report;
 }
 
-bool NoteManager::deleteNote(int id) {
-    NoteNode* node = findNode(id);
-    if (node == nullptr) {
-        std::cout << "Ошибка: заметка с ID " << id << " не найдена" << std::endl;
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::saveSnapshot() const {
+    if constexpr (!Storage::persistent || !Index::secondary) {
         return false;
     }
     
-    // Удаляем файл заметки
-    if (remove(node->data.filePath.c_str()) != 0) {
-        std::cout << "Предупреждение: не удалось удалить файл заметки" << std::endl;
+    // Снимок должен соответствовать файлу метаданных после фоновой очистки
+    // и записи отложенных изменений
+    waitForPurge();
+    flush();
+    SnapshotState state;
+    FileStamp metadataStamp;
+    if (!readFileStamp(metadataFile, metadataStamp)) {
+        return false;
     }
+    state.header.generation = generation;
+    state.header.metadataSize = static_cast<uint64_t>(metadataStamp.size);
     
-    // Удаляем узел из списка
-    if (node->prev != nullptr) {
-        node->prev->next = node->next;
-    } else {
-        // Удаляем голову списка
-        head = node->next;
+    SnapshotWriter out;
+    out.putU64(static_cast<uint64_t>(nextId));
+    out.putU64(static_cast<uint64_t>(noteCount));
+    for (NoteNode* current = head; current != nullptr; current = current->next) {
+        const Note& note = current->data;
+        FileStamp stamp;
+        readFileStamp(note.filePath, stamp);
+        out.putU32(static_cast<uint32_t>(note.id));
+        out.putString(note.title);
+        out.putString(note.category);
+        out.putString(note.creationDate);
+        out.putString(note.filePath);
+        out.putString(joinTags(note.tags));
+        out.putString(note.content);
+        out.putString(note.bodyHash);
+        out.putI64(note.createdAt);
+        out.putI64(stamp.size);
+        out.putI64(stamp.mtimeNs);
     }
+    titlePrefixes.save(out);
+    titleFuzzy.save(out);
+    categoryFuzzy.save(out);
+    columns.save(out);
+    tagIndex.save(out);
+    aggregates.save(out);
+    similarNotes.save(out);
     
-    if (node->next != nullptr) {
-        node->next->prev = node->prev;
-    } else {
-        // Удаляем хвост списка
-        tail = node->prev;
+    return writeSnapshotFile(snapshotFile, state.header, out.data());
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::loadSnapshot(SnapshotState& state) {
+    std::string payload;
+    if (!readSnapshotFile(snapshotFile, state.header, payload)) {
+        return false;
     }
     
-    delete node;
-    noteCount--;
-    
-    // Обновляем метаданные
-    saveToFile();
-    
+    clearList();
+    try {
+        SnapshotReader in(payload);
+        int savedNextId = static_cast<int>(in.getU64());
+        size_t count = in.getCount(4 + 7 * sizeof(uint64_t) + 3 * sizeof(int64_t));
+        state.stamps.reserve(count);
+        idIndex.reserve(count);
+        titleIndex.reserve(count);
+        
+        for (size_t i = 0; i < count; i++) {
+            Note note;
+            note.id = static_cast<int>(in.getU32());
+            note.title = in.getString();
+            note.category = in.getString();
+            note.creationDate = in.getString();
+            note.filePath = in.getString();
+            note.tags = parseTags(in.getString());
+            note.content = in.getString();
+            note.bodyHash = in.getString();
+            note.createdAt = in.getI64();
+            FileStamp& stamp = state.stamps[note.id];
+            stamp.size = in.getI64();
+            stamp.mtimeNs = in.getI64();
+            
+            // Индексы восстанавливаются ниже целиком, здесь - только список и хеш-таблицы
+            NoteNode* node = new NoteNode(std::move(note));
+            linkNode(node);
+            idIndex[node->data.id] = node;
+            titleIndex[node->data.title] = node;
+            bodies.addRef(node->data.bodyHash, node->data.content.size());
+        }
+        if (idIndex.size() != count || titleIndex.size() != count) {
+            throw std::runtime_error("повторные ID или названия");
+        }
+        
+        titlePrefixes.load(in);
+        titleFuzzy.load(in);
+        categoryFuzzy.load(in);
+        columns.load(in);
+        tagIndex.load(in);
+        aggregates.load(in);
+        similarNotes.load(in);
+        if (!in.atEnd()) {
+            throw std::runtime_error("лишние данные");
+        }
+        nextId = savedNextId;
+    } catch (const std::exception& e) {
+        std::cout << "Снимок индексов не использован: " << e.what() << std::endl;
+        clearList();
+        nextId = 1;
+        return false;
+    }
     return true;
 }
 
-void NoteManager::displayAllNotes() const {
-    if (noteCount == 0) {
-        std::cout << "\nЗаметки не найдены\n" << std::endl;
-        return;
+template <typename Storage, typename Index, typename Durability>
+int BasicNoteManager<Storage, Index, Durability>::applyMetadataDelta(std::vector<Note>& records, SnapshotState& state) {
+    // Сначала удаляем заметки, которых нет в метаданных или чья запись изменилась:
+    // так названия, переходящие между заметками, не конфликтуют в индексах
+    std::unordered_map<int, const Note*> recordById;
+    recordById.reserve(records.size());
+    for (const Note& record : records) {
+        recordById[record.id] = &record;
     }
     
-    std::cout << "\n=== СПИСОК ЗАМЕТОК ===" << std::endl;
-    std::cout << "№  | Название                | Тема           | Дата создания" << std::endl;
-    std::cout << "---+------------------------+----------------+--------------" << std::endl;
-    
     NoteNode* current = head;
     while (current != nullptr) {
-        std::cout.width(2);
-        std::cout << std::left << current->data.id << " | ";
-        
-        std::string title = current->data.title;
-        if (title.length() > 22) {
-            title = title.substr(0, 19) + "...";
+        NoteNode* next = current->next;
+        const Note& note = current->data;
+        auto it = recordById.find(note.id);
+        if (it == recordById.end() || it->second->title != note.title ||
+            it->second->category != note.category || it->second->creationDate != note.creationDate ||
+            it->second->filePath != note.filePath || it->second->tags != note.tags) {
+            state.stamps.erase(note.id);
+            unlinkNode(current);
+            delete current;
         }
-        std::cout.width(22);
-        std::cout << std::left << title << " | ";
-        
-        std::string category = current->data.category;
-        if (category.length() > 14) {
-            category = category.substr(0, 11) + "...";
+        current = next;
+    }
+    
+    // Новые и измененные записи читаются с диска
+    int loaded = 0;
+    for (Note& record : records) {
+        if (record.id >= nextId) {
+            nextId = record.id + 1;
+        }
+        if (findNode(record.id) == nullptr) {
+            loadNoteBody(record);
+            appendNode(new NoteNode(std::move(record)));
+            loaded++;
         }
-        std::cout.width(14);
-        std::cout << std::left << category << " | ";
-        
-        std::cout << current->data.creationDate << std::endl;
-        
-        current = current->next;
     }
-    std::cout << std::endl;
+    
+    // Порядок списка - как в файле метаданных
+    head = tail = nullptr;
+    for (const Note& record : records) {
+        NoteNode* node = findNode(record.id);
+        node->next = nullptr;
+        node->prev = tail;
+        if (tail == nullptr) {
+            head = node;
+        } else {
+            tail->next = node;
+        }
+        tail = node;
+    }
+    return loaded;
 }
 
-void NoteManager::displayNote(int id) const {
-    NoteNode* node = findNode(id);
-    if (node == nullptr) {
-        std::cout << "Ошибка: заметка с ID " << id << " не найдена" << std::endl;
+template <typename Storage, typename Index, typename Durability>
+int BasicNoteManager<Storage, Index, Durability>::refreshChangedFiles(const SnapshotState& state) {
+    // Текст перечитывается для заметок, чей файл изменился после снимка
+    int refreshed = 0;
+    for (NoteNode* current = head; current != nullptr; current = current->next) {
+        auto it = state.stamps.find(current->data.id);
+        if (it == state.stamps.end()) {
+            continue;
+        }
+        FileStamp stamp;
+        readFileStamp(current->data.filePath, stamp);
+        if (stamp != it->second) {
+            Note updated = current->data;
+            loadNoteBody(updated);
+            recordRevision(current->data, updated);
+            replaceNodeData(current, std::move(updated));
+            refreshed++;
+        }
+    }
+    return refreshed;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::saveToFile() const {
+    if constexpr (Storage::persistent) {
+        std::string data = formatMetadata();
+        writeMetadata(data, generation);
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::flush() const {
+    if (metadataDirty) {
+        saveToFile();
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::persistChange() {
+    if constexpr (Storage::persistent && Durability::deferred) {
+        metadataDirty = true;
+    } else if constexpr (Storage::persistent) {
+        saveToFile();
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::finishBulkLoad() {
+    bulkLoading = false;
+    if constexpr (Index::secondary) {
+        titlePrefixes.finalize();
+    }
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::string BasicNoteManager<Storage, Index, Durability>::formatMetadata() const {
+    // Заметки из корзины в файл не попадают - они описаны в журнале корзины
+    generation++;
+    metadataHasTrash = false;
+    metadataDirty = false;
+    std::string data = formatMetadataHeader(generation);
+    data += '\n';
+    for (NoteNode* current = head; current != nullptr; current = current->next) {
+        data += formatMetadataRecord(current->data);
+        data += '\n';
+    }
+    return data;
+}
+
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::writeMetadata(const std::string& data,
+                                                                 uint64_t fileGeneration) const {
+    // Файл пишется во временный и заменяет старый переименованием: при сбое
+    // на диске остается целая старая или новая версия
+    std::lock_guard<std::mutex> lock(metadataMutex);
+    if (fileGeneration <= writtenGeneration) {
+        // Основной поток уже записал более новую версию
         return;
     }
     
-    const Note& note = node->data;
+    std::string tmpFile = metadataFile + ".tmp";
+    std::ofstream file(tmpFile, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Не удалось открыть файл метаданных для записи");
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    file.close();
+    if (!file) {
+        std::remove(tmpFile.c_str());
+        throw std::runtime_error("Ошибка записи файла метаданных");
+    }
     
-    std::cout << "\n=== ЗАМЕТКА #" << note.id << " ===" << std::endl;
-    std::cout << "Название: " << note.title << std::endl;
-    std::cout << "Тема: " << note.category << std::endl;
-    std::cout << "Дата: " << note.creationDate << std::endl;
-    std::cout << "\nТекст:" << std::endl;
-    std::cout << note.content << std::endl;
-    std::cout << std::endl;
+#ifdef _WIN32
+    // rename в Windows не заменяет существующий файл
+    std::remove(metadataFile.c_str());
+#endif
+    if (std::rename(tmpFile.c_str(), metadataFile.c_str()) != 0) {
+        std::remove(tmpFile.c_str());
+        throw std::runtime_error("Не удалось заменить файл метаданных");
+    }
+    writtenGeneration = fileGeneration;
 }
 
-void NoteManager::searchByCategory(const std::string& category) const {
-    bool foundAny = false;
-    
-    std::cout << "\n=== РЕЗУЛЬТАТЫ ПОИСКА: " << category << " ===" << std::endl;
-    std::cout << "№  | Название                | Тема           | Дата создания" << std::endl;
-    std::cout << "---+------------------------+----------------+--------------" << std::endl;
+template <typename Storage, typename Index, typename Durability>
+int BasicNoteManager<Storage, Index, Durability>::reconcile(const WatchBatch& batch) {
+    int applied = 0;
+    bool metadataChanged = false;
+    if constexpr (!Storage::persistent) {
+        return applied;
+    }
     
-    // Ищем и сразу выводим заметки по категории (обход списка)
-    NoteNode* current = head;
-    while (current != nullptr) {
-        if (current->data.category == category) {
-            foundAny = true;
-            
-            std::cout.width(2);
-            std::cout << std::left << current->data.id << " | ";
-            
-            std::string title = current->data.title;
-            if (title.length() > 22) {
-                title = title.substr(0, 19) + "...";
+    if (batch.overflow) {
+        // События потеряны - сверяем все заметки, но метаданные не перечитываем
+        NoteNode* current = head;
+        while (current != nullptr) {
+            NoteNode* next = current->next;
+            if (reconcileNode(current, metadataChanged)) {
+                applied++;
             }
-            std::cout.width(22);
-            std::cout << std::left << title << " | ";
-            
-            std::string cat = current->data.category;
-            if (cat.length() > 14) {
-                cat = cat.substr(0, 11) + "...";
+            current = next;
+        }
+    } else {
+        for (const std::string& name : batch.files) {
+            // Имя файла заметки начинается с ее ID: <id>_<название>.txt
+            int id = 0;
+            size_t digits = 0;
+            while (digits < name.size() && digits < 9 && name[digits] >= '0' && name[digits] <= '9') {
+                id = id * 10 + (name[digits] - '0');
+                digits++;
+            }
+            if (digits == 0 || digits >= name.size() || name[digits] != '_') {
+                continue;
             }
-            std::cout.width(14);
-            std::cout << std::left << cat << " | ";
             
-            std::cout << current->data.creationDate << std::endl;
+            // Файлы без заметки (в том числе старые имена после переименования) пропускаются
+            NoteNode* node = findNode(id);
+            if (node == nullptr || node->data.filePath != notesDir + "/" + name) {
+                continue;
+            }
+            if (reconcileNode(node, metadataChanged)) {
+                applied++;
+            }
         }
-        current = current->next;
     }
     
-    if (!foundAny) {
-        std::cout << "\nЗаметки с темой \"" << category << "\" не найдены" << std::endl;
+    if (metadataChanged) {
+        persistChange();
+    }
+    return applied;
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::reconcileNode(NoteNode* node, bool& metadataChanged) {
+    std::string data;
+    if (!readWholeFile(node->data.filePath, data)) {
+        // Файл удален вне программы
+        std::string bodyHash = node->data.bodyHash;
+        history.remove(node->data.id);
+        unlinkNode(node);
+        delete node;
+        bodies.removeIfUnused(bodyHash);
+        metadataChanged = true;
+        return true;
     }
     
-    std::cout << std::endl;
+    Note updated = node->data;
+    if (!parseNoteHeader(data, updated.title, updated.category, updated.creationDate) ||
+        updated.title.empty()) {
+        std::cout << "Предупреждение: заголовок файла " << node->data.filePath
+                  << " поврежден, изменения не применены" << std::endl;
+        return false;
+    }
+    
+    const Note& note = node->data;
+    
+    // Текст записан в файл напрямую (редактором) - его нужно перенести в хранилище текстов
+    bool inlineBody = !parseNoteBodyRef(data, updated.bodyHash);
+    if (inlineBody) {
+        updated.bodyHash.clear();
+        updated.content.assign(noteBodyView(data));
+    } else if (updated.bodyHash != note.bodyHash && !bodies.read(updated.bodyHash, updated.content)) {
+        std::cout << "Предупреждение: текст " << updated.bodyHash << " для файла "
+                  << node->data.filePath << " не найден, изменения не применены" << std::endl;
+        return false;
+    }
+    
+    bool headerChanged = updated.title != note.title || updated.category != note.category ||
+                         updated.creationDate != note.creationDate;
+    bool contentChanged = updated.content != note.content;
+    if (!headerChanged && !contentChanged && (!inlineBody || note.bodyHash.empty())) {
+        // Собственная запись программы или повторное событие; текст, уже
+        // хранившийся в файле заметки (коллизия хеша), повторно не переносится
+        return false;
+    }
+    if (updated.title != note.title && titleIndex.count(updated.title) != 0) {
+        std::cout << "Предупреждение: название \"" << updated.title
+                  << "\" из файла уже занято, изменения не применены" << std::endl;
+        return false;
+    }
+    
+    if (inlineBody) {
+        // Файл перезаписывается со ссылкой; при ошибке текст остается в файле заметки
+        try {
+            saveNoteToFile(updated);
+        } catch (const std::exception& e) {
+            updated.bodyHash.clear();
+            std::cout << "Предупреждение: текст файла " << updated.filePath
+                      << " не перенесен в хранилище текстов: " << e.what() << std::endl;
+        }
+    }
+    
+    std::string oldBodyHash = note.bodyHash;
+    metadataChanged = metadataChanged || headerChanged;
+    recordRevision(note, updated);
+    replaceNodeData(node, std::move(updated));
+    bodies.removeIfUnused(oldBodyHash);
+    return headerChanged || contentChanged;
 }
 
-void NoteManager::loadFromFile() {
-    std::ifstream file(METADATA_FILE);
-    if (!file.is_open()) {
-        // Файл не существует - это нормально при первом запуске
-        return;
+template <typename Storage, typename Index, typename Durability>
+FsckReport BasicNoteManager<Storage, Index, Durability>::verifyStore(size_t threads) const {
+    FsckReport report;
+    if constexpr (!Storage::persistent) {
+        return report;
     }
+    waitForPurge();
+    flush();
     
-    // Очищаем текущий список
-    clearList();
+    // Записи читаются с диска, а не из памяти: проверяется то, что загрузится
+    std::vector<Note> records;
+    std::vector<MetadataError> badRecords;
+    readMetadataFile(metadataFile, records, badRecords);
+    
+    report.records = static_cast<int>(records.size() + badRecords.size());
+    report.badRecords = static_cast<int>(badRecords.size());
+    for (const MetadataError& error : badRecords) {
+        report.problems.push_back("строка " + std::to_string(error.line) + ": " + error.reason);
+    }
+    
+    // Проверка файлов заметок частями на пуле потоков: читается только файл
+    // заметки (заголовок и ссылка), для текста проверяется наличие файла
+    std::unordered_set<std::string> referencedBodies;
+    std::mutex reportMutex;
+    {
+        std::lock_guard<std::mutex> scanLock(scanMutex);
+        ThreadPool& pool = scanPoolFor(threads);
+        for (size_t begin = 0; begin < records.size(); begin += PARALLEL_SCAN_CHUNK) {
+            size_t end = std::min(records.size(), begin + PARALLEL_SCAN_CHUNK);
+            pool.submit([&, begin, end]() {
+                int missing = 0;
+                int mismatches = 0;
+                int missingBodies = 0;
+                std::vector<std::string> problems;
+                std::vector<std::string> hashes;
+                std::string data;
+                std::string hash;
+                for (size_t i = begin; i < end; i++) {
+                    const Note& note = records[i];
+                    if (!readWholeFile(note.filePath, data)) {
+                        missing++;
+                        problems.push_back("заметка " + std::to_string(note.id) +
+                                           ": нет файла " + note.filePath);
+                        continue;
+                    }
+                    std::string_view header(data.data(), std::min(data.size(), data.find('\n')));
+                    if (header != "Название: " + note.title) {
+                        mismatches++;
+                        problems.push_back("заметка " + std::to_string(note.id) +
+                                           ": название в файле не совпадает");
+                    }
+                    if (parseNoteBodyRef(data, hash)) {
+                        if (!bodies.exists(hash)) {
+                            missingBodies++;
+                            problems.push_back("заметка " + std::to_string(note.id) +
+                                               ": нет текста " + bodies.pathOf(hash));
+                        }
+                        hashes.push_back(hash);
+                    }
+                }
+                
+                std::lock_guard<std::mutex> lock(reportMutex);
+                report.missingFiles += missing;
+                report.titleMismatches += mismatches;
+                report.missingBodies += missingBodies;
+                report.problems.insert(report.problems.end(), problems.begin(), problems.end());
+                referencedBodies.insert(hashes.begin(), hashes.end());
+            });
+        }
+        pool.wait();
+    }
+    
+    // Файлы в директории заметок, на которые нет ни одной записи
+    // (файлы и тексты заметок из корзины остаются до очистки)
+    std::unordered_set<std::string> referenced;
+    for (const Note& note : records) {
+        referenced.insert(std::filesystem::path(note.filePath).filename().string());
+    }
+    std::vector<TrashEntry> trashed;
+    readTrashJournal(trashFile, trashed);
+    for (const TrashEntry& entry : trashed) {
+        referenced.insert(std::filesystem::path(entry.note.filePath).filename().string());
+        referencedBodies.insert(entry.note.bodyHash);
+    }
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(notesDir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (entry.is_regular_file(ec) && referenced.count(name) == 0) {
+            report.orphanFiles.push_back(entry.path().string());
+        }
+    }
+    std::sort(report.orphanFiles.begin(), report.orphanFiles.end());
+    for (const std::string& orphan : report.orphanFiles) {
+        report.problems.push_back("лишний файл " + orphan);
+    }
+    
+    // Тексты, на которые не ссылается ни один файл заметки
+    for (const std::string& hash : bodies.listHashes()) {
+        if (referencedBodies.count(hash) == 0) {
+            report.orphanBodies.push_back(bodies.pathOf(hash));
+        }
+    }
+    std::sort(report.orphanBodies.begin(), report.orphanBodies.end());
+    for (const std::string& orphan : report.orphanBodies) {
+        report.problems.push_back("лишний текст " + orphan);
+    }
+    
+    return report;
+}
+
+template <typename Storage, typename Index, typename Durability>
+std::vector<Note> BasicNoteManager<Storage, Index, Durability>::snapshot() const {
+    // Копия всех заметок на один момент времени, включая тексты
+    std::vector<Note> notes;
+    notes.reserve(noteCount);
+    for (NoteNode* current = head; current != nullptr; current = current->next) {
+        notes.push_back(current->data);
+    }
+    return notes;
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::exportArchive(const std::string& path, bool compress) const {
+    // Хранилище занято только на время копирования в память;
+    // запись архива идет уже из снимка
+    std::vector<Note> notes = snapshot();
+    
+    try {
+        ArchiveWriter writer(path, compress);
+        for (const Note& note : notes) {
+            writer.add(note);
+        }
+        writer.finish();
+    } catch (const std::exception& e) {
+        std::cout << "Ошибка экспорта: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::importArchive(const std::string& path) {
+    int imported = 0;
+    int skipped = 0;
+    int invalid = 0;
+    bool success = true;
     
-    std::string line;
+    // ID из корзины заняты до ее очистки, как и при добавлении
+    std::unordered_set<int> trashIds;
+    for (const TrashEntry& entry : trash) {
+        trashIds.insert(entry.note.id);
+    }
     
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string token;
+    try {
+        ArchiveReader reader(path);
         Note note;
         
-        // Парсим строку: id|title|category|date|filepath
-        if (std::getline(ss, token, '|')) {
-            note.id = std::stoi(token);
+        // Индексы строятся массово, метаданные записываются один раз в конце
+        bulkLoading = true;
+        while (reader.next(note)) {
+            // Контрольная сумма не защищает от подделанной записи - поля
+            // проверяются так же, как при вводе
+            note.tags = normalizeTags(note.tags);
+            if (note.id <= 0 || checkNoteTitle(note.title) != ValidationError::None ||
+                checkNoteCategory(note.category) != ValidationError::None ||
+                checkNoteContent(note.content) != ValidationError::None ||
+                checkNoteTags(note.tags) != ValidationError::None) {
+                invalid++;
+                continue;
+            }
+            if (idIndex.count(note.id) != 0 || titleIndex.count(note.title) != 0 || trashIds.count(note.id) != 0) {
+                skipped++;
+                continue;
+            }
+            note.filePath = generateFilePath(note.id, note.title);
+            saveNoteToFile(note);
+            appendNode(new NoteNode(note));
             if (note.id >= nextId) {
                 nextId = note.id + 1;
             }
+            imported++;
         }
-        if (std::getline(ss, note.title, '|') &&
-            std::getline(ss, note.category, '|') &&
-            std::getline(ss, note.creationDate, '|') &&
-            std::getline(ss, note.filePath)) {
-            
-            // Загружаем содержимое из файла
-            note.content = loadNoteContent(note.filePath);
-            
-            // Создаем новый узел и добавляем в конец списка
-            NoteNode* newNode = new NoteNode(note);
-            if (tail == nullptr) {
-                head = tail = newNode;
-            } else {
-                tail->next = newNode;
-                newNode->prev = tail;
-                tail = newNode;
-            }
-            noteCount++;
-        }
+    } catch (const std::exception& e) {
+        std::cout << "Ошибка импорта: " << e.what() << std::endl;
+        success = false;
     }
     
-    file.close();
-}
-
-void NoteManager::saveToFile() const {
-    std::ofstream file(METADATA_FILE);
-    if (!file.is_open()) {
-        throw std::runtime_error("Не удалось открыть файл метаданных для записи");
-    }
+    finishBulkLoad();
     
-    NoteNode* current = head;
-    while (current != nullptr) {
-        file << current->data.id << "|"
-             << current->data.title << "|"
-             << current->data.category << "|"
-             << current->data.creationDate << "|"
-             << current->data.filePath << std::endl;
-        current = current->next;
+    // Успешно прочитанные заметки сохраняются даже при ошибке в архиве
+    if (imported > 0) {
+        persistChange();
     }
     
-    file.close();
+    std::cout << "Импортировано заметок: " << imported;
+    if (skipped > 0) {
+        std::cout << ", пропущено (ID или название уже заняты): " << skipped;
+    }
+    if (invalid > 0) {
+        std::cout << ", пропущено (недопустимые поля): " << invalid;
+    }
+    std::cout << std::endl;
+    return success;
 }
 
-bool NoteManager::noteExists(int id) const {
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::noteExists(int id) const {
     return findNode(id) != nullptr;
 }
 
-int NoteManager::findNoteIndex(int id) const {
+template <typename Storage, typename Index, typename Durability>
+bool BasicNoteManager<Storage, Index, Durability>::titleExists(const std::string& title) const {
+    return titleIndex.count(title) != 0;
+}
+
+template <typename Storage, typename Index, typename Durability>
+const Note* BasicNoteManager<Storage, Index, Durability>::getNote(int id) const {
+    NoteNode* node = findNode(id);
+    return node != nullptr ? &node->data : nullptr;
+}
+
+// Память строк записи заметки (без текста) и массива меток
+static size_t noteStringBytes(const Note& note) {
+    size_t bytes = stringHeapBytes(note.title) + stringHeapBytes(note.category) +
+                   stringHeapBytes(note.creationDate) + stringHeapBytes(note.filePath) +
+                   stringHeapBytes(note.bodyHash);
+    for (const std::string& tag : note.tags) {
+        bytes += stringHeapBytes(tag);
+    }
+    return bytes;
+}
+
+template <typename Storage, typename Index, typename Durability>
+MemoryReport BasicNoteManager<Storage, Index, Durability>::memoryUsage() const {
+    MemoryReport report;
+    for (NoteNode* node = head; node != nullptr; node = node->next) {
+        report.nodes += heapBlockBytes(sizeof(NoteNode)) + vectorHeapBytes(node->data.tags);
+        report.strings += noteStringBytes(node->data);
+        report.content += stringHeapBytes(node->data.content);
+    }
+    
+    report.idIndex = hashTableBytes(idIndex);
+    report.titleIndex = stringKeyedTableBytes(titleIndex);
+    if constexpr (Index::secondary) {
+        report.titlePrefixes = titlePrefixes.memoryUsage();
+        report.titleFuzzy = titleFuzzy.memoryUsage();
+        report.categoryFuzzy = categoryFuzzy.memoryUsage();
+        report.columns = columns.memoryUsage();
+        report.tags = tagIndex.memoryUsage();
+        report.aggregates = aggregates.memoryUsage();
+        report.similar = similarNotes.memoryUsage();
+    }
+    report.bodyRefs = bodies.memoryUsage();
+    
+    // Записи корзины хранят строки так же, как узлы списка
+    report.trash = vectorHeapBytes(trash);
+    for (const TrashEntry& entry : trash) {
+        report.trash += noteStringBytes(entry.note) + vectorHeapBytes(entry.note.tags) +
+                        stringHeapBytes(entry.note.content);
+    }
+    if constexpr (Storage::persistent) {
+        report.history = history.memoryUsage();
+    }
+    return report;
+}
+
+template <typename Storage, typename Index, typename Durability>
+int BasicNoteManager<Storage, Index, Durability>::findNoteIndex(int id) const {
     // Для совместимости с тестами возвращаем индекс узла в списке
     NoteNode* current = head;
     int index = 0;
@@ -314,7 +2113,12 @@ int NoteManager::findNoteIndex(int id) const {
     return -1;
 }
 
-std::string NoteManager::generateFilePath(int id, const std::string& title) const {
+template <typename Storage, typename Index, typename Durability>
+std::string BasicNoteManager<Storage, Index, Durability>::generateFilePath(int id, const std::string& title) const {
+    if constexpr (!Storage::persistent) {
+        return std::string();
+    }
+    
     // Создаем безопасное имя файла
     std::string safeName = title;
     const std::string invalidChars = " /<>|\\:\"*?";
@@ -326,49 +2130,71 @@ std::string NoteManager::generateFilePath(int id, const std::string& title) cons
     }
     
     std::stringstream ss;
-    ss << NOTES_DIR << "/" << id << "_" << safeName << ".txt";
+    ss << notesDir << "/" << id << "_" << safeName << ".txt";
     return ss.str();
 }
 
-void NoteManager::saveNoteToFile(const Note& note) const {
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::saveNoteToFile(Note& note) const {
+    if constexpr (!Storage::persistent) {
+        return;
+    }
+    
+    // Сначала текст: файл заметки не должен ссылаться на несохраненный текст.
+    // Пустой хеш - коллизия в хранилище текстов, текст пишется в файл заметки
+    note.bodyHash = bodies.put(note.content);
+    
     std::ofstream file(note.filePath);
     if (!file.is_open()) {
         throw std::runtime_error("Невозможно создать файл заметки");
     }
     
-    file << "Название: " << note.title << std::endl;
-    file << "Тема: " << note.category << std::endl;
-    file << "Дата: " << note.creationDate << std::endl;
-    file << std::endl;
-    file << note.content;
+    // Файл собирается в памяти и записывается одной операцией
+    std::string data;
+    data.reserve(96 + note.title.size() + note.category.size() +
+                 (note.bodyHash.empty() ? note.content.size() : 0));
+    data += "Название: ";
+    data += note.title;
+    data += "\nТема: ";
+    data += note.category;
+    data += "\nДата: ";
+    data += note.creationDate;
+    if (note.bodyHash.empty()) {
+        data += "\n\n";
+        data += note.content;
+    } else {
+        data += "\nТекст: ";
+        data += note.bodyHash;
+        data += "\n";
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
     
     file.close();
+    if (!file) {
+        throw std::runtime_error("Ошибка записи файла заметки");
+    }
 }
 
-std::string NoteManager::loadNoteContent(const std::string& filePath) const {
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        return "";
-    }
-    
-    std::string content;
-    std::string line;
-    bool contentStarted = false;
-    
-    // Пропускаем заголовочные строки и пустую строку
-    for (int i = 0; i < 4; i++) {
-        std::getline(file, line);
+template <typename Storage, typename Index, typename Durability>
+void BasicNoteManager<Storage, Index, Durability>::loadNoteBody(Note& note) const {
+    // Файл читается целиком за одну операцию; текст берется по ссылке из
+    // хранилища текстов, в файлах старого формата - после заголовка
+    std::string data;
+    note.content.clear();
+    note.bodyHash.clear();
+    if (!readWholeFile(note.filePath, data)) {
+        return;
     }
-    
-    // Читаем содержимое
-    while (std::getline(file, line)) {
-        if (contentStarted) {
-            content += "\n";
-        }
-        content += line;
-        contentStarted = true;
+    if (parseNoteBodyRef(data, note.bodyHash)) {
+        bodies.read(note.bodyHash, note.content);
+    } else {
+        note.content.assign(noteBodyView(data));
     }
-    
-    file.close();
-    return content;
 }
+
+// Собранные конфигурации (note.h)
+template class BasicNoteManager<FileStorage, FullIndex, SyncDurability>;
+template class BasicNoteManager<FileStorage, FullIndex, DeferredDurability>;
+template class BasicNoteManager<FileStorage, LookupIndex, SyncDurability>;
+template class BasicNoteManager<MemoryStorage, FullIndex, SyncDurability>;
+template class BasicNoteManager<MemoryStorage, LookupIndex, SyncDurability>;
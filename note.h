@@ -1,7 +1,24 @@
 #ifndef NOTE_H
 #define NOTE_H
 
+#include "title_index.h"
+#include "fuzzy.h"
+#include "columns.h"
+#include "tags.h"
+#include "aggregate.h"
+#include "bodystore.h"
+#include "history.h"
+#include "similar.h"
+#include "watcher.h"
+#include "note_policy.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 // Структура для хранения заметки
 struct Note {
@@ -10,7 +27,10 @@ struct Note {
     std::string category;        // Тема/категория заметки
     std::string content;         // Текст заметки
     std::string creationDate;    // Дата создания в формате ГГГГ-ММ-ДД
+    int64_t createdAt = 0;       // Время создания, мкс от начала эпохи (0 - неизвестно)
     std::string filePath;        // Путь к файлу заметки
+    std::vector<std::string> tags; // Метки (нормализованные, см. tags.h)
+    std::string bodyHash;        // Хеш текста в хранилище текстов (пусто - текст в файле заметки)
 };
 
 // Узел двусвязного списка
@@ -20,51 +40,373 @@ struct NoteNode {
     NoteNode* prev;              // Указатель на предыдущий узел
     
     NoteNode(const Note& note) : data(note), next(nullptr), prev(nullptr) {}
+    NoteNode(Note&& note) : data(std::move(note)), next(nullptr), prev(nullptr) {}
 };
 
-// Класс для управления заметками
-class NoteManager {
+// Заметка в корзине (журнал корзины - trash.h)
+struct TrashEntry {
+    Note note;                  // Запись заметки (текст не хранится, он остается на диске)
+    int64_t deletedAt = 0;      // Время удаления, мкс от начала эпохи
+    uint64_t batch = 0;         // Номер операции удаления
+    uint64_t bodySize = 0;      // Размер текста (для учета ссылок в BodyStore)
+};
+
+// Режим удаления заметок
+enum class DeleteMode {
+    Immediate,  // Файл удаляется, метаданные перезаписываются сразу
+    Trash       // Заметка уходит в корзину: одна строка в журнале, отмена возможна
+};
+
+// Срок хранения заметок в корзине
+const int64_t TRASH_RETENTION_US = 7LL * 24 * 60 * 60 * 1000000;
+
+class ThreadPool;
+
+// Итог операции без вывода сообщений (этапы операций и асинхронный API)
+enum class OpStatus {
+    Ok,
+    NotFound,           // Заметки с таким ID нет
+    DuplicateTitle,     // Название занято
+    DuplicateId,        // ID занят
+    InvalidInput,       // Поле не прошло проверку (validation.h)
+    IoError             // Ошибка записи файлов
+};
+
+// Режим загрузки файла метаданных
+enum class LoadMode {
+    Strict,     // Первая поврежденная запись - исключение, хранилище не меняется
+    Recover     // Поврежденные записи пропускаются и сохраняются в <метаданные>.rejected
+};
+
+// Итог загрузки метаданных
+struct LoadReport {
+    int loaded = 0;                     // Загружено заметок
+    int skipped = 0;                    // Пропущено поврежденных записей
+    std::vector<std::string> errors;    // "строка N: причина"
+    bool fromSnapshot = false;          // Хранилище восстановлено из снимка индексов
+    int refreshed = 0;                  // Заметки, перечитанные с диска поверх снимка
+};
+
+// Итог проверки хранилища (fsck)
+struct FsckReport {
+    int records = 0;                        // Записей в файле метаданных
+    int badRecords = 0;                     // Поврежденные записи и повторы ID/названий
+    int missingFiles = 0;                   // Записи без файла заметки
+    int titleMismatches = 0;                // Название в файле не совпадает с записью
+    int missingBodies = 0;                  // Ссылки на тексты, которых нет в bodies/
+    std::vector<std::string> orphanFiles;   // Файлы заметок без записи
+    std::vector<std::string> orphanBodies;  // Тексты, на которые не ссылается ни одна заметка
+    std::vector<std::string> problems;      // Описания найденных ошибок
+    
+    bool ok() const {
+        return badRecords == 0 && missingFiles == 0 && titleMismatches == 0 && missingBodies == 0 &&
+               orphanFiles.empty() && orphanBodies.empty();
+    }
+};
+
+// Учет памяти хранилища по структурам, байты кучи (оценки - memory.h)
+struct MemoryReport {
+    size_t nodes = 0;           // Узлы списка и массивы меток
+    size_t strings = 0;         // Название, тема, дата, путь, хеш текста и метки
+    size_t content = 0;         // Тексты заметок в памяти
+    size_t idIndex = 0;         // Хеш-таблица ID
+    size_t titleIndex = 0;      // Хеш-таблица названий вместе с ключами
+    size_t titlePrefixes = 0;   // Префиксный индекс названий
+    size_t titleFuzzy = 0;      // BK-дерево названий
+    size_t categoryFuzzy = 0;   // BK-дерево тем
+    size_t columns = 0;         // Столбцы темы и даты
+    size_t tags = 0;            // Индекс меток
+    size_t aggregates = 0;      // Счетчики по темам и датам
+    size_t similar = 0;         // Подписи и LSH-индекс похожих текстов
+    size_t bodyRefs = 0;        // Счетчики ссылок на тексты
+    size_t trash = 0;           // Корзина
+    size_t history = 0;         // Сведения об истории версий
+    
+    size_t indexes() const {
+        return idIndex + titleIndex + titlePrefixes + titleFuzzy + categoryFuzzy + columns + tags + aggregates +
+               similar;
+    }
+    size_t total() const {
+        return nodes + strings + content + indexes() + bodyRefs + trash + history;
+    }
+};
+
+// Класс для управления заметками. Storage, Index и Durability - политики из
+// note_policy.h; собранные конфигурации перечислены в конце файла
+template <typename Storage = FileStorage, typename Index = FullIndex, typename Durability = SyncDurability>
+class BasicNoteManager {
 private:
     NoteNode* head;             // Голова списка
     NoteNode* tail;             // Хвост списка
     int noteCount;              // Текущее количество заметок
     int nextId;                 // Следующий доступный ID
+    std::string metadataFile;   // Путь к файлу метаданных
+    std::string notesDir;       // Директория с файлами заметок
+    std::string snapshotFile;   // Снимок индексов (рядом с файлом метаданных)
+    std::string trashFile;      // Журнал корзины (рядом с файлом метаданных)
+    mutable uint64_t generation; // Поколение файла метаданных (растет при сохранении)
+    mutable bool metadataDirty;  // Есть изменения, не записанные в метаданные (DeferredDurability)
+    
+    // Индексы для быстрого доступа к узлам списка
+    std::unordered_map<int, NoteNode*> idIndex;            // ID -> узел
+    std::unordered_map<std::string, NoteNode*> titleIndex; // Название -> узел
+    TitleIndex titlePrefixes;                              // Префиксы названий
+    BKTree titleFuzzy;                                     // Нечеткий поиск по названиям
+    BKTree categoryFuzzy;                                  // Нечеткий поиск по темам
+    NoteColumns columns;                                   // Столбцы темы и даты
+    TagIndex tagIndex;                                     // Метки -> битовые карты ID
+    NoteAggregates aggregates;                             // Число заметок по темам и датам
+    SimilarityIndex similarNotes;                          // Подписи MinHash текстов
+    BodyStore bodies;                                      // Тексты заметок по содержимому
+    RevisionHistory history;                               // Версии измененных заметок
+    bool bulkLoading;                                      // Идет массовая загрузка
+    bool bulkRemoving;                                     // Идет массовое удаление
+    std::unordered_set<int> bulkRemoved;                   // ID, еще не убранные из индексов названий и тем
+    std::unordered_set<std::string> reservedTitles;        // Названия заметок, файлы которых еще пишутся
+    std::unordered_set<int> reservedIds;                   // ID таких заметок
+    double nearDuplicateThreshold;                         // Порог предупреждения о почти дубликате (0 - нет)
+    
+    // Корзина
+    DeleteMode deleteMode;                                 // Режим удаления
+    std::vector<TrashEntry> trash;                         // Заметки в корзине в порядке удаления
+    uint64_t lastBatch;                                    // Номер последней операции удаления
+    mutable bool metadataHasTrash;                         // В файле метаданных остались записи из корзины
+    
+    // Фоновая очистка корзины: запись метаданных из фонового потока и из
+    // основного упорядочивается по поколению
+    mutable std::mutex metadataMutex;                      // Запись файла метаданных
+    std::mutex journalMutex;                               // Запись журнала корзины
+    mutable uint64_t writtenGeneration;                    // Поколение последней записанной версии
+    std::unique_ptr<ThreadPool> purgePool;                 // Поток удаления файлов и записи метаданных
+    
+    // Пул параллельных просмотров (поиск по тексту, подсчет с условием, проверка
+    // хранилища): создается при первом просмотре и заново при другом числе
+    // потоков. Просмотры одного менеджера выполняются по очереди
+    mutable std::mutex scanMutex;
+    mutable std::unique_ptr<ThreadPool> scanPool;
 
 public:
-    NoteManager();
-    ~NoteManager();
+    BasicNoteManager();
+    // Хранилище в указанной директории (storeRoot/notes_metadata.dat и storeRoot/notes/)
+    explicit BasicNoteManager(const std::string& storeRoot);
+    // С DeferredDurability записывает несохраненные изменения
+    ~BasicNoteManager();
+    
+    BasicNoteManager(const BasicNoteManager&) = delete;
+    BasicNoteManager& operator=(const BasicNoteManager&) = delete;
     
     // Основные операции
-    bool addNote(const std::string& title, const std::string& category, const std::string& content);
+    bool addNote(const std::string& title, const std::string& category, const std::string& content,
+                 const std::vector<std::string>& tags = {});
+    // Добавление с заданным ID (для распределенного хранилища с общим пространством ID)
+    bool insertNote(int id, const std::string& title, const std::string& category, const std::string& content,
+                    const std::vector<std::string>& tags = {});
     bool deleteNote(int id);
+    // Удаление всех заметок темы одной операцией (одна запись метаданных или
+    // одна запись в журнал корзины); возвращает число удаленных заметок
+    int deleteByCategory(const std::string& category);
+    bool updateNote(int id, const std::string& title, const std::string& category, const std::string& content);
+    // Замена меток заметки (метки хранятся только в метаданных, файл не меняется)
+    bool setNoteTags(int id, const std::vector<std::string>& tags);
     void displayAllNotes() const;
     void displayNote(int id) const;
     
+    // Корзина. В режиме DeleteMode::Trash удаление переносит заметку в корзину:
+    // файл остается на месте, метаданные не перезаписываются, в журнал
+    // дописывается одна строка. Заметки из корзины не видны в поиске и индексах.
+    void setDeleteMode(DeleteMode mode) { deleteMode = mode; }
+    DeleteMode getDeleteMode() const { return deleteMode; }
+    bool restoreNote(int id);
+    // Восстановление всех заметок последней операции удаления; возвращает их число
+    int undoDelete();
+    const std::vector<TrashEntry>& getTrash() const { return trash; }
+    // Окончательное удаление заметок, попавших в корзину не позже deletedBefore
+    // (мкс от начала эпохи). Файлы заметок удаляются, а метаданные сжимаются
+    // одним пакетом в фоновом потоке; возвращает число удаленных заметок
+    int purgeTrash(int64_t deletedBefore);
+    // Ожидание завершения фоновой очистки
+    void waitForPurge() const;
+    
+    // История версий: каждое изменение названия, темы или текста (в программе
+    // или в файле заметки) записывается новой версией, см. history.h
+    std::vector<RevisionInfo> listRevisions(int id) const { return history.list(id); }
+    bool getRevision(int id, uint32_t number, NoteVersion& out) const { return history.get(id, number, out); }
+    bool diffRevisions(int id, uint32_t from, uint32_t to, std::vector<DiffLine>& out) const {
+        return history.diff(id, from, to, out);
+    }
+    // Возврат заметки к версии (записывается как новая версия)
+    bool restoreRevision(int id, uint32_t number);
+    RevisionHistory& getHistory() { return history; }
+    
     // Поиск и фильтрация
     void searchByCategory(const std::string& category) const;
+    void searchByContent(const std::string& text) const;
+    std::vector<int> findByContent(const std::string& text) const;
+    size_t parallelSearchContent(const std::string& text,
+                                 const std::function<void(const Note&)>& onMatch,
+                                 size_t threads = 0) const;
+    std::vector<int> findByCategory(const std::string& category) const;
+    std::vector<int> findByDateRange(const std::string& from, const std::string& to) const;
+    // Поиск по меткам: ID по возрастанию и число заметок по меткам (фасеты)
+    void searchByTags(const std::string& queryText) const;
+    std::vector<int> findByTags(const TagQuery& query) const;
+    std::vector<TagCount> tagCounts() const;
+    std::vector<TagCount> tagCounts(const TagQuery& query) const;
+    
+    // Число заметок по темам или интервалам дат: счетчики обновляются при каждом
+    // изменении, чтение - O(число групп)
+    std::vector<GroupCount> countBy(GroupBy by) const;
+    // То же только для заметок, подходящих под условие: параллельный полный просмотр
+    // (threads = 0 - по числу аппаратных потоков)
+    std::vector<GroupCount> countBy(GroupBy by, const std::function<bool(const Note&)>& filter,
+                                    size_t threads = 0) const;
+    std::vector<std::string> suggestTitles(const std::string& prefix, size_t limit = 10) const;
+    std::vector<FuzzyMatch> fuzzySearchTitles(const std::string& query, int maxDistance = 2) const;
+    std::vector<FuzzyMatch> fuzzySearchCategories(const std::string& query, int maxDistance = 2) const;
+    
+    // Похожие заметки: сходство текстов по Жаккару (similar.h) не ниже
+    // minSimilarity, по убыванию сходства. С FullIndex кандидаты берутся из
+    // LSH-индекса за время, не зависящее от числа заметок; пара со сходством
+    // около 0,5 находится с вероятностью около 2/3, от 0,7 - почти всегда.
+    // С LookupIndex сравниваются все заметки.
+    std::vector<SimilarNote> findSimilar(int id, double minSimilarity = SIMILAR_NOTES_THRESHOLD,
+                                         size_t limit = 10) const;
+    std::vector<SimilarNote> findSimilarText(const std::string& content, double minSimilarity = SIMILAR_NOTES_THRESHOLD,
+                                             size_t limit = 10) const;
+    // Предупреждение при добавлении заметки, текст которой похож на текст
+    // другой заметки не меньше чем на threshold (0 - без предупреждения)
+    void setNearDuplicateWarning(double threshold) { nearDuplicateThreshold = threshold; }
     
     // Работа с данными
-    void loadFromFile();
+    // Загрузка использует снимок индексов, если он есть: при том же поколении
+    // метаданных заметки и индексы берутся из снимка целиком, иначе к снимку
+    // применяется разница с файлом метаданных
+    LoadReport loadFromFile(LoadMode mode = LoadMode::Recover);
     void saveToFile() const;
+    // Запись метаданных, если есть несохраненные изменения (DeferredDurability)
+    void flush() const;
+    
+    // Сохранение снимка заметок и индексов (при штатном завершении)
+    bool saveSnapshot() const;
+    
+    // Применение изменений файлов, сделанных вне программы (пакет от NoteWatcher):
+    // правка заголовка или текста обновляет заметку и индексы, удаление файла -
+    // удаляет заметку. Повторное применение не меняет хранилище.
+    // Возвращает число измененных заметок.
+    int reconcile(const WatchBatch& batch);
+    
+    // Проверка хранилища на диске: записи метаданных, файлы заметок и лишние файлы.
+    // Файлы проверяются параллельно (threads = 0 - по числу аппаратных потоков)
+    FsckReport verifyStore(size_t threads = 0) const;
+    
+    // Снимок и архив хранилища
+    std::vector<Note> snapshot() const;
+    bool exportArchive(const std::string& path, bool compress = false) const;
+    bool importArchive(const std::string& path);
     
     // Вспомогательные функции
     int getNoteCount() const { return noteCount; }
     bool noteExists(int id) const;
+    bool titleExists(const std::string& title) const;
+    int getNextId() const { return nextId; }
+    const std::string& getNotesDir() const { return notesDir; }
+    // Учет текстов: сколько места экономит хранение одинаковых текстов один раз
+    BodyStats bodyStats() const { return bodies.stats(); }
+    const BodyStore& getBodyStore() const { return bodies; }
+    // Память, занятая заметками и индексами (без объекта менеджера)
+    MemoryReport memoryUsage() const;
+    const Note* getNote(int id) const;
     int findNoteIndex(int id) const;
     
 private:
     // Генерация пути к файлу заметки
     std::string generateFilePath(int id, const std::string& title) const;
     
-    // Сохранение/загрузка отдельной заметки
-    void saveNoteToFile(const Note& note) const;
-    std::string loadNoteContent(const std::string& filePath) const;
+    // Сохранение/загрузка отдельной заметки: текст сохраняется в хранилище
+    // текстов, note.bodyHash получает его хеш
+    void saveNoteToFile(Note& note) const;
+    void loadNoteBody(Note& note) const;
     
     // Поиск узла по ID
     NoteNode* findNode(int id) const;
     
+    // Операции над списком и индексами
+    void linkNode(NoteNode* node);
+    void appendNode(NoteNode* node);
+    void unlinkNode(NoteNode* node);
+    void indexNode(NoteNode* node);
+    void unindexNode(NoteNode* node);
+    // Замена данных узла с обновлением только затронутых ключей индексов
+    void replaceNodeData(NoteNode* node, Note updated);
+    // Похожие тексты без заметки excludeId
+    std::vector<SimilarNote> similarTo(const std::string& content, int excludeId, double minSimilarity,
+                                       size_t limit) const;
+    // Запись изменения заметки в историю версий
+    void recordRevision(const Note& before, const Note& after);
+    // Сверка заметки с ее файлом; metadataChanged - изменились поля метаданных
+    bool reconcileNode(NoteNode* node, bool& metadataChanged);
+    
+    // Пул просмотров на threads потоков (вызывается под scanMutex)
+    ThreadPool& scanPoolFor(size_t threads) const;
+    
+    // Восстановление из снимка и применение разницы с метаданными
+    struct SnapshotState;
+    bool loadSnapshot(SnapshotState& state);
+    int applyMetadataDelta(std::vector<Note>& records, SnapshotState& state);
+    int refreshChangedFiles(const SnapshotState& state);
+    
+    // Добавление по этапам: резервирование ID и названия, запись файлов
+    // (saveNoteToFile - можно вне потока владельца), включение в список или
+    // отмена. Резерв держит ссылку на текст, чтобы параллельное удаление
+    // заметки с тем же текстом не удалило его файл. insertNote выполняет
+    // этапы подряд, AsyncNoteManager пишет файлы в пуле ввода-вывода.
+    OpStatus reserveNote(int id, const std::string& title, const std::string& category, const std::string& content,
+                         const std::vector<std::string>& tags, Note& note);
+    void commitNote(Note note);
+    void cancelNote(const Note& note);
+    // Исключение заметки из списка и индексов перед удалением ее файла
+    Note detachNote(NoteNode* node);
+    
+    // Удаление узлов одной операцией (в корзину или сразу, по режиму)
+    int deleteNodes(const std::vector<NoteNode*>& nodes);
+    // Перенос узлов в корзину без вывода; false - журнал корзины не записан
+    // (заметки в корзине до перезапуска, после него вернутся в список)
+    bool trashNodes(const std::vector<NoteNode*>& nodes);
+    void finishBulkRemove();
+    bool restoreEntry(const TrashEntry& entry);
+    // Применение журнала корзины после загрузки
+    void loadTrash();
+    
+    // Сборка файла метаданных (в основном потоке) и его запись
+    std::string formatMetadata() const;
+    void writeMetadata(const std::string& data, uint64_t fileGeneration) const;
+    
+    // Сохранение после изменения: сразу или при flush(), по политике записи
+    void persistChange();
+    // Конец массовой загрузки: одна сортировка префиксного индекса
+    void finishBulkLoad();
+    
     // Очистка списка
     void clearList();
+    
+    friend class AsyncNoteManager;
 };
 
+// Хранилище в файлах со всеми индексами, метаданные пишутся после каждого изменения
+using NoteManager = BasicNoteManager<FileStorage, FullIndex, SyncDurability>;
+// То же с записью метаданных в flush()
+using BufferedNoteManager = BasicNoteManager<FileStorage, FullIndex, DeferredDurability>;
+// Хранилище в файлах без вторичных индексов
+using LookupNoteManager = BasicNoteManager<FileStorage, LookupIndex, SyncDurability>;
+// Только память, со всеми индексами и без них
+using MemoryNoteManager = BasicNoteManager<MemoryStorage, FullIndex, SyncDurability>;
+using MemoryLookupNoteManager = BasicNoteManager<MemoryStorage, LookupIndex, SyncDurability>;
+
+// Определения функций - в note.cpp, там же собираются эти конфигурации
+extern template class BasicNoteManager<FileStorage, FullIndex, SyncDurability>;
+extern template class BasicNoteManager<FileStorage, FullIndex, DeferredDurability>;
+extern template class BasicNoteManager<FileStorage, LookupIndex, SyncDurability>;
+extern template class BasicNoteManager<MemoryStorage, FullIndex, SyncDurability>;
+extern template class BasicNoteManager<MemoryStorage, LookupIndex, SyncDurability>;
+
 #endif // NOTE_H
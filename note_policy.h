@@ -0,0 +1,55 @@
+#ifndef NOTE_POLICY_H
+#define NOTE_POLICY_H
+
+// Политики менеджера заметок (BasicNoteManager в note.h): хранение, индексы
+// и запись метаданных. Политика выбирается при компиляции, код отключенной
+// возможности отбрасывается через if constexpr, поэтому неиспользуемые
+// индексы и запись на диск не стоят ничего во время работы.
+
+// ===== ХРАНЕНИЕ =====
+
+// Файлы на диске: метаданные, файлы заметок, тексты по хешу содержимого и
+// история версий. Имена - относительно корня хранилища
+struct FileStorage {
+    static constexpr bool persistent = true;
+    static constexpr const char* metadataFile = "notes_metadata.dat";
+    static constexpr const char* notesDir = "notes";
+    static constexpr const char* bodiesDir = "bodies";
+    static constexpr const char* historyDir = "history";
+};
+
+// Только память (тесты, кэши): на диск ничего не пишется и не читается,
+// истории версий нет, корзина хранит тексты удаленных заметок в памяти
+struct MemoryStorage {
+    static constexpr bool persistent = false;
+};
+
+// ===== ИНДЕКСЫ =====
+
+// Все индексы: префиксы и опечатки в названиях, столбцы темы и даты, метки,
+// счетчики по темам и датам, снимок индексов для быстрого запуска
+struct FullIndex {
+    static constexpr bool secondary = true;
+};
+
+// Только хеш-таблицы ID и названий: остальные запросы выполняются просмотром
+// списка (с тем же результатом), добавление и удаление дешевле
+struct LookupIndex {
+    static constexpr bool secondary = false;
+};
+
+// ===== ЗАПИСЬ МЕТАДАННЫХ =====
+
+// Файл метаданных перезаписывается после каждого изменения
+struct SyncDurability {
+    static constexpr bool deferred = false;
+};
+
+// Файл метаданных записывается в flush(), saveToFile() и деструкторе. Файлы
+// заметок и текстов пишутся сразу, поэтому при сбое теряются только записи
+// метаданных после последнего flush() (verifyStore покажет их файлы как лишние)
+struct DeferredDurability {
+    static constexpr bool deferred = true;
+};
+
+#endif // NOTE_POLICY_H
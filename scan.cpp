@@ -0,0 +1,265 @@
+#include "scan.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define SCAN_X86 1
+    #include <immintrin.h>
+#endif
+
+// ===== СКАЛЯРНЫЕ РЕАЛИЗАЦИИ =====
+
+static size_t findSubstringScalar(std::string_view haystack, std::string_view needle) {
+    return haystack.find(needle);
+}
+
+static void filterEqualScalar(const uint32_t* column, size_t count, uint32_t value, std::vector<uint32_t>& rows) {
+    for (size_t i = 0; i < count; i++) {
+        if (column[i] == value) {
+            rows.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+static void filterRangeScalar(const uint32_t* column, size_t count, uint32_t low, uint32_t high, std::vector<uint32_t>& rows) {
+    // Одно беззнаковое сравнение вместо двух: x - low <= high - low
+    uint32_t span = high - low;
+    for (size_t i = 0; i < count; i++) {
+        if (column[i] - low <= span) {
+            rows.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+// Добавление номеров строк по битовой маске совпадений
+static inline void appendMatches(unsigned mask, size_t base, std::vector<uint32_t>& rows) {
+    while (mask != 0) {
+        rows.push_back(static_cast<uint32_t>(base + __builtin_ctz(mask)));
+        mask &= mask - 1;
+    }
+}
+
+#ifdef SCAN_X86
+
+// ===== SSE4.2 =====
+
+// Поиск подстроки: сравниваются сразу 16 позиций по первому и последнему
+// символу образца, полное сравнение выполняется только для кандидатов
+__attribute__((target("sse4.2")))
+static size_t findSubstringSSE42(std::string_view haystack, std::string_view needle) {
+    size_t n = haystack.size();
+    size_t k = needle.size();
+    if (k < 2 || n < k + 16) {
+        return haystack.find(needle);
+    }
+    
+    const char* h = haystack.data();
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[k - 1]);
+    
+    size_t i = 0;
+    for (; i + k - 1 + 16 <= n; i += 16) {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(h + i + k - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast))));
+        while (mask != 0) {
+            size_t pos = i + __builtin_ctz(mask);
+            if (std::memcmp(h + pos + 1, needle.data() + 1, k - 2) == 0) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    
+    size_t tail = haystack.substr(i).find(needle);
+    return tail == std::string_view::npos ? tail : i + tail;
+}
+
+__attribute__((target("sse4.2")))
+static void filterEqualSSE42(const uint32_t* column, size_t count, uint32_t value, std::vector<uint32_t>& rows) {
+    const __m128i target = _mm_set1_epi32(static_cast<int>(value));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(values, target))));
+        appendMatches(mask, i, rows);
+    }
+    size_t tailStart = rows.size();
+    filterEqualScalar(column + i, count - i, value, rows);
+    for (size_t j = tailStart; j < rows.size(); j++) {
+        rows[j] += static_cast<uint32_t>(i);
+    }
+}
+
+__attribute__((target("sse4.2")))
+static void filterRangeSSE42(const uint32_t* column, size_t count, uint32_t low, uint32_t high, std::vector<uint32_t>& rows) {
+    const __m128i lowVec = _mm_set1_epi32(static_cast<int>(low));
+    const __m128i spanVec = _mm_set1_epi32(static_cast<int>(high - low));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i shifted = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i)), lowVec);
+        // shifted <= span (беззнаково) <=> min(shifted, span) == shifted
+        __m128i inRange = _mm_cmpeq_epi32(_mm_min_epu32(shifted, spanVec), shifted);
+        appendMatches(static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(inRange))), i, rows);
+    }
+    size_t tailStart = rows.size();
+    filterRangeScalar(column + i, count - i, low, high, rows);
+    for (size_t j = tailStart; j < rows.size(); j++) {
+        rows[j] += static_cast<uint32_t>(i);
+    }
+}
+
+// ===== AVX2 =====
+
+__attribute__((target("avx2")))
+static size_t findSubstringAVX2(std::string_view haystack, std::string_view needle) {
+    size_t n = haystack.size();
+    size_t k = needle.size();
+    if (k < 2 || n < k + 32) {
+        return findSubstringSSE42(haystack, needle);
+    }
+    
+    const char* h = haystack.data();
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[k - 1]);
+    
+    size_t i = 0;
+    for (; i + k - 1 + 32 <= n; i += 32) {
+        __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + i));
+        __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + i + k - 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast))));
+        while (mask != 0) {
+            size_t pos = i + __builtin_ctz(mask);
+            if (std::memcmp(h + pos + 1, needle.data() + 1, k - 2) == 0) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    
+    size_t tail = haystack.substr(i).find(needle);
+    return tail == std::string_view::npos ? tail : i + tail;
+}
+
+__attribute__((target("avx2")))
+static void filterEqualAVX2(const uint32_t* column, size_t count, uint32_t value, std::vector<uint32_t>& rows) {
+    const __m256i target = _mm256_set1_epi32(static_cast<int>(value));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(values, target))));
+        appendMatches(mask, i, rows);
+    }
+    size_t tailStart = rows.size();
+    filterEqualScalar(column + i, count - i, value, rows);
+    for (size_t j = tailStart; j < rows.size(); j++) {
+        rows[j] += static_cast<uint32_t>(i);
+    }
+}
+
+__attribute__((target("avx2")))
+static void filterRangeAVX2(const uint32_t* column, size_t count, uint32_t low, uint32_t high, std::vector<uint32_t>& rows) {
+    const __m256i lowVec = _mm256_set1_epi32(static_cast<int>(low));
+    const __m256i spanVec = _mm256_set1_epi32(static_cast<int>(high - low));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i shifted = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i)), lowVec);
+        __m256i inRange = _mm256_cmpeq_epi32(_mm256_min_epu32(shifted, spanVec), shifted);
+        appendMatches(static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(inRange))), i, rows);
+    }
+    size_t tailStart = rows.size();
+    filterRangeScalar(column + i, count - i, low, high, rows);
+    for (size_t j = tailStart; j < rows.size(); j++) {
+        rows[j] += static_cast<uint32_t>(i);
+    }
+}
+
+#endif // SCAN_X86
+
+// ===== ВЫБОР РЕАЛИЗАЦИИ =====
+
+ScanLevel detectScanLevel() {
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return ScanLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return ScanLevel::SSE42;
+    }
+#endif
+    return ScanLevel::Scalar;
+}
+
+// Текущий уровень; определяется при первом обращении
+static ScanLevel& activeLevel() {
+    static ScanLevel level = detectScanLevel();
+    return level;
+}
+
+ScanLevel getScanLevel() {
+    return activeLevel();
+}
+
+void setScanLevel(ScanLevel level) {
+    // Нельзя выбрать инструкции, которых нет у процессора
+    if (static_cast<int>(level) > static_cast<int>(detectScanLevel())) {
+        level = detectScanLevel();
+    }
+    activeLevel() = level;
+}
+
+const char* scanLevelName(ScanLevel level) {
+    switch (level) {
+        case ScanLevel::AVX2:
+            return "AVX2";
+        case ScanLevel::SSE42:
+            return "SSE4.2";
+        default:
+            return "scalar";
+    }
+}
+
+size_t findSubstring(std::string_view haystack, std::string_view needle) {
+    switch (activeLevel()) {
+#ifdef SCAN_X86
+        case ScanLevel::AVX2:
+            return findSubstringAVX2(haystack, needle);
+        case ScanLevel::SSE42:
+            return findSubstringSSE42(haystack, needle);
+#endif
+        default:
+            return findSubstringScalar(haystack, needle);
+    }
+}
+
+void filterEqual(const uint32_t* column, size_t count, uint32_t value, std::vector<uint32_t>& rows) {
+    switch (activeLevel()) {
+#ifdef SCAN_X86
+        case ScanLevel::AVX2:
+            filterEqualAVX2(column, count, value, rows);
+            return;
+        case ScanLevel::SSE42:
+            filterEqualSSE42(column, count, value, rows);
+            return;
+#endif
+        default:
+            filterEqualScalar(column, count, value, rows);
+    }
+}
+
+void filterRange(const uint32_t* column, size_t count, uint32_t low, uint32_t high, std::vector<uint32_t>& rows) {
+    switch (activeLevel()) {
+#ifdef SCAN_X86
+        case ScanLevel::AVX2:
+            filterRangeAVX2(column, count, low, high, rows);
+            return;
+        case ScanLevel::SSE42:
+            filterRangeSSE42(column, count, low, high, rows);
+            return;
+#endif
+        default:
+            filterRangeScalar(column, count, low, high, rows);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Векторные ядра полного просмотра для запросов без индекса.
+// Реализация (AVX2, SSE4.2 или скалярная) выбирается при первом вызове
+// по возможностям процессора и может быть переопределена setScanLevel().
+
+enum class ScanLevel {
+    Scalar,
+    SSE42,
+    AVX2
+};
+
+// Лучший уровень, поддерживаемый процессором
+ScanLevel detectScanLevel();
+
+// Текущий и принудительно заданный уровень (не выше поддерживаемого)
+ScanLevel getScanLevel();
+void setScanLevel(ScanLevel level);
+const char* scanLevelName(ScanLevel level);
+
+// Позиция первого вхождения needle в haystack или std::string_view::npos
+size_t findSubstring(std::string_view haystack, std::string_view needle);
+
+// Номера строк столбца, равных value, добавляются в rows
+void filterEqual(const uint32_t* column, size_t count, uint32_t value, std::vector<uint32_t>& rows);
+
+// Номера строк столбца со значениями в диапазоне [low, high] добавляются в rows
+void filterRange(const uint32_t* column, size_t count, uint32_t low, uint32_t high, std::vector<uint32_t>& rows);
+
+#endif // SCAN_H
@@ -0,0 +1,217 @@
+#include "sharded.h"
+#include "fileio.h"
+#include "utf8.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+// Отметка шарда в его корне: "TMSHARD01 <номер> <число шардов>"
+static const char SHARD_MARKER_FILE[] = "/shard.dat";
+static const char SHARD_MARKER_MAGIC[] = "TMSHARD01";
+
+// Номер и число шардов из отметки; false - отметки нет
+static bool readShardMarker(const std::string& root, size_t& index, size_t& count) {
+    std::string data;
+    if (!readWholeFile(root + SHARD_MARKER_FILE, data)) {
+        return false;
+    }
+    std::istringstream in(data);
+    std::string magic;
+    if (!(in >> magic >> index >> count) || magic != SHARD_MARKER_MAGIC) {
+        throw std::runtime_error("Поврежденная отметка шарда: " + root + SHARD_MARKER_FILE);
+    }
+    return true;
+}
+
+ShardedNoteManager::ShardedNoteManager(const std::vector<std::string>& storeRoots)
+    : nextId(1), pool(storeRoots.empty() ? 1 : storeRoots.size()) {
+    if (storeRoots.empty()) {
+        throw std::invalid_argument("Не задано ни одной директории хранилища");
+    }
+    
+    // Сначала проверяются все отметки и только потом открываются хранилища,
+    // чтобы чужой шард не загружался и в его корне ничего не создавалось.
+    // Недостающие отметки (новое хранилище или созданное до их появления)
+    // дописываются после открытия
+    std::vector<size_t> unmarked;
+    for (size_t i = 0; i < storeRoots.size(); i++) {
+        size_t index = 0;
+        size_t count = 0;
+        if (!readShardMarker(storeRoots[i], index, count)) {
+            unmarked.push_back(i);
+        } else if (index != i || count != storeRoots.size()) {
+            throw std::runtime_error("Директория " + storeRoots[i] + " - шард " + std::to_string(index + 1) +
+                                     " из " + std::to_string(count) + ", а открывается как шард " +
+                                     std::to_string(i + 1) + " из " + std::to_string(storeRoots.size()));
+        }
+    }
+    for (const std::string& root : storeRoots) {
+        shards.push_back(std::make_unique<NoteManager>(root));
+    }
+    for (size_t i : unmarked) {
+        std::ofstream file(storeRoots[i] + SHARD_MARKER_FILE);
+        file << SHARD_MARKER_MAGIC << ' ' << i << ' ' << storeRoots.size() << '\n';
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Не удалось записать отметку шарда в " + storeRoots[i]);
+        }
+    }
+}
+
+size_t ShardedNoteManager::shardOf(int id) const {
+    // Перемешивание битов, чтобы соседние ID расходились по шардам равномерно
+    uint64_t x = static_cast<uint64_t>(static_cast<uint32_t>(id));
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x % shards.size());
+}
+
+template <typename Result, typename Query>
+std::vector<Result> ShardedNoteManager::fanOut(Query query) const {
+    std::vector<std::vector<Result>> partial(shards.size());
+    for (size_t i = 0; i < shards.size(); i++) {
+        pool.submit([this, &partial, &query, i]() {
+            partial[i] = query(*shards[i]);
+        });
+    }
+    pool.wait();
+    
+    std::vector<Result> merged;
+    for (std::vector<Result>& part : partial) {
+        merged.insert(merged.end(), part.begin(), part.end());
+    }
+    return merged;
+}
+
+bool ShardedNoteManager::titleExists(const std::string& title) const {
+    for (const auto& shard : shards) {
+        if (shard->titleExists(title)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ShardedNoteManager::addNote(const std::string& title, const std::string& category, const std::string& content) {
+    if (titleExists(title)) {
+        std::cout << "Ошибка: заметка с таким названием уже существует" << std::endl;
+        return false;
+    }
+    
+    int id = nextId++;
+    return shards[shardOf(id)]->insertNote(id, title, category, content);
+}
+
+bool ShardedNoteManager::deleteNote(int id) {
+    return shards[shardOf(id)]->deleteNote(id);
+}
+
+bool ShardedNoteManager::updateNote(int id, const std::string& title, const std::string& category, const std::string& content) {
+    NoteManager& owner = *shards[shardOf(id)];
+    const Note* note = owner.getNote(id);
+    if (note != nullptr && note->title != title && titleExists(title)) {
+        std::cout << "Ошибка: заметка с таким названием уже существует" << std::endl;
+        return false;
+    }
+    return owner.updateNote(id, title, category, content);
+}
+
+const Note* ShardedNoteManager::getNote(int id) const {
+    return shards[shardOf(id)]->getNote(id);
+}
+
+bool ShardedNoteManager::noteExists(int id) const {
+    return shards[shardOf(id)]->noteExists(id);
+}
+
+std::vector<int> ShardedNoteManager::findByCategory(const std::string& category) const {
+    std::vector<int> ids = fanOut<int>([&category](const NoteManager& shard) {
+        return shard.findByCategory(category);
+    });
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+std::vector<int> ShardedNoteManager::findByContent(const std::string& text) const {
+    std::vector<int> ids = fanOut<int>([&text](const NoteManager& shard) {
+        return shard.findByContent(text);
+    });
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+std::vector<int> ShardedNoteManager::findByTags(const TagQuery& query) const {
+    std::vector<int> ids = fanOut<int>([&query](const NoteManager& shard) {
+        return shard.findByTags(query);
+    });
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+std::vector<GroupCount> ShardedNoteManager::countBy(GroupBy by) const {
+    std::vector<GroupCount> partial = fanOut<GroupCount>([by](const NoteManager& shard) {
+        return shard.countBy(by);
+    });
+    
+    // Одна группа может встречаться в нескольких шардах
+    std::unordered_map<std::string, uint64_t> total;
+    for (const GroupCount& group : partial) {
+        total[group.key] += group.count;
+    }
+    std::vector<GroupCount> groups;
+    groups.reserve(total.size());
+    for (const auto& entry : total) {
+        groups.push_back({entry.first, entry.second});
+    }
+    sortGroups(groups, by);
+    return groups;
+}
+
+std::vector<FuzzyMatch> ShardedNoteManager::fuzzySearchTitles(const std::string& query, int maxDistance) const {
+    std::vector<FuzzyMatch> matches = fanOut<FuzzyMatch>([&query, maxDistance](const NoteManager& shard) {
+        return shard.fuzzySearchTitles(query, maxDistance);
+    });
+    std::sort(matches.begin(), matches.end(), [](const FuzzyMatch& a, const FuzzyMatch& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+    });
+    return matches;
+}
+
+std::vector<std::string> ShardedNoteManager::suggestTitles(const std::string& prefix, size_t limit) const {
+    // Каждый шард отдает свои первые limit подсказок, из объединения берем первые limit
+    std::vector<std::string> titles = fanOut<std::string>([&prefix, limit](const NoteManager& shard) {
+        return shard.suggestTitles(prefix, limit);
+    });
+    std::sort(titles.begin(), titles.end(), [](const std::string& a, const std::string& b) {
+        return foldCaseUtf8(a) < foldCaseUtf8(b);
+    });
+    if (titles.size() > limit) {
+        titles.resize(limit);
+    }
+    return titles;
+}
+
+void ShardedNoteManager::loadFromFile() {
+    for (size_t i = 0; i < shards.size(); i++) {
+        pool.submit([this, i]() { shards[i]->loadFromFile(); });
+    }
+    pool.wait();
+    
+    nextId = 1;
+    for (const auto& shard : shards) {
+        nextId = std::max(nextId, shard->getNextId());
+    }
+}
+
+int ShardedNoteManager::getNoteCount() const {
+    int count = 0;
+    for (const auto& shard : shards) {
+        count += shard->getNoteCount();
+    }
+    return count;
+}
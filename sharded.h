@@ -0,0 +1,59 @@
+#ifndef SHARDED_H
+#define SHARDED_H
+
+#include "note.h"
+#include "thread_pool.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Хранилище, распределенное по нескольким директориям (например, на разных дисках).
+// Заметка попадает в шард по хешу ID; ID выдаются из общего пространства,
+// названия уникальны во всем хранилище. Запросы выполняются во всех шардах
+// параллельно, результаты объединяются в порядке ID; исключение из запроса
+// к шарду перебрасывается вызывающему.
+//
+// Шард заметки зависит от числа шардов, поэтому в корне каждого шарда лежит
+// отметка shard.dat с его номером и числом шардов. Открытие с другим числом
+// или порядком директорий отклоняется: ID ушли бы не в свой шард.
+class ShardedNoteManager {
+public:
+    // std::runtime_error - директории записаны другим набором шардов
+    explicit ShardedNoteManager(const std::vector<std::string>& storeRoots);
+    
+    // Основные операции
+    bool addNote(const std::string& title, const std::string& category, const std::string& content);
+    bool deleteNote(int id);
+    bool updateNote(int id, const std::string& title, const std::string& category, const std::string& content);
+    const Note* getNote(int id) const;
+    bool noteExists(int id) const;
+    
+    // Поиск по всем шардам
+    std::vector<int> findByCategory(const std::string& category) const;
+    std::vector<int> findByContent(const std::string& text) const;
+    std::vector<int> findByTags(const TagQuery& query) const;
+    std::vector<GroupCount> countBy(GroupBy by) const;
+    std::vector<FuzzyMatch> fuzzySearchTitles(const std::string& query, int maxDistance = 2) const;
+    std::vector<std::string> suggestTitles(const std::string& prefix, size_t limit = 10) const;
+    
+    // Параллельная загрузка всех шардов
+    void loadFromFile();
+    
+    int getNoteCount() const;
+    size_t shardCount() const { return shards.size(); }
+    size_t shardOf(int id) const;
+    const NoteManager& shard(size_t index) const { return *shards[index]; }
+    
+private:
+    std::vector<std::unique_ptr<NoteManager>> shards;
+    int nextId;                         // Следующий ID в общем пространстве
+    mutable ThreadPool pool;            // Потоки для параллельных запросов
+    
+    bool titleExists(const std::string& title) const;
+    
+    // Выполнение запроса во всех шардах параллельно
+    template <typename Result, typename Query>
+    std::vector<Result> fanOut(Query query) const;
+};
+
+#endif // SHARDED_H
@@ -0,0 +1,411 @@
+#include "similar.h"
+#include "snapshot.h"
+#include "utf8.h"
+#include "memory.h"
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+
+// Строка не задана (конец списка корзины)
+static const uint32_t NO_ROW = std::numeric_limits<uint32_t>::max();
+
+// Начальный размер таблицы корзин полосы
+static const size_t INITIAL_SLOTS = 16;
+
+// Перемешивание битов (финализатор splitmix64)
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Коэффициенты хеш-функций MinHash: h_i(x) = a_i * x + b_i (a_i нечетные),
+// старшие биты результата
+struct MinHashFunctions {
+    uint64_t a[MINHASH_SIZE];
+    uint64_t b[MINHASH_SIZE];
+
+    MinHashFunctions() {
+        uint64_t state = 0x5EED5EED5EED5EEDULL;
+        for (size_t i = 0; i < MINHASH_SIZE; i++) {
+            state += 0x9E3779B97F4A7C15ULL;
+            a[i] = mix64(state) | 1;
+            state += 0x9E3779B97F4A7C15ULL;
+            b[i] = mix64(state);
+        }
+    }
+};
+
+static const MinHashFunctions& minHashFunctions() {
+    static const MinHashFunctions functions;
+    return functions;
+}
+
+// Буква или цифра: ASCII - по std::isalnum, остальное - кроме знаков
+// Latin-1 (U+0080-U+00BF) и общей пунктуации (U+2000-U+206F)
+static bool isWordChar(char32_t cp) {
+    if (cp < 0x80) {
+        return std::isalnum(static_cast<unsigned char>(cp)) != 0;
+    }
+    if (cp <= 0xBF || (cp >= 0x2000 && cp <= 0x206F)) {
+        return false;
+    }
+    return cp != UTF8_REPLACEMENT;
+}
+
+std::vector<uint64_t> textShingles(std::string_view text) {
+    std::u32string normalized;
+    normalized.reserve(text.size());
+    size_t pos = 0;
+    while (pos < text.size()) {
+        char32_t cp = decodeUtf8Char(text, pos);
+        if (isWordChar(cp)) {
+            normalized.push_back(foldCase(cp));
+        } else if (!normalized.empty() && normalized.back() != U' ') {
+            normalized.push_back(U' ');
+        }
+    }
+    if (!normalized.empty() && normalized.back() == U' ') {
+        normalized.pop_back();
+    }
+
+    std::vector<uint64_t> shingles;
+    if (normalized.empty()) {
+        return shingles;
+    }
+    // Текст короче шингла - один шингл из всего текста
+    size_t length = std::min(SHINGLE_LENGTH, normalized.size());
+    shingles.reserve(normalized.size() - length + 1);
+    for (size_t start = 0; start + length <= normalized.size(); start++) {
+        // FNV-1a по символам окна
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        for (size_t i = start; i < start + length; i++) {
+            hash = (hash ^ static_cast<uint64_t>(normalized[i])) * 0x100000001B3ULL;
+        }
+        shingles.push_back(mix64(hash));
+    }
+    std::sort(shingles.begin(), shingles.end());
+    shingles.erase(std::unique(shingles.begin(), shingles.end()), shingles.end());
+    return shingles;
+}
+
+double jaccardSimilarity(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b) {
+    if (a.empty() && b.empty()) {
+        return 0.0;
+    }
+    size_t common = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i] < b[j]) {
+            i++;
+        } else if (b[j] < a[i]) {
+            j++;
+        } else {
+            common++;
+            i++;
+            j++;
+        }
+    }
+    return static_cast<double>(common) / static_cast<double>(a.size() + b.size() - common);
+}
+
+MinHashSignature minHashSignature(const std::vector<uint64_t>& shingles) {
+    const MinHashFunctions& functions = minHashFunctions();
+    uint64_t minimums[MINHASH_SIZE];
+    std::fill(minimums, minimums + MINHASH_SIZE, std::numeric_limits<uint64_t>::max());
+    for (uint64_t shingle : shingles) {
+        for (size_t i = 0; i < MINHASH_SIZE; i++) {
+            minimums[i] = std::min(minimums[i], functions.a[i] * shingle + functions.b[i]);
+        }
+    }
+
+    MinHashSignature signature;
+    for (size_t i = 0; i < MINHASH_SIZE; i++) {
+        signature[i] = static_cast<uint16_t>(minimums[i] >> 48);
+    }
+    return signature;
+}
+
+double estimateSimilarity(const MinHashSignature& a, const MinHashSignature& b) {
+    size_t equal = 0;
+    for (size_t i = 0; i < MINHASH_SIZE; i++) {
+        equal += a[i] == b[i] ? 1 : 0;
+    }
+    return static_cast<double>(equal) / MINHASH_SIZE;
+}
+
+void sortSimilar(std::vector<SimilarNote>& notes) {
+    std::sort(notes.begin(), notes.end(), [](const SimilarNote& a, const SimilarNote& b) {
+        return a.similarity > b.similarity || (a.similarity == b.similarity && a.id < b.id);
+    });
+}
+
+// ===== ТАБЛИЦА КОРЗИН ПОЛОСЫ =====
+
+uint32_t SimilarityIndex::bandKey(const uint16_t* signature, size_t band) {
+    // LSH_ROWS значений по 16 бит - ровно 64 бита
+    uint64_t values = 0;
+    for (size_t i = band * LSH_ROWS; i < (band + 1) * LSH_ROWS; i++) {
+        values = (values << 16) | signature[i];
+    }
+    uint32_t key = static_cast<uint32_t>(mix64(values + band * 0x9E3779B97F4A7C15ULL) >> 32);
+    return key != 0 ? key : 1;
+}
+
+size_t SimilarityIndex::findSlot(const BandTable& table, uint32_t key) {
+    if (table.slots.empty()) {
+        return NO_ROW;
+    }
+    size_t mask = table.slots.size() - 1;
+    for (size_t pos = key & mask; table.slots[pos].key != 0; pos = (pos + 1) & mask) {
+        if (table.slots[pos].key == key) {
+            return pos;
+        }
+    }
+    return NO_ROW;
+}
+
+SimilarityIndex::Slot& SimilarityIndex::insertSlot(BandTable& table, uint32_t key) {
+    // Заполнение не больше 70%: цепочки проб остаются короткими
+    if ((table.used + 1) * 10 > table.slots.size() * 7) {
+        grow(table);
+    }
+    size_t mask = table.slots.size() - 1;
+    size_t pos = key & mask;
+    while (table.slots[pos].key != 0) {
+        pos = (pos + 1) & mask;
+    }
+    table.slots[pos] = {key, NO_ROW};
+    table.used++;
+    return table.slots[pos];
+}
+
+void SimilarityIndex::eraseSlot(BandTable& table, size_t pos) {
+    // Удаление без меток: следующие записи цепочки проб сдвигаются назад,
+    // если дыра лежит между их исходной ячейкой и текущей
+    size_t mask = table.slots.size() - 1;
+    size_t hole = pos;
+    for (size_t next = (hole + 1) & mask; table.slots[next].key != 0; next = (next + 1) & mask) {
+        size_t home = table.slots[next].key & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            table.slots[hole] = table.slots[next];
+            hole = next;
+        }
+    }
+    table.slots[hole] = {0, 0};
+    table.used--;
+}
+
+void SimilarityIndex::grow(BandTable& table) {
+    std::vector<Slot> old = std::move(table.slots);
+    table.slots.assign(old.empty() ? INITIAL_SLOTS : old.size() * 2, Slot{0, 0});
+    table.used = 0;
+    for (const Slot& slot : old) {
+        if (slot.key != 0) {
+            insertSlot(table, slot.key).head = slot.head;
+        }
+    }
+}
+
+// ===== ИНДЕКС =====
+
+void SimilarityIndex::add(int id, const MinHashSignature& signature) {
+    remove(id);
+
+    uint32_t row;
+    if (!freeRows.empty()) {
+        row = freeRows.back();
+        freeRows.pop_back();
+        rowIds[row] = id;
+    } else {
+        row = static_cast<uint32_t>(rowIds.size());
+        rowIds.push_back(id);
+        signatures.resize(signatures.size() + MINHASH_SIZE);
+        nextRows.resize(nextRows.size() + LSH_BANDS);
+        prevRows.resize(prevRows.size() + LSH_BANDS);
+    }
+    std::copy(signature.begin(), signature.end(), signatures.begin() + static_cast<std::ptrdiff_t>(row * MINHASH_SIZE));
+    rowById[id] = row;
+
+    // Строка становится первой в корзине каждой полосы
+    const uint16_t* values = &signatures[row * MINHASH_SIZE];
+    for (size_t band = 0; band < LSH_BANDS; band++) {
+        uint32_t key = bandKey(values, band);
+        size_t pos = findSlot(bands[band], key);
+        Slot& slot = pos != NO_ROW ? bands[band].slots[pos] : insertSlot(bands[band], key);
+        nextRows[row * LSH_BANDS + band] = slot.head;
+        prevRows[row * LSH_BANDS + band] = NO_ROW;
+        if (slot.head != NO_ROW) {
+            prevRows[slot.head * LSH_BANDS + band] = row;
+        }
+        slot.head = row;
+    }
+}
+
+bool SimilarityIndex::remove(int id) {
+    auto it = rowById.find(id);
+    if (it == rowById.end()) {
+        return false;
+    }
+    uint32_t row = it->second;
+    rowById.erase(it);
+
+    const uint16_t* values = &signatures[row * MINHASH_SIZE];
+    for (size_t band = 0; band < LSH_BANDS; band++) {
+        uint32_t next = nextRows[row * LSH_BANDS + band];
+        uint32_t prev = prevRows[row * LSH_BANDS + band];
+        if (next != NO_ROW) {
+            prevRows[next * LSH_BANDS + band] = prev;
+        }
+        if (prev != NO_ROW) {
+            nextRows[prev * LSH_BANDS + band] = next;
+            continue;
+        }
+        // Строка была первой в корзине
+        BandTable& table = bands[band];
+        size_t pos = findSlot(table, bandKey(values, band));
+        if (pos == NO_ROW) {
+            continue;
+        }
+        if (next == NO_ROW) {
+            eraseSlot(table, pos);
+        } else {
+            table.slots[pos].head = next;
+        }
+    }
+    freeRows.push_back(row);
+    return true;
+}
+
+bool SimilarityIndex::signatureOf(int id, MinHashSignature& out) const {
+    auto it = rowById.find(id);
+    if (it == rowById.end()) {
+        return false;
+    }
+    const uint16_t* values = &signatures[it->second * MINHASH_SIZE];
+    std::copy(values, values + MINHASH_SIZE, out.begin());
+    return true;
+}
+
+std::vector<SimilarNote> SimilarityIndex::candidates(const MinHashSignature& signature, double minEstimate) const {
+    // Строки всех корзин, в которые попала подпись
+    std::vector<uint32_t> rows;
+    for (size_t band = 0; band < LSH_BANDS; band++) {
+        size_t pos = findSlot(bands[band], bandKey(signature.data(), band));
+        if (pos == NO_ROW) {
+            continue;
+        }
+        for (uint32_t row = bands[band].slots[pos].head; row != NO_ROW; row = nextRows[row * LSH_BANDS + band]) {
+            rows.push_back(row);
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    std::vector<SimilarNote> result;
+    for (uint32_t row : rows) {
+        const uint16_t* values = &signatures[row * MINHASH_SIZE];
+        size_t equal = 0;
+        for (size_t i = 0; i < MINHASH_SIZE; i++) {
+            equal += values[i] == signature[i] ? 1 : 0;
+        }
+        double estimate = static_cast<double>(equal) / MINHASH_SIZE;
+        if (estimate >= minEstimate) {
+            result.push_back({rowIds[row], estimate});
+        }
+    }
+    sortSimilar(result);
+    return result;
+}
+
+void SimilarityIndex::save(SnapshotWriter& out) const {
+    out.putVector(signatures);
+    out.putVector(rowIds);
+    out.putVector(nextRows);
+    out.putVector(freeRows);
+    for (const BandTable& table : bands) {
+        out.putVector(table.slots);
+        out.putU64(table.used);
+    }
+}
+
+void SimilarityIndex::load(SnapshotReader& in) {
+    clear();
+    in.getVector(signatures);
+    in.getVector(rowIds);
+    in.getVector(nextRows);
+    in.getVector(freeRows);
+    for (BandTable& table : bands) {
+        in.getVector(table.slots);
+        table.used = in.getU64();
+        if ((table.slots.size() & (table.slots.size() - 1)) != 0 || table.used > table.slots.size()) {
+            throw std::runtime_error("поврежденная таблица похожих текстов");
+        }
+    }
+    if (signatures.size() != rowIds.size() * MINHASH_SIZE || nextRows.size() != rowIds.size() * LSH_BANDS ||
+        freeRows.size() > rowIds.size()) {
+        throw std::runtime_error("размеры индекса похожих текстов не совпадают");
+    }
+
+    // Обратные ссылки восстанавливаются обходом корзин; строка вне массива
+    // или цикл в списке - повреждение
+    prevRows.assign(nextRows.size(), NO_ROW);
+    for (size_t band = 0; band < LSH_BANDS; band++) {
+        for (const Slot& slot : bands[band].slots) {
+            if (slot.key == 0) {
+                continue;
+            }
+            uint32_t prev = NO_ROW;
+            size_t steps = 0;
+            for (uint32_t row = slot.head; row != NO_ROW; row = nextRows[row * LSH_BANDS + band]) {
+                if (row >= rowIds.size() || ++steps > rowIds.size()) {
+                    clear();
+                    throw std::runtime_error("поврежденный список корзины похожих текстов");
+                }
+                prevRows[row * LSH_BANDS + band] = prev;
+                prev = row;
+            }
+        }
+    }
+
+    std::vector<bool> freeRow(rowIds.size(), false);
+    for (uint32_t row : freeRows) {
+        if (row >= rowIds.size()) {
+            throw std::runtime_error("строка индекса похожих текстов вне диапазона");
+        }
+        freeRow[row] = true;
+    }
+    rowById.reserve(rowIds.size() - freeRows.size());
+    for (uint32_t row = 0; row < rowIds.size(); row++) {
+        if (!freeRow[row]) {
+            rowById[rowIds[row]] = row;
+        }
+    }
+}
+
+void SimilarityIndex::clear() {
+    signatures.clear();
+    rowIds.clear();
+    nextRows.clear();
+    prevRows.clear();
+    freeRows.clear();
+    rowById.clear();
+    for (BandTable& table : bands) {
+        table.slots.clear();
+        table.used = 0;
+    }
+}
+
+size_t SimilarityIndex::memoryUsage() const {
+    size_t bytes = vectorHeapBytes(signatures) + vectorHeapBytes(rowIds) + vectorHeapBytes(nextRows) +
+                   vectorHeapBytes(prevRows) + vectorHeapBytes(freeRows) + hashTableBytes(rowById);
+    for (const BandTable& table : bands) {
+        bytes += vectorHeapBytes(table.slots);
+    }
+    return bytes;
+}
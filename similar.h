@@ -0,0 +1,111 @@
+#ifndef SIMILAR_H
+#define SIMILAR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+// Поиск похожих заметок по тексту.
+//
+// Текст приводится к нижнему регистру, знаки препинания и пробельные символы
+// сводятся к одному пробелу; шинглы - все подстроки из SHINGLE_LENGTH символов.
+// Сходство двух текстов - коэффициент Жаккара их множеств шинглов.
+//
+// Подпись MinHash - минимумы MINHASH_SIZE хеш-функций по шинглам: доля
+// совпавших позиций двух подписей оценивает сходство. LSH-индекс делит
+// подпись на LSH_BANDS полос по LSH_ROWS значений; заметки, у которых совпала
+// хотя бы одна полоса, - кандидаты. Пара со сходством s попадает в кандидаты
+// с вероятностью 1 - (1 - s^4)^16: 0,64 при s = 0,5, 0,89 при 0,6, 0,99 при 0,7
+// и почти 1 от 0,8. Пары со сходством 0,1 становятся кандидатами реже 1 раза
+// из 500, поэтому запрос просматривает малую часть заметок.
+
+const size_t SHINGLE_LENGTH = 5;
+const size_t MINHASH_SIZE = 64;
+const size_t LSH_BANDS = 16;
+const size_t LSH_ROWS = MINHASH_SIZE / LSH_BANDS;
+
+// Порог сходства для "похожих заметок" и для предупреждения о почти дубликате
+const double SIMILAR_NOTES_THRESHOLD = 0.5;
+const double NEAR_DUPLICATE_THRESHOLD = 0.8;
+
+// Запас оценки по подписи: кандидаты с оценкой не ниже порога минус запас
+// проверяются точно (стандартное отклонение оценки из 64 значений - до 0,063)
+const double MINHASH_ESTIMATE_MARGIN = 0.15;
+
+// Похожая заметка
+struct SimilarNote {
+    int id;
+    double similarity;          // Сходство по Жаккару (или оценка по подписи)
+};
+
+// Хеши шинглов текста по возрастанию, без повторов (пустой текст - пусто)
+std::vector<uint64_t> textShingles(std::string_view text);
+
+// Коэффициент Жаккара двух множеств из textShingles
+double jaccardSimilarity(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b);
+
+// Подпись MinHash (старшие 16 бит каждого минимума)
+using MinHashSignature = std::array<uint16_t, MINHASH_SIZE>;
+MinHashSignature minHashSignature(const std::vector<uint64_t>& shingles);
+double estimateSimilarity(const MinHashSignature& a, const MinHashSignature& b);
+
+// Порядок результатов: по убыванию сходства, затем по ID
+void sortSimilar(std::vector<SimilarNote>& notes);
+
+// LSH-индекс подписей. Подписи лежат подряд в одном массиве, корзины полосы -
+// хеш-таблица с открытой адресацией (ключ полосы -> первая строка корзины),
+// строки одной корзины связаны двусвязным списком через nextRows и prevRows,
+// поэтому удаление не просматривает корзину (у одинаковых текстов она общая).
+// Удаление освобождает строку для следующего добавления.
+class SimilarityIndex {
+public:
+    void add(int id, const MinHashSignature& signature);
+    bool remove(int id);
+    bool signatureOf(int id, MinHashSignature& out) const;
+
+    // Заметки, у которых с подписью совпала хотя бы одна полоса и оценка
+    // сходства не ниже minEstimate; по убыванию оценки
+    std::vector<SimilarNote> candidates(const MinHashSignature& signature, double minEstimate) const;
+
+    // Сохранение в снимок и восстановление (snapshot.h)
+    void save(SnapshotWriter& out) const;
+    void load(SnapshotReader& in);
+
+    void clear();
+    size_t size() const { return rowById.size(); }
+    // Байты кучи индекса (memory.h)
+    size_t memoryUsage() const;
+
+private:
+    struct Slot {
+        uint32_t key;           // Хеш значений полосы (0 - ячейка пуста)
+        uint32_t head;          // Первая строка корзины
+    };
+
+    struct BandTable {
+        std::vector<Slot> slots;    // Размер - степень двойки
+        size_t used = 0;
+    };
+
+    std::vector<uint16_t> signatures;           // MINHASH_SIZE значений на строку
+    std::vector<int> rowIds;                    // ID заметки строки
+    std::vector<uint32_t> nextRows;             // LSH_BANDS на строку: следующая строка корзины
+    std::vector<uint32_t> prevRows;             // LSH_BANDS на строку: предыдущая (в снимок не пишется)
+    std::vector<uint32_t> freeRows;             // Освобожденные строки
+    std::unordered_map<int, uint32_t> rowById;  // ID -> строка
+    BandTable bands[LSH_BANDS];
+
+    static uint32_t bandKey(const uint16_t* signature, size_t band);
+    static size_t findSlot(const BandTable& table, uint32_t key);
+    static Slot& insertSlot(BandTable& table, uint32_t key);
+    static void eraseSlot(BandTable& table, size_t pos);
+    static void grow(BandTable& table);
+};
+
+#endif // SIMILAR_H
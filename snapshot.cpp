@@ -0,0 +1,115 @@
+#include "snapshot.h"
+#include "checksum.h"
+#include "fileio.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static const char SNAPSHOT_MAGIC[8] = {'T', 'M', 'S', 'N', 'A', 'P', '0', '7'};
+static const size_t SNAPSHOT_HEADER_SIZE = sizeof(SNAPSHOT_MAGIC) + 8 + 8 + 8 + 4;
+
+void SnapshotWriter::putBytes(const void* data, size_t size) {
+    buffer.append(static_cast<const char*>(data), size);
+}
+
+void SnapshotWriter::putString(std::string_view text) {
+    putU64(text.size());
+    putBytes(text.data(), text.size());
+}
+
+void SnapshotReader::getBytes(void* out, size_t size) {
+    if (size > data.size() - pos) {
+        throw std::runtime_error("Снимок обрывается");
+    }
+    if (size > 0) {
+        std::memcpy(out, data.data() + pos, size);
+    }
+    pos += size;
+}
+
+std::string SnapshotReader::getString() {
+    std::string text(getCount(1), '\0');
+    getBytes(&text[0], text.size());
+    return text;
+}
+
+size_t SnapshotReader::getCount(size_t elementSize) {
+    uint64_t count = getU64();
+    if (count > (data.size() - pos) / elementSize) {
+        throw std::runtime_error("Снимок обрывается");
+    }
+    return static_cast<size_t>(count);
+}
+
+bool writeSnapshotFile(const std::string& path, const SnapshotHeader& header, const std::string& payload) {
+    SnapshotWriter head;
+    head.putBytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    head.putU64(header.generation);
+    head.putU64(header.metadataSize);
+    head.putU64(payload.size());
+    head.putU32(crc32String(payload));
+    
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        file.write(head.data().data(), static_cast<std::streamsize>(head.data().size()));
+        file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        file.close();
+        if (!file) {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+    
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Разбор заголовка; size и crc - размер и контрольная сумма данных
+static bool parseSnapshotHeader(std::string_view data, SnapshotHeader& header,
+                                uint64_t& size, uint32_t& crc) {
+    if (data.size() < SNAPSHOT_HEADER_SIZE ||
+        std::memcmp(data.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        return false;
+    }
+    SnapshotReader in(data.substr(sizeof(SNAPSHOT_MAGIC), SNAPSHOT_HEADER_SIZE - sizeof(SNAPSHOT_MAGIC)));
+    header.generation = in.getU64();
+    header.metadataSize = in.getU64();
+    size = in.getU64();
+    crc = in.getU32();
+    return true;
+}
+
+bool readSnapshotHeader(const std::string& path, SnapshotHeader& header) {
+    std::ifstream file(path, std::ios::binary);
+    char data[SNAPSHOT_HEADER_SIZE];
+    uint64_t size;
+    uint32_t crc;
+    return file.read(data, sizeof(data)) &&
+           parseSnapshotHeader(std::string_view(data, sizeof(data)), header, size, crc);
+}
+
+bool readSnapshotFile(const std::string& path, SnapshotHeader& header, std::string& payload) {
+    std::string data;
+    uint64_t size;
+    uint32_t crc;
+    if (!readWholeFile(path, data) || !parseSnapshotHeader(data, header, size, crc)) {
+        return false;
+    }
+    if (size != data.size() - SNAPSHOT_HEADER_SIZE ||
+        crc32(data.data() + SNAPSHOT_HEADER_SIZE, size) != crc) {
+        return false;
+    }
+    
+    // Данные сдвигаются в начало того же буфера без повторного выделения
+    data.erase(0, SNAPSHOT_HEADER_SIZE);
+    payload.swap(data);
+    return true;
+}
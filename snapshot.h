@@ -0,0 +1,85 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Двоичный снимок хранилища и индексов (<метаданные>.snap).
+//
+// Формат файла:
+//   заголовок  "TMSNAP07", u64 поколение и u64 размер файла метаданных,
+//              u64 размер данных, u32 CRC-32 данных
+//   данные     последовательность полей SnapshotWriter
+// Снимок - локальный кэш, поэтому числа пишутся в порядке байтов текущей
+// машины, а при любой ошибке он просто не используется.
+
+// Сборка данных снимка в памяти
+class SnapshotWriter {
+public:
+    void putBytes(const void* data, size_t size);
+    void putU32(uint32_t value) { putBytes(&value, sizeof(value)); }
+    void putU64(uint64_t value) { putBytes(&value, sizeof(value)); }
+    void putI64(int64_t value) { putBytes(&value, sizeof(value)); }
+    void putString(std::string_view text);
+    
+    // Массив простых значений одним блоком
+    template <typename T>
+    void putVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "нужен тривиально копируемый тип");
+        putU64(values.size());
+        putBytes(values.data(), values.size() * sizeof(T));
+    }
+    
+    const std::string& data() const { return buffer; }
+    
+private:
+    std::string buffer;
+};
+
+// Чтение данных снимка; выход за границы данных - std::runtime_error
+class SnapshotReader {
+public:
+    explicit SnapshotReader(std::string_view data) : data(data), pos(0) {}
+    
+    void getBytes(void* out, size_t size);
+    uint32_t getU32() { uint32_t value; getBytes(&value, sizeof(value)); return value; }
+    uint64_t getU64() { uint64_t value; getBytes(&value, sizeof(value)); return value; }
+    int64_t getI64() { int64_t value; getBytes(&value, sizeof(value)); return value; }
+    std::string getString();
+    
+    // Длина массива из count элементов размера elementSize с проверкой по остатку данных
+    size_t getCount(size_t elementSize);
+    
+    template <typename T>
+    void getVector(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "нужен тривиально копируемый тип");
+        values.resize(getCount(sizeof(T)));
+        getBytes(values.data(), values.size() * sizeof(T));
+    }
+    
+    bool atEnd() const { return pos == data.size(); }
+    
+private:
+    std::string_view data;
+    size_t pos;
+};
+
+// Состояние файла метаданных, для которого сделан снимок
+struct SnapshotHeader {
+    uint64_t generation = 0;    // Поколение из заголовка метаданных
+    uint64_t metadataSize = 0;  // Размер файла метаданных в байтах
+};
+
+// Атомарная запись файла снимка (временный файл и переименование)
+bool writeSnapshotFile(const std::string& path, const SnapshotHeader& header, const std::string& payload);
+
+// Чтение только заголовка (без чтения данных)
+bool readSnapshotHeader(const std::string& path, SnapshotHeader& header);
+
+// Чтение файла снимка с проверкой заголовка и контрольной суммы
+bool readSnapshotFile(const std::string& path, SnapshotHeader& header, std::string& payload);
+
+#endif // SNAPSHOT_H
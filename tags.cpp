@@ -0,0 +1,232 @@
+#include "tags.h"
+#include "snapshot.h"
+#include "utf8.h"
+#include "memory.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+static bool isTagSeparator(char c) {
+    return c == ',' || std::isspace(static_cast<unsigned char>(c));
+}
+
+// Разбиение строки по запятым и пробельным символам
+static std::vector<std::string_view> splitTagTokens(std::string_view text) {
+    std::vector<std::string_view> tokens;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        while (pos < text.size() && isTagSeparator(text[pos])) {
+            pos++;
+        }
+        size_t start = pos;
+        while (pos < text.size() && !isTagSeparator(text[pos])) {
+            pos++;
+        }
+        if (pos > start) {
+            tokens.push_back(text.substr(start, pos - start));
+        }
+    }
+    return tokens;
+}
+
+std::vector<std::string> normalizeTags(const std::vector<std::string>& tags) {
+    std::vector<std::string> result;
+    result.reserve(tags.size());
+    for (const std::string& tag : tags) {
+        for (std::string_view token : splitTagTokens(tag)) {
+            result.push_back(foldCaseUtf8(token));
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+std::vector<std::string> parseTags(std::string_view text) {
+    return normalizeTags({std::string(text)});
+}
+
+std::string joinTags(const std::vector<std::string>& tags) {
+    std::string result;
+    for (const std::string& tag : tags) {
+        if (!result.empty()) {
+            result += ',';
+        }
+        result += tag;
+    }
+    return result;
+}
+
+TagQuery parseTagQuery(std::string_view text) {
+    TagQuery query;
+    bool negate = false;
+    for (std::string_view token : splitTagTokens(text)) {
+        if (token == "AND" || token == "И") {
+            continue;
+        }
+        if (token == "NOT" || token == "НЕ") {
+            negate = !negate;
+            continue;
+        }
+        if (token.front() == '-') {
+            negate = !negate;
+            token.remove_prefix(1);
+            if (token.empty()) {
+                continue;
+            }
+        }
+        (negate ? query.exclude : query.include).push_back(foldCaseUtf8(token));
+        negate = false;
+    }
+    return query;
+}
+
+bool matchesTagQuery(const std::vector<std::string>& tags, const TagQuery& query) {
+    // Метки заметки отсортированы (normalizeTags)
+    for (const std::string& tag : query.include) {
+        if (!std::binary_search(tags.begin(), tags.end(), tag)) {
+            return false;
+        }
+    }
+    for (const std::string& tag : query.exclude) {
+        if (std::binary_search(tags.begin(), tags.end(), tag)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ===== ИНДЕКС МЕТОК =====
+
+void TagIndex::add(int id, const std::vector<std::string>& tags) {
+    all.add(static_cast<uint32_t>(id));
+    for (const std::string& tag : tags) {
+        bitmaps[tag].add(static_cast<uint32_t>(id));
+    }
+}
+
+void TagIndex::remove(int id, const std::vector<std::string>& tags) {
+    all.remove(static_cast<uint32_t>(id));
+    for (const std::string& tag : tags) {
+        auto it = bitmaps.find(tag);
+        if (it == bitmaps.end()) {
+            continue;
+        }
+        it->second.remove(static_cast<uint32_t>(id));
+        // Метки без заметок не показываются в фасетах
+        if (it->second.empty()) {
+            bitmaps.erase(it);
+        }
+    }
+}
+
+RoaringBitmap TagIndex::select(const TagQuery& query) const {
+    std::vector<const RoaringBitmap*> included;
+    included.reserve(query.include.size());
+    for (const std::string& tag : query.include) {
+        auto it = bitmaps.find(tag);
+        if (it == bitmaps.end()) {
+            return RoaringBitmap();
+        }
+        included.push_back(&it->second);
+    }
+
+    // Самое маленькое множество первым: дальше пересечения только сужаются
+    std::sort(included.begin(), included.end(), [](const RoaringBitmap* a, const RoaringBitmap* b) {
+        return a->cardinality() < b->cardinality();
+    });
+
+    RoaringBitmap result = included.empty() ? all : *included.front();
+    for (size_t i = 1; i < included.size() && !result.empty(); i++) {
+        result = result & *included[i];
+    }
+    for (const std::string& tag : query.exclude) {
+        if (result.empty()) {
+            break;
+        }
+        auto it = bitmaps.find(tag);
+        if (it != bitmaps.end()) {
+            result = result.andNot(it->second);
+        }
+    }
+    return result;
+}
+
+std::vector<int> TagIndex::query(const TagQuery& query) const {
+    std::vector<int> ids;
+    RoaringBitmap matches = select(query);
+    std::vector<uint32_t> values = matches.toVector();
+    ids.reserve(values.size());
+    for (uint32_t value : values) {
+        ids.push_back(static_cast<int>(value));
+    }
+    return ids;
+}
+
+void sortTagCounts(std::vector<TagCount>& counts) {
+    std::sort(counts.begin(), counts.end(), [](const TagCount& a, const TagCount& b) {
+        return a.count > b.count || (a.count == b.count && a.tag < b.tag);
+    });
+}
+
+std::vector<TagCount> TagIndex::counts() const {
+    std::vector<TagCount> result;
+    result.reserve(bitmaps.size());
+    for (const auto& entry : bitmaps) {
+        result.push_back({entry.first, entry.second.cardinality()});
+    }
+    sortTagCounts(result);
+    return result;
+}
+
+std::vector<TagCount> TagIndex::counts(const RoaringBitmap& within) const {
+    std::vector<TagCount> result;
+    for (const auto& entry : bitmaps) {
+        uint64_t count = entry.second.andCardinality(within);
+        if (count > 0) {
+            result.push_back({entry.first, count});
+        }
+    }
+    sortTagCounts(result);
+    return result;
+}
+
+void TagIndex::save(SnapshotWriter& out) const {
+    all.save(out);
+    out.putU64(bitmaps.size());
+    for (const auto& entry : bitmaps) {
+        out.putString(entry.first);
+        entry.second.save(out);
+    }
+}
+
+void TagIndex::load(SnapshotReader& in) {
+    clear();
+    all.load(in);
+    size_t count = in.getCount(2 * sizeof(uint64_t));
+    bitmaps.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        std::string tag = in.getString();
+        RoaringBitmap& bitmap = bitmaps[tag];
+        bitmap.load(in);
+        if (bitmap.empty()) {
+            throw std::runtime_error("пустая метка в снимке");
+        }
+    }
+    if (bitmaps.size() != count) {
+        throw std::runtime_error("повторные метки в снимке");
+    }
+}
+
+void TagIndex::clear() {
+    bitmaps.clear();
+    all.clear();
+}
+
+size_t TagIndex::memoryUsage() const {
+    size_t bytes = stringKeyedTableBytes(bitmaps) + all.memoryUsage();
+    for (const auto& entry : bitmaps) {
+        bytes += entry.second.memoryUsage();
+    }
+    return bytes;
+}
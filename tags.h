@@ -0,0 +1,81 @@
+#ifndef TAGS_H
+#define TAGS_H
+
+#include "bitmap.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+// Метки заметки хранятся нормализованными: без пробелов по краям, в нижнем
+// регистре, по возрастанию и без повторов. Запятые и пробельные символы
+// разделяют метки, поэтому внутри метки их нет.
+
+// Нормализация списка меток
+std::vector<std::string> normalizeTags(const std::vector<std::string>& tags);
+
+// Разбор строки "Работа, срочно отчет" в нормализованный список
+std::vector<std::string> parseTags(std::string_view text);
+
+// Список меток через запятую (поле файла метаданных)
+std::string joinTags(const std::vector<std::string>& tags);
+
+// Запрос по меткам: все метки include и ни одной из exclude
+struct TagQuery {
+    std::vector<std::string> include;
+    std::vector<std::string> exclude;
+};
+
+// Разбор запроса "работа AND срочно AND NOT архив". Ключевые слова
+// AND/NOT (И/НЕ) пишутся заглавными; "-метка" - то же, что "NOT метка",
+// метки без AND между ними тоже объединяются через AND.
+TagQuery parseTagQuery(std::string_view text);
+
+// Проверка меток одной заметки (нормализованных) по запросу - для просмотра
+// без индекса меток
+bool matchesTagQuery(const std::vector<std::string>& tags, const TagQuery& query);
+
+// Число заметок с меткой (фасеты)
+struct TagCount {
+    std::string tag;
+    uint64_t count;
+};
+
+// Порядок фасетов: по убыванию числа, затем по имени
+void sortTagCounts(std::vector<TagCount>& counts);
+
+// Индекс меток: для каждой метки - сжатое множество ID заметок
+class TagIndex {
+public:
+    void add(int id, const std::vector<std::string>& tags);
+    void remove(int id, const std::vector<std::string>& tags);
+
+    // ID заметок, подходящих под запрос. Пересечение начинается с самой
+    // редкой метки; запрос без include отбирает из всех заметок.
+    RoaringBitmap select(const TagQuery& query) const;
+    std::vector<int> query(const TagQuery& query) const;
+
+    // Число заметок по каждой метке (по убыванию числа, затем по имени);
+    // с within - только среди заметок множества
+    std::vector<TagCount> counts() const;
+    std::vector<TagCount> counts(const RoaringBitmap& within) const;
+
+    // Сохранение в снимок и восстановление (snapshot.h)
+    void save(SnapshotWriter& out) const;
+    void load(SnapshotReader& in);
+
+    void clear();
+    size_t tagCount() const { return bitmaps.size(); }
+    // Байты кучи индекса вместе с битовыми картами (memory.h)
+    size_t memoryUsage() const;
+
+private:
+    std::unordered_map<std::string, RoaringBitmap> bitmaps; // Метка -> ID заметок
+    RoaringBitmap all;                                      // ID всех заметок
+};
+
+#endif // TAGS_H
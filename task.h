@@ -0,0 +1,262 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include "thread_pool.h"
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Сопрограммы C++20 для асинхронного API (async_note.h).
+//
+// Task<T> - ленивая сопрограмма: тело начинает выполняться при co_await,
+// по завершении управление сразу передается ожидающей сопрограмме.
+// Переход в другой поток - co_await resumeOn(pool). Из обычного кода
+// результат получается через syncWait, несколько задач запускаются
+// одновременно через whenAll.
+
+template <typename T>
+class Task;
+
+// Общая часть promise_type: ожидающая сопрограмма и исключение
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> self) noexcept {
+            std::coroutine_handle<> next = self.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+    T take() { return std::move(*value); }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void take() {}
+};
+
+template <typename T>
+class Task {
+public:
+    using promise_type = TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle handle) : coroutine(handle) {}
+    Task(Task&& other) noexcept : coroutine(std::exchange(other.coroutine, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (coroutine) {
+                coroutine.destroy();
+            }
+            coroutine = std::exchange(other.coroutine, {});
+        }
+        return *this;
+    }
+    ~Task() {
+        if (coroutine) {
+            coroutine.destroy();
+        }
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    // Ожидание: задача запускается в потоке ожидающей сопрограммы
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        coroutine.promise().continuation = awaiting;
+        return coroutine;
+    }
+    T await_resume() {
+        promise_type& promise = coroutine.promise();
+        if (promise.error) {
+            std::rethrow_exception(promise.error);
+        }
+        return promise.take();
+    }
+
+private:
+    Handle coroutine;
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Сопрограмма без ожидающего: запускается сразу, кадр освобождается по завершении
+struct DetachedCoroutine {
+    struct promise_type {
+        DetachedCoroutine get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+// Продолжение сопрограммы в потоке пула
+struct ResumeOn {
+    ThreadPool& pool;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const {
+        pool.submit([handle]() { handle.resume(); });
+    }
+    void await_resume() const noexcept {}
+};
+
+inline ResumeOn resumeOn(ThreadPool& pool) {
+    return ResumeOn{pool};
+}
+
+// ===== ОЖИДАНИЕ ИЗ ОБЫЧНОГО КОДА =====
+
+// Флаг завершения: ожидающий поток не может вернуться (и освободить флаг),
+// пока сопрограмма не отпустит мьютекс
+struct SyncWaitSignal {
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+
+    void set() {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        finished.notify_all();
+    }
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this]() { return done; });
+    }
+};
+
+template <typename T>
+DetachedCoroutine runSyncWait(Task<T>& task, std::optional<std::conditional_t<std::is_void_v<T>, char, T>>& result,
+                              std::exception_ptr& error, SyncWaitSignal& signal) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            result.emplace();
+        } else {
+            result.emplace(co_await task);
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    signal.set();
+}
+
+// Выполнение задачи с блокировкой вызывающего потока до ее завершения
+template <typename T>
+T syncWait(Task<T> task) {
+    std::optional<std::conditional_t<std::is_void_v<T>, char, T>> result;
+    std::exception_ptr error;
+    SyncWaitSignal signal;
+    runSyncWait(task, result, error, signal);
+    signal.wait();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if constexpr (!std::is_void_v<T>) {
+        return std::move(*result);
+    }
+}
+
+// ===== НЕСКОЛЬКО ЗАДАЧ ОДНОВРЕМЕННО =====
+
+// Счетчик незавершенных задач; последняя завершившаяся продолжает ожидающую
+// сопрограмму. Лишняя единица в счетчике снимается после запуска всех задач,
+// чтобы ожидающая не продолжилась раньше, чем приостановится.
+struct WhenAllState {
+    std::atomic<size_t> remaining{0};
+    std::coroutine_handle<> parent;
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    void finishOne() {
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            parent.resume();
+        }
+    }
+};
+
+template <typename T>
+DetachedCoroutine runWhenAllPart(Task<T>& task, std::optional<T>& slot, WhenAllState& state) {
+    try {
+        slot.emplace(co_await task);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(state.errorMutex);
+        if (!state.error) {
+            state.error = std::current_exception();
+        }
+    }
+    state.finishOne();
+}
+
+template <typename T>
+struct WhenAllAwaiter {
+    std::vector<Task<T>>& tasks;
+    std::vector<std::optional<T>>& results;
+    WhenAllState& state;
+
+    bool await_ready() const noexcept { return tasks.empty(); }
+    bool await_suspend(std::coroutine_handle<> handle) {
+        state.parent = handle;
+        state.remaining.store(tasks.size() + 1, std::memory_order_relaxed);
+        for (size_t i = 0; i < tasks.size(); i++) {
+            runWhenAllPart(tasks[i], results[i], state);
+        }
+        // Все задачи уже завершились - продолжаем без приостановки
+        return state.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+    void await_resume() const noexcept {}
+};
+
+// Одновременное выполнение задач; результаты в порядке задач
+template <typename T>
+Task<std::vector<T>> whenAll(std::vector<Task<T>> tasks) {
+    std::vector<std::optional<T>> results(tasks.size());
+    WhenAllState state;
+    co_await WhenAllAwaiter<T>{tasks, results, state};
+    if (state.error) {
+        std::rethrow_exception(state.error);
+    }
+
+    std::vector<T> values;
+    values.reserve(results.size());
+    for (std::optional<T>& result : results) {
+        values.push_back(std::move(*result));
+    }
+    co_return values;
+}
+
+#endif // TASK_H
@@ -1,10 +1,35 @@
 #include "note.h"
 #include "validation.h"
+#include "fileio.h"
+#include "utf8.h"
+#include "scan.h"
+#include "thread_pool.h"
+#include "sharded.h"
+#include "checksum.h"
+#include "archive.h"
+#include "metadata.h"
+#include "watcher.h"
+#include "timestamp.h"
+#include "snapshot.h"
+#include "tags.h"
+#include "trash.h"
+#include "async_note.h"
+#include "memory.h"
+#include "similar.h"
 #include <iostream>
 #include <cassert>
 #include <string>
 #include <fstream>
 #include <filesystem>
+#include <random>
+#include <atomic>
+#include <thread>
+#include <ctime>
+#include <cstdio>
+#include <set>
+#include <algorithm>
+#include <sstream>
+#include <cmath>
 
 // Цвета для консольного вывода
 #define GREEN "\033[32m"
@@ -148,7 +173,14 @@ void cleanupTestData() {
     // Используем std::filesystem для безопасного удаления
     std::error_code ec;
     std::filesystem::remove("notes_metadata.dat", ec);
+    std::filesystem::remove("notes_metadata.dat.rejected", ec);
+    std::filesystem::remove("notes_metadata.dat.snap", ec);
+    std::filesystem::remove("notes_metadata.dat.trash", ec);
     std::filesystem::remove_all("notes", ec);
+    std::filesystem::remove_all("bodies", ec);
+    std::filesystem::remove_all("history", ec);
+    std::filesystem::remove_all("test_stores", ec);
+    std::filesystem::remove("test_archive.tma", ec);
     // Игнорируем ошибку, если файлы/директории не существуют
 }
 
@@ -329,6 +361,2772 @@ TEST(test_note_content_persistence) {
     cleanupTestData();
 }
 
+TEST(test_update_note_content) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.addNote("Редактируемая", "Тест", "Старый текст");
+        ASSERT_TRUE(manager.updateNote(1, "Редактируемая", "Тест", "Новый текст"));
+        ASSERT_EQUAL(manager.getNote(1)->content, std::string("Новый текст"));
+    }
+    
+    {
+        NoteManager manager;
+        manager.loadFromFile();
+        ASSERT_EQUAL(manager.getNoteCount(), 1);
+        ASSERT_EQUAL(manager.getNote(1)->content, std::string("Новый текст"));
+    }
+    
+    cleanupTestData();
+}
+
+TEST(test_update_note_title_renames_file) {
+    cleanupTestData();
+    NoteManager manager;
+    
+    manager.addNote("Старое название", "Тест", "Содержимое");
+    std::string oldPath = manager.getNote(1)->filePath;
+    
+    ASSERT_TRUE(manager.updateNote(1, "Новое название", "Тест", "Содержимое"));
+    
+    const Note* note = manager.getNote(1);
+    ASSERT_EQUAL(note->id, 1);
+    ASSERT_TRUE(note->filePath != oldPath);
+    ASSERT_FALSE(std::filesystem::exists(oldPath));
+    ASSERT_TRUE(std::filesystem::exists(note->filePath));
+    
+    // Старое название освобождается, новое занято
+    ASSERT_TRUE(manager.addNote("Старое название", "Тест", "Другая заметка"));
+    ASSERT_FALSE(manager.addNote("Новое название", "Тест", "Дубликат"));
+    
+    cleanupTestData();
+}
+
+TEST(test_update_note_duplicate_title) {
+    cleanupTestData();
+    NoteManager manager;
+    
+    manager.addNote("Первая", "Тест", "Содержимое 1");
+    manager.addNote("Вторая", "Тест", "Содержимое 2");
+    
+    ASSERT_FALSE(manager.updateNote(2, "Первая", "Тест", "Содержимое 2"));
+    ASSERT_EQUAL(manager.getNote(2)->title, std::string("Вторая"));
+    
+    cleanupTestData();
+}
+
+TEST(test_update_note_not_exists) {
+    cleanupTestData();
+    NoteManager manager;
+    
+    ASSERT_FALSE(manager.updateNote(999, "Название", "Тест", "Содержимое"));
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ ДЛЯ ЧТЕНИЯ ФАЙЛОВ =====
+
+TEST(test_note_body_view) {
+    std::string data = "Название: А\nТема: Б\nДата: 2026-01-01\n\nСтрока 1\nСтрока 2\n";
+    ASSERT_EQUAL(noteBodyView(data), std::string_view("Строка 1\nСтрока 2\n"));
+    ASSERT_EQUAL(noteBodyView("Название: А\nТема: Б\n"), std::string_view());
+}
+
+TEST(test_multiline_content_roundtrip) {
+    cleanupTestData();
+    
+    std::string content = "Первая строка\nВторая строка\n\nПосле пустой строки\n";
+    
+    {
+        NoteManager manager;
+        manager.addNote("Многострочная", "Тест", content);
+    }
+    
+    {
+        NoteManager manager;
+        manager.loadFromFile();
+        // Текст, включая завершающий перевод строки, загружается без изменений
+        ASSERT_EQUAL(manager.getNote(1)->content, content);
+    }
+    
+    cleanupTestData();
+}
+
+TEST(test_read_missing_file) {
+    std::string buffer;
+    ASSERT_FALSE(readWholeFile("notes/нет_такого_файла.txt", buffer));
+    ASSERT_EQUAL(readNoteBody("notes/нет_такого_файла.txt"), std::string());
+}
+
+// ===== ТЕСТЫ ДЛЯ АВТОДОПОЛНЕНИЯ =====
+
+TEST(test_fold_case_utf8) {
+    ASSERT_EQUAL(foldCaseUtf8("Работа"), std::string("работа"));
+    ASSERT_EQUAL(foldCaseUtf8("ЁЛКА Hello"), std::string("ёлка hello"));
+    ASSERT_EQUAL(foldCaseUtf8("123 !?"), std::string("123 !?"));
+}
+
+TEST(test_suggest_titles_prefix) {
+    cleanupTestData();
+    NoteManager manager;
+    
+    manager.addNote("Проект Альфа", "Работа", "Текст");
+    manager.addNote("Покупки", "Быт", "Текст");
+    manager.addNote("проект Бета", "Работа", "Текст");
+    manager.addNote("Отпуск", "Личное", "Текст");
+    
+    std::vector<std::string> titles = manager.suggestTitles("ПРО");
+    ASSERT_EQUAL(titles.size(), 2);
+    ASSERT_EQUAL(titles[0], std::string("Проект Альфа"));
+    ASSERT_EQUAL(titles[1], std::string("проект Бета"));
+    
+    ASSERT_EQUAL(manager.suggestTitles("По").size(), 1);
+    ASSERT_EQUAL(manager.suggestTitles("П").size(), 3);
+    ASSERT_EQUAL(manager.suggestTitles("П", 2).size(), 2);
+    ASSERT_EQUAL(manager.suggestTitles("Я").size(), 0);
+    
+    // Префикс, обрезанный посередине буквы "р" (2 байта в UTF-8)
+    std::string partial = std::string("Пр").substr(0, 3);
+    ASSERT_EQUAL(manager.suggestTitles(partial).size(), 3);
+    
+    cleanupTestData();
+}
+
+TEST(test_suggest_titles_sync) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.addNote("Заметка А", "Тест", "Текст");
+        manager.addNote("Заметка Б", "Тест", "Текст");
+        manager.addNote("Другое", "Тест", "Текст");
+        
+        manager.deleteNote(1);
+        ASSERT_EQUAL(manager.suggestTitles("заметка").size(), 1);
+        
+        manager.updateNote(3, "Заметка В", "Тест", "Текст");
+        ASSERT_EQUAL(manager.suggestTitles("заметка").size(), 2);
+        ASSERT_EQUAL(manager.suggestTitles("друг").size(), 0);
+    }
+    
+    {
+        NoteManager manager;
+        manager.loadFromFile();
+        std::vector<std::string> titles = manager.suggestTitles("заметка");
+        ASSERT_EQUAL(titles.size(), 2);
+        ASSERT_EQUAL(titles[0], std::string("Заметка Б"));
+        ASSERT_EQUAL(titles[1], std::string("Заметка В"));
+    }
+    
+    cleanupTestData();
+}
+
+TEST(test_title_index_matches_reference) {
+    // Вставки и удаления вперемешку, через несколько слияний добавок
+    TitleIndex index;
+    std::set<std::pair<std::string, int>> reference;
+    const char* words[] = {"Проект", "план", "Отчет", "отпуск", "Покупки"};
+    std::mt19937 rng(28);
+    for (int id = 1; id <= 3000; id++) {
+        std::string title = std::string(words[rng() % 5]) + " " + std::to_string(rng() % 500);
+        if (id <= 1000) {
+            index.append(title, id);
+        } else {
+            index.insert(title, id);
+        }
+        reference.insert({foldCaseUtf8(title), id});
+        if (id == 1000) {
+            index.finalize();
+        }
+        if (id > 1000 && id % 3 == 0) {
+            auto victim = reference.begin();
+            std::advance(victim, rng() % reference.size());
+            ASSERT_TRUE(index.erase(victim->first, victim->second));
+            reference.erase(victim);
+        }
+    }
+    ASSERT_EQUAL(index.size(), reference.size());
+    
+    // Помеченную удаленной запись нельзя удалить повторно, а та же пара
+    // (название, ID) после переименования туда и обратно снова находится
+    std::pair<std::string, int> first = *reference.begin();
+    ASSERT_TRUE(index.erase(first.first, first.second));
+    ASSERT_FALSE(index.erase(first.first, first.second));
+    index.insert(first.first, first.second);
+    ASSERT_EQUAL(index.size(), reference.size());
+    
+    auto expected = [&](const std::string& prefix, size_t limit) {
+        std::vector<int> ids;
+        std::string key = foldCaseUtf8(prefix);
+        for (auto it = reference.lower_bound({key, 0}); it != reference.end() && ids.size() < limit; ++it) {
+            if (it->first.compare(0, key.size(), key) != 0) {
+                break;
+            }
+            ids.push_back(it->second);
+        }
+        return ids;
+    };
+    const char* prefixes[] = {"п", "ПРОЕКТ 1", "отч", "о", "покупки 49", "я"};
+    for (const char* prefix : prefixes) {
+        ASSERT_TRUE(index.complete(prefix, 50) == expected(prefix, 50));
+    }
+    
+    // В снимке добавки уже слиты с основным массивом
+    SnapshotWriter out;
+    index.save(out);
+    TitleIndex restored;
+    SnapshotReader in(out.data());
+    restored.load(in);
+    ASSERT_EQUAL(restored.size(), reference.size());
+    for (const char* prefix : prefixes) {
+        ASSERT_TRUE(restored.complete(prefix, 50) == expected(prefix, 50));
+    }
+    
+    // Пометки и массовое удаление вместе
+    std::unordered_set<int> ids;
+    for (auto it = reference.begin(); it != reference.end();) {
+        if (it->second % 7 == 0) {
+            ids.insert(it->second);
+            it = reference.erase(it);
+        } else if (it->second % 5 == 0) {
+            ASSERT_TRUE(restored.erase(it->first, it->second));
+            it = reference.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    restored.eraseIds(ids);
+    ASSERT_EQUAL(restored.size(), reference.size());
+    for (const char* prefix : prefixes) {
+        ASSERT_TRUE(restored.complete(prefix, 50) == expected(prefix, 50));
+    }
+}
+
+// ===== ТЕСТЫ ДЛЯ НЕЧЕТКОГО ПОИСКА =====
+
+TEST(test_bounded_edit_distance) {
+    ASSERT_EQUAL(boundedEditDistance(U"кот", U"кот", 2), 0);
+    ASSERT_EQUAL(boundedEditDistance(U"кот", U"кит", 2), 1);
+    ASSERT_EQUAL(boundedEditDistance(U"работа", U"забота", 2), 1);
+    ASSERT_EQUAL(boundedEditDistance(U"abc", U"xyzw", 2), 3);
+    ASSERT_EQUAL(boundedEditDistance(U"", U"abc", 5), 3);
+}
+
+TEST(test_fuzzy_search_categories) {
+    cleanupTestData();
+    NoteManager manager;
+    
+    manager.addNote("Отчет", "Работа", "Текст");
+    manager.addNote("Список", "Быт", "Текст");
+    manager.addNote("План", "работа", "Текст");
+    
+    // Разный регистр - точное совпадение после приведения
+    std::vector<FuzzyMatch> matches = manager.fuzzySearchCategories("РАБОТА", 0);
+    ASSERT_EQUAL(matches.size(), 2);
+    ASSERT_EQUAL(matches[0].id, 1);
+    ASSERT_EQUAL(matches[1].id, 3);
+    
+    // Одна опечатка
+    matches = manager.fuzzySearchCategories("Робота", 1);
+    ASSERT_EQUAL(matches.size(), 2);
+    ASSERT_EQUAL(matches[0].distance, 1);
+    
+    ASSERT_EQUAL(manager.fuzzySearchCategories("Отдых", 1).size(), 0);
+    
+    // Удаление из узла с множеством ID (через карту позиций) и после
+    // массового удаления, которое ее сбрасывает
+    BKTree tree;
+    std::set<int> expected;
+    for (int id = 1; id <= 300; id++) {
+        tree.insert(id % 2 ? "Работа" : "работа", id);
+        expected.insert(id);
+    }
+    for (int id = 3; id <= 300; id += 3) {
+        ASSERT_TRUE(tree.erase("Работа", id));
+        expected.erase(id);
+    }
+    ASSERT_FALSE(tree.erase("Работа", 3));
+    tree.insert("Работа", 3);
+    tree.insert("Работа", 1000);
+    expected.insert(3);
+    expected.insert(1000);
+    ASSERT_TRUE(tree.erase("Работа", 1));
+    expected.erase(1);
+    tree.eraseIds({2, 4});
+    expected.erase(2);
+    expected.erase(4);
+    ASSERT_TRUE(tree.erase("Работа", 1000));
+    ASSERT_TRUE(tree.erase("Работа", 5));
+    expected.erase(1000);
+    expected.erase(5);
+    std::vector<int> ids;
+    for (const FuzzyMatch& match : tree.search("работа", 0)) {
+        ids.push_back(match.id);
+    }
+    ASSERT_TRUE(ids == std::vector<int>(expected.begin(), expected.end()));
+    ASSERT_EQUAL(tree.size(), expected.size());
+    
+    cleanupTestData();
+}
+
+TEST(test_fuzzy_search_titles_sync) {
+    cleanupTestData();
+    NoteManager manager;
+    
+    manager.addNote("Встреча с клиентом", "Работа", "Текст");
+    manager.addNote("Покупки", "Быт", "Текст");
+    
+    std::vector<FuzzyMatch> matches = manager.fuzzySearchTitles("встеча с клиентом", 2);
+    ASSERT_EQUAL(matches.size(), 1);
+    ASSERT_EQUAL(matches[0].id, 1);
+    
+    manager.updateNote(2, "Покупки на неделю", "Быт", "Текст");
+    ASSERT_EQUAL(manager.fuzzySearchTitles("Покупки", 1).size(), 0);
+    ASSERT_EQUAL(manager.fuzzySearchTitles("покупки на неделю", 0).size(), 1);
+    
+    manager.deleteNote(1);
+    ASSERT_EQUAL(manager.fuzzySearchTitles("встеча с клиентом", 2).size(), 0);
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ ДЛЯ ВЕКТОРНЫХ ЯДЕР =====
+
+TEST(test_scan_kernels_match_scalar) {
+    std::mt19937 rng(5);
+    std::string haystack;
+    for (int i = 0; i < 3000; i++) {
+        haystack.push_back(static_cast<char>('a' + rng() % 4));
+    }
+    std::vector<uint32_t> column;
+    for (int i = 0; i < 1001; i++) {
+        column.push_back(rng() % 10);
+    }
+    
+    const ScanLevel levels[] = {ScanLevel::Scalar, ScanLevel::SSE42, ScanLevel::AVX2};
+    ScanLevel original = getScanLevel();
+    
+    for (ScanLevel level : levels) {
+        setScanLevel(level);
+        for (int len = 1; len <= 12; len++) {
+            for (int start = 0; start < 2900; start += 97) {
+                std::string needle = haystack.substr(start, len);
+                ASSERT_EQUAL(findSubstring(haystack, needle), haystack.find(needle));
+            }
+        }
+        ASSERT_EQUAL(findSubstring(haystack, "abcdabcdxx"), std::string::npos);
+        ASSERT_EQUAL(findSubstring("", "a"), std::string::npos);
+        
+        std::vector<uint32_t> rows;
+        filterEqual(column.data(), column.size(), 3, rows);
+        size_t expected = 0;
+        for (size_t i = 0; i < column.size(); i++) {
+            if (column[i] == 3) {
+                ASSERT_EQUAL(rows[expected], i);
+                expected++;
+            }
+        }
+        ASSERT_EQUAL(rows.size(), expected);
+        
+        rows.clear();
+        filterRange(column.data(), column.size(), 2, 5, rows);
+        expected = 0;
+        for (size_t i = 0; i < column.size(); i++) {
+            if (column[i] >= 2 && column[i] <= 5) {
+                ASSERT_EQUAL(rows[expected], i);
+                expected++;
+            }
+        }
+        ASSERT_EQUAL(rows.size(), expected);
+    }
+    
+    setScanLevel(original);
+}
+
+TEST(test_find_by_content_and_date) {
+    cleanupTestData();
+    NoteManager manager;
+    
+    manager.addNote("Первая", "Тест", "Купить молоко и хлеб");
+    manager.addNote("Вторая", "Тест", "Позвонить в банк");
+    manager.addNote("Третья", "Работа", "Отчет: молоко не нужно");
+    
+    std::vector<int> ids = manager.findByContent("молоко");
+    ASSERT_EQUAL(ids.size(), 2);
+    ASSERT_EQUAL(ids[0], 1);
+    ASSERT_EQUAL(ids[1], 3);
+    ASSERT_EQUAL(manager.findByContent("кефир").size(), 0);
+    
+    std::string today = getCurrentDate();
+    ASSERT_EQUAL(manager.findByDateRange(today, today).size(), 3);
+    ASSERT_EQUAL(manager.findByDateRange("1990-01-01", "1990-12-31").size(), 0);
+    ASSERT_EQUAL(manager.findByDateRange("не дата", today).size(), 0);
+    
+    manager.deleteNote(1);
+    ASSERT_EQUAL(manager.findByDateRange(today, today).size(), 2);
+    ASSERT_EQUAL(manager.findByContent("молоко").size(), 1);
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ ДЛЯ ПАРАЛЛЕЛЬНОГО ПОИСКА =====
+
+TEST(test_thread_pool_runs_all_tasks) {
+    std::atomic<int> counter(0);
+    ThreadPool pool(4);
+    for (int i = 0; i < 100; i++) {
+        pool.submit([&pool, &counter]() {
+            counter++;
+            // Вложенные задачи попадают в очередь текущего потока
+            pool.submit([&counter]() { counter++; });
+        });
+    }
+    pool.wait();
+    ASSERT_EQUAL(counter.load(), 200);
+}
+
+TEST(test_thread_pool_task_exception) {
+    std::atomic<int> counter(0);
+    ThreadPool pool(4);
+    for (int i = 0; i < 50; i++) {
+        pool.submit([&counter, i]() {
+            if (i % 10 == 3) {
+                throw std::runtime_error("ошибка задачи");
+            }
+            counter++;
+        });
+    }
+    // Исключение не завершает поток: остальные задачи выполнены, ошибка - в wait()
+    bool thrown = false;
+    try {
+        pool.wait();
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+    ASSERT_EQUAL(counter.load(), 45);
+    
+    // Ошибка отдается один раз, пул продолжает работать
+    pool.submit([&counter]() { counter++; });
+    pool.wait();
+    ASSERT_EQUAL(counter.load(), 46);
+    
+    // Исключение из обработчика результатов доходит до вызывающего
+    cleanupTestData();
+    MemoryNoteManager manager;
+    for (int i = 0; i < 1100; i++) {
+        manager.addNote("Заметка " + std::to_string(i), "Тест", "текст " + std::to_string(i));
+    }
+    thrown = false;
+    try {
+        manager.parallelSearchContent("текст", [](const Note& note) {
+            if (note.id == 700) {
+                throw std::runtime_error("ошибка обработчика");
+            }
+        }, 4);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+    ASSERT_EQUAL(manager.findByContent("текст 1099").size(), size_t(1));
+    ASSERT_EQUAL(manager.countBy(GroupBy::Category, [](const Note&) { return true; }, 2)[0].count, uint64_t(1100));
+    cleanupTestData();
+}
+
+TEST(test_parallel_search_ordered) {
+    cleanupTestData();
+    NoteManager manager;
+    
+    for (int i = 0; i < 1100; i++) {
+        std::string content = (i % 7 == 0) ? "искомый фрагмент " + std::to_string(i) : "обычный текст";
+        manager.addNote("Заметка " + std::to_string(i), "Тест", content);
+    }
+    
+    std::vector<int> ids;
+    size_t found = manager.parallelSearchContent("искомый", [&ids](const Note& note) {
+        ids.push_back(note.id);
+    }, 4);
+    
+    ASSERT_EQUAL(found, 158);
+    ASSERT_EQUAL(ids.size(), 158);
+    for (size_t i = 0; i < ids.size(); i++) {
+        // Заметка i имеет ID i + 1; совпадают заметки с i, кратным 7
+        ASSERT_EQUAL(ids[i], static_cast<int>(i * 7 + 1));
+    }
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ ДЛЯ РАСПРЕДЕЛЕННОГО ХРАНИЛИЩА =====
+
+TEST(test_custom_store_root) {
+    cleanupTestData();
+    std::filesystem::create_directory("test_stores");
+    
+    {
+        NoteManager manager("test_stores/main");
+        ASSERT_TRUE(manager.addNote("Заметка", "Тест", "Содержимое"));
+    }
+    
+    ASSERT_TRUE(std::filesystem::exists("test_stores/main/notes_metadata.dat"));
+    ASSERT_FALSE(std::filesystem::exists("notes_metadata.dat"));
+    
+    {
+        NoteManager manager("test_stores/main");
+        manager.loadFromFile();
+        ASSERT_EQUAL(manager.getNoteCount(), 1);
+        ASSERT_EQUAL(manager.getNote(1)->content, std::string("Содержимое"));
+    }
+    
+    cleanupTestData();
+}
+
+TEST(test_sharded_global_ids) {
+    cleanupTestData();
+    std::filesystem::create_directory("test_stores");
+    std::vector<std::string> roots = {"test_stores/a", "test_stores/b", "test_stores/c"};
+    
+    {
+        ShardedNoteManager manager(roots);
+        for (int i = 0; i < 30; i++) {
+            std::string category = (i % 3 == 0) ? "Работа" : "Быт";
+            ASSERT_TRUE(manager.addNote("Заметка " + std::to_string(i), category, "Текст " + std::to_string(i)));
+        }
+        // Названия уникальны во всем хранилище
+        ASSERT_FALSE(manager.addNote("Заметка 5", "Тест", "Дубликат"));
+        ASSERT_EQUAL(manager.getNoteCount(), 30);
+        
+        // Каждая заметка лежит в своем шарде, все шарды заняты
+        for (size_t i = 0; i < manager.shardCount(); i++) {
+            ASSERT_TRUE(manager.shard(i).getNoteCount() > 0);
+        }
+        for (int id = 1; id <= 30; id++) {
+            ASSERT_TRUE(manager.shard(manager.shardOf(id)).noteExists(id));
+        }
+        
+        ASSERT_TRUE(manager.deleteNote(4));
+    }
+    
+    {
+        ShardedNoteManager manager(roots);
+        manager.loadFromFile();
+        ASSERT_EQUAL(manager.getNoteCount(), 29);
+        ASSERT_FALSE(manager.noteExists(4));
+        
+        std::vector<int> ids = manager.findByCategory("Работа");
+        ASSERT_EQUAL(ids.size(), 9);
+        ASSERT_EQUAL(ids[0], 1);
+        ASSERT_EQUAL(ids[1], 7);
+        ASSERT_EQUAL(ids[8], 28);
+        
+        ASSERT_EQUAL(manager.findByContent("Текст 1").size(), 11);
+        ASSERT_EQUAL(manager.suggestTitles("заметка 2").size(), 10);
+        
+        // Новые ID продолжают общее пространство
+        ASSERT_TRUE(manager.addNote("Новая", "Тест", "Текст"));
+        ASSERT_TRUE(manager.noteExists(31));
+    }
+    
+    // Другое число или порядок директорий отклоняются: ID ушли бы не в свой шард
+    auto opens = [](const std::vector<std::string>& shardRoots) {
+        try {
+            ShardedNoteManager manager(shardRoots);
+            return true;
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+    };
+    ASSERT_FALSE(opens({"test_stores/a", "test_stores/b"}));
+    ASSERT_FALSE(opens({"test_stores/a", "test_stores/b", "test_stores/c", "test_stores/d"}));
+    ASSERT_FALSE(opens({"test_stores/b", "test_stores/a", "test_stores/c"}));
+    // Хранилища не открываются до проверки: в новом корне ничего не создано
+    ASSERT_FALSE(std::filesystem::exists("test_stores/d"));
+    ASSERT_TRUE(opens(roots));
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ ДЛЯ АРХИВОВ =====
+
+TEST(test_crc32_known_value) {
+    ASSERT_EQUAL(crc32String("123456789"), 0xCBF43926u);
+    ASSERT_EQUAL(crc32String(""), 0u);
+    // Накопление по частям дает тот же результат
+    ASSERT_EQUAL(crc32String("6789", crc32String("12345")), 0xCBF43926u);
+}
+
+// Экспорт хранилища и восстановление в пустое хранилище
+void checkArchiveRoundtrip(bool compress) {
+    cleanupTestData();
+    
+    int64_t createdAt = 0;
+    {
+        NoteManager manager;
+        manager.addNote("Первая", "Работа", "Текст первой заметки\nс двумя строками\n");
+        manager.addNote("Вторая", "Быт", std::string(5000, 'x'));
+        manager.addNote("Третья", "Работа", "Текст");
+        manager.deleteNote(2);
+        createdAt = manager.getNote(1)->createdAt;
+        ASSERT_TRUE(manager.exportArchive("test_archive.tma", compress));
+    }
+    
+    std::error_code ec;
+    std::filesystem::remove("notes_metadata.dat", ec);
+    std::filesystem::remove_all("notes", ec);
+    
+    {
+        NoteManager manager;
+        ASSERT_TRUE(manager.importArchive("test_archive.tma"));
+        ASSERT_EQUAL(manager.getNoteCount(), 2);
+        ASSERT_EQUAL(manager.getNote(1)->content, std::string("Текст первой заметки\nс двумя строками\n"));
+        ASSERT_EQUAL(manager.getNote(3)->category, std::string("Работа"));
+        ASSERT_FALSE(manager.noteExists(2));
+        ASSERT_EQUAL(manager.getNote(1)->createdAt, createdAt);
+        // Новые ID не пересекаются с восстановленными
+        ASSERT_TRUE(manager.addNote("Четвертая", "Тест", "Текст"));
+        ASSERT_TRUE(manager.noteExists(4));
+    }
+    
+    {
+        NoteManager manager;
+        manager.loadFromFile();
+        ASSERT_EQUAL(manager.getNoteCount(), 3);
+        ASSERT_EQUAL(manager.getNote(3)->content, std::string("Текст"));
+    }
+    
+    cleanupTestData();
+}
+
+TEST(test_archive_roundtrip) {
+    checkArchiveRoundtrip(false);
+}
+
+TEST(test_archive_roundtrip_compressed) {
+    if (!archiveCompressionAvailable()) {
+        return;
+    }
+    checkArchiveRoundtrip(true);
+}
+
+TEST(test_archive_corruption_detected) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.addNote("Заметка", "Тест", "Содержимое, которое будет повреждено");
+        ASSERT_TRUE(manager.exportArchive("test_archive.tma"));
+    }
+    
+    // Портим один байт в тексте заметки
+    {
+        std::fstream file("test_archive.tma", std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-20, std::ios::end);
+        file.put('#');
+    }
+    
+    std::error_code ec;
+    std::filesystem::remove("notes_metadata.dat", ec);
+    std::filesystem::remove_all("notes", ec);
+    
+    NoteManager manager;
+    ASSERT_FALSE(manager.importArchive("test_archive.tma"));
+    ASSERT_EQUAL(manager.getNoteCount(), 0);
+    
+    cleanupTestData();
+}
+
+TEST(test_archive_invalid_records_skipped) {
+    cleanupTestData();
+    
+    // Записи с верной контрольной суммой, но недопустимыми полями
+    {
+        ArchiveWriter writer("test_archive.tma", false);
+        Note note;
+        note.id = 1;
+        note.title = "Верная";
+        note.category = "Тест";
+        note.creationDate = "2025-01-01";
+        note.content = "Текст";
+        writer.add(note);
+        
+        Note bad = note;
+        bad.id = 0;
+        bad.title = "Нулевой ID";
+        writer.add(bad);
+        bad.id = 3;
+        bad.title = "   ";
+        writer.add(bad);
+        bad.id = 4;
+        bad.title = "Длинный текст";
+        bad.content = std::string(MAX_CONTENT_LENGTH + 1, 'x');
+        writer.add(bad);
+        bad.id = 5;
+        bad.title = "Плохой UTF-8";
+        bad.content = "\xC3\x28";
+        writer.add(bad);
+        bad.id = 6;
+        bad.title = "Много меток";
+        bad.content = "Текст";
+        for (size_t i = 0; i <= MAX_TAGS_PER_NOTE; i++) {
+            bad.tags.push_back("метка" + std::to_string(i));
+        }
+        writer.add(bad);
+        writer.finish();
+    }
+    
+    NoteManager manager;
+    ASSERT_TRUE(manager.importArchive("test_archive.tma"));
+    ASSERT_EQUAL(manager.getNoteCount(), 1);
+    ASSERT_TRUE(manager.noteExists(1));
+    ASSERT_EQUAL(manager.getNextId(), 2);
+    
+    // ID из корзины тоже занят
+    manager.setDeleteMode(DeleteMode::Trash);
+    ASSERT_TRUE(manager.deleteNote(1));
+    ASSERT_TRUE(manager.importArchive("test_archive.tma"));
+    ASSERT_EQUAL(manager.getNoteCount(), 0);
+    ASSERT_EQUAL(manager.undoDelete(), 1);
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ ФОРМАТА МЕТАДАННЫХ =====
+
+TEST(test_metadata_escape_roundtrip) {
+    std::string original = "a|b\\c\nd\re\\p";
+    std::string escaped = escapeMetadataField(original);
+    ASSERT_TRUE(escaped.find('|') == std::string::npos);
+    ASSERT_TRUE(escaped.find('\n') == std::string::npos);
+    
+    std::string restored;
+    ASSERT_TRUE(unescapeMetadataField(escaped, restored));
+    ASSERT_EQUAL(restored, original);
+    ASSERT_FALSE(unescapeMetadataField("abc\\", restored));
+    ASSERT_FALSE(unescapeMetadataField("\\x", restored));
+}
+
+TEST(test_title_with_separator_roundtrip) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        ASSERT_TRUE(manager.addNote("Доходы | расходы", "Финансы|2024", "Текст"));
+    }
+    
+    NoteManager manager;
+    LoadReport report = manager.loadFromFile();
+    ASSERT_EQUAL(report.loaded, 1);
+    ASSERT_EQUAL(report.skipped, 0);
+    const Note* note = manager.getNote(1);
+    ASSERT_TRUE(note != nullptr);
+    ASSERT_EQUAL(note->title, "Доходы | расходы");
+    ASSERT_EQUAL(note->category, "Финансы|2024");
+    ASSERT_EQUAL(note->content, "Текст");
+    
+    cleanupTestData();
+}
+
+TEST(test_corrupt_record_skipped) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.addNote("Первая", "Тест", "Один");
+        manager.addNote("Вторая", "Тест", "Два");
+        manager.addNote("Третья", "Тест", "Три");
+    }
+    
+    // Портим один байт во второй записи и добавляем мусорную строку
+    std::string data;
+    ASSERT_TRUE(readWholeFile("notes_metadata.dat", data));
+    size_t pos = data.find("Вторая");
+    ASSERT_TRUE(pos != std::string::npos);
+    data[pos + 1] ^= 1;
+    data += "abc|мусор\n";
+    // Короткая запись с верной контрольной суммой тоже отбрасывается
+    char crc[16];
+    std::snprintf(crc, sizeof(crc), "|%08x", crc32String("7|x"));
+    data += std::string("7|x") + crc + "\n";
+    {
+        std::ofstream file("notes_metadata.dat", std::ios::binary);
+        file << data;
+    }
+    
+    {
+        // Строгий режим не загружает ничего
+        NoteManager manager;
+        bool thrown = false;
+        try {
+            manager.loadFromFile(LoadMode::Strict);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        ASSERT_TRUE(thrown);
+        ASSERT_EQUAL(manager.getNoteCount(), 0);
+    }
+    
+    NoteManager manager;
+    LoadReport report = manager.loadFromFile();
+    ASSERT_EQUAL(report.loaded, 2);
+    ASSERT_EQUAL(report.skipped, 3);
+    ASSERT_EQUAL(report.errors.size(), size_t(3));
+    ASSERT_TRUE(manager.noteExists(1));
+    ASSERT_FALSE(manager.noteExists(2));
+    ASSERT_FALSE(manager.noteExists(7));
+    ASSERT_TRUE(manager.noteExists(3));
+    ASSERT_EQUAL(manager.getNextId(), 4);
+    
+    // Отброшенные строки сохранены для ручного восстановления
+    std::string rejected;
+    ASSERT_TRUE(readWholeFile("notes_metadata.dat.rejected", rejected));
+    ASSERT_TRUE(rejected.find("abc|мусор") != std::string::npos);
+    
+    // Записи с 1–4 полями и верной суммой отклоняются без чтения за границей
+    for (const char* body : {"7", "7|x", "7|x|y", "7|x|y|z"}) {
+        std::snprintf(crc, sizeof(crc), "|%08x", crc32String(body));
+        Note parsed;
+        std::string reason;
+        ASSERT_FALSE(parseMetadataRecord(std::string(body) + crc, 2, parsed, reason));
+        ASSERT_EQUAL(reason, "неверное число полей");
+    }
+    
+    cleanupTestData();
+}
+
+TEST(test_legacy_metadata_loaded) {
+    cleanupTestData();
+    
+    std::filesystem::create_directory("notes");
+    {
+        std::ofstream note("notes/5_Старая.txt");
+        note << "Название: Старая\nТема: Архив\nДата: 2020-01-01\n\nТекст";
+        std::ofstream metadata("notes_metadata.dat");
+        metadata << "5|Старая|Архив|2020-01-01|notes/5_Старая.txt\n";
+        metadata << "x|Битая|Архив|2020-01-01|notes/x.txt\n";
+    }
+    
+    NoteManager manager;
+    LoadReport report = manager.loadFromFile();
+    ASSERT_EQUAL(report.loaded, 1);
+    ASSERT_EQUAL(report.skipped, 1);
+    ASSERT_EQUAL(manager.getNote(5)->content, "Текст");
+    ASSERT_EQUAL(manager.getNextId(), 6);
+    
+    // Следующее сохранение переводит файл в формат версии 2
+    manager.addNote("Новая", "Архив", "");
+    std::string data;
+    ASSERT_TRUE(readWholeFile("notes_metadata.dat", data));
+    ASSERT_EQUAL(data.compare(0, METADATA_HEADER_V2.size(), METADATA_HEADER_V2), 0);
+    
+    cleanupTestData();
+}
+
+TEST(test_verify_store) {
+    cleanupTestData();
+    
+    NoteManager manager;
+    for (int i = 0; i < 20; i++) {
+        manager.addNote("Заметка " + std::to_string(i), "Тест", "Текст");
+    }
+    FsckReport clean = manager.verifyStore(2);
+    ASSERT_TRUE(clean.ok());
+    ASSERT_EQUAL(clean.records, 20);
+    
+    // Удаленный файл, лишний файл и измененный заголовок
+    std::filesystem::remove(manager.getNote(3)->filePath);
+    {
+        std::ofstream orphan("notes/999_Лишний.txt");
+        orphan << "Название: Лишний\n";
+        std::ofstream renamed(manager.getNote(7)->filePath);
+        renamed << "Название: Другое\n";
+    }
+    
+    FsckReport report = manager.verifyStore(2);
+    ASSERT_FALSE(report.ok());
+    ASSERT_EQUAL(report.badRecords, 0);
+    ASSERT_EQUAL(report.missingFiles, 1);
+    ASSERT_EQUAL(report.titleMismatches, 1);
+    ASSERT_EQUAL(report.orphanFiles.size(), size_t(1));
+    ASSERT_EQUAL(report.problems.size(), size_t(3));
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ СВЕРКИ С ФАЙЛАМИ =====
+
+// Имя файла заметки внутри директории notes/
+static std::string noteFileName(const NoteManager& manager, int id) {
+    return std::filesystem::path(manager.getNote(id)->filePath).filename().string();
+}
+
+TEST(test_reconcile_external_edit) {
+    cleanupTestData();
+    
+    NoteManager manager;
+    manager.addNote("Список", "Дом", "Хлеб");
+    manager.addNote("План", "Работа", "Отчет");
+    
+    {
+        std::ofstream file(manager.getNote(1)->filePath);
+        file << "Название: Покупки\nТема: Магазин\nДата: 2024-05-01\n\nХлеб, молоко";
+    }
+    
+    WatchBatch batch;
+    batch.files.insert(noteFileName(manager, 1));
+    batch.files.insert("не_заметка.txt");
+    ASSERT_EQUAL(manager.reconcile(batch), 1);
+    
+    const Note* note = manager.getNote(1);
+    ASSERT_EQUAL(note->title, "Покупки");
+    ASSERT_EQUAL(note->content, "Хлеб, молоко");
+    ASSERT_FALSE(manager.titleExists("Список"));
+    ASSERT_EQUAL(manager.suggestTitles("пок").size(), size_t(1));
+    ASSERT_EQUAL(manager.findByCategory("Магазин").size(), size_t(1));
+    ASSERT_EQUAL(manager.findByDateRange("2024-05-01", "2024-05-01").size(), size_t(1));
+    
+    // Повторный пакет ничего не меняет
+    ASSERT_EQUAL(manager.reconcile(batch), 0);
+    
+    // Метаданные сохранены
+    NoteManager reloaded;
+    reloaded.loadFromFile();
+    ASSERT_TRUE(reloaded.titleExists("Покупки"));
+    
+    cleanupTestData();
+}
+
+TEST(test_reconcile_external_delete) {
+    cleanupTestData();
+    
+    NoteManager manager;
+    manager.addNote("Первая", "Тест", "Один");
+    manager.addNote("Вторая", "Тест", "Два");
+    
+    WatchBatch batch;
+    batch.files.insert(noteFileName(manager, 2));
+    std::filesystem::remove(manager.getNote(2)->filePath);
+    
+    ASSERT_EQUAL(manager.reconcile(batch), 1);
+    ASSERT_FALSE(manager.noteExists(2));
+    ASSERT_FALSE(manager.titleExists("Вторая"));
+    ASSERT_EQUAL(manager.getNoteCount(), 1);
+    ASSERT_EQUAL(manager.reconcile(batch), 0);
+    
+    // Полная сверка после переполнения очереди событий
+    std::filesystem::remove(manager.getNote(1)->filePath);
+    WatchBatch overflow;
+    overflow.overflow = true;
+    ASSERT_EQUAL(manager.reconcile(overflow), 1);
+    ASSERT_EQUAL(manager.getNoteCount(), 0);
+    
+    cleanupTestData();
+}
+
+TEST(test_watcher_batches_burst) {
+    cleanupTestData();
+    
+    NoteManager manager;
+    for (int i = 0; i < 10; i++) {
+        manager.addNote("Заметка " + std::to_string(i), "Тест", "Текст");
+    }
+    
+    NoteWatcher watcher(manager.getNotesDir(), std::chrono::milliseconds(100));
+    if (!watcher.active()) {
+        // inotify недоступен - проверять нечего
+        cleanupTestData();
+        return;
+    }
+    
+    // Серия перезаписей одних и тех же файлов приходит одним пакетом
+    for (int round = 0; round < 5; round++) {
+        for (int id = 1; id <= 10; id++) {
+            std::ofstream file(manager.getNote(id)->filePath);
+            file << "Название: Заметка " << (id - 1) << "\nТема: Тест\nДата: "
+                 << manager.getNote(id)->creationDate << "\n\nВерсия " << round;
+        }
+    }
+    
+    WatchBatch batch;
+    ASSERT_TRUE(watcher.waitBatch(batch, std::chrono::milliseconds(3000)));
+    ASSERT_EQUAL(batch.files.size(), size_t(10));
+    WatchBatch extra;
+    ASSERT_FALSE(watcher.takeBatch(extra));
+    
+    ASSERT_EQUAL(manager.reconcile(batch), 10);
+    ASSERT_EQUAL(manager.getNote(4)->content, "Версия 4");
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ СНИМКА ИНДЕКСОВ =====
+
+TEST(test_snapshot_roundtrip) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.addNote("Покупки", "Дом", "Хлеб");
+        manager.addNote("Отчет", "Работа", "Квартал");
+        manager.addNote("План", "Работа", "Задачи");
+        manager.deleteNote(2);
+        ASSERT_TRUE(manager.saveSnapshot());
+    }
+    
+    NoteManager manager;
+    LoadReport report = manager.loadFromFile();
+    ASSERT_TRUE(report.fromSnapshot);
+    ASSERT_EQUAL(report.loaded, 2);
+    ASSERT_EQUAL(report.refreshed, 0);
+    ASSERT_EQUAL(manager.getNextId(), 4);
+    ASSERT_EQUAL(manager.getNote(3)->content, "Задачи");
+    ASSERT_EQUAL(manager.findNoteIndex(3), 1);
+    
+    // Индексы восстановлены без перестроения
+    ASSERT_EQUAL(manager.suggestTitles("по").size(), size_t(1));
+    ASSERT_EQUAL(manager.fuzzySearchTitles("Плна", 2).size(), size_t(1));
+    ASSERT_EQUAL(manager.fuzzySearchCategories("работ", 1).size(), size_t(1));
+    ASSERT_EQUAL(manager.findByCategory("Работа").size(), size_t(1));
+    ASSERT_EQUAL(manager.findByDateRange("2000-01-01", "2100-01-01").size(), size_t(2));
+    
+    // Индексы после восстановления продолжают обновляться
+    ASSERT_TRUE(manager.addNote("Поездка", "Дом", "Билеты"));
+    ASSERT_EQUAL(manager.suggestTitles("по").size(), size_t(2));
+    ASSERT_EQUAL(manager.findByCategory("Дом").size(), size_t(2));
+    
+    cleanupTestData();
+}
+
+TEST(test_snapshot_applies_delta) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.addNote("Первая", "Тест", "Один");
+        manager.addNote("Вторая", "Тест", "Два");
+        manager.addNote("Третья", "Тест", "Три");
+        ASSERT_TRUE(manager.saveSnapshot());
+    }
+    
+    {
+        // Сеанс без сохранения снимка (например, аварийное завершение)
+        NoteManager manager;
+        manager.loadFromFile();
+        manager.deleteNote(1);
+        manager.updateNote(2, "Вторая новая", "Другая", "Два");
+        manager.updateNote(3, "Третья", "Тест", "Три с половиной");
+        manager.addNote("Четвертая", "Тест", "Четыре");
+    }
+    
+    NoteManager manager;
+    LoadReport report = manager.loadFromFile();
+    ASSERT_TRUE(report.fromSnapshot);
+    ASSERT_EQUAL(report.loaded, 3);
+    ASSERT_EQUAL(report.refreshed, 3);
+    ASSERT_FALSE(manager.noteExists(1));
+    ASSERT_FALSE(manager.titleExists("Вторая"));
+    ASSERT_TRUE(manager.titleExists("Вторая новая"));
+    ASSERT_EQUAL(manager.getNote(3)->content, "Три с половиной");
+    ASSERT_EQUAL(manager.getNote(4)->content, "Четыре");
+    ASSERT_EQUAL(manager.findByCategory("Другая").size(), size_t(1));
+    ASSERT_EQUAL(manager.findByCategory("Тест").size(), size_t(2));
+    ASSERT_EQUAL(manager.suggestTitles("вт").size(), size_t(1));
+    ASSERT_EQUAL(manager.getNextId(), 5);
+    
+    // Порядок заметок - как в файле метаданных
+    ASSERT_EQUAL(manager.findNoteIndex(2), 0);
+    ASSERT_EQUAL(manager.findNoteIndex(4), 2);
+    
+    cleanupTestData();
+}
+
+TEST(test_snapshot_corrupt_fallback) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.addNote("Заметка", "Тест", "Текст");
+        ASSERT_TRUE(manager.saveSnapshot());
+    }
+    
+    {
+        std::fstream file("notes_metadata.dat.snap", std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-5, std::ios::end);
+        file.put('#');
+    }
+    
+    NoteManager manager;
+    LoadReport report = manager.loadFromFile();
+    ASSERT_FALSE(report.fromSnapshot);
+    ASSERT_EQUAL(report.loaded, 1);
+    ASSERT_EQUAL(manager.getNote(1)->content, "Текст");
+    
+    cleanupTestData();
+}
+
+TEST(test_snapshot_sees_in_place_edits) {
+    cleanupTestData();
+    
+    std::string path;
+    {
+        NoteManager manager;
+        manager.addNote("Первая", "Тест", "Один");
+        manager.addNote("Вторая", "Тест", "Два");
+        path = manager.getNote(2)->filePath;
+        ASSERT_TRUE(manager.saveSnapshot());
+    }
+    
+    // Файл перезаписан "на месте" (старый формат с текстом после заголовка):
+    // время изменения директории прежнее, поколение метаданных совпадает
+    auto dirTime = std::filesystem::last_write_time("notes");
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "Название: Вторая\nТема: Тест\nДата: 2026-01-01\n\nДва, исправлено редактором\n";
+    }
+    ASSERT_TRUE(std::filesystem::last_write_time("notes") == dirTime);
+    
+    NoteManager manager;
+    LoadReport report = manager.loadFromFile();
+    ASSERT_TRUE(report.fromSnapshot);
+    ASSERT_EQUAL(report.refreshed, 1);
+    ASSERT_EQUAL(manager.getNote(1)->content, "Один");
+    ASSERT_EQUAL(manager.getNote(2)->content, "Два, исправлено редактором\n");
+    ASSERT_EQUAL(manager.findByContent("исправлено").size(), size_t(1));
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ ВРЕМЕНИ СОЗДАНИЯ =====
+
+// Момент местного времени в микросекундах
+static int64_t localTimestampUs(int year, int month, int day, int hour, int minute, int second) {
+    std::tm local = {};
+    local.tm_year = year - 1900;
+    local.tm_mon = month - 1;
+    local.tm_mday = day;
+    local.tm_hour = hour;
+    local.tm_min = minute;
+    local.tm_sec = second;
+    local.tm_isdst = -1;
+    return static_cast<int64_t>(std::mktime(&local)) * 1000000;
+}
+
+TEST(test_local_date_day_boundary) {
+    ASSERT_EQUAL(localDate(localTimestampUs(2024, 2, 29, 12, 0, 0)), "2024-02-29");
+    
+    // Кэш обновляется при переходе через полночь в обе стороны
+    int64_t lastSecond = localTimestampUs(2024, 12, 31, 23, 59, 59);
+    ASSERT_EQUAL(localDate(lastSecond), "2024-12-31");
+    ASSERT_EQUAL(localDate(lastSecond + 999999), "2024-12-31");
+    ASSERT_EQUAL(localDate(lastSecond + 1000000), "2025-01-01");
+    ASSERT_EQUAL(localDate(lastSecond), "2024-12-31");
+    
+    ASSERT_EQUAL(currentDate(), getCurrentDate());
+    
+    // Время по одной дате (старые архивы) - начало тех же суток
+    int64_t midnight = dateTimestamp("2024-02-29");
+    ASSERT_EQUAL(midnight, localTimestampUs(2024, 2, 29, 0, 0, 0));
+    ASSERT_EQUAL(localDate(midnight), "2024-02-29");
+    ASSERT_EQUAL(dateTimestamp("29.02.2024"), int64_t(0));
+    ASSERT_EQUAL(dateTimestamp("2024-02-29x"), int64_t(0));
+}
+
+TEST(test_current_date_concurrent) {
+    // Ожидаемая дата вычисляется независимо от кэша
+    std::time_t now = std::time(nullptr);
+    std::tm local;
+    localtime_r(&now, &local);
+    char expected[32];
+    std::snprintf(expected, sizeof(expected), "%04d-%02d-%02d",
+                  local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+    
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 20000; i++) {
+                // Потоки чередуют текущую дату и даты в прошлом, сбивая кэш
+                if (i % 100 == t) {
+                    if (localDate(localTimestampUs(2020, 1 + t, 10, 8, 0, 0)).compare(0, 5, "2020-") != 0) {
+                        mismatches++;
+                    }
+                } else if (currentDate() != expected) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    
+    // Полночь могла наступить во время теста
+    std::time_t after = std::time(nullptr);
+    localtime_r(&after, &local);
+    if (local.tm_mday == std::atoi(expected + 8)) {
+        ASSERT_EQUAL(mismatches.load(), 0);
+    }
+}
+
+TEST(test_created_timestamp_persisted) {
+    cleanupTestData();
+    
+    int64_t before = currentTimestampUs();
+    int64_t createdAt = 0;
+    {
+        NoteManager manager;
+        manager.addNote("Заметка", "Тест", "Текст");
+        createdAt = manager.getNote(1)->createdAt;
+        ASSERT_TRUE(createdAt >= before);
+        ASSERT_TRUE(createdAt <= currentTimestampUs());
+        ASSERT_EQUAL(manager.getNote(1)->creationDate, localDate(createdAt));
+    }
+    
+    {
+        NoteManager manager;
+        manager.loadFromFile();
+        ASSERT_EQUAL(manager.getNote(1)->createdAt, createdAt);
+        ASSERT_TRUE(manager.saveSnapshot());
+    }
+    
+    NoteManager manager;
+    ASSERT_TRUE(manager.loadFromFile().fromSnapshot);
+    ASSERT_EQUAL(manager.getNote(1)->createdAt, createdAt);
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ ПРОВЕРКИ UTF-8 =====
+
+// Эталон: посимвольное декодирование (символ замены допустим только как U+FFFD в тексте)
+static bool referenceUtf8Length(std::string_view text, size_t& length) {
+    size_t pos = 0;
+    length = 0;
+    while (pos < text.size()) {
+        size_t start = pos;
+        if (decodeUtf8Char(text, pos) == UTF8_REPLACEMENT && text.substr(start, 3) != "\xEF\xBF\xBD") {
+            return false;
+        }
+        length++;
+    }
+    return true;
+}
+
+TEST(test_utf8_length_kernels_match_reference) {
+    std::mt19937 rng(38);
+    const char32_t samples[] = {U'a', U' ', U'я', U'Ё', U'€', U'�', U'\U0001F600', U'\U0010FFFF', U'߿', U'ࠀ'};
+    
+    // Корректные строки разной длины и их порча в случайных местах
+    std::vector<std::string> inputs = {
+        "", "abc", "\xC0\x80", "\xE0\x80\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xF5\x80\x80\x80",
+        "\x80", "\xD0", "abc\xE2\x82", "\xF0\x9F\x98"
+    };
+    for (int i = 0; i < 400; i++) {
+        std::string text;
+        size_t count = rng() % 70;
+        for (size_t j = 0; j < count; j++) {
+            appendUtf8(text, samples[rng() % (sizeof(samples) / sizeof(samples[0]))]);
+        }
+        inputs.push_back(text);
+        if (!text.empty()) {
+            std::string broken = text;
+            broken[rng() % broken.size()] = static_cast<char>(rng() % 256);
+            inputs.push_back(broken);
+            inputs.push_back(text.substr(0, rng() % text.size()));
+        }
+    }
+    
+    // Незавершенная последовательность точно на границе блоков 16 и 32 байт
+    for (size_t boundary : {15, 16, 31, 32, 33}) {
+        inputs.push_back(std::string(boundary, 'x') + "\xD0");
+        inputs.push_back(std::string(boundary, 'x') + "\xD0" + std::string(40, 'y'));
+        inputs.push_back(std::string(boundary, 'x') + "\xE2\x82\xAC" + std::string(40, 'y'));
+    }
+    
+    const ScanLevel levels[] = {ScanLevel::Scalar, ScanLevel::SSE42, ScanLevel::AVX2};
+    ScanLevel original = getScanLevel();
+    for (ScanLevel level : levels) {
+        setScanLevel(level);
+        for (const std::string& input : inputs) {
+            size_t expected = 0;
+            size_t actual = 0;
+            bool valid = referenceUtf8Length(input, expected);
+            ASSERT_EQUAL(utf8Length(input, actual), valid);
+            if (valid) {
+                ASSERT_EQUAL(actual, expected);
+            }
+        }
+    }
+    setScanLevel(original);
+}
+
+TEST(test_validation_counts_characters) {
+    // Ограничения считаются в символах: 100 кириллических букв - это 200 байт
+    std::string title;
+    for (int i = 0; i < 100; i++) {
+        title += "ж";
+    }
+    ASSERT_TRUE(checkNoteTitle(title) == ValidationError::None);
+    ASSERT_TRUE(validateNoteTitle(title));
+    ASSERT_TRUE(checkNoteTitle(title + "ж") == ValidationError::TooLong);
+    
+    std::string category;
+    for (int i = 0; i < 50; i++) {
+        category += "т";
+    }
+    ASSERT_TRUE(checkNoteCategory(category) == ValidationError::None);
+    ASSERT_TRUE(checkNoteCategory(category + "т") == ValidationError::TooLong);
+    
+    std::string content;
+    for (int i = 0; i < 10000; i++) {
+        content += "ы";
+    }
+    ASSERT_TRUE(checkNoteContent(content) == ValidationError::None);
+    ASSERT_TRUE(checkNoteContent(content + "ы") == ValidationError::TooLong);
+    
+    ASSERT_TRUE(checkNoteTitle("") == ValidationError::Empty);
+    ASSERT_TRUE(checkNoteTitle(" \t ") == ValidationError::OnlySpaces);
+    ASSERT_TRUE(checkNoteCategory("Раб\xFFота") == ValidationError::InvalidUtf8);
+    ASSERT_TRUE(checkNoteContent("Обрезано \xD0") == ValidationError::InvalidUtf8);
+    ASSERT_FALSE(validateNoteContent("Обрезано \xD0"));
+}
+
+// ===== ТЕСТЫ МЕТОК =====
+
+static std::vector<uint32_t> setToVector(const std::set<uint32_t>& values) {
+    return std::vector<uint32_t>(values.begin(), values.end());
+}
+
+TEST(test_roaring_bitmap_matches_set) {
+    std::mt19937 rng(39);
+    
+    // Плотные (больше 4096 значений в контейнере) и разреженные области
+    auto randomSet = [&rng](size_t denseCount, size_t sparseCount) {
+        std::set<uint32_t> values;
+        for (size_t i = 0; i < denseCount; i++) {
+            values.insert(rng() % 12000);
+        }
+        for (size_t i = 0; i < sparseCount; i++) {
+            values.insert(rng() % 5000000);
+        }
+        return values;
+    };
+    
+    for (int round = 0; round < 4; round++) {
+        std::set<uint32_t> a = randomSet(round % 2 == 0 ? 9000 : 100, 3000);
+        std::set<uint32_t> b = randomSet(round < 2 ? 9000 : 50, 3000);
+        RoaringBitmap bitmapA;
+        RoaringBitmap bitmapB;
+        for (uint32_t value : a) {
+            bitmapA.add(value);
+        }
+        for (uint32_t value : b) {
+            bitmapB.add(value);
+        }
+        ASSERT_EQUAL(bitmapA.cardinality(), uint64_t(a.size()));
+        ASSERT_TRUE(bitmapA.toVector() == setToVector(a));
+        
+        std::set<uint32_t> both, either, onlyA;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::inserter(both, both.end()));
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::inserter(either, either.end()));
+        std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::inserter(onlyA, onlyA.end()));
+        ASSERT_TRUE((bitmapA & bitmapB).toVector() == setToVector(both));
+        ASSERT_TRUE((bitmapA | bitmapB).toVector() == setToVector(either));
+        ASSERT_TRUE(bitmapA.andNot(bitmapB).toVector() == setToVector(onlyA));
+        ASSERT_EQUAL(bitmapA.andCardinality(bitmapB), uint64_t(both.size()));
+        
+        // Удаление переводит контейнер обратно в массив; результат совпадает с построенным заново
+        for (uint32_t value : b) {
+            ASSERT_EQUAL(bitmapA.remove(value), a.count(value) != 0);
+        }
+        ASSERT_FALSE(bitmapA.contains(*b.begin()));
+        RoaringBitmap rebuilt;
+        for (uint32_t value : onlyA) {
+            rebuilt.add(value);
+        }
+        ASSERT_TRUE(bitmapA == rebuilt);
+        
+        // Сохранение в снимок и восстановление
+        SnapshotWriter out;
+        bitmapB.save(out);
+        SnapshotReader in(out.data());
+        RoaringBitmap loaded;
+        loaded.load(in);
+        ASSERT_TRUE(in.atEnd());
+        ASSERT_TRUE(loaded == bitmapB);
+    }
+}
+
+TEST(test_tag_queries_and_counts) {
+    cleanupTestData();
+    
+    ASSERT_TRUE(parseTags(" Работа,срочно  РАБОТА ,") == std::vector<std::string>({"работа", "срочно"}));
+    TagQuery query = parseTagQuery("Работа AND срочно AND NOT архив -черновик");
+    ASSERT_TRUE(query.include == std::vector<std::string>({"работа", "срочно"}));
+    ASSERT_TRUE(query.exclude == std::vector<std::string>({"архив", "черновик"}));
+    
+    NoteManager manager;
+    manager.addNote("Отчет", "Работа", "Квартал", {"работа", "срочно"});
+    manager.addNote("Старый отчет", "Работа", "Прошлый год", {"работа", "срочно", "архив"});
+    manager.addNote("План", "Работа", "Задачи", {"Работа"});
+    manager.addNote("Покупки", "Дом", "Хлеб");
+    
+    ASSERT_TRUE(manager.findByTags(parseTagQuery("работа AND срочно")) == std::vector<int>({1, 2}));
+    ASSERT_TRUE(manager.findByTags(parseTagQuery("работа AND срочно AND NOT архив")) == std::vector<int>({1}));
+    ASSERT_TRUE(manager.findByTags(parseTagQuery("NOT работа")) == std::vector<int>({4}));
+    ASSERT_TRUE(manager.findByTags(parseTagQuery("работа неизвестная")).empty());
+    
+    std::vector<TagCount> counts = manager.tagCounts();
+    ASSERT_EQUAL(counts.size(), size_t(3));
+    ASSERT_EQUAL(counts[0].tag, "работа");
+    ASSERT_EQUAL(counts[0].count, uint64_t(3));
+    ASSERT_EQUAL(counts[1].tag, "срочно");
+    ASSERT_EQUAL(counts[2].tag, "архив");
+    
+    // Фасеты среди результатов запроса
+    std::vector<TagCount> facets = manager.tagCounts(parseTagQuery("архив"));
+    ASSERT_EQUAL(facets.size(), size_t(3));
+    ASSERT_EQUAL(facets[0].count, uint64_t(1));
+    
+    // Изменение меток, удаление заметки и повторная загрузка
+    ASSERT_TRUE(manager.setNoteTags(3, {"срочно"}));
+    ASSERT_TRUE(manager.findByTags(parseTagQuery("срочно NOT архив")) == std::vector<int>({1, 3}));
+    ASSERT_TRUE(manager.deleteNote(2));
+    ASSERT_EQUAL(manager.tagCounts().size(), size_t(2));
+    ASSERT_TRUE(manager.updateNote(1, "Отчет", "Работа", "Квартал и год"));
+    ASSERT_TRUE(manager.getNote(1)->tags == std::vector<std::string>({"работа", "срочно"}));
+    
+    NoteManager reloaded;
+    reloaded.loadFromFile();
+    ASSERT_TRUE(reloaded.getNote(3)->tags == std::vector<std::string>({"срочно"}));
+    ASSERT_TRUE(reloaded.findByTags(parseTagQuery("срочно")) == std::vector<int>({1, 3}));
+    
+    ASSERT_TRUE(checkNoteTags(parseTags("а,б,в")) == ValidationError::None);
+    ASSERT_TRUE(checkNoteTags(std::vector<std::string>(MAX_TAGS_PER_NOTE + 1, "x")) == ValidationError::TooMany);
+    ASSERT_TRUE(checkNoteTags({std::string(MAX_TAG_LENGTH + 1, 'x')}) == ValidationError::TooLong);
+    
+    cleanupTestData();
+}
+
+TEST(test_tags_in_snapshot_and_archive) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.addNote("Отчет", "Работа", "Квартал", {"работа", "срочно"});
+        manager.addNote("План", "Работа", "Задачи", {"работа"});
+        ASSERT_TRUE(manager.saveSnapshot());
+        ASSERT_TRUE(manager.exportArchive("test_archive.tma", true));
+    }
+    
+    {
+        NoteManager manager;
+        ASSERT_TRUE(manager.loadFromFile().fromSnapshot);
+        ASSERT_TRUE(manager.findByTags(parseTagQuery("работа NOT срочно")) == std::vector<int>({2}));
+        ASSERT_EQUAL(manager.tagCounts().size(), size_t(2));
+        
+        // Метки, измененные в сеансе без снимка, применяются как разница
+        ASSERT_TRUE(manager.setNoteTags(2, {"срочно"}));
+    }
+    
+    {
+        NoteManager manager;
+        manager.loadFromFile();
+        ASSERT_TRUE(manager.findByTags(parseTagQuery("срочно")) == std::vector<int>({1, 2}));
+    }
+    
+    // Архив переносит метки в новое хранилище
+    std::error_code ec;
+    std::filesystem::remove("notes_metadata.dat", ec);
+    std::filesystem::remove("notes_metadata.dat.snap", ec);
+    std::filesystem::remove_all("notes", ec);
+    NoteManager manager;
+    ASSERT_TRUE(manager.importArchive("test_archive.tma"));
+    ASSERT_TRUE(manager.getNote(1)->tags == std::vector<std::string>({"работа", "срочно"}));
+    ASSERT_TRUE(manager.findByTags(parseTagQuery("работа")) == std::vector<int>({1, 2}));
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ АГРЕГАЦИИ =====
+
+TEST(test_date_group_keys) {
+    ASSERT_EQUAL(dateGroupKey("2025-03-14", GroupBy::Day), "2025-03-14");
+    ASSERT_EQUAL(dateGroupKey("2025-03-14", GroupBy::Week), "2025-W11");
+    ASSERT_EQUAL(dateGroupKey("2025-03-14", GroupBy::Month), "2025-03");
+    ASSERT_EQUAL(dateGroupKey("2025-03-14", GroupBy::Year), "2025");
+    
+    // Недели на границе года относятся к году своего четверга
+    ASSERT_EQUAL(dateGroupKey("2021-01-03", GroupBy::Week), "2020-W53");
+    ASSERT_EQUAL(dateGroupKey("2024-12-30", GroupBy::Week), "2025-W01");
+    ASSERT_EQUAL(dateGroupKey("2026-01-01", GroupBy::Week), "2026-W01");
+    ASSERT_EQUAL(dateGroupKey("2025-13-01", GroupBy::Month), "");
+    ASSERT_EQUAL(dateGroupKey("нет даты", GroupBy::Week), "");
+    
+    GroupBy by;
+    ASSERT_TRUE(parseGroupBy("week", by));
+    ASSERT_TRUE(by == GroupBy::Week);
+    ASSERT_FALSE(parseGroupBy("quarter", by));
+}
+
+TEST(test_aggregates_incremental) {
+    NoteAggregates aggregates;
+    aggregates.add("Работа", "2025-03-10");
+    aggregates.add("Работа", "2025-03-16");
+    aggregates.add("Дом", "2025-03-17");
+    aggregates.add("Дом", "2025-04-01");
+    aggregates.add("Дом", "2025-04-01");
+    aggregates.remove("Дом", "2025-04-01");
+    
+    std::vector<GroupCount> weeks = aggregates.counts(GroupBy::Week);
+    ASSERT_EQUAL(weeks.size(), size_t(3));
+    ASSERT_EQUAL(weeks[0].key, "2025-W11");
+    ASSERT_EQUAL(weeks[0].count, uint64_t(2));
+    ASSERT_EQUAL(weeks[1].key, "2025-W12");
+    ASSERT_EQUAL(weeks[2].key, "2025-W14");
+    
+    std::vector<GroupCount> months = aggregates.counts(GroupBy::Month);
+    ASSERT_EQUAL(months.size(), size_t(2));
+    ASSERT_EQUAL(months[0].count, uint64_t(3));
+    
+    // Опустевшие группы исчезают
+    aggregates.remove("Дом", "2025-04-01");
+    ASSERT_EQUAL(aggregates.counts(GroupBy::Month).size(), size_t(1));
+    std::vector<GroupCount> categories = aggregates.counts(GroupBy::Category);
+    ASSERT_EQUAL(categories.size(), size_t(2));
+    ASSERT_EQUAL(categories[0].key, "Работа");
+    
+    SnapshotWriter out;
+    aggregates.save(out);
+    SnapshotReader in(out.data());
+    NoteAggregates loaded;
+    loaded.load(in);
+    ASSERT_TRUE(in.atEnd());
+    ASSERT_EQUAL(loaded.counts(GroupBy::Week).size(), size_t(2));
+    ASSERT_EQUAL(loaded.counts(GroupBy::Category)[1].count, uint64_t(1));
+}
+
+// Совпадение счетчиков с полным просмотром для всех группировок
+static bool aggregatesMatchScan(const NoteManager& manager) {
+    const GroupBy groupings[] = {GroupBy::Category, GroupBy::Day, GroupBy::Week, GroupBy::Month, GroupBy::Year};
+    for (GroupBy by : groupings) {
+        std::vector<GroupCount> counted = manager.countBy(by);
+        std::vector<GroupCount> scanned = manager.countBy(by, [](const Note&) { return true; }, 4);
+        if (counted.size() != scanned.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < counted.size(); i++) {
+            if (counted[i].key != scanned[i].key || counted[i].count != scanned[i].count) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+TEST(test_count_by_matches_scan) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.addNote("Отчет", "Работа", "Квартал");
+        manager.addNote("План", "Работа", "Задачи");
+        manager.addNote("Покупки", "Дом", "Хлеб");
+        manager.addNote("Ремонт", "Дом", "Краска");
+        manager.deleteNote(4);
+        manager.updateNote(2, "План", "Учеба", "Задачи");
+        ASSERT_TRUE(aggregatesMatchScan(manager));
+        
+        std::vector<GroupCount> categories = manager.countBy(GroupBy::Category);
+        ASSERT_EQUAL(categories.size(), size_t(3));
+        ASSERT_EQUAL(manager.countBy(GroupBy::Day).size(), size_t(1));
+        ASSERT_EQUAL(manager.countBy(GroupBy::Day)[0].count, uint64_t(3));
+        
+        // Произвольное условие - только полным просмотром
+        std::vector<GroupCount> filtered = manager.countBy(GroupBy::Category, [](const Note& note) {
+            return note.content.find("Хлеб") != std::string::npos;
+        });
+        ASSERT_EQUAL(filtered.size(), size_t(1));
+        ASSERT_EQUAL(filtered[0].key, "Дом");
+        ASSERT_TRUE(manager.saveSnapshot());
+    }
+    
+    // Счетчики восстанавливаются из снимка и при полной загрузке
+    NoteManager fromSnapshot;
+    ASSERT_TRUE(fromSnapshot.loadFromFile().fromSnapshot);
+    ASSERT_TRUE(aggregatesMatchScan(fromSnapshot));
+    std::filesystem::remove("notes_metadata.dat.snap");
+    NoteManager fromFiles;
+    fromFiles.loadFromFile();
+    ASSERT_TRUE(aggregatesMatchScan(fromFiles));
+    ASSERT_EQUAL(fromFiles.countBy(GroupBy::Category)[0].count, uint64_t(1));
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ ХРАНЕНИЯ ТЕКСТОВ =====
+
+TEST(test_content_hash_and_body_ref) {
+    std::string hash = contentHash("Текст заметки");
+    ASSERT_EQUAL(hash.size(), size_t(32));
+    ASSERT_EQUAL(hash, contentHash("Текст заметки"));
+    ASSERT_TRUE(hash != contentHash("Текст заметки."));
+    ASSERT_TRUE(contentHash("") != contentHash(std::string(1, '\0')));
+    
+    // Хеши коротких строк не совпадают
+    std::set<std::string> hashes;
+    for (int i = 0; i < 10000; i++) {
+        hashes.insert(contentHash(std::to_string(i)));
+    }
+    ASSERT_EQUAL(hashes.size(), size_t(10000));
+    
+    std::string parsed;
+    ASSERT_TRUE(parseNoteBodyRef("Название: А\nТема: Б\nДата: 2025-01-01\nТекст: " + hash + "\n", parsed));
+    ASSERT_EQUAL(parsed, hash);
+    ASSERT_FALSE(parseNoteBodyRef("Название: А\nТема: Б\nДата: 2025-01-01\n\nТекст: " + hash + "\n", parsed));
+    ASSERT_FALSE(parseNoteBodyRef("Название: А\nТема: Б\nДата: 2025-01-01\nТекст: " + hash + "\nеще", parsed));
+    ASSERT_FALSE(parseNoteBodyRef("Название: А\nТема: Б\nДата: 2025-01-01\nТекст: XYZ\n", parsed));
+}
+
+TEST(test_duplicate_bodies_stored_once) {
+    cleanupTestData();
+    
+    NoteManager manager;
+    std::string shared = "Повестка: отчет, сроки, бюджет";
+    manager.addNote("Встреча 1", "Работа", shared);
+    manager.addNote("Встреча 2", "Работа", shared);
+    manager.addNote("Встреча 3", "Работа", shared);
+    manager.addNote("Список", "Дом", "Хлеб");
+    
+    BodyStats stats = manager.bodyStats();
+    ASSERT_EQUAL(stats.uniqueBodies, uint64_t(2));
+    ASSERT_EQUAL(stats.references, uint64_t(4));
+    ASSERT_EQUAL(stats.savedBytes(), uint64_t(2 * shared.size()));
+    ASSERT_EQUAL(manager.getBodyStore().listHashes().size(), size_t(2));
+    std::string sharedHash = manager.getNote(1)->bodyHash;
+    ASSERT_EQUAL(manager.getBodyStore().refCount(sharedHash), uint32_t(3));
+    
+    // Поврежденный файл текста того же размера восстанавливается при записи
+    {
+        std::fstream file(manager.getBodyStore().pathOf(sharedHash), std::ios::in | std::ios::out | std::ios::binary);
+        file.put('#');
+    }
+    ASSERT_EQUAL(manager.getBodyStore().put(shared), sharedHash);
+    std::string repaired;
+    ASSERT_TRUE(manager.getBodyStore().read(sharedHash, repaired));
+    ASSERT_EQUAL(repaired, shared);
+    
+    // Удаление освобождает ссылку, файл текста живет до последней
+    ASSERT_TRUE(manager.deleteNote(1));
+    ASSERT_TRUE(manager.deleteNote(2));
+    ASSERT_TRUE(manager.getBodyStore().exists(sharedHash));
+    ASSERT_EQUAL(manager.getNote(3)->content, shared);
+    
+    // Изменение текста переводит заметку на новый текст, старый удаляется
+    ASSERT_TRUE(manager.updateNote(3, "Встреча 3", "Работа", "Итоги"));
+    ASSERT_FALSE(manager.getBodyStore().exists(sharedHash));
+    ASSERT_EQUAL(manager.getBodyStore().listHashes().size(), size_t(2));
+    
+    // Одинаковый текст после правки снова хранится один раз
+    ASSERT_TRUE(manager.updateNote(4, "Список", "Дом", "Итоги"));
+    ASSERT_EQUAL(manager.getBodyStore().listHashes().size(), size_t(1));
+    ASSERT_EQUAL(manager.bodyStats().references, uint64_t(2));
+    ASSERT_TRUE(manager.verifyStore(2).ok());
+    
+    cleanupTestData();
+}
+
+TEST(test_body_hash_collision_kept_inline) {
+    cleanupTestData();
+    
+    // Два разных текста с одинаковым contentHash (подобраны по блокам)
+    std::string first = "radA8?\?gKm=b0mF'";
+    std::string second = "X>l+cXkVv:0_T[zM";
+    ASSERT_TRUE(first != second);
+    ASSERT_EQUAL(contentHash(first), contentHash(second));
+    std::string hash = contentHash(first);
+    
+    {
+        NoteManager manager;
+        ASSERT_TRUE(manager.addNote("Первая", "Тест", first));
+        ASSERT_TRUE(manager.addNote("Вторая", "Тест", second));
+        
+        // Чужой текст под тем же хешем не перезаписан, второй лег в файл заметки
+        ASSERT_EQUAL(manager.getNote(1)->bodyHash, hash);
+        ASSERT_TRUE(manager.getNote(2)->bodyHash.empty());
+        std::string stored;
+        ASSERT_TRUE(manager.getBodyStore().read(hash, stored));
+        ASSERT_EQUAL(stored, first);
+        ASSERT_EQUAL(manager.getBodyStore().refCount(hash), uint32_t(1));
+        ASSERT_TRUE(manager.getBodyStore().put(second).empty());
+    }
+    
+    NoteManager manager;
+    manager.loadFromFile();
+    ASSERT_EQUAL(manager.getNote(1)->content, first);
+    ASSERT_EQUAL(manager.getNote(2)->content, second);
+    ASSERT_TRUE(manager.verifyStore(2).ok());
+    
+    // Удаление в корзину и восстановление второй заметки не трогают текст первой
+    manager.setDeleteMode(DeleteMode::Trash);
+    ASSERT_TRUE(manager.deleteNote(2));
+    ASSERT_TRUE(manager.restoreNote(2));
+    ASSERT_EQUAL(manager.getNote(2)->content, second);
+    ASSERT_EQUAL(manager.getNote(1)->content, first);
+    ASSERT_TRUE(manager.getBodyStore().exists(hash));
+    
+    cleanupTestData();
+}
+
+TEST(test_body_refs_rebuilt_on_load) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.addNote("Первая", "Тест", "Общий текст");
+        manager.addNote("Вторая", "Тест", "Общий текст");
+        manager.saveSnapshot();
+    }
+    
+    // Из снимка и полной загрузкой счетчики ссылок одинаковы
+    for (int fromSnapshot = 1; fromSnapshot >= 0; fromSnapshot--) {
+        if (!fromSnapshot) {
+            std::filesystem::remove("notes_metadata.dat.snap");
+        }
+        NoteManager manager;
+        LoadReport report = manager.loadFromFile();
+        ASSERT_EQUAL(report.fromSnapshot, fromSnapshot != 0);
+        ASSERT_EQUAL(manager.getNote(2)->content, "Общий текст");
+        ASSERT_EQUAL(manager.bodyStats().references, uint64_t(2));
+        ASSERT_EQUAL(manager.bodyStats().uniqueBodies, uint64_t(1));
+    }
+    
+    // Файл старого формата с текстом после заголовка читается и при правке
+    // редактором переносится в хранилище текстов
+    NoteManager manager;
+    manager.loadFromFile();
+    {
+        std::ofstream file(manager.getNote(1)->filePath);
+        file << "Название: Первая\nТема: Тест\nДата: " << manager.getNote(1)->creationDate
+             << "\n\nОбщий текст";
+    }
+    WatchBatch batch;
+    batch.files.insert(noteFileName(manager, 1));
+    ASSERT_EQUAL(manager.reconcile(batch), 0);
+    std::string data;
+    ASSERT_TRUE(readWholeFile(manager.getNote(1)->filePath, data));
+    std::string hash;
+    ASSERT_TRUE(parseNoteBodyRef(data, hash));
+    ASSERT_EQUAL(hash, manager.getNote(2)->bodyHash);
+    ASSERT_EQUAL(manager.bodyStats().references, uint64_t(2));
+    
+    // Проверка хранилища: пропавший и лишний тексты
+    std::filesystem::remove(manager.getBodyStore().pathOf(hash));
+    {
+        std::ofstream orphan(manager.getBodyStore().pathOf(contentHash("Лишний")));
+        orphan << "Лишний";
+    }
+    FsckReport report = manager.verifyStore(2);
+    ASSERT_FALSE(report.ok());
+    ASSERT_EQUAL(report.missingBodies, 2);
+    ASSERT_EQUAL(report.orphanBodies.size(), size_t(1));
+    ASSERT_EQUAL(report.missingFiles, 0);
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ КОРЗИНЫ =====
+
+TEST(test_trash_delete_and_undo) {
+    cleanupTestData();
+    
+    NoteManager manager;
+    manager.setDeleteMode(DeleteMode::Trash);
+    manager.addNote("Первая", "Тест", "Один");
+    manager.addNote("Вторая", "Тест", "Два");
+    manager.addNote("Третья", "Тест", "Три");
+    uint64_t generation = readMetadataGeneration("notes_metadata.dat");
+    std::string path = manager.getNote(2)->filePath;
+    
+    // Удаление не трогает ни файл заметки, ни метаданные
+    ASSERT_TRUE(manager.deleteNote(2));
+    ASSERT_FALSE(manager.noteExists(2));
+    ASSERT_FALSE(manager.titleExists("Вторая"));
+    ASSERT_EQUAL(manager.getNoteCount(), 2);
+    ASSERT_EQUAL(manager.findByCategory("Тест").size(), size_t(2));
+    ASSERT_TRUE(std::filesystem::exists(path));
+    ASSERT_EQUAL(readMetadataGeneration("notes_metadata.dat"), generation);
+    ASSERT_EQUAL(manager.getTrash().size(), size_t(1));
+    
+    ASSERT_EQUAL(manager.undoDelete(), 1);
+    ASSERT_EQUAL(manager.getNote(2)->content, "Два");
+    ASSERT_EQUAL(manager.suggestTitles("вто").size(), size_t(1));
+    ASSERT_TRUE(manager.getTrash().empty());
+    ASSERT_EQUAL(manager.undoDelete(), 0);
+    ASSERT_FALSE(manager.restoreNote(2));
+    
+    // Восстановление по ID, пока название не занято другой заметкой
+    ASSERT_TRUE(manager.deleteNote(1));
+    ASSERT_TRUE(manager.deleteNote(3));
+    ASSERT_TRUE(manager.restoreNote(1));
+    ASSERT_TRUE(manager.addNote("Третья", "Тест", "Новая"));
+    ASSERT_FALSE(manager.restoreNote(3));
+    ASSERT_EQUAL(manager.getTrash().size(), size_t(1));
+    
+    // Корзина переживает перезапуск
+    NoteManager reloaded;
+    reloaded.loadFromFile();
+    ASSERT_EQUAL(reloaded.getNoteCount(), 3);
+    ASSERT_EQUAL(reloaded.getTrash().size(), size_t(1));
+    ASSERT_EQUAL(reloaded.getTrash()[0].note.id, 3);
+    
+    cleanupTestData();
+}
+
+TEST(test_delete_by_category_and_purge) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.setDeleteMode(DeleteMode::Trash);
+        // Больше порога массового обновления индексов
+        for (int i = 0; i < 70; i++) {
+            manager.addNote("Старая " + std::to_string(i), "Архив", "Общий текст");
+        }
+        for (int i = 0; i < 5; i++) {
+            manager.addNote("Новая " + std::to_string(i), "Работа", "Текст " + std::to_string(i));
+        }
+        
+        // Вся тема - одна операция: одна отмена возвращает все заметки
+        ASSERT_EQUAL(manager.deleteByCategory("Архив"), 70);
+        ASSERT_EQUAL(manager.getNoteCount(), 5);
+        ASSERT_EQUAL(manager.countBy(GroupBy::Category).size(), size_t(1));
+        ASSERT_TRUE(manager.suggestTitles("стар").empty());
+        ASSERT_TRUE(manager.fuzzySearchCategories("Архив", 0).empty());
+        ASSERT_EQUAL(manager.undoDelete(), 70);
+        ASSERT_EQUAL(manager.findByCategory("Архив").size(), size_t(70));
+        ASSERT_EQUAL(manager.suggestTitles("стар", 100).size(), size_t(70));
+        ASSERT_EQUAL(manager.fuzzySearchTitles("Старая 5", 0).size(), size_t(1));
+        
+        ASSERT_EQUAL(manager.deleteByCategory("Архив"), 70);
+        ASSERT_TRUE(manager.deleteNote(71));
+        ASSERT_TRUE(manager.verifyStore(2).ok());
+        manager.saveSnapshot();
+    }
+    
+    // Снимок сделан после удаления, корзина восстанавливается из журнала
+    NoteManager manager;
+    ASSERT_TRUE(manager.loadFromFile().fromSnapshot);
+    ASSERT_EQUAL(manager.getNoteCount(), 4);
+    ASSERT_EQUAL(manager.getTrash().size(), size_t(71));
+    ASSERT_EQUAL(manager.bodyStats().references, uint64_t(75));
+    
+    // Без снимка записи из корзины, оставшиеся в метаданных, убираются из списка
+    {
+        std::filesystem::remove("notes_metadata.dat.snap");
+        NoteManager full;
+        full.loadFromFile();
+        ASSERT_EQUAL(full.getNoteCount(), 4);
+        ASSERT_TRUE(full.suggestTitles("стар").empty());
+        ASSERT_EQUAL(full.countBy(GroupBy::Category).size(), size_t(1));
+    }
+    
+    // Срок хранения отсчитывается от времени удаления
+    ASSERT_EQUAL(manager.purgeTrash(manager.getTrash()[0].deletedAt - 1), 0);
+    ASSERT_EQUAL(manager.purgeTrash(currentTimestampUs()), 71);
+    manager.waitForPurge();
+    ASSERT_TRUE(manager.getTrash().empty());
+    ASSERT_EQUAL(manager.getBodyStore().listHashes().size(), size_t(4));
+    ASSERT_EQUAL(std::distance(std::filesystem::directory_iterator("notes"),
+                               std::filesystem::directory_iterator()), 4);
+    
+    // Метаданные сжаты, журнал пуст
+    std::vector<Note> records;
+    std::vector<MetadataError> errors;
+    ASSERT_TRUE(readMetadataFile("notes_metadata.dat", records, errors));
+    ASSERT_EQUAL(records.size(), size_t(4));
+    std::vector<TrashEntry> journal;
+    ASSERT_TRUE(readTrashJournal("notes_metadata.dat.trash", journal));
+    ASSERT_TRUE(journal.empty());
+    ASSERT_TRUE(manager.verifyStore(2).ok());
+    
+    NoteManager reloaded;
+    reloaded.loadFromFile();
+    ASSERT_EQUAL(reloaded.getNoteCount(), 4);
+    ASSERT_TRUE(reloaded.getTrash().empty());
+    
+    cleanupTestData();
+}
+
+TEST(test_trash_journal_replay) {
+    cleanupTestData();
+    
+    TrashEntry first;
+    first.note.id = 7;
+    first.note.title = "Заметка | с разделителем";
+    first.note.category = "Тест";
+    first.note.creationDate = "2025-01-01";
+    first.note.filePath = "notes/7_Заметка.txt";
+    first.note.tags = {"архив"};
+    first.note.bodyHash = contentHash("Текст");
+    first.deletedAt = 1700000000000000;
+    first.batch = 1;
+    first.bodySize = 10;
+    TrashEntry second = first;
+    second.note.id = 8;
+    second.note.title = "Вторая";
+    second.batch = 2;
+    
+    std::string lines = formatTrashRecord(first) + "\n" + formatTrashRecord(second) + "\n" +
+                        formatRestoreRecord(8) + "\n" + formatRestoreRecord(99) + "\n";
+    ASSERT_TRUE(appendTrashJournal("notes_metadata.dat.trash", lines));
+    // Оборванная запись в конце (сбой при дописывании) пропускается
+    ASSERT_TRUE(appendTrashJournal("notes_metadata.dat.trash", formatTrashRecord(second).substr(0, 40)));
+    
+    std::vector<TrashEntry> entries;
+    ASSERT_TRUE(readTrashJournal("notes_metadata.dat.trash", entries));
+    ASSERT_EQUAL(entries.size(), size_t(1));
+    ASSERT_EQUAL(entries[0].note.id, 7);
+    ASSERT_EQUAL(entries[0].note.title, first.note.title);
+    ASSERT_TRUE(entries[0].note.tags == first.note.tags);
+    ASSERT_EQUAL(entries[0].note.bodyHash, first.note.bodyHash);
+    ASSERT_EQUAL(entries[0].deletedAt, first.deletedAt);
+    ASSERT_EQUAL(entries[0].batch, uint64_t(1));
+    ASSERT_EQUAL(entries[0].bodySize, uint64_t(10));
+    
+    ASSERT_FALSE(readTrashJournal("нет_журнала.trash", entries));
+    
+    cleanupTestData();
+}
+
+TEST(test_trash_ids_not_reused_after_restart) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.setDeleteMode(DeleteMode::Trash);
+        manager.addNote("A", "Тест", "Первый текст");
+        manager.addNote("B", "Тест", "Второй текст");
+        ASSERT_TRUE(manager.updateNote(2, "B", "Тест", "Второй текст, правка"));
+        ASSERT_TRUE(manager.deleteNote(2));
+        // Сохранение метаданных без записи удаленной заметки
+        ASSERT_TRUE(manager.updateNote(1, "A", "Тест", "Первый текст, правка"));
+    }
+    
+    NoteManager manager;
+    manager.loadFromFile();
+    ASSERT_EQUAL(manager.getTrash().size(), size_t(1));
+    ASSERT_TRUE(manager.addNote("C", "Тест", "Третий текст"));
+    ASSERT_TRUE(manager.noteExists(3));
+    ASSERT_TRUE(manager.listRevisions(3).empty());
+    ASSERT_EQUAL(manager.undoDelete(), 1);
+    ASSERT_EQUAL(manager.getNote(2)->content, "Второй текст, правка");
+    ASSERT_FALSE(manager.listRevisions(2).empty());
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ ИСТОРИИ ВЕРСИЙ =====
+
+TEST(test_delta_encoding) {
+    std::string base;
+    for (int i = 0; i < 200; i++) {
+        base += "Строка номер " + std::to_string(i) + "\n";
+    }
+    
+    // Правка в одном месте: разница - это две копии и короткая вставка
+    std::string edited = base;
+    edited.replace(edited.find("номер 100"), 9, "изменена");
+    std::string delta = encodeDelta(base, edited);
+    std::string restored;
+    ASSERT_TRUE(applyDelta(base, delta, restored));
+    ASSERT_EQUAL(restored, edited);
+    ASSERT_TRUE(delta.size() < 32);
+    
+    // Переставленные куски находятся по совпадающим блокам
+    std::string moved = base.substr(base.size() / 2) + "новое начало\n" + base.substr(0, base.size() / 2);
+    delta = encodeDelta(base, moved);
+    ASSERT_TRUE(applyDelta(base, delta, restored));
+    ASSERT_EQUAL(restored, moved);
+    ASSERT_TRUE(delta.size() < 64);
+    
+    ASSERT_TRUE(applyDelta("", encodeDelta("", "текст"), restored));
+    ASSERT_EQUAL(restored, "текст");
+    ASSERT_TRUE(applyDelta(base, encodeDelta(base, ""), restored));
+    ASSERT_TRUE(restored.empty());
+    
+    // Копия за границей текста - повреждение
+    std::string bad = encodeDelta(base, edited);
+    ASSERT_FALSE(applyDelta("короткий", bad, restored));
+    ASSERT_FALSE(applyDelta(base, std::string("\x07\x01", 2), restored));
+    
+    std::vector<DiffLine> diff = diffLines("один\nдва\nтри\n", "один\nдва с половиной\nтри\nчетыре");
+    ASSERT_EQUAL(diff.size(), size_t(5));
+    ASSERT_EQUAL(diff[0].op, ' ');
+    ASSERT_EQUAL(diff[1].op, '+');
+    ASSERT_EQUAL(diff[1].text, "два с половиной");
+    ASSERT_EQUAL(diff[2].op, '-');
+    ASSERT_EQUAL(diff[2].text, "два");
+    ASSERT_EQUAL(diff[3].op, ' ');
+    ASSERT_EQUAL(diff[4].op, '+');
+}
+
+TEST(test_note_revision_history) {
+    cleanupTestData();
+    
+    std::string text;
+    for (int i = 0; i < 100; i++) {
+        text += "Абзац " + std::to_string(i) + ": текст заметки\n";
+    }
+    std::vector<std::string> versions = {text};
+    {
+        NoteManager manager;
+        manager.addNote("История", "Тест", text);
+        // Новая заметка без истории: версии появляются с первым изменением
+        ASSERT_TRUE(manager.listRevisions(1).empty());
+        
+        for (int i = 1; i <= 40; i++) {
+            text.replace(text.find("Абзац " + std::to_string(i) + ":"), 10, "Пункт");
+            versions.push_back(text);
+            ASSERT_TRUE(manager.updateNote(1, "История", "Тест", text));
+        }
+        ASSERT_TRUE(manager.updateNote(1, "История (правка)", "Тест", text));
+        versions.push_back(text);
+        ASSERT_TRUE(manager.updateNote(1, "История (правка)", "Тест", text));
+    }
+    
+    // История переживает перезапуск; опорные версии не реже чем каждые
+    // HISTORY_KEYFRAME_INTERVAL версий, остальные - короткие разницы
+    NoteManager manager;
+    manager.loadFromFile();
+    std::vector<RevisionInfo> revisions = manager.listRevisions(1);
+    ASSERT_EQUAL(revisions.size(), versions.size());
+    uint32_t sinceKeyframe = 0;
+    for (size_t i = 0; i < revisions.size(); i++) {
+        ASSERT_EQUAL(revisions[i].number, uint32_t(i + 1));
+        sinceKeyframe = revisions[i].keyframe ? 0 : sinceKeyframe + 1;
+        ASSERT_TRUE(sinceKeyframe < HISTORY_KEYFRAME_INTERVAL);
+        if (!revisions[i].keyframe) {
+            ASSERT_TRUE(revisions[i].storedBytes < 128);
+        }
+        
+        NoteVersion version;
+        ASSERT_TRUE(manager.getRevision(1, revisions[i].number, version));
+        ASSERT_EQUAL(version.content, versions[i]);
+    }
+    ASSERT_EQUAL(revisions[0].title, "История");
+    ASSERT_EQUAL(revisions.back().title, "История (правка)");
+    
+    std::vector<DiffLine> diff;
+    ASSERT_TRUE(manager.diffRevisions(1, 1, 3, diff));
+    size_t changed = 0;
+    for (const DiffLine& line : diff) {
+        changed += line.op != ' ' ? 1 : 0;
+    }
+    ASSERT_EQUAL(changed, size_t(4));
+    ASSERT_FALSE(manager.diffRevisions(1, 1, 99, diff));
+    
+    // Возврат к версии - новая версия; оборванная запись в конце файла отрезается
+    {
+        std::ofstream file(manager.getHistory().pathOf(1), std::ios::binary | std::ios::app);
+        file << "\x30\x00\x00";
+    }
+    ASSERT_TRUE(manager.restoreRevision(1, 1));
+    ASSERT_EQUAL(manager.getNote(1)->content, versions[0]);
+    ASSERT_EQUAL(manager.getNote(1)->title, "История");
+    revisions = manager.listRevisions(1);
+    ASSERT_EQUAL(revisions.size(), versions.size() + 1);
+    ASSERT_EQUAL(revisions.back().number, uint32_t(versions.size() + 1));
+    ASSERT_FALSE(manager.restoreRevision(1, 999));
+    
+    // Изменение файла вне программы тоже попадает в историю
+    {
+        std::ofstream file(manager.getNote(1)->filePath);
+        file << "Название: История\nТема: Тест\nДата: " << manager.getNote(1)->creationDate << "\n\nРедактор";
+    }
+    WatchBatch batch;
+    batch.files.insert(noteFileName(manager, 1));
+    ASSERT_EQUAL(manager.reconcile(batch), 1);
+    NoteVersion latest;
+    ASSERT_TRUE(manager.getRevision(1, manager.listRevisions(1).back().number, latest));
+    ASSERT_EQUAL(latest.content, "Редактор");
+    
+    cleanupTestData();
+}
+
+TEST(test_history_compaction) {
+    cleanupTestData();
+    
+    NoteManager manager;
+    manager.getHistory().setKeepRevisions(4);
+    manager.addNote("Сжатие", "Тест", "Версия 0");
+    manager.addNote("Без истории", "Тест", "Текст");
+    for (int i = 1; i <= 30; i++) {
+        ASSERT_TRUE(manager.updateNote(1, "Сжатие", "Тест", "Версия " + std::to_string(i)));
+    }
+    manager.getHistory().waitForCompaction();
+    
+    // После фонового сжатия остаются последние версии, первая из них - опорная
+    std::vector<RevisionInfo> revisions = manager.listRevisions(1);
+    ASSERT_TRUE(revisions.size() >= 4);
+    ASSERT_TRUE(revisions.size() < 4 + HISTORY_KEYFRAME_INTERVAL);
+    ASSERT_TRUE(revisions[0].keyframe);
+    ASSERT_EQUAL(revisions.back().number, uint32_t(31));
+    for (const RevisionInfo& info : revisions) {
+        NoteVersion version;
+        ASSERT_TRUE(manager.getRevision(1, info.number, version));
+        ASSERT_EQUAL(version.content, "Версия " + std::to_string(info.number - 1));
+    }
+    NoteVersion dropped;
+    ASSERT_FALSE(manager.getRevision(1, 1, dropped));
+    
+    // Явное сжатие и учет места
+    ASSERT_TRUE(manager.getHistory().compact(1));
+    ASSERT_EQUAL(manager.listRevisions(1).size(), size_t(4));
+    ASSERT_TRUE(manager.updateNote(1, "Сжатие", "Тест", "Версия 31"));
+    HistoryStats stats = manager.getHistory().stats();
+    ASSERT_EQUAL(stats.notes, uint64_t(1));
+    ASSERT_EQUAL(stats.revisions, uint64_t(5));
+    
+    // Окончательное удаление заметки удаляет и ее историю
+    std::string path = manager.getHistory().pathOf(1);
+    ASSERT_TRUE(std::filesystem::exists(path));
+    ASSERT_TRUE(manager.deleteNote(1));
+    ASSERT_FALSE(std::filesystem::exists(path));
+    ASSERT_TRUE(manager.listRevisions(1).empty());
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ АСИНХРОННОГО API =====
+
+static Task<int> incrementTask(int value) {
+    co_return value + 1;
+}
+
+static Task<std::thread::id> threadAfterHop(ThreadPool& pool) {
+    co_await resumeOn(pool);
+    co_return std::this_thread::get_id();
+}
+
+static Task<int> chainedTask(ThreadPool& pool, int value) {
+    int first = co_await incrementTask(value);
+    co_await resumeOn(pool);
+    co_return co_await incrementTask(first);
+}
+
+static Task<int> failingTask(ThreadPool& pool) {
+    co_await resumeOn(pool);
+    throw std::runtime_error("ошибка в сопрограмме");
+}
+
+TEST(test_coroutine_tasks) {
+    ThreadPool pool(2);
+    ASSERT_EQUAL(syncWait(incrementTask(1)), 2);
+    ASSERT_EQUAL(syncWait(chainedTask(pool, 1)), 3);
+    ASSERT_TRUE(syncWait(threadAfterHop(pool)) != std::this_thread::get_id());
+    
+    // Задачи выполняются одновременно, результаты - в порядке задач
+    std::vector<Task<int>> tasks;
+    for (int i = 0; i < 100; i++) {
+        tasks.push_back(chainedTask(pool, i));
+    }
+    std::vector<int> results = syncWait(whenAll(std::move(tasks)));
+    ASSERT_EQUAL(results.size(), size_t(100));
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQUAL(results[i], i + 2);
+    }
+    ASSERT_TRUE(syncWait(whenAll(std::vector<Task<int>>())).empty());
+    
+    // Исключение доходит до ожидающего, в том числе через whenAll
+    bool thrown = false;
+    try {
+        syncWait(failingTask(pool));
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+    std::vector<Task<int>> mixed;
+    mixed.push_back(incrementTask(1));
+    mixed.push_back(failingTask(pool));
+    thrown = false;
+    try {
+        syncWait(whenAll(std::move(mixed)));
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+}
+
+TEST(test_async_note_manager) {
+    cleanupTestData();
+    
+    {
+        NoteManager manager;
+        manager.addNote("Старая", "Тест", "Добавлена синхронно");
+        AsyncNoteManager async(manager, 2);
+        
+        AsyncResult added = syncWait(async.addNote("Первая", "Работа", "Асинхронный текст", {"Метка"}));
+        ASSERT_TRUE(added.ok());
+        ASSERT_EQUAL(added.id, 2);
+        std::optional<Note> note = syncWait(async.getNote(2));
+        ASSERT_TRUE(note.has_value());
+        ASSERT_EQUAL(note->content, "Асинхронный текст");
+        ASSERT_EQUAL(note->tags.size(), size_t(1));
+        ASSERT_FALSE(syncWait(async.getNote(99)).has_value());
+        
+        // Ошибки возвращаются кодом, без вывода в консоль
+        ASSERT_TRUE(syncWait(async.addNote("Первая", "Работа", "Другой текст")).status == OpStatus::DuplicateTitle);
+        ASSERT_TRUE(syncWait(async.addNote("", "Работа", "Текст")).status == OpStatus::InvalidInput);
+        ASSERT_TRUE(syncWait(async.addNote("Плохой текст", "Работа", "\xC0\xAF")).status == OpStatus::InvalidInput);
+        ASSERT_TRUE(syncWait(async.deleteNote(99)).status == OpStatus::NotFound);
+        
+        // Название резервируется до записи файлов: из двух одновременных добавлений проходит одно
+        std::vector<Task<AsyncResult>> tasks;
+        tasks.push_back(async.addNote("Гонка", "Тест", "Один"));
+        tasks.push_back(async.addNote("Гонка", "Тест", "Два"));
+        std::vector<AsyncResult> results = syncWait(whenAll(std::move(tasks)));
+        ASSERT_TRUE(results[0].ok() != results[1].ok());
+        
+        ASSERT_EQUAL(syncWait(async.findByContent("Асинхронный")).size(), size_t(1));
+        ASSERT_EQUAL(syncWait(async.findByCategory("Тест")).size(), size_t(2));
+        ASSERT_TRUE(syncWait(async.deleteNote(1)).ok());
+        ASSERT_TRUE(syncWait(async.deleteNote(1)).status == OpStatus::NotFound);
+        
+        // Удаление в корзину - как в синхронном API
+        manager.setDeleteMode(DeleteMode::Trash);
+        ASSERT_TRUE(syncWait(async.deleteNote(2)).ok());
+        ASSERT_EQUAL(manager.getTrash().size(), size_t(1));
+        
+        // Журнал корзины не записан - код ошибки, а не сообщение в консоль
+        AsyncResult temporary = syncWait(async.addNote("Временная", "Тест", "Текст"));
+        ASSERT_TRUE(temporary.ok());
+        std::filesystem::rename("notes_metadata.dat.trash", "notes_metadata.dat.trash.saved");
+        std::filesystem::create_directory("notes_metadata.dat.trash");
+        std::ostringstream captured;
+        std::streambuf* console = std::cout.rdbuf(captured.rdbuf());
+        AsyncResult trashed = syncWait(async.deleteNote(temporary.id));
+        std::cout.rdbuf(console);
+        ASSERT_TRUE(trashed.status == OpStatus::IoError);
+        ASSERT_TRUE(captured.str().empty());
+        std::filesystem::remove("notes_metadata.dat.trash");
+        std::filesystem::rename("notes_metadata.dat.trash.saved", "notes_metadata.dat.trash");
+    }
+    
+    // Операция завершается после записи метаданных
+    NoteManager reloaded;
+    reloaded.loadFromFile();
+    // Заметка, чье удаление не попало в журнал, после перезапуска снова в списке
+    ASSERT_EQUAL(reloaded.getNoteCount(), 2);
+    ASSERT_TRUE(reloaded.titleExists("Временная"));
+    ASSERT_TRUE(reloaded.titleExists("Гонка"));
+    ASSERT_EQUAL(reloaded.getTrash().size(), size_t(1));
+    ASSERT_TRUE(reloaded.verifyStore(2).ok());
+    
+    cleanupTestData();
+}
+
+TEST(test_async_group_commit) {
+    cleanupTestData();
+    
+    const int total = 300;
+    {
+        NoteManager manager;
+        AsyncNoteManager async(manager, 4);
+        
+        // Половина заметок с одинаковым текстом: один файл текста пишут несколько потоков
+        std::vector<Task<AsyncResult>> adds;
+        for (int i = 0; i < total; i++) {
+            adds.push_back(async.addNote("Заметка " + std::to_string(i), "Тест",
+                                         i % 2 == 0 ? std::string("Общий текст") : "Текст " + std::to_string(i)));
+        }
+        std::vector<AsyncResult> added = syncWait(whenAll(std::move(adds)));
+        std::set<int> ids;
+        for (const AsyncResult& result : added) {
+            ASSERT_TRUE(result.ok());
+            ids.insert(result.id);
+        }
+        ASSERT_EQUAL(ids.size(), size_t(total));
+        ASSERT_EQUAL(manager.getNoteCount(), total);
+        // Операции, завершившиеся во время записи, фиксируются одной записью
+        ASSERT_TRUE(async.metadataWrites() < uint64_t(total));
+        
+        // Удаления вперемешку с добавлениями того же текста
+        std::vector<Task<AsyncResult>> mixed;
+        for (int i = 0; i < total; i += 2) {
+            mixed.push_back(async.deleteNote(added[i].id));
+            mixed.push_back(async.addNote("Новая " + std::to_string(i), "Тест", "Общий текст"));
+        }
+        for (const AsyncResult& result : syncWait(whenAll(std::move(mixed)))) {
+            ASSERT_TRUE(result.ok());
+        }
+        ASSERT_EQUAL(manager.getNoteCount(), total);
+        ASSERT_EQUAL(manager.getBodyStore().refCount(contentHash("Общий текст")), uint32_t(total / 2));
+    }
+    
+    NoteManager reloaded;
+    reloaded.loadFromFile();
+    ASSERT_EQUAL(reloaded.getNoteCount(), total);
+    ASSERT_EQUAL(reloaded.findByContent("Общий текст").size(), size_t(total / 2));
+    ASSERT_TRUE(reloaded.verifyStore(2).ok());
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ ПОЛИТИК ХРАНИЛИЩА =====
+
+// Одинаковые изменения для менеджеров разных конфигураций
+template <typename Manager>
+void fillPolicyStore(Manager& manager) {
+    manager.addNote("План работ", "Работа", "Сроки и бюджет", {"срочно", "квартал"});
+    manager.addNote("План отпуска", "Личное", "Билеты и гостиница", {"отпуск"});
+    manager.addNote("Протокол", "Работа", "Решения встречи", {"квартал"});
+    manager.addNote("Покупки", "Дом", "Хлеб, молоко", {"срочно"});
+    manager.addNote("Пароль от wi-fi", "Дом", "Наклейка на роутере");
+    manager.updateNote(3, "Протокол встречи", "Работа", "Решения и сроки");
+    manager.setNoteTags(4, {"срочно", "дом"});
+    manager.deleteNote(5);
+}
+
+std::vector<std::pair<int, int>> fuzzyPairs(const std::vector<FuzzyMatch>& matches) {
+    std::vector<std::pair<int, int>> pairs;
+    for (const FuzzyMatch& match : matches) {
+        pairs.emplace_back(match.id, match.distance);
+    }
+    return pairs;
+}
+
+std::vector<std::pair<std::string, uint64_t>> groupPairs(const std::vector<GroupCount>& groups) {
+    std::vector<std::pair<std::string, uint64_t>> pairs;
+    for (const GroupCount& group : groups) {
+        pairs.emplace_back(group.key, group.count);
+    }
+    return pairs;
+}
+
+std::vector<std::pair<std::string, uint64_t>> tagPairs(const std::vector<TagCount>& counts) {
+    std::vector<std::pair<std::string, uint64_t>> pairs;
+    for (const TagCount& count : counts) {
+        pairs.emplace_back(count.tag, count.count);
+    }
+    return pairs;
+}
+
+TEST(test_memory_storage_policy) {
+    cleanupTestData();
+    
+    {
+        MemoryNoteManager manager;
+        fillPolicyStore(manager);
+        ASSERT_EQUAL(manager.getNoteCount(), 4);
+        ASSERT_EQUAL(manager.getNote(3)->content, "Решения и сроки");
+        ASSERT_TRUE(manager.getNote(3)->filePath.empty());
+        ASSERT_EQUAL(manager.findByContent("сроки").size(), size_t(1));
+        ASSERT_EQUAL(manager.findByCategory("Работа").size(), size_t(2));
+        ASSERT_TRUE(manager.addNote("Покупки", "Дом", "Дубликат") == false);
+        
+        // Корзина хранит текст в памяти: после восстановления он на месте
+        manager.setDeleteMode(DeleteMode::Trash);
+        ASSERT_EQUAL(manager.deleteByCategory("Работа"), 2);
+        ASSERT_EQUAL(manager.getNoteCount(), 2);
+        ASSERT_EQUAL(manager.undoDelete(), 2);
+        ASSERT_EQUAL(manager.getNote(1)->content, "Сроки и бюджет");
+        manager.deleteNote(2);
+        ASSERT_EQUAL(manager.purgeTrash(currentTimestampUs()), 1);
+        ASSERT_TRUE(manager.getTrash().empty());
+        
+        // Истории версий и файлов нет; сохранение и проверка ничего не делают
+        ASSERT_TRUE(manager.listRevisions(3).empty());
+        manager.saveToFile();
+        ASSERT_FALSE(manager.saveSnapshot());
+        ASSERT_TRUE(manager.verifyStore(1).ok());
+        ASSERT_EQUAL(manager.loadFromFile().loaded, 0);
+        ASSERT_EQUAL(manager.getNoteCount(), 3);
+    }
+    ASSERT_FALSE(std::filesystem::exists("notes"));
+    ASSERT_FALSE(std::filesystem::exists("bodies"));
+    ASSERT_FALSE(std::filesystem::exists("history"));
+    ASSERT_FALSE(std::filesystem::exists("notes_metadata.dat"));
+}
+
+TEST(test_lookup_index_policy) {
+    cleanupTestData();
+    
+    // Без вторичных индексов запросы выполняются просмотром с тем же результатом
+    MemoryNoteManager indexed;
+    MemoryLookupNoteManager scanned;
+    fillPolicyStore(indexed);
+    fillPolicyStore(scanned);
+    
+    ASSERT_TRUE(indexed.findByCategory("Работа") == scanned.findByCategory("Работа"));
+    ASSERT_TRUE(indexed.findByCategory("Нет такой") == scanned.findByCategory("Нет такой"));
+    std::string today = indexed.getNote(1)->creationDate;
+    ASSERT_TRUE(indexed.findByDateRange(today, today) == scanned.findByDateRange(today, today));
+    ASSERT_EQUAL(scanned.findByDateRange(today, today).size(), size_t(4));
+    ASSERT_TRUE(scanned.findByDateRange("2020-01-01", "плохая дата").empty());
+    TagQuery query = parseTagQuery("срочно AND NOT дом");
+    ASSERT_TRUE(indexed.findByTags(query) == scanned.findByTags(query));
+    ASSERT_EQUAL(scanned.findByTags(query).size(), size_t(1));
+    ASSERT_TRUE(tagPairs(indexed.tagCounts()) == tagPairs(scanned.tagCounts()));
+    ASSERT_TRUE(tagPairs(indexed.tagCounts(query)) == tagPairs(scanned.tagCounts(query)));
+    ASSERT_TRUE(groupPairs(indexed.countBy(GroupBy::Category)) == groupPairs(scanned.countBy(GroupBy::Category)));
+    ASSERT_TRUE(groupPairs(indexed.countBy(GroupBy::Month)) == groupPairs(scanned.countBy(GroupBy::Month)));
+    ASSERT_TRUE(fuzzyPairs(indexed.fuzzySearchTitles("план", 2)) == fuzzyPairs(scanned.fuzzySearchTitles("план", 2)));
+    ASSERT_TRUE(fuzzyPairs(indexed.fuzzySearchCategories("работы", 1)) ==
+                fuzzyPairs(scanned.fuzzySearchCategories("работы", 1)));
+    ASSERT_TRUE(indexed.suggestTitles("ПЛ", 10) == scanned.suggestTitles("ПЛ", 10));
+    ASSERT_TRUE(indexed.suggestTitles("п", 2) == scanned.suggestTitles("п", 2));
+    ASSERT_EQUAL(scanned.suggestTitles("п", 2).size(), size_t(2));
+    
+    // Хранилище в файлах без индексов читается обычным менеджером и наоборот
+    {
+        LookupNoteManager manager;
+        fillPolicyStore(manager);
+    }
+    NoteManager reloaded;
+    reloaded.loadFromFile();
+    ASSERT_EQUAL(reloaded.getNoteCount(), 4);
+    ASSERT_TRUE(reloaded.findByCategory("Работа") == scanned.findByCategory("Работа"));
+    ASSERT_TRUE(reloaded.verifyStore(1).ok());
+    reloaded.addNote("Новая", "Дом", "Текст");
+    reloaded.saveSnapshot();
+    LookupNoteManager lookup;
+    LoadReport report = lookup.loadFromFile();
+    ASSERT_FALSE(report.fromSnapshot);
+    ASSERT_EQUAL(lookup.findByCategory("Дом").size(), size_t(2));
+    
+    cleanupTestData();
+}
+
+TEST(test_deferred_durability_policy) {
+    cleanupTestData();
+    
+    {
+        BufferedNoteManager manager;
+        for (int i = 1; i <= 20; i++) {
+            manager.addNote("Заметка " + std::to_string(i), "Тест", "Текст " + std::to_string(i));
+        }
+        manager.deleteNote(20);
+        // Файлы заметок уже записаны, метаданные - еще нет
+        ASSERT_TRUE(std::filesystem::exists(manager.getNote(1)->filePath));
+        ASSERT_FALSE(std::filesystem::exists("notes_metadata.dat"));
+        
+        manager.flush();
+        NoteManager reader;
+        reader.loadFromFile();
+        ASSERT_EQUAL(reader.getNoteCount(), 19);
+        
+        // Изменения после flush() записывает деструктор
+        manager.updateNote(1, "Первая", "Тест", "Новый текст");
+        manager.addNote("Последняя", "Тест", "Текст");
+    }
+    
+    NoteManager reloaded;
+    reloaded.loadFromFile();
+    ASSERT_EQUAL(reloaded.getNoteCount(), 20);
+    ASSERT_TRUE(reloaded.titleExists("Первая"));
+    ASSERT_EQUAL(reloaded.getNote(1)->content, "Новый текст");
+    ASSERT_EQUAL(reloaded.listRevisions(1).size(), size_t(2));
+    ASSERT_TRUE(reloaded.verifyStore(1).ok());
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ УЧЕТА ПАМЯТИ =====
+
+TEST(test_memory_estimates) {
+    // Блоки malloc: заголовок 8 байт, выравнивание 16, минимум 32
+    ASSERT_EQUAL(heapBlockBytes(0), size_t(0));
+    ASSERT_EQUAL(heapBlockBytes(1), size_t(32));
+    ASSERT_EQUAL(heapBlockBytes(24), size_t(32));
+    ASSERT_EQUAL(heapBlockBytes(25), size_t(48));
+    
+    // Короткая строка живет внутри объекта, длинная - в куче
+    std::string shortText = "метка";
+    std::string longText(100, 'x');
+    ASSERT_EQUAL(stringHeapBytes(shortText), size_t(0));
+    ASSERT_TRUE(stringHeapBytes(longText) >= longText.capacity() + 1);
+    
+    std::vector<int> values;
+    ASSERT_EQUAL(vectorHeapBytes(values), size_t(0));
+    values.reserve(10);
+    ASSERT_EQUAL(vectorHeapBytes(values), heapBlockBytes(10 * sizeof(int)));
+    
+    std::unordered_map<int, int> table;
+    for (int i = 0; i < 100; i++) {
+        table[i] = i;
+    }
+    ASSERT_TRUE(hashTableBytes(table) >= 100 * (sizeof(void*) + sizeof(std::pair<const int, int>)));
+    
+    // Счетчик кучи собирается только в memtest_runner
+    ASSERT_FALSE(allocationStats().enabled);
+    ASSERT_TRUE(residentBytes() > 0);
+}
+
+TEST(test_memory_usage_by_structure) {
+    MemoryNoteManager manager;
+    MemoryReport empty = manager.memoryUsage();
+    ASSERT_EQUAL(empty.nodes, size_t(0));
+    ASSERT_EQUAL(empty.content, size_t(0));
+    
+    std::string text(300, 'a');
+    for (int i = 1; i <= 200; i++) {
+        manager.addNote("Длинное название заметки номер " + std::to_string(i), "Тема " + std::to_string(i % 5),
+                        text, {"метка" + std::to_string(i % 3)});
+    }
+    MemoryReport full = manager.memoryUsage();
+    ASSERT_EQUAL(full.nodes, 200 * heapBlockBytes(sizeof(NoteNode)) + 200 * vectorHeapBytes(manager.getNote(1)->tags));
+    ASSERT_TRUE(full.content >= 200 * (text.size() + 1));
+    ASSERT_TRUE(full.strings > 0);
+    ASSERT_TRUE(full.idIndex > 0);
+    ASSERT_TRUE(full.titleIndex > full.idIndex);
+    ASSERT_TRUE(full.titlePrefixes > 0);
+    ASSERT_TRUE(full.titleFuzzy > 0);
+    ASSERT_TRUE(full.categoryFuzzy > 0);
+    ASSERT_TRUE(full.columns > 0);
+    ASSERT_TRUE(full.tags > 0);
+    ASSERT_TRUE(full.aggregates > 0);
+    ASSERT_EQUAL(full.trash, size_t(0));
+    ASSERT_EQUAL(full.total(), full.nodes + full.strings + full.content + full.indexes() + full.bodyRefs +
+                               full.trash + full.history);
+    
+    // Удаленные заметки уходят из учета, в корзине их строки и тексты остаются
+    manager.setDeleteMode(DeleteMode::Trash);
+    for (int i = 1; i <= 100; i++) {
+        manager.deleteNote(i);
+    }
+    MemoryReport trashed = manager.memoryUsage();
+    ASSERT_EQUAL(trashed.nodes * 2, full.nodes);
+    ASSERT_TRUE(trashed.content * 2 <= full.content);
+    ASSERT_TRUE(trashed.trash >= 100 * (text.size() + 1));
+    
+    // Без вторичных индексов их части равны нулю
+    MemoryLookupNoteManager lookup;
+    lookup.addNote("Длинное название заметки", "Тема", text, {"метка"});
+    MemoryReport lookupReport = lookup.memoryUsage();
+    ASSERT_TRUE(lookupReport.idIndex > 0);
+    ASSERT_TRUE(lookupReport.titleIndex > 0);
+    ASSERT_EQUAL(lookupReport.titlePrefixes + lookupReport.titleFuzzy + lookupReport.categoryFuzzy +
+                 lookupReport.columns + lookupReport.tags + lookupReport.aggregates, size_t(0));
+}
+
+TEST(test_memory_usage_file_store) {
+    cleanupTestData();
+    
+    NoteManager manager;
+    std::string text(200, 'b');
+    manager.addNote("Первая", "Работа", text);
+    manager.addNote("Вторая", "Работа", text);
+    MemoryReport before = manager.memoryUsage();
+    // Одинаковые тексты - одна запись счетчика ссылок
+    ASSERT_TRUE(before.bodyRefs > 0);
+    ASSERT_EQUAL(manager.getBodyStore().memoryUsage(), before.bodyRefs);
+    ASSERT_EQUAL(before.history, size_t(0));
+    
+    manager.updateNote(1, "Первая", "Работа", "Новый текст");
+    MemoryReport after = manager.memoryUsage();
+    ASSERT_TRUE(after.history > 0);
+    ASSERT_TRUE(after.bodyRefs > before.bodyRefs);
+    
+    cleanupTestData();
+}
+
+// ===== ТЕСТЫ ПОХОЖИХ ЗАМЕТОК =====
+
+// Текст из случайных слов (слова - из букв латиницы и кириллицы)
+std::string randomWordsText(std::mt19937& rng, size_t words) {
+    const char* syllables[] = {"ка", "ро", "ми", "ла", "ba", "to", "ne", "ру", "sa", "де", "ki", "мо"};
+    std::string text;
+    for (size_t i = 0; i < words; i++) {
+        size_t length = 2 + rng() % 3;
+        for (size_t j = 0; j < length; j++) {
+            text += syllables[rng() % 12];
+        }
+        text += ' ';
+    }
+    return text;
+}
+
+// Копия текста с заменой части слов
+std::string editWords(const std::string& text, std::mt19937& rng, size_t edits) {
+    std::vector<std::string> words;
+    std::istringstream in(text);
+    std::string word;
+    while (in >> word) {
+        words.push_back(word);
+    }
+    for (size_t i = 0; i < edits; i++) {
+        words[rng() % words.size()] = "замена" + std::to_string(rng() % 1000);
+    }
+    std::string result;
+    for (const std::string& w : words) {
+        result += w + " ";
+    }
+    return result;
+}
+
+TEST(test_minhash_similarity) {
+    // Регистр, знаки препинания и пробелы не влияют на шинглы
+    ASSERT_TRUE(textShingles("Купить хлеб, молоко!") == textShingles("  купить   ХЛЕБ молоко"));
+    ASSERT_TRUE(textShingles(" ... ").empty());
+    ASSERT_EQUAL(textShingles("кот").size(), size_t(1));
+    
+    std::vector<uint64_t> a = textShingles("Отчет по проекту за первый квартал");
+    std::vector<uint64_t> b = textShingles("Отчет по проекту за второй квартал");
+    std::vector<uint64_t> c = textShingles("Рецепт пирога с яблоками");
+    ASSERT_EQUAL(jaccardSimilarity(a, a), 1.0);
+    double close = jaccardSimilarity(a, b);
+    ASSERT_TRUE(close > 0.5 && close < 1.0);
+    ASSERT_TRUE(jaccardSimilarity(a, c) < 0.1);
+    
+    // Оценка по подписи близка к точному сходству
+    std::mt19937 rng(47);
+    for (int i = 0; i < 20; i++) {
+        std::string text = randomWordsText(rng, 40);
+        std::string edited = editWords(text, rng, 1 + i % 10);
+        std::vector<uint64_t> first = textShingles(text);
+        std::vector<uint64_t> second = textShingles(edited);
+        double exact = jaccardSimilarity(first, second);
+        double estimate = estimateSimilarity(minHashSignature(first), minHashSignature(second));
+        ASSERT_TRUE(std::abs(exact - estimate) < 0.25);
+    }
+    ASSERT_EQUAL(estimateSimilarity(minHashSignature(a), minHashSignature(a)), 1.0);
+}
+
+TEST(test_similarity_index) {
+    std::mt19937 rng(7);
+    SimilarityIndex index;
+    std::vector<std::string> texts;
+    for (int id = 1; id <= 2000; id++) {
+        texts.push_back(randomWordsText(rng, 30));
+        index.add(id, minHashSignature(textShingles(texts.back())));
+    }
+    ASSERT_EQUAL(index.size(), size_t(2000));
+    
+    // Почти дубликат находится, случайные тексты в кандидаты почти не попадают
+    std::string copy = editWords(texts[99], rng, 2);
+    MinHashSignature signature = minHashSignature(textShingles(copy));
+    std::vector<SimilarNote> found = index.candidates(signature, 0.0);
+    ASSERT_FALSE(found.empty());
+    ASSERT_EQUAL(found[0].id, 100);
+    ASSERT_TRUE(found.size() < 20);
+    
+    // Удаление убирает подпись из всех корзин, строка переиспользуется
+    ASSERT_TRUE(index.remove(100));
+    ASSERT_FALSE(index.remove(100));
+    for (const SimilarNote& note : index.candidates(signature, 0.0)) {
+        ASSERT_TRUE(note.id != 100);
+    }
+    index.add(5000, signature);
+    ASSERT_EQUAL(index.candidates(signature, 0.9)[0].id, 5000);
+    MinHashSignature stored;
+    ASSERT_TRUE(index.signatureOf(5000, stored));
+    ASSERT_TRUE(stored == signature);
+    for (int id = 1; id <= 1000; id++) {
+        index.remove(id);
+    }
+    ASSERT_EQUAL(index.size(), size_t(1001));
+    
+    // Одинаковые тексты делят корзины: удаление из начала, середины и конца списка
+    MinHashSignature shared = minHashSignature(textShingles(texts[1999]));
+    for (int id = 6001; id <= 6010; id++) {
+        index.add(id, shared);
+    }
+    auto sharedIds = [&](const SimilarityIndex& target) {
+        std::vector<int> ids;
+        for (const SimilarNote& note : target.candidates(shared, 0.99)) {
+            ids.push_back(note.id);
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+    ASSERT_TRUE(index.remove(6010));
+    ASSERT_TRUE(index.remove(6005));
+    ASSERT_TRUE(index.remove(6001));
+    ASSERT_TRUE(index.remove(2000));
+    ASSERT_TRUE(sharedIds(index) == std::vector<int>({6002, 6003, 6004, 6006, 6007, 6008, 6009}));
+    ASSERT_EQUAL(index.size(), size_t(1007));
+    
+    // Снимок восстанавливает тот же индекс
+    SnapshotWriter out;
+    index.save(out);
+    SimilarityIndex loaded;
+    SnapshotReader in(out.data());
+    loaded.load(in);
+    ASSERT_TRUE(in.atEnd());
+    ASSERT_EQUAL(loaded.size(), size_t(1007));
+    MinHashSignature probe = minHashSignature(textShingles(texts[1500]));
+    std::vector<SimilarNote> before = index.candidates(probe, 0.0);
+    std::vector<SimilarNote> after = loaded.candidates(probe, 0.0);
+    ASSERT_EQUAL(before.size(), after.size());
+    ASSERT_EQUAL(after[0].id, 1501);
+    ASSERT_TRUE(loaded.signatureOf(5000, stored));
+    ASSERT_TRUE(stored == signature);
+    
+    // Обратные ссылки корзин восстановлены при загрузке
+    ASSERT_TRUE(loaded.remove(6007));
+    ASSERT_TRUE(loaded.remove(6009));
+    ASSERT_TRUE(loaded.remove(6002));
+    ASSERT_TRUE(sharedIds(loaded) == std::vector<int>({6003, 6004, 6006, 6008}));
+}
+
+TEST(test_find_similar_notes) {
+    cleanupTestData();
+    
+    std::mt19937 rng(11);
+    std::string base = randomWordsText(rng, 40);
+    std::vector<std::string> texts = {base, editWords(base, rng, 2), randomWordsText(rng, 40),
+                                      editWords(base, rng, 4), randomWordsText(rng, 40)};
+    {
+        NoteManager manager;
+        MemoryLookupNoteManager lookup;
+        for (size_t i = 0; i < texts.size(); i++) {
+            manager.addNote("Заметка " + std::to_string(i + 1), "Тест", texts[i]);
+            lookup.addNote("Заметка " + std::to_string(i + 1), "Тест", texts[i]);
+        }
+        std::vector<SimilarNote> similar = manager.findSimilar(1);
+        ASSERT_EQUAL(similar.size(), size_t(2));
+        ASSERT_EQUAL(similar[0].id, 2);
+        ASSERT_EQUAL(similar[1].id, 4);
+        ASSERT_TRUE(similar[0].similarity > similar[1].similarity);
+        ASSERT_EQUAL(similar[0].similarity, jaccardSimilarity(textShingles(texts[0]), textShingles(texts[1])));
+        
+        // Без индекса - тот же результат полным просмотром
+        std::vector<SimilarNote> scanned = lookup.findSimilar(1);
+        ASSERT_EQUAL(scanned.size(), size_t(2));
+        ASSERT_EQUAL(scanned[0].id, 2);
+        ASSERT_EQUAL(scanned[0].similarity, similar[0].similarity);
+        ASSERT_EQUAL(manager.findSimilarText(texts[0], 0.99).size(), size_t(1));
+        ASSERT_EQUAL(manager.findSimilar(1, 0.0, 1).size(), size_t(1));
+        
+        // Правка текста и удаление обновляют индекс
+        manager.updateNote(2, "Заметка 2", "Тест", texts[2]);
+        similar = manager.findSimilar(1);
+        ASSERT_EQUAL(similar.size(), size_t(1));
+        ASSERT_EQUAL(similar[0].id, 4);
+        ASSERT_EQUAL(manager.findSimilar(3)[0].id, 2);
+        manager.deleteNote(4);
+        ASSERT_TRUE(manager.findSimilar(1).empty());
+        
+        // Предупреждение не мешает добавлению почти дубликата
+        manager.setNearDuplicateWarning(NEAR_DUPLICATE_THRESHOLD);
+        ASSERT_TRUE(manager.addNote("Копия", "Тест", texts[0]));
+        ASSERT_EQUAL(manager.findSimilar(1)[0].id, manager.getNextId() - 1);
+        manager.saveSnapshot();
+    }
+    
+    // Индекс восстанавливается из снимка
+    NoteManager reloaded;
+    LoadReport report = reloaded.loadFromFile();
+    ASSERT_TRUE(report.fromSnapshot);
+    std::vector<SimilarNote> similar = reloaded.findSimilar(1);
+    ASSERT_EQUAL(similar.size(), size_t(1));
+    ASSERT_EQUAL(similar[0].id, reloaded.getNextId() - 1);
+    ASSERT_EQUAL(reloaded.findSimilar(3)[0].id, 2);
+    
+    cleanupTestData();
+}
+
 // ===== ГЛАВНАЯ ФУНКЦИЯ =====
 
 int main() {
@@ -380,6 +3178,144 @@ int main() {
     RUN_TEST(test_generate_safe_filepath);
     RUN_TEST(test_note_content_persistence);
     
+    // Тесты редактирования заметок
+    std::cout << "\n--- Тесты редактирования ---" << std::endl;
+    RUN_TEST(test_update_note_content);
+    RUN_TEST(test_update_note_title_renames_file);
+    RUN_TEST(test_update_note_duplicate_title);
+    RUN_TEST(test_update_note_not_exists);
+    
+    // Тесты чтения файлов заметок
+    std::cout << "\n--- Тесты чтения файлов ---" << std::endl;
+    RUN_TEST(test_note_body_view);
+    RUN_TEST(test_multiline_content_roundtrip);
+    RUN_TEST(test_read_missing_file);
+    
+    // Тесты автодополнения названий
+    std::cout << "\n--- Тесты автодополнения ---" << std::endl;
+    RUN_TEST(test_fold_case_utf8);
+    RUN_TEST(test_suggest_titles_prefix);
+    RUN_TEST(test_suggest_titles_sync);
+    RUN_TEST(test_title_index_matches_reference);
+    
+    // Тесты нечеткого поиска
+    std::cout << "\n--- Тесты нечеткого поиска ---" << std::endl;
+    RUN_TEST(test_bounded_edit_distance);
+    RUN_TEST(test_fuzzy_search_categories);
+    RUN_TEST(test_fuzzy_search_titles_sync);
+    
+    // Тесты полного просмотра
+    std::cout << "\n--- Тесты векторных ядер просмотра ---" << std::endl;
+    RUN_TEST(test_scan_kernels_match_scalar);
+    RUN_TEST(test_find_by_content_and_date);
+    
+    // Тесты параллельного поиска
+    std::cout << "\n--- Тесты параллельного поиска ---" << std::endl;
+    RUN_TEST(test_thread_pool_runs_all_tasks);
+    RUN_TEST(test_thread_pool_task_exception);
+    RUN_TEST(test_parallel_search_ordered);
+    
+    // Тесты распределенного хранилища
+    std::cout << "\n--- Тесты распределенного хранилища ---" << std::endl;
+    RUN_TEST(test_custom_store_root);
+    RUN_TEST(test_sharded_global_ids);
+    
+    // Тесты архивов
+    std::cout << "\n--- Тесты архивов ---" << std::endl;
+    RUN_TEST(test_crc32_known_value);
+    RUN_TEST(test_archive_roundtrip);
+    RUN_TEST(test_archive_roundtrip_compressed);
+    RUN_TEST(test_archive_corruption_detected);
+    RUN_TEST(test_archive_invalid_records_skipped);
+    
+    // Тесты формата метаданных
+    std::cout << "\n--- Тесты формата метаданных ---" << std::endl;
+    RUN_TEST(test_metadata_escape_roundtrip);
+    RUN_TEST(test_title_with_separator_roundtrip);
+    RUN_TEST(test_corrupt_record_skipped);
+    RUN_TEST(test_legacy_metadata_loaded);
+    RUN_TEST(test_verify_store);
+    
+    // Тесты сверки с файлами
+    std::cout << "\n--- Тесты сверки с файлами ---" << std::endl;
+    RUN_TEST(test_reconcile_external_edit);
+    RUN_TEST(test_reconcile_external_delete);
+    RUN_TEST(test_watcher_batches_burst);
+    
+    // Тесты снимка индексов
+    std::cout << "\n--- Тесты снимка индексов ---" << std::endl;
+    RUN_TEST(test_snapshot_roundtrip);
+    RUN_TEST(test_snapshot_applies_delta);
+    RUN_TEST(test_snapshot_corrupt_fallback);
+    RUN_TEST(test_snapshot_sees_in_place_edits);
+    
+    // Тесты времени создания
+    std::cout << "\n--- Тесты времени создания ---" << std::endl;
+    RUN_TEST(test_local_date_day_boundary);
+    RUN_TEST(test_current_date_concurrent);
+    RUN_TEST(test_created_timestamp_persisted);
+    
+    // Тесты проверки UTF-8
+    std::cout << "\n--- Тесты проверки UTF-8 ---" << std::endl;
+    RUN_TEST(test_utf8_length_kernels_match_reference);
+    RUN_TEST(test_validation_counts_characters);
+    
+    // Тесты меток
+    std::cout << "\n--- Тесты меток ---" << std::endl;
+    RUN_TEST(test_roaring_bitmap_matches_set);
+    RUN_TEST(test_tag_queries_and_counts);
+    RUN_TEST(test_tags_in_snapshot_and_archive);
+    
+    // Тесты агрегации
+    std::cout << "\n--- Тесты агрегации ---" << std::endl;
+    RUN_TEST(test_date_group_keys);
+    RUN_TEST(test_aggregates_incremental);
+    RUN_TEST(test_count_by_matches_scan);
+    
+    // Тесты хранения текстов
+    std::cout << "\n--- Тесты хранения текстов ---" << std::endl;
+    RUN_TEST(test_content_hash_and_body_ref);
+    RUN_TEST(test_duplicate_bodies_stored_once);
+    RUN_TEST(test_body_hash_collision_kept_inline);
+    RUN_TEST(test_body_refs_rebuilt_on_load);
+    
+    // Тесты корзины
+    std::cout << "\n--- Тесты корзины ---" << std::endl;
+    RUN_TEST(test_trash_delete_and_undo);
+    RUN_TEST(test_delete_by_category_and_purge);
+    RUN_TEST(test_trash_journal_replay);
+    RUN_TEST(test_trash_ids_not_reused_after_restart);
+    
+    // Тесты истории версий
+    std::cout << "\n--- Тесты истории версий ---" << std::endl;
+    RUN_TEST(test_delta_encoding);
+    RUN_TEST(test_note_revision_history);
+    RUN_TEST(test_history_compaction);
+    
+    // Тесты асинхронного API
+    std::cout << "\n--- Тесты асинхронного API ---" << std::endl;
+    RUN_TEST(test_coroutine_tasks);
+    RUN_TEST(test_async_note_manager);
+    RUN_TEST(test_async_group_commit);
+    
+    // Тесты политик хранилища
+    std::cout << "\n--- Тесты политик хранилища ---" << std::endl;
+    RUN_TEST(test_memory_storage_policy);
+    RUN_TEST(test_lookup_index_policy);
+    RUN_TEST(test_deferred_durability_policy);
+    
+    // Тесты учета памяти
+    std::cout << "\n--- Тесты учета памяти ---" << std::endl;
+    RUN_TEST(test_memory_estimates);
+    RUN_TEST(test_memory_usage_by_structure);
+    RUN_TEST(test_memory_usage_file_store);
+    
+    // Тесты похожих заметок
+    std::cout << "\n--- Тесты похожих заметок ---" << std::endl;
+    RUN_TEST(test_minhash_similarity);
+    RUN_TEST(test_similarity_index);
+    RUN_TEST(test_find_similar_notes);
+    
     // Итоги
     std::cout << "\n=== РЕЗУЛЬТАТЫ ТЕСТИРОВАНИЯ ===" << std::endl;
     std::cout << "Тесты пройдены: " << GREEN << testsPassed << RESET << std::endl;
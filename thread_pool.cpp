@@ -0,0 +1,132 @@
+#include "thread_pool.h"
+
+// Пул и индекс очереди текущего рабочего потока
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentIndex = 0;
+
+size_t ThreadPool::resolveThreads(size_t threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        if (threads == 0) {
+            threads = 1;
+        }
+    }
+    return threads;
+}
+
+ThreadPool::ThreadPool(size_t threads)
+    : queuedTasks(0), unfinishedTasks(0), nextQueue(0), stopping(false) {
+    threads = resolveThreads(threads);
+    
+    for (size_t i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t index;
+    if (currentPool == this) {
+        index = currentIndex;
+    } else {
+        index = nextQueue.fetch_add(1) % queues.size();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        queuedTasks++;
+        unfinishedTasks++;
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this]() { return unfinishedTasks == 0; });
+    if (firstError) {
+        std::exception_ptr error = std::move(firstError);
+        firstError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+bool ThreadPool::takeTask(size_t index, std::function<void()>& task) {
+    // Сначала своя очередь с начала, в порядке постановки
+    {
+        Queue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    
+    // Затем перехват с конца чужих очередей
+    for (size_t offset = 1; offset < queues.size(); offset++) {
+        Queue& victim = *queues[(index + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentIndex = index;
+    
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            taskAvailable.wait(lock, [this]() { return stopping || queuedTasks > 0; });
+            if (queuedTasks == 0) {
+                // stopping и задач не осталось
+                return;
+            }
+            // Резервируем одну задачу, чтобы другие потоки не ждали ее зря
+            queuedTasks--;
+        }
+        
+        std::function<void()> task;
+        while (!takeTask(index, task)) {
+            // Очереди просматриваются не атомарно - при гонке повторяем
+            std::this_thread::yield();
+        }
+        
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (error && !firstError) {
+            firstError = std::move(error);
+        }
+        if (--unfinishedTasks == 0) {
+            allDone.notify_all();
+        }
+    }
+}
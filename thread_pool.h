@@ -0,0 +1,64 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом задач (work stealing).
+// У каждого потока своя очередь: владелец выполняет задачи в порядке
+// постановки, а простаивающие потоки забирают их с конца чужих очередей.
+// Так ранние задачи (например, первые части хранилища) завершаются первыми.
+// Исключение из задачи не завершает поток: первое из них сохраняется
+// и перебрасывается из wait().
+class ThreadPool {
+public:
+    // threads = 0 - по числу аппаратных потоков
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    // Постановка задачи: из рабочего потока - в его очередь,
+    // извне - по очереди во все очереди
+    void submit(std::function<void()> task);
+    
+    // Ожидание завершения всех поставленных задач; если какая-то задача
+    // бросила исключение, первое из них перебрасывается (остальные теряются)
+    void wait();
+    
+    size_t size() const { return workers.size(); }
+    
+    // Число потоков для запрошенного: 0 - по числу аппаратных потоков
+    static size_t resolveThreads(size_t threads);
+    
+private:
+    struct Queue {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+    
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    
+    std::mutex stateMutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable allDone;
+    size_t queuedTasks;                 // Задачи в очередях (под stateMutex)
+    size_t unfinishedTasks;             // Поставленные, но не завершенные задачи
+    std::exception_ptr firstError;      // Первое исключение из задач (под stateMutex)
+    std::atomic<size_t> nextQueue;      // Очередь для задач извне
+    bool stopping;
+    
+    bool takeTask(size_t index, std::function<void()>& task);
+    void workerLoop(size_t index);
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,93 @@
+#include "timestamp.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+int64_t currentTimestampUs() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+// Потокобезопасное преобразование во время местного часового пояса
+static void toLocalTime(std::time_t time, std::tm& result) {
+#ifdef _WIN32
+    localtime_s(&result, &time);
+#else
+    localtime_r(&time, &result);
+#endif
+}
+
+// Кэш даты одного потока: сутки [dayStart, dayEnd) в секундах
+struct DateCache {
+    std::time_t dayStart = 1;
+    std::time_t dayEnd = 0;
+    std::string date;
+    
+    void refresh(std::time_t time) {
+        std::tm local;
+        toLocalTime(time, local);
+        
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d",
+                      local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+        date = buffer;
+        
+        // Границы суток через mktime учитывают переход на летнее время
+        local.tm_hour = 0;
+        local.tm_min = 0;
+        local.tm_sec = 0;
+        local.tm_isdst = -1;
+        dayStart = std::mktime(&local);
+        local.tm_mday += 1;
+        local.tm_isdst = -1;
+        dayEnd = std::mktime(&local);
+        
+        // mktime не смог вычислить границы - кэш действует одну секунду
+        if (dayStart == -1 || dayEnd == -1 || time < dayStart || time >= dayEnd) {
+            dayStart = time;
+            dayEnd = time + 1;
+        }
+    }
+};
+
+std::string localDate(int64_t timestampUs) {
+    thread_local DateCache cache;
+    
+    // Деление с округлением вниз и для моментов до начала эпохи
+    int64_t seconds = timestampUs / 1000000;
+    if (timestampUs % 1000000 < 0) {
+        seconds--;
+    }
+    std::time_t time = static_cast<std::time_t>(seconds);
+    
+    if (time < cache.dayStart || time >= cache.dayEnd) {
+        cache.refresh(time);
+    }
+    return cache.date;
+}
+
+std::string currentDate() {
+    return localDate(currentTimestampUs());
+}
+
+int64_t dateTimestamp(const std::string& date) {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    char tail = 0;
+    if (std::sscanf(date.c_str(), "%4d-%2d-%2d%c", &year, &month, &day, &tail) != 3 ||
+        month < 1 || month > 12 || day < 1 || day > 31) {
+        return 0;
+    }
+    
+    std::tm local = {};
+    local.tm_year = year - 1900;
+    local.tm_mon = month - 1;
+    local.tm_mday = day;
+    local.tm_isdst = -1;
+    std::time_t time = std::mktime(&local);
+    if (time == -1) {
+        return 0;
+    }
+    return static_cast<int64_t>(time) * 1000000;
+}
@@ -0,0 +1,22 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <cstdint>
+#include <string>
+
+// Текущее время в микросекундах от начала эпохи (UTC)
+int64_t currentTimestampUs();
+
+// Локальная дата ГГГГ-ММ-ДД для момента времени в микросекундах.
+// Отформатированная дата кэшируется в каждом потоке вместе с границами
+// ее суток, поэтому localtime_r вызывается только при смене дня.
+std::string localDate(int64_t timestampUs);
+
+// Текущая локальная дата ГГГГ-ММ-ДД (потокобезопасно)
+std::string currentDate();
+
+// Начало локальных суток даты ГГГГ-ММ-ДД в микросекундах; 0 - дата не разобрана.
+// Для записей, в которых сохранилась только дата создания
+int64_t dateTimestamp(const std::string& date);
+
+#endif // TIMESTAMP_H
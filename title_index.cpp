@@ -0,0 +1,241 @@
+#include "title_index.h"
+#include "snapshot.h"
+#include "utf8.h"
+#include "memory.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Наименьший порог слияния добавок: на малых индексах сливать чаще незачем
+const size_t TITLE_INDEX_MIN_PENDING = 64;
+// Пометка удаленной записи основного массива - старший бит длины ключа
+// (ключ остается на месте, чтобы порядок массива не нарушался)
+const uint32_t TITLE_INDEX_ERASED = 0x80000000u;
+
+TitleIndex::TitleIndex() : erasedCount(0), garbageBytes(0) {}
+
+std::string_view TitleIndex::keyOf(const Entry& entry) const {
+    return std::string_view(arena.data() + entry.offset, entry.length & ~TITLE_INDEX_ERASED);
+}
+
+bool TitleIndex::isErased(const Entry& entry) {
+    return (entry.length & TITLE_INDEX_ERASED) != 0;
+}
+
+TitleIndex::Entry TitleIndex::storeKey(const std::string& title, int id) {
+    std::string key = foldCaseUtf8(title);
+    Entry entry;
+    entry.offset = static_cast<uint32_t>(arena.size());
+    entry.length = static_cast<uint32_t>(key.size());
+    entry.id = id;
+    arena += key;
+    return entry;
+}
+
+bool TitleIndex::less(const Entry& a, const Entry& b) const {
+    int cmp = keyOf(a).compare(keyOf(b));
+    return cmp < 0 || (cmp == 0 && a.id < b.id);
+}
+
+void TitleIndex::insert(const std::string& title, int id) {
+    Entry entry = storeKey(title, id);
+    auto pos = std::lower_bound(pending.begin(), pending.end(), entry,
+        [this](const Entry& a, const Entry& b) { return less(a, b); });
+    pending.insert(pos, entry);
+    
+    if (pending.size() > pendingLimit()) {
+        mergePending();
+    }
+}
+
+size_t TitleIndex::pendingLimit() const {
+    return std::max(TITLE_INDEX_MIN_PENDING, static_cast<size_t>(std::sqrt(static_cast<double>(entries.size()))));
+}
+
+void TitleIndex::mergePending() {
+    dropErased();
+    size_t middle = entries.size();
+    entries.insert(entries.end(), pending.begin(), pending.end());
+    std::inplace_merge(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(middle), entries.end(),
+        [this](const Entry& a, const Entry& b) { return less(a, b); });
+    pending.clear();
+}
+
+void TitleIndex::dropErased() {
+    if (erasedCount == 0) {
+        return;
+    }
+    entries.erase(std::remove_if(entries.begin(), entries.end(), isErased), entries.end());
+    erasedCount = 0;
+}
+
+std::vector<TitleIndex::Entry>::iterator TitleIndex::findEntry(std::vector<Entry>& sorted,
+                                                               const std::string& key, int id) {
+    auto pos = std::lower_bound(sorted.begin(), sorted.end(), key,
+        [this, id](const Entry& entry, const std::string& k) {
+            int cmp = keyOf(entry).compare(k);
+            return cmp < 0 || (cmp == 0 && entry.id < id);
+        });
+    if (pos == sorted.end() || pos->id != id || keyOf(*pos) != key) {
+        return sorted.end();
+    }
+    return pos;
+}
+
+bool TitleIndex::erase(const std::string& title, int id) {
+    std::string key = foldCaseUtf8(title);
+    auto pos = findEntry(pending, key, id);
+    if (pos != pending.end()) {
+        garbageBytes += pos->length;
+        pending.erase(pos);
+    } else {
+        // В основном массиве запись только помечается, сдвига нет
+        pos = findEntry(entries, key, id);
+        if (pos == entries.end() || isErased(*pos)) {
+            return false;
+        }
+        garbageBytes += pos->length;
+        pos->length |= TITLE_INDEX_ERASED;
+        if (++erasedCount > pendingLimit()) {
+            dropErased();
+        }
+    }
+    
+    // Буфер сжимается, когда мусора становится больше половины
+    if (garbageBytes > arena.size() / 2) {
+        compact();
+    }
+    return true;
+}
+
+size_t TitleIndex::eraseIds(const std::unordered_set<int>& ids) {
+    size_t before = size();
+    auto removed = [&](const Entry& entry) {
+        if (isErased(entry)) {
+            return true;
+        }
+        if (ids.count(entry.id) == 0) {
+            return false;
+        }
+        garbageBytes += entry.length;
+        return true;
+    };
+    entries.erase(std::remove_if(entries.begin(), entries.end(), removed), entries.end());
+    pending.erase(std::remove_if(pending.begin(), pending.end(), removed), pending.end());
+    erasedCount = 0;
+    
+    if (garbageBytes > arena.size() / 2) {
+        compact();
+    }
+    return before - size();
+}
+
+void TitleIndex::append(const std::string& title, int id) {
+    entries.push_back(storeKey(title, id));
+}
+
+void TitleIndex::finalize() {
+    dropErased();
+    entries.insert(entries.end(), pending.begin(), pending.end());
+    pending.clear();
+    std::sort(entries.begin(), entries.end(),
+        [this](const Entry& a, const Entry& b) { return less(a, b); });
+}
+
+std::vector<int> TitleIndex::complete(const std::string& prefix, size_t limit) const {
+    // Незавершенный последний символ отбрасывается, чтобы префикс,
+    // обрезанный посередине кириллической буквы, оставался корректным
+    std::string key = foldCaseUtf8(
+        std::string_view(prefix).substr(0, utf8CompletePrefixLength(prefix)));
+    
+    auto first = [&](const std::vector<Entry>& sorted) {
+        return std::lower_bound(sorted.begin(), sorted.end(), key,
+            [this](const Entry& entry, const std::string& k) {
+                return keyOf(entry) < std::string_view(k);
+            });
+    };
+    auto matches = [&](std::vector<Entry>::const_iterator pos, const std::vector<Entry>& sorted) {
+        return pos != sorted.end() && keyOf(*pos).compare(0, key.size(), key) == 0;
+    };
+    
+    // Совпадения из основного массива и из добавок сливаются по порядку,
+    // помеченные удаленными записи пропускаются
+    std::vector<int> result;
+    auto main = first(entries);
+    auto added = first(pending);
+    while (result.size() < limit) {
+        if (main != entries.end() && isErased(*main)) {
+            ++main;
+            continue;
+        }
+        bool haveMain = matches(main, entries);
+        bool haveAdded = matches(added, pending);
+        if (!haveMain && !haveAdded) {
+            break;
+        }
+        if (haveMain && (!haveAdded || less(*main, *added))) {
+            result.push_back((main++)->id);
+        } else {
+            result.push_back((added++)->id);
+        }
+    }
+    return result;
+}
+
+void TitleIndex::clear() {
+    arena.clear();
+    entries.clear();
+    pending.clear();
+    erasedCount = 0;
+    garbageBytes = 0;
+}
+
+size_t TitleIndex::memoryUsage() const {
+    return stringHeapBytes(arena) + vectorHeapBytes(entries) + vectorHeapBytes(pending);
+}
+
+void TitleIndex::save(SnapshotWriter& out) const {
+    // В снимке один отсортированный массив без пометок, как после слияния
+    out.putString(arena);
+    if (pending.empty() && erasedCount == 0) {
+        out.putVector(entries);
+    } else {
+        std::vector<Entry> merged(entries.size() + pending.size());
+        auto end = std::merge(entries.begin(), entries.end(), pending.begin(), pending.end(), merged.begin(),
+            [this](const Entry& a, const Entry& b) { return less(a, b); });
+        merged.erase(std::remove_if(merged.begin(), end, isErased), merged.end());
+        out.putVector(merged);
+    }
+    out.putU64(garbageBytes);
+}
+
+void TitleIndex::load(SnapshotReader& in) {
+    arena = in.getString();
+    in.getVector(entries);
+    pending.clear();
+    erasedCount = 0;
+    garbageBytes = in.getU64();
+    
+    // Ключи должны лежать внутри буфера
+    for (const Entry& entry : entries) {
+        if (entry.offset > arena.size() || entry.length > arena.size() - entry.offset) {
+            clear();
+            throw std::runtime_error("Снимок префиксного индекса поврежден");
+        }
+    }
+}
+
+void TitleIndex::compact() {
+    dropErased();
+    std::string newArena;
+    newArena.reserve(arena.size() - garbageBytes);
+    for (std::vector<Entry>* sorted : {&entries, &pending}) {
+        for (Entry& entry : *sorted) {
+            uint32_t offset = static_cast<uint32_t>(newArena.size());
+            newArena.append(arena, entry.offset, entry.length);
+            entry.offset = offset;
+        }
+    }
+    arena.swap(newArena);
+    garbageBytes = 0;
+}
@@ -0,0 +1,82 @@
+#ifndef TITLE_INDEX_H
+#define TITLE_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+class SnapshotWriter;
+class SnapshotReader;
+
+// Префиксный индекс названий заметок для автодополнения.
+// Ключи (названия в нижнем регистре) хранятся подряд в одном буфере,
+// а отсортированный массив записей ссылается на них смещениями:
+// 12 байт на запись плюс байты ключа, без отдельной строки на каждый ключ.
+//
+// Вставка в основной массив сдвигала бы его целиком (на 1 млн названий -
+// около 100 мкс), поэтому новые записи попадают в небольшой отсортированный
+// массив добавок. Добавки вливаются в основной массив одним проходом, когда их
+// становится больше корня из размера индекса: вставка стоит O(корень из n),
+// поиск просматривает оба массива. Удаление из основного массива по той же
+// причине только помечает запись; помеченные записи пропускаются поиском и
+// выбрасываются при слиянии или когда их становится больше того же порога.
+class TitleIndex {
+public:
+    TitleIndex();
+    
+    // Добавление и удаление с сохранением порядка
+    void insert(const std::string& title, int id);
+    bool erase(const std::string& title, int id);
+    // Массовое удаление: один проход по записям вместо сдвига массива на каждую
+    size_t eraseIds(const std::unordered_set<int>& ids);
+    
+    // Массовая загрузка: append без сортировки, затем один finalize()
+    void append(const std::string& title, int id);
+    void finalize();
+    
+    // ID заметок, названия которых начинаются с prefix (без учета регистра),
+    // в алфавитном порядке, не более limit штук
+    std::vector<int> complete(const std::string& prefix, size_t limit) const;
+    
+    // Сохранение в снимок и восстановление без перестроения (snapshot.h)
+    void save(SnapshotWriter& out) const;
+    void load(SnapshotReader& in);
+    
+    void clear();
+    size_t size() const { return entries.size() - erasedCount + pending.size(); }
+    // Байты кучи индекса (memory.h)
+    size_t memoryUsage() const;
+    
+private:
+    struct Entry {
+        uint32_t offset;        // Смещение ключа в буфере
+        uint32_t length;        // Длина ключа в байтах
+        int id;                 // ID заметки
+    };
+    
+    std::string arena;          // Буфер ключей
+    std::vector<Entry> entries; // Записи, отсортированные по (ключ, ID)
+    std::vector<Entry> pending; // Добавки с последнего слияния, в том же порядке
+    size_t erasedCount;         // Помеченных удаленными записей в entries
+    size_t garbageBytes;        // Байты удаленных ключей в буфере
+    
+    std::string_view keyOf(const Entry& entry) const;
+    static bool isErased(const Entry& entry);
+    Entry storeKey(const std::string& title, int id);
+    bool less(const Entry& a, const Entry& b) const;
+    
+    // Позиция записи (ключ, ID) в отсортированном массиве или end()
+    std::vector<Entry>::iterator findEntry(std::vector<Entry>& sorted, const std::string& key, int id);
+    // Допустимое число добавок и пометок до слияния
+    size_t pendingLimit() const;
+    // Слияние добавок с основным массивом и выброс помеченных записей
+    void mergePending();
+    void dropErased();
+    
+    // Сборка мусора в буфере ключей
+    void compact();
+};
+
+#endif // TITLE_INDEX_H
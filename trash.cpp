@@ -0,0 +1,139 @@
+#include "trash.h"
+#include "metadata.h"
+#include <cstdio>
+#include <fstream>
+#include <unordered_map>
+
+std::string formatTrashRecord(const TrashEntry& entry) {
+    return "D|" + std::to_string(entry.deletedAt) + "|" + std::to_string(entry.batch) + "|" +
+           entry.note.bodyHash + "|" + std::to_string(entry.bodySize) + "|" +
+           formatMetadataRecord(entry.note);
+}
+
+std::string formatRestoreRecord(int id) {
+    return "R|" + std::to_string(id);
+}
+
+// Поле до следующего '|'; pos сдвигается за разделитель
+static bool nextField(const std::string& line, size_t& pos, std::string& field) {
+    size_t separator = line.find('|', pos);
+    if (separator == std::string::npos) {
+        return false;
+    }
+    field.assign(line, pos, separator - pos);
+    pos = separator + 1;
+    return true;
+}
+
+// Разбор числа без знака в поле целиком
+static bool parseNumber(const std::string& field, uint64_t& value) {
+    if (field.empty() || field.size() > 19) {
+        return false;
+    }
+    value = 0;
+    for (char c : field) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+}
+
+static bool parseTrashRecord(const std::string& line, TrashEntry& entry) {
+    size_t pos = 2;
+    std::string deletedAt, batch, bodySize, error;
+    uint64_t number = 0;
+    if (!nextField(line, pos, deletedAt) || !nextField(line, pos, batch) ||
+        !nextField(line, pos, entry.note.bodyHash) || !nextField(line, pos, bodySize)) {
+        return false;
+    }
+    if (!parseNumber(deletedAt, number)) {
+        return false;
+    }
+    entry.deletedAt = static_cast<int64_t>(number);
+    if (!parseNumber(batch, entry.batch) || !parseNumber(bodySize, entry.bodySize)) {
+        return false;
+    }
+    return parseMetadataRecord(line.substr(pos), 2, entry.note, error);
+}
+
+bool readTrashJournal(const std::string& path, std::vector<TrashEntry>& entries) {
+    entries.clear();
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    // Повторное удаление того же ID заменяет прежнюю запись
+    std::unordered_map<int, size_t> positions;
+    std::vector<bool> restored;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.size() > 2 && line.compare(0, 2, "D|") == 0) {
+            TrashEntry entry;
+            if (!parseTrashRecord(line, entry)) {
+                continue;
+            }
+            auto it = positions.find(entry.note.id);
+            if (it != positions.end()) {
+                entries[it->second] = std::move(entry);
+            } else {
+                positions[entry.note.id] = entries.size();
+                entries.push_back(std::move(entry));
+                restored.push_back(false);
+            }
+        } else if (line.size() > 2 && line.compare(0, 2, "R|") == 0) {
+            uint64_t id = 0;
+            auto it = parseNumber(line.substr(2), id) ? positions.find(static_cast<int>(id)) : positions.end();
+            if (it != positions.end()) {
+                restored[it->second] = true;
+                positions.erase(it);
+            }
+        }
+    }
+    
+    std::vector<TrashEntry> remaining;
+    remaining.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!restored[i]) {
+            remaining.push_back(std::move(entries[i]));
+        }
+    }
+    entries = std::move(remaining);
+    return true;
+}
+
+bool appendTrashJournal(const std::string& path, const std::string& lines) {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+    file.close();
+    return static_cast<bool>(file);
+}
+
+bool writeTrashJournal(const std::string& path, const std::vector<TrashEntry>& entries) {
+    std::string data;
+    for (const TrashEntry& entry : entries) {
+        data += formatTrashRecord(entry);
+        data += '\n';
+    }
+    
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file.close();
+        if (!file) {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef TRASH_H
+#define TRASH_H
+
+#include "note.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Журнал корзины (<метаданные>.trash).
+//
+// По строке на событие:
+//   D|время_удаления|операция|хеш_текста|размер_текста|<запись метаданных>
+//   R|id
+// D - заметка перемещена в корзину (запись метаданных целиком, см. metadata.h),
+// R - заметка восстановлена. Операция - номер удаления: все заметки, удаленные
+// одной командой (например, вся тема), имеют один номер и восстанавливаются
+// вместе. Журнал только дописывается; при очистке корзины он перезаписывается
+// оставшимися заметками. Оборванная последняя строка (сбой при записи)
+// пропускается.
+
+// Строки журнала (без перевода строки)
+std::string formatTrashRecord(const TrashEntry& entry);
+std::string formatRestoreRecord(int id);
+
+// Чтение журнала: заметки, оставшиеся в корзине, в порядке удаления.
+// false - журнала нет.
+bool readTrashJournal(const std::string& path, std::vector<TrashEntry>& entries);
+
+// Дописывание строк в конец журнала одной операцией
+bool appendTrashJournal(const std::string& path, const std::string& lines);
+
+// Перезапись журнала (через временный файл) текущим содержимым корзины
+bool writeTrashJournal(const std::string& path, const std::vector<TrashEntry>& entries);
+
+#endif // TRASH_H
@@ -1,22 +1,40 @@
 #include "ui.h"
 #include "validation.h"
+#include "timestamp.h"
 #include <iostream>
 #include <limits>
 
 UI::UI(NoteManager& manager) : noteManager(manager) {}
 
 void UI::run() {
-    // Загружаем данные при запуске
+    // Загружаем данные при запуске; удаление из меню идет через корзину,
+    // о почти повторяющемся тексте новой заметки программа предупреждает
     noteManager.loadFromFile();
+    noteManager.setDeleteMode(DeleteMode::Trash);
+    noteManager.setNearDuplicateWarning(NEAR_DUPLICATE_THRESHOLD);
+    
+    // Изменения файлов заметок вне программы применяются перед каждым показом меню
+    NoteWatcher watcher(noteManager.getNotesDir());
     
     bool running = true;
     
     while (running) {
+        WatchBatch batch;
+        if (watcher.takeBatch(batch)) {
+            int changed = noteManager.reconcile(batch);
+            if (changed > 0) {
+                std::cout << "Применены внешние изменения файлов, заметок: " << changed << std::endl;
+            }
+        }
+        
+        // Заметки, пролежавшие в корзине дольше срока хранения, удаляются в фоне
+        noteManager.purgeTrash(currentTimestampUs() - TRASH_RETENTION_US);
+        
         displayMainMenu();
         
         int choice = getIntInput("Выберите пункт меню: ");
         
-        if (!validateMenuChoice(choice, 1, 6)) {
+        if (!validateMenuChoice(choice, 1, 11)) {
             continue;
         }
         
@@ -33,12 +51,29 @@ void UI::run() {
                 handleSearchByCategory();
                 break;
             case 4:
-                handleOpenNote();
+                handleSearchByContent();
                 break;
             case 5:
-                handleDeleteNote();
+                handleSearchByTags();
                 break;
             case 6:
+                handleOpenNote();
+                break;
+            case 7:
+                handleEditNote();
+                break;
+            case 8:
+                handleDeleteNote();
+                break;
+            case 9:
+                handleTrash();
+                break;
+            case 10:
+                handleHistory();
+                break;
+            case 11:
+                // Снимок индексов ускоряет следующий запуск
+                noteManager.saveSnapshot();
                 std::cout << "Выход из программы. До свидания!" << std::endl;
                 running = false;
                 break;
@@ -57,9 +92,14 @@ void UI::displayMainMenu() const {
     std::cout << "1. Создать новую заметку" << std::endl;
     std::cout << "2. Показать все заметки" << std::endl;
     std::cout << "3. Поиск по теме" << std::endl;
-    std::cout << "4. Открыть заметку" << std::endl;
-    std::cout << "5. Удалить заметку" << std::endl;
-    std::cout << "6. Выход" << std::endl;
+    std::cout << "4. Поиск по тексту" << std::endl;
+    std::cout << "5. Поиск по меткам" << std::endl;
+    std::cout << "6. Открыть заметку" << std::endl;
+    std::cout << "7. Редактировать заметку" << std::endl;
+    std::cout << "8. Удалить заметку" << std::endl;
+    std::cout << "9. Корзина" << std::endl;
+    std::cout << "10. История заметки" << std::endl;
+    std::cout << "11. Выход" << std::endl;
     std::cout << std::endl;
 }
 
@@ -81,7 +121,12 @@ void UI::handleCreateNote() {
         content = getInput("Введите текст заметки: ");
     } while (!validateNoteContent(content));
     
-    if (noteManager.addNote(title, category, content)) {
+    std::vector<std::string> tags;
+    do {
+        tags = parseTags(getInput("Введите метки через запятую (можно оставить пустым): "));
+    } while (!validateNoteTags(tags));
+    
+    if (noteManager.addNote(title, category, content, tags)) {
         std::cout << "\nЗаметка успешно создана!" << std::endl;
     } else {
         std::cout << "\nНе удалось создать заметку." << std::endl;
@@ -97,6 +142,36 @@ void UI::handleSearchByCategory() {
     noteManager.searchByCategory(category);
 }
 
+void UI::handleSearchByContent() {
+    std::string text = getInput("Введите текст для поиска: ");
+    if (text.empty()) {
+        std::cout << "Ошибка: строка поиска не может быть пустой" << std::endl;
+        return;
+    }
+    noteManager.searchByContent(text);
+}
+
+void UI::handleSearchByTags() {
+    std::vector<TagCount> counts = noteManager.tagCounts();
+    if (counts.empty()) {
+        std::cout << "У заметок пока нет меток." << std::endl;
+        return;
+    }
+    
+    std::cout << "Метки:";
+    for (const TagCount& facet : counts) {
+        std::cout << " " << facet.tag << " (" << facet.count << ")";
+    }
+    std::cout << std::endl;
+    
+    std::string query = getInput("Запрос (например: работа AND срочно AND NOT архив): ");
+    if (query.empty()) {
+        std::cout << "Ошибка: запрос не может быть пустым" << std::endl;
+        return;
+    }
+    noteManager.searchByTags(query);
+}
+
 void UI::handleOpenNote() {
     if (noteManager.getNoteCount() == 0) {
         std::cout << "Нет доступных заметок для отображения." << std::endl;
@@ -107,6 +182,65 @@ void UI::handleOpenNote() {
     noteManager.displayNote(id);
 }
 
+void UI::handleEditNote() {
+    if (noteManager.getNoteCount() == 0) {
+        std::cout << "Нет доступных заметок для редактирования." << std::endl;
+        return;
+    }
+    
+    int id = getIntInput("Введите ID заметки для редактирования: ");
+    
+    const Note* note = noteManager.getNote(id);
+    if (note == nullptr) {
+        std::cout << "Заметка с ID " << id << " не найдена." << std::endl;
+        return;
+    }
+    
+    std::cout << "Оставьте поле пустым, чтобы сохранить текущее значение." << std::endl;
+    
+    std::string title;
+    do {
+        title = getInput("Новое название [" + note->title + "]: ");
+        if (title.empty()) {
+            title = note->title;
+        }
+    } while (!validateNoteTitle(title));
+    
+    std::string category;
+    do {
+        category = getInput("Новая тема [" + note->category + "]: ");
+        if (category.empty()) {
+            category = note->category;
+        }
+    } while (!validateNoteCategory(category));
+    
+    std::string content;
+    do {
+        content = getInput("Новый текст (Enter - без изменений): ");
+        if (content.empty()) {
+            content = note->content;
+        }
+    } while (!validateNoteContent(content));
+    
+    std::vector<std::string> tags;
+    do {
+        std::string input = getInput("Новые метки [" + joinTags(note->tags) + "] (\"-\" - убрать все): ");
+        if (input.empty()) {
+            tags = note->tags;
+        } else if (input == "-") {
+            tags.clear();
+        } else {
+            tags = parseTags(input);
+        }
+    } while (!validateNoteTags(tags));
+    
+    if (noteManager.updateNote(id, title, category, content) && noteManager.setNoteTags(id, tags)) {
+        std::cout << "\nЗаметка успешно обновлена!" << std::endl;
+    } else {
+        std::cout << "\nНе удалось обновить заметку." << std::endl;
+    }
+}
+
 void UI::handleDeleteNote() {
     if (noteManager.getNoteCount() == 0) {
         std::cout << "Нет доступных заметок для удаления." << std::endl;
@@ -122,7 +256,7 @@ void UI::handleDeleteNote() {
     
     if (confirmAction("Вы уверены, что хотите удалить эту заметку?")) {
         if (noteManager.deleteNote(id)) {
-            std::cout << "Заметка успешно удалена!" << std::endl;
+            std::cout << "Заметка перемещена в корзину (восстановление - пункт 9)." << std::endl;
         } else {
             std::cout << "Не удалось удалить заметку." << std::endl;
         }
@@ -131,6 +265,128 @@ void UI::handleDeleteNote() {
     }
 }
 
+void UI::handleTrash() {
+    std::cout << "=== КОРЗИНА ===" << std::endl;
+    const std::vector<TrashEntry>& trash = noteManager.getTrash();
+    if (trash.empty()) {
+        std::cout << "Корзина пуста." << std::endl;
+    }
+    for (const TrashEntry& entry : trash) {
+        std::cout << entry.note.id << " | " << entry.note.title << " | " << entry.note.category
+                  << " | удалена " << localDate(entry.deletedAt) << std::endl;
+    }
+    
+    std::cout << "\n1. Отменить последнее удаление" << std::endl;
+    std::cout << "2. Восстановить заметку по ID" << std::endl;
+    std::cout << "3. Удалить все заметки темы" << std::endl;
+    std::cout << "4. Очистить корзину" << std::endl;
+    std::cout << "5. Назад" << std::endl;
+    
+    int choice = getIntInput("Выберите действие: ");
+    if (!validateMenuChoice(choice, 1, 5)) {
+        return;
+    }
+    
+    switch (choice) {
+        case 1: {
+            int restored = noteManager.undoDelete();
+            std::cout << "Восстановлено заметок: " << restored << std::endl;
+            break;
+        }
+        case 2: {
+            int id = getIntInput("Введите ID заметки для восстановления: ");
+            if (noteManager.restoreNote(id)) {
+                std::cout << "Заметка восстановлена!" << std::endl;
+            }
+            break;
+        }
+        case 3: {
+            std::string category = getInput("Введите тему: ");
+            size_t count = noteManager.findByCategory(category).size();
+            if (count == 0) {
+                std::cout << "Заметок с темой \"" << category << "\" нет." << std::endl;
+            } else if (confirmAction("Переместить в корзину заметок: " + std::to_string(count) + "?")) {
+                std::cout << "Перемещено в корзину: " << noteManager.deleteByCategory(category) << std::endl;
+            }
+            break;
+        }
+        case 4:
+            if (!trash.empty() && confirmAction("Удалить заметки из корзины без возможности восстановления?")) {
+                std::cout << "Удалено заметок: " << noteManager.purgeTrash(currentTimestampUs()) << std::endl;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void UI::handleHistory() {
+    std::cout << "=== ИСТОРИЯ ЗАМЕТКИ ===" << std::endl;
+    int id = getIntInput("Введите ID заметки: ");
+    if (!noteManager.noteExists(id)) {
+        std::cout << "Заметка с ID " << id << " не найдена." << std::endl;
+        return;
+    }
+    
+    std::vector<RevisionInfo> revisions = noteManager.listRevisions(id);
+    if (revisions.empty()) {
+        std::cout << "Заметка не изменялась." << std::endl;
+        return;
+    }
+    for (const RevisionInfo& info : revisions) {
+        std::cout << info.number << " | " << localDate(info.savedAt) << " | " << info.title
+                  << " | " << info.category << " | " << info.size << " байт" << std::endl;
+    }
+    
+    std::cout << "\n1. Показать версию" << std::endl;
+    std::cout << "2. Сравнить две версии" << std::endl;
+    std::cout << "3. Вернуть заметку к версии" << std::endl;
+    std::cout << "4. Назад" << std::endl;
+    
+    int choice = getIntInput("Выберите действие: ");
+    if (!validateMenuChoice(choice, 1, 4)) {
+        return;
+    }
+    
+    switch (choice) {
+        case 1: {
+            int number = getIntInput("Номер версии: ");
+            NoteVersion version;
+            if (number > 0 && noteManager.getRevision(id, static_cast<uint32_t>(number), version)) {
+                std::cout << "\nНазвание: " << version.title << "\nТема: " << version.category
+                          << "\n\n" << version.content << std::endl;
+            } else {
+                std::cout << "Версия не найдена." << std::endl;
+            }
+            break;
+        }
+        case 2: {
+            int from = getIntInput("Старая версия: ");
+            int to = getIntInput("Новая версия: ");
+            std::vector<DiffLine> diff;
+            if (from <= 0 || to <= 0 ||
+                !noteManager.diffRevisions(id, static_cast<uint32_t>(from), static_cast<uint32_t>(to), diff)) {
+                std::cout << "Версия не найдена." << std::endl;
+                break;
+            }
+            for (const DiffLine& line : diff) {
+                std::cout << line.op << ' ' << line.text << std::endl;
+            }
+            break;
+        }
+        case 3: {
+            int number = getIntInput("Номер версии: ");
+            if (number > 0 && confirmAction("Вернуть заметку к версии " + std::to_string(number) + "?") &&
+                noteManager.restoreRevision(id, static_cast<uint32_t>(number))) {
+                std::cout << "Заметка возвращена к версии " << number << "." << std::endl;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
 std::string UI::getInput(const std::string& prompt) {
     std::cout << prompt;
     std::string input;
@@ -22,8 +22,13 @@ private:
     void handleCreateNote();
     void handleShowAllNotes();
     void handleSearchByCategory();
+    void handleSearchByContent();
+    void handleSearchByTags();
     void handleOpenNote();
+    void handleEditNote();
     void handleDeleteNote();
+    void handleTrash();
+    void handleHistory();
     
     // Вспомогательные функции ввода
     std::string getInput(const std::string& prompt);
@@ -0,0 +1,451 @@
+#include "utf8.h"
+#include "scan.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define UTF8_X86 1
+    #include <immintrin.h>
+#endif
+
+char32_t decodeUtf8Char(std::string_view text, size_t& pos) {
+    unsigned char lead = static_cast<unsigned char>(text[pos]);
+    
+    // Однобайтовый символ ASCII
+    if (lead < 0x80) {
+        pos++;
+        return lead;
+    }
+    
+    int length;
+    char32_t cp;
+    char32_t minValue;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        cp = lead & 0x1F;
+        minValue = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        cp = lead & 0x0F;
+        minValue = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        cp = lead & 0x07;
+        minValue = 0x10000;
+    } else {
+        pos++;
+        return UTF8_REPLACEMENT;
+    }
+    
+    if (pos + length > text.size()) {
+        pos++;
+        return UTF8_REPLACEMENT;
+    }
+    
+    for (int i = 1; i < length; i++) {
+        unsigned char c = static_cast<unsigned char>(text[pos + i]);
+        if ((c & 0xC0) != 0x80) {
+            pos++;
+            return UTF8_REPLACEMENT;
+        }
+        cp = (cp << 6) | (c & 0x3F);
+    }
+    
+    // Отбрасываем избыточные кодировки, суррогаты и значения вне Unicode
+    if (cp < minValue || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        pos++;
+        return UTF8_REPLACEMENT;
+    }
+    
+    pos += length;
+    return cp;
+}
+
+std::u32string decodeUtf8(std::string_view text) {
+    std::u32string result;
+    result.reserve(text.size());
+    size_t pos = 0;
+    while (pos < text.size()) {
+        result.push_back(decodeUtf8Char(text, pos));
+    }
+    return result;
+}
+
+void appendUtf8(std::string& out, char32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+char32_t foldCase(char32_t cp) {
+    // Латиница
+    if (cp >= 'A' && cp <= 'Z') {
+        return cp + 0x20;
+    }
+    if (cp < 0x80) {
+        return cp;
+    }
+    // Latin-1: À-Þ, кроме знака умножения
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) {
+        return cp + 0x20;
+    }
+    // Кириллица: Ѐ-Џ (включая Ё) и А-Я
+    if (cp >= 0x400 && cp <= 0x40F) {
+        return cp + 0x50;
+    }
+    if (cp >= 0x410 && cp <= 0x42F) {
+        return cp + 0x20;
+    }
+    return cp;
+}
+
+std::string foldCaseUtf8(std::string_view text) {
+    std::string result;
+    result.reserve(text.size());
+    size_t pos = 0;
+    while (pos < text.size()) {
+        unsigned char c = static_cast<unsigned char>(text[pos]);
+        if (c < 0x80) {
+            // Быстрый путь для ASCII
+            result.push_back(static_cast<char>(c >= 'A' && c <= 'Z' ? c + 0x20 : c));
+            pos++;
+            continue;
+        }
+        appendUtf8(result, foldCase(decodeUtf8Char(text, pos)));
+    }
+    return result;
+}
+
+size_t utf8CompletePrefixLength(std::string_view text) {
+    // Ищем начало последнего символа (не более 4 байт назад)
+    size_t end = text.size();
+    size_t start = end;
+    while (start > 0 && end - start < 4) {
+        start--;
+        unsigned char c = static_cast<unsigned char>(text[start]);
+        if ((c & 0xC0) != 0x80) {
+            break;
+        }
+    }
+    if (start == end) {
+        return end;
+    }
+    
+    unsigned char lead = static_cast<unsigned char>(text[start]);
+    size_t expected = 1;
+    if ((lead & 0xE0) == 0xC0) {
+        expected = 2;
+    } else if ((lead & 0xF0) == 0xE0) {
+        expected = 3;
+    } else if ((lead & 0xF8) == 0xF0) {
+        expected = 4;
+    }
+    
+    return (end - start < expected) ? start : end;
+}
+
+// ===== ПРОВЕРКА UTF-8 =====
+
+// Скалярная проверка; ASCII пропускается по 8 байт
+static bool utf8LengthScalar(const unsigned char* data, size_t size, size_t& length) {
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos < size) {
+        if (pos + 8 <= size) {
+            uint64_t block;
+            std::memcpy(&block, data + pos, sizeof(block));
+            if ((block & 0x8080808080808080ULL) == 0) {
+                pos += 8;
+                count += 8;
+                continue;
+            }
+        }
+        
+        unsigned char lead = data[pos];
+        if (lead < 0x80) {
+            pos++;
+            count++;
+            continue;
+        }
+        
+        // Допустимые диапазоны второго байта зависят от первого (RFC 3629)
+        size_t need;
+        unsigned char low = 0x80;
+        unsigned char high = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            need = 2;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            need = 3;
+            if (lead == 0xE0) {
+                low = 0xA0;
+            } else if (lead == 0xED) {
+                high = 0x9F;
+            }
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            need = 4;
+            if (lead == 0xF0) {
+                low = 0x90;
+            } else if (lead == 0xF4) {
+                high = 0x8F;
+            }
+        } else {
+            return false;
+        }
+        
+        if (size - pos < need || data[pos + 1] < low || data[pos + 1] > high) {
+            return false;
+        }
+        for (size_t i = 2; i < need; i++) {
+            if ((data[pos + i] & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        pos += need;
+        count++;
+    }
+    length = count;
+    return true;
+}
+
+#ifdef UTF8_X86
+
+// Векторная проверка по таблицам (алгоритм Кейзера-Лемира): для каждой пары
+// соседних байтов три таблицы по 16 элементов дают битовые маски возможных
+// ошибок, их пересечение непусто только для некорректной пары. Отдельно
+// проверяется, что третий и четвертый байты длинных последовательностей -
+// продолжения. Кодовые точки считаются как байты, не являющиеся продолжением.
+
+// Классы ошибок (биты масок)
+const uint8_t UTF8_TOO_SHORT = 1 << 0;      // Ведущий байт без продолжения
+const uint8_t UTF8_TOO_LONG = 1 << 1;       // Продолжение после ASCII
+const uint8_t UTF8_OVERLONG_3 = 1 << 2;     // Избыточная трехбайтовая запись
+const uint8_t UTF8_TOO_LARGE = 1 << 3;      // Больше U+10FFFF
+const uint8_t UTF8_SURROGATE = 1 << 4;      // Суррогаты U+D800-U+DFFF
+const uint8_t UTF8_OVERLONG_2 = 1 << 5;     // Избыточная двухбайтовая запись
+const uint8_t UTF8_TOO_LARGE_1000 = 1 << 6; // Больше U+10FFFF (второй байт 1000____)
+const uint8_t UTF8_OVERLONG_4 = 1 << 6;     // Избыточная четырехбайтовая запись
+const uint8_t UTF8_TWO_CONTS = 1 << 7;      // Два продолжения подряд без ведущего байта
+const uint8_t UTF8_CARRY = UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS;
+
+// Старшая тетрада первого байта пары
+alignas(16) static const uint8_t UTF8_BYTE1_HIGH[16] = {
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+};
+
+// Младшая тетрада первого байта пары
+alignas(16) static const uint8_t UTF8_BYTE1_LOW[16] = {
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+    UTF8_CARRY | UTF8_OVERLONG_2,
+    UTF8_CARRY,
+    UTF8_CARRY,
+    UTF8_CARRY | UTF8_TOO_LARGE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000
+};
+
+// Старшая тетрада второго байта пары
+alignas(16) static const uint8_t UTF8_BYTE2_HIGH[16] = {
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+};
+
+// Порог незавершенной последовательности в конце блока: последние три байта
+// не должны начинать последовательность длиннее оставшегося места
+alignas(32) static const uint8_t UTF8_MAX_TAIL[32] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+};
+
+// ===== SSE4.2 =====
+
+__attribute__((target("sse4.2")))
+static inline __m128i utf8HighNibbleSSE(__m128i value) {
+    return _mm_and_si128(_mm_srli_epi16(value, 4), _mm_set1_epi8(0x0F));
+}
+
+// Маска ошибок блока; previous - предыдущий блок (для пар на границе)
+__attribute__((target("sse4.2")))
+static inline __m128i utf8BlockErrorsSSE(__m128i input, __m128i previous) {
+    __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+    __m128i prev2 = _mm_alignr_epi8(input, previous, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, previous, 13);
+    
+    __m128i byte1High = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(UTF8_BYTE1_HIGH)),
+                                         utf8HighNibbleSSE(prev1));
+    __m128i byte1Low = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(UTF8_BYTE1_LOW)),
+                                        _mm_and_si128(prev1, _mm_set1_epi8(0x0F)));
+    __m128i byte2High = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(UTF8_BYTE2_HIGH)),
+                                         utf8HighNibbleSSE(input));
+    __m128i special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+    
+    // Байт через один после 111_____ и через два после 1111____ - продолжения
+    __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(static_cast<char>(0x80)));
+    return _mm_xor_si128(must23, special);
+}
+
+__attribute__((target("sse4.2")))
+static bool utf8LengthSSE42(const unsigned char* data, size_t size, size_t& length) {
+    const __m128i maxTail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(UTF8_MAX_TAIL + 16));
+    const __m128i contLimit = _mm_set1_epi8(-64);
+    __m128i previous = _mm_setzero_si128();
+    __m128i errors = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+    size_t continuations = 0;
+    
+    size_t pos = 0;
+    alignas(16) unsigned char tail[16];
+    while (pos < size) {
+        __m128i input;
+        if (size - pos >= 16) {
+            input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        } else {
+            // Хвост дополняется нулями: это ASCII, и незавершенная
+            // последовательность перед ними даст ошибку TOO_SHORT
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, data + pos, size - pos);
+            input = _mm_load_si128(reinterpret_cast<const __m128i*>(tail));
+        }
+        
+        if (_mm_movemask_epi8(input) == 0) {
+            // Блок ASCII: достаточно проверить конец предыдущего блока
+            errors = _mm_or_si128(errors, incomplete);
+        } else {
+            errors = _mm_or_si128(errors, utf8BlockErrorsSSE(input, previous));
+            incomplete = _mm_subs_epu8(input, maxTail);
+            continuations += __builtin_popcount(static_cast<unsigned>(
+                _mm_movemask_epi8(_mm_cmpgt_epi8(contLimit, input))));
+        }
+        previous = input;
+        pos += 16;
+    }
+    errors = _mm_or_si128(errors, incomplete);
+    
+    if (!_mm_testz_si128(errors, errors)) {
+        return false;
+    }
+    length = size - continuations;
+    return true;
+}
+
+// ===== AVX2 =====
+
+__attribute__((target("avx2")))
+static inline __m256i utf8HighNibbleAVX2(__m256i value) {
+    return _mm256_and_si256(_mm256_srli_epi16(value, 4), _mm256_set1_epi8(0x0F));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i utf8BlockErrorsAVX2(__m256i input, __m256i previous) {
+    // Сдвиг на N байтов через границу 128-битных половин
+    __m256i joined = _mm256_permute2x128_si256(previous, input, 0x21);
+    __m256i prev1 = _mm256_alignr_epi8(input, joined, 15);
+    __m256i prev2 = _mm256_alignr_epi8(input, joined, 14);
+    __m256i prev3 = _mm256_alignr_epi8(input, joined, 13);
+    
+    __m256i byte1High = _mm256_shuffle_epi8(
+        _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(UTF8_BYTE1_HIGH))),
+        utf8HighNibbleAVX2(prev1));
+    __m256i byte1Low = _mm256_shuffle_epi8(
+        _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(UTF8_BYTE1_LOW))),
+        _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+    __m256i byte2High = _mm256_shuffle_epi8(
+        _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(UTF8_BYTE2_HIGH))),
+        utf8HighNibbleAVX2(input));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+    
+    __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+    return _mm256_xor_si256(must23, special);
+}
+
+__attribute__((target("avx2")))
+static bool utf8LengthAVX2(const unsigned char* data, size_t size, size_t& length) {
+    const __m256i maxTail = _mm256_load_si256(reinterpret_cast<const __m256i*>(UTF8_MAX_TAIL));
+    const __m256i contLimit = _mm256_set1_epi8(-64);
+    __m256i previous = _mm256_setzero_si256();
+    __m256i errors = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    size_t continuations = 0;
+    
+    size_t pos = 0;
+    alignas(32) unsigned char tail[32];
+    while (pos < size) {
+        __m256i input;
+        if (size - pos >= 32) {
+            input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        } else {
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, data + pos, size - pos);
+            input = _mm256_load_si256(reinterpret_cast<const __m256i*>(tail));
+        }
+        
+        if (_mm256_movemask_epi8(input) == 0) {
+            errors = _mm256_or_si256(errors, incomplete);
+        } else {
+            errors = _mm256_or_si256(errors, utf8BlockErrorsAVX2(input, previous));
+            incomplete = _mm256_subs_epu8(input, maxTail);
+            continuations += __builtin_popcount(static_cast<unsigned>(
+                _mm256_movemask_epi8(_mm256_cmpgt_epi8(contLimit, input))));
+        }
+        previous = input;
+        pos += 32;
+    }
+    errors = _mm256_or_si256(errors, incomplete);
+    
+    if (!_mm256_testz_si256(errors, errors)) {
+        return false;
+    }
+    length = size - continuations;
+    return true;
+}
+
+#endif // UTF8_X86
+
+bool utf8Length(std::string_view text, size_t& length) {
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+    switch (getScanLevel()) {
+#ifdef UTF8_X86
+        case ScanLevel::AVX2:
+            return utf8LengthAVX2(data, text.size(), length);
+        case ScanLevel::SSE42:
+            return utf8LengthSSE42(data, text.size(), length);
+#endif
+        default:
+            return utf8LengthScalar(data, text.size(), length);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <string>
+#include <string_view>
+
+// Символ замены для некорректных последовательностей UTF-8
+const char32_t UTF8_REPLACEMENT = 0xFFFD;
+
+// Декодирование одного символа, начиная с позиции pos.
+// pos сдвигается на начало следующего символа; некорректная
+// последовательность дает UTF8_REPLACEMENT и сдвиг на один байт.
+char32_t decodeUtf8Char(std::string_view text, size_t& pos);
+
+// Декодирование строки UTF-8 в последовательность кодовых точек
+std::u32string decodeUtf8(std::string_view text);
+
+// Кодирование кодовой точки в UTF-8 с добавлением в конец строки
+void appendUtf8(std::string& out, char32_t cp);
+
+// Приведение символа к нижнему регистру (латиница, Latin-1, кириллица)
+char32_t foldCase(char32_t cp);
+
+// Приведение строки UTF-8 к нижнему регистру
+std::string foldCaseUtf8(std::string_view text);
+
+// Проверка корректности UTF-8 и подсчет кодовых точек за один проход.
+// Отвергаются избыточные кодировки, суррогаты, значения больше U+10FFFF и
+// незавершенные последовательности. Векторная реализация выбирается тем же
+// уровнем, что и ядра просмотра (scan.h). false - строка не в UTF-8.
+bool utf8Length(std::string_view text, size_t& length);
+
+// Длина строки без незавершенной последовательности UTF-8 в конце
+// (например, если префикс обрезан посередине кириллической буквы)
+size_t utf8CompletePrefixLength(std::string_view text);
+
+#endif // UTF8_H
@@ -1,66 +1,113 @@
 #include "validation.h"
+#include "timestamp.h"
+#include "utf8.h"
 #include <iostream>
 #include <cctype>
-#include <ctime>
-#include <sstream>
-#include <iomanip>
 
-bool validateNoteTitle(const std::string& title) {
-    // Проверка длины
-    if (title.empty() || title.length() > 100) {
-        std::cout << "Ошибка: название должно содержать от 1 до 100 символов" << std::endl;
-        return false;
+// Общая проверка текстового поля
+static ValidationError checkField(std::string_view value, size_t maxLength, bool requireVisible) {
+    if (value.empty()) {
+        return ValidationError::Empty;
     }
     
-    // Проверка на наличие хотя бы одного видимого символа
-    bool hasVisibleChar = false;
-    for (char c : title) {
-        if (!std::isspace(static_cast<unsigned char>(c))) {
-            hasVisibleChar = true;
-            break;
-        }
+    // Граница в байтах отсекает заведомо длинные строки до проверки
+    // (символ UTF-8 занимает не больше 4 байт)
+    if (value.size() > maxLength * 4) {
+        return ValidationError::TooLong;
     }
     
-    if (!hasVisibleChar) {
-        std::cout << "Ошибка: название не может состоять только из пробелов" << std::endl;
-        return false;
+    size_t length = 0;
+    if (!utf8Length(value, length)) {
+        return ValidationError::InvalidUtf8;
+    }
+    if (length > maxLength) {
+        return ValidationError::TooLong;
     }
     
-    return true;
+    // Проверка на наличие хотя бы одного видимого символа
+    if (requireVisible) {
+        for (char c : value) {
+            if (!std::isspace(static_cast<unsigned char>(c))) {
+                return ValidationError::None;
+            }
+        }
+        return ValidationError::OnlySpaces;
+    }
+    return ValidationError::None;
 }
 
-bool validateNoteCategory(const std::string& category) {
-    // Проверка длины
-    if (category.empty() || category.length() > 50) {
-        std::cout << "Ошибка: тема должна содержать от 1 до 50 символов" << std::endl;
-        return false;
+ValidationError checkNoteTitle(std::string_view title) {
+    return checkField(title, MAX_TITLE_LENGTH, true);
+}
+
+ValidationError checkNoteCategory(std::string_view category) {
+    return checkField(category, MAX_CATEGORY_LENGTH, true);
+}
+
+ValidationError checkNoteContent(std::string_view content) {
+    return checkField(content, MAX_CONTENT_LENGTH, false);
+}
+
+ValidationError checkNoteTags(const std::vector<std::string>& tags) {
+    if (tags.size() > MAX_TAGS_PER_NOTE) {
+        return ValidationError::TooMany;
     }
-    
-    // Проверка на наличие хотя бы одного видимого символа
-    bool hasVisibleChar = false;
-    for (char c : category) {
-        if (!std::isspace(static_cast<unsigned char>(c))) {
-            hasVisibleChar = true;
-            break;
+    for (const std::string& tag : tags) {
+        ValidationError error = checkField(tag, MAX_TAG_LENGTH, true);
+        if (error != ValidationError::None) {
+            return error;
         }
     }
-    
-    if (!hasVisibleChar) {
-        std::cout << "Ошибка: тема не может состоять только из пробелов" << std::endl;
-        return false;
+    return ValidationError::None;
+}
+
+// Вывод сообщения, соответствующего ошибке проверки поля
+static bool reportError(ValidationError error, const char* lengthMessage, const char* spacesMessage,
+                        const char* encodingMessage) {
+    switch (error) {
+        case ValidationError::None:
+            return true;
+        case ValidationError::Empty:
+        case ValidationError::TooLong:
+        case ValidationError::TooMany:
+            std::cout << lengthMessage << std::endl;
+            break;
+        case ValidationError::OnlySpaces:
+            std::cout << spacesMessage << std::endl;
+            break;
+        case ValidationError::InvalidUtf8:
+            std::cout << encodingMessage << std::endl;
+            break;
     }
-    
-    return true;
+    return false;
+}
+
+bool validateNoteTitle(const std::string& title) {
+    return reportError(checkNoteTitle(title),
+                       "Ошибка: название должно содержать от 1 до 100 символов",
+                       "Ошибка: название не может состоять только из пробелов",
+                       "Ошибка: название содержит некорректные символы (не UTF-8)");
+}
+
+bool validateNoteCategory(const std::string& category) {
+    return reportError(checkNoteCategory(category),
+                       "Ошибка: тема должна содержать от 1 до 50 символов",
+                       "Ошибка: тема не может состоять только из пробелов",
+                       "Ошибка: тема содержит некорректные символы (не UTF-8)");
 }
 
 bool validateNoteContent(const std::string& content) {
-    // Проверка длины
-    if (content.empty() || content.length() > 10000) {
-        std::cout << "Ошибка: текст должен содержать от 1 до 10000 символов" << std::endl;
-        return false;
-    }
-    
-    return true;
+    return reportError(checkNoteContent(content),
+                       "Ошибка: текст должен содержать от 1 до 10000 символов",
+                       "Ошибка: текст не может состоять только из пробелов",
+                       "Ошибка: текст содержит некорректные символы (не UTF-8)");
+}
+
+bool validateNoteTags(const std::vector<std::string>& tags) {
+    return reportError(checkNoteTags(tags),
+                       "Ошибка: у заметки может быть до 20 меток, каждая до 30 символов",
+                       "Ошибка: метка не может состоять только из пробелов",
+                       "Ошибка: метки содержат некорректные символы (не UTF-8)");
 }
 
 bool validateMenuChoice(int choice, int min, int max) {
@@ -94,14 +141,6 @@ bool confirmAction(const std::string& message) {
 }
 
 std::string getCurrentDate() {
-    std::time_t now = std::time(nullptr);
-    std::tm* localTime = std::localtime(&now);
-    
-    std::stringstream ss;
-    ss << std::setfill('0') 
-       << std::setw(4) << (localTime->tm_year + 1900) << "-"
-       << std::setw(2) << (localTime->tm_mon + 1) << "-"
-       << std::setw(2) << localTime->tm_mday;
-    
-    return ss.str();
+    // Дата кэшируется до конца суток (см. timestamp.h)
+    return currentDate();
 }
@@ -1,12 +1,41 @@
 #ifndef VALIDATION_H
 #define VALIDATION_H
 
+#include <cstddef>
 #include <string>
+#include <string_view>
+#include <vector>
 
-// Функции валидации данных
+// Ограничения длины в символах (кодовых точках UTF-8), а не в байтах
+const size_t MAX_TITLE_LENGTH = 100;
+const size_t MAX_CATEGORY_LENGTH = 50;
+const size_t MAX_CONTENT_LENGTH = 10000;
+const size_t MAX_TAG_LENGTH = 30;
+const size_t MAX_TAGS_PER_NOTE = 20;
+
+// Результат проверки поля
+enum class ValidationError {
+    None,           // Значение допустимо
+    Empty,          // Пустая строка
+    TooLong,        // Больше допустимого числа символов
+    OnlySpaces,     // Только пробельные символы
+    InvalidUtf8,    // Некорректная последовательность UTF-8
+    TooMany         // Больше допустимого числа меток
+};
+
+// Проверки без вывода и без выделения памяти (для массовых операций).
+// Корректность UTF-8 и длина в символах проверяются за один проход.
+ValidationError checkNoteTitle(std::string_view title);
+ValidationError checkNoteCategory(std::string_view category);
+ValidationError checkNoteContent(std::string_view content);
+// Метки - уже нормализованный список (tags.h)
+ValidationError checkNoteTags(const std::vector<std::string>& tags);
+
+// Функции валидации данных с выводом сообщения об ошибке
 bool validateNoteTitle(const std::string& title);
 bool validateNoteCategory(const std::string& category);
 bool validateNoteContent(const std::string& content);
+bool validateNoteTags(const std::vector<std::string>& tags);
 bool validateMenuChoice(int choice, int min, int max);
 
 // Очистка экрана
@@ -0,0 +1,128 @@
+#include "watcher.h"
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+NoteWatcher::NoteWatcher(const std::string& directory,
+                         std::chrono::milliseconds debounce,
+                         std::chrono::milliseconds maxDelay)
+    : fd(-1), wakePipe{-1, -1}, debounce(debounce), maxDelay(maxDelay) {
+#ifdef __linux__
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    // Запись файла учитывается по закрытию, а не по каждому write
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+    if (inotify_add_watch(fd, directory.c_str(), mask) < 0 ||
+        pipe2(wakePipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+        close(fd);
+        fd = -1;
+        return;
+    }
+    worker = std::thread(&NoteWatcher::run, this);
+#else
+    (void)directory;
+#endif
+}
+
+NoteWatcher::~NoteWatcher() {
+#ifdef __linux__
+    if (fd < 0) {
+        return;
+    }
+    // Канал пуст, поэтому запись одного байта не блокируется и не теряется
+    char byte = 0;
+    ssize_t written = write(wakePipe[1], &byte, 1);
+    (void)written;
+    worker.join();
+    close(fd);
+    close(wakePipe[0]);
+    close(wakePipe[1]);
+#endif
+}
+
+bool NoteWatcher::takeBatch(WatchBatch& batch) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ready.empty()) {
+        return false;
+    }
+    batch = std::move(ready);
+    ready = WatchBatch();
+    return true;
+}
+
+bool NoteWatcher::waitBatch(WatchBatch& batch, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!batchReady.wait_for(lock, timeout, [this]() { return !ready.empty(); })) {
+        return false;
+    }
+    batch = std::move(ready);
+    ready = WatchBatch();
+    return true;
+}
+
+void NoteWatcher::run() {
+#ifdef __linux__
+    using Clock = std::chrono::steady_clock;
+    
+    WatchBatch pending;
+    Clock::time_point firstEvent;
+    Clock::time_point lastEvent;
+    alignas(inotify_event) char buffer[16 * 1024];
+    
+    while (true) {
+        // Без накопленных событий ждем бесконечно, иначе - до конца паузы
+        int timeout = -1;
+        if (!pending.empty()) {
+            Clock::time_point deadline = std::min(lastEvent + debounce, firstEvent + maxDelay);
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+            timeout = left.count() > 0 ? static_cast<int>(left.count()) : 0;
+        }
+        
+        pollfd fds[2] = {{fd, POLLIN, 0}, {wakePipe[0], POLLIN, 0}};
+        int result = poll(fds, 2, timeout);
+        if (fds[1].revents != 0) {
+            return;
+        }
+        
+        if (result > 0 && (fds[0].revents & POLLIN) != 0) {
+            ssize_t length;
+            while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char* ptr = buffer; ptr < buffer + length;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+                    if ((event->mask & IN_Q_OVERFLOW) != 0) {
+                        pending.overflow = true;
+                    } else if (event->len > 0) {
+                        pending.files.insert(event->name);
+                    }
+                    ptr += sizeof(inotify_event) + event->len;
+                }
+            }
+            
+            Clock::time_point now = Clock::now();
+            if (firstEvent == Clock::time_point() && !pending.empty()) {
+                firstEvent = now;
+            }
+            lastEvent = now;
+            continue;
+        }
+        
+        // Пауза закончилась - публикуем пакет, дополняя неотданный
+        if (!pending.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready.files.insert(pending.files.begin(), pending.files.end());
+                ready.overflow = ready.overflow || pending.overflow;
+            }
+            batchReady.notify_all();
+            pending = WatchBatch();
+            firstEvent = Clock::time_point();
+        }
+    }
+#endif
+}
@@ -0,0 +1,58 @@
+#ifndef WATCHER_H
+#define WATCHER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+// Пакет изменений в директории заметок
+struct WatchBatch {
+    std::set<std::string> files;    // Имена измененных или удаленных файлов
+    bool overflow = false;          // Очередь событий переполнена - нужна полная сверка
+    
+    bool empty() const { return files.empty() && !overflow; }
+};
+
+// Наблюдение за директорией заметок через inotify (только Linux).
+// Фоновый поток лишь собирает имена файлов: события одного файла схлопываются,
+// а пакет публикуется после паузы debounce без новых событий (но не позже
+// maxDelay от первого события). Так массовое изменение директории, например
+// git checkout, приходит одним пакетом. Применяет пакет поток-владелец
+// NoteManager (NoteManager::reconcileFiles), сам наблюдатель хранилище не трогает.
+class NoteWatcher {
+public:
+    explicit NoteWatcher(const std::string& directory,
+                         std::chrono::milliseconds debounce = std::chrono::milliseconds(200),
+                         std::chrono::milliseconds maxDelay = std::chrono::milliseconds(2000));
+    ~NoteWatcher();
+    
+    NoteWatcher(const NoteWatcher&) = delete;
+    NoteWatcher& operator=(const NoteWatcher&) = delete;
+    
+    // false - inotify недоступен (другая ОС или ошибка), пакетов не будет
+    bool active() const { return fd >= 0; }
+    
+    // Забрать готовый пакет без ожидания
+    bool takeBatch(WatchBatch& batch);
+    
+    // Ждать готовый пакет не дольше timeout
+    bool waitBatch(WatchBatch& batch, std::chrono::milliseconds timeout);
+    
+private:
+    int fd;                     // Дескриптор inotify
+    int wakePipe[2];            // Пробуждение потока при остановке
+    std::chrono::milliseconds debounce;
+    std::chrono::milliseconds maxDelay;
+    std::thread worker;
+    
+    std::mutex mutex;
+    std::condition_variable batchReady;
+    WatchBatch ready;           // Опубликованный пакет (под mutex)
+    
+    void run();
+};
+
+#endif // WATCHER_H